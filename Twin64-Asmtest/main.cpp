@@ -9,6 +9,7 @@
 //  A <argStr> -> assemble input argument
 //  D <val>    -> disassemble instruction value
 //  T <argStr> -> assemble input, show and pass to disassemble
+//  F <file> [ <elfFile> ] -> assemble a source file, optionally write an ELF file
 //  E          -> exit   
 //  ?          -> show help
 //
@@ -31,6 +32,8 @@
 #include "T64-Common.h"
 #include "T64-InlineAsm.h"
 
+#include <chrono>
+
 T64Assemble     *doAsm  = nullptr;
 T64DisAssemble  *disAsm = nullptr;
 
@@ -78,16 +81,44 @@ void testAsmDisAsm( char *asmStr ) {
     else printf( "%s\n", doAsm -> getErrStr( doAsm -> getErrId( )));
 }
 
+void assembleFile( char *arg ) {
+
+    char *fileName  = strtok( arg, " \t" );
+    char *elfName   = strtok( NULL, " \t" );
+
+    auto    start   = std::chrono::steady_clock::now( );
+    int     errCode = doAsm -> assembleFile( fileName, 0 );
+    double  ms      = std::chrono::duration<double, std::milli>
+                        ( std::chrono::steady_clock::now( ) - start ).count( );
+
+    if ( errCode != 0 ) {
+
+        printf( "Line %d: %s\n", 
+                doAsm -> getErrLine( ), doAsm -> getErrStr( doAsm -> getErrId( )));
+        return;
+    }
+
+    printf( "%d lines, %" PRId64 " bytes, %.3f ms\n", 
+            doAsm -> getLineCount( ), doAsm -> getImageSize( ), ms );
+
+    if (( elfName != nullptr ) && ( ! doAsm -> writeElfFile( elfName ))) {
+
+        printf( "Error writing ELF file\n" );
+    }
+}
+
 void printHelp( ) {
     
     printf( "A <argStr> -> assemble input argument\n" );
     printf( "D <val>    -> disassemble instruction value\n" );
     printf( "T <argStr> -> assemble input, show and pass to disassemble\n" );
+    printf( "F <file> [ <elfFile> ] -> assemble a source file\n" );
     printf( "E          -> exit\n" );
 }
 
 //----------------------------------------------------------------------------------------
-// Read the command input, strip newline char and convert to uppercase.
+// Read the command input, strip newline char and convert the command to 
+// uppercase. The arguments are left alone, file names are case sensitive.
 //
 //----------------------------------------------------------------------------------------
 int getInput( char *buf ) {
@@ -95,7 +126,11 @@ int getInput( char *buf ) {
     if ( fgets( buf, 128, stdin ) == nullptr ) return( -1 );
     buf[ strcspn( buf, "\n") ] = '\0';
 
-    for ( char *s = buf; *s; s++ ) *s = toupper((unsigned char) *s );
+    for ( char *s = buf; ( *s ) && ( *s != ' ' ) && ( *s != '\t' ); s++ ) {
+        
+        *s = toupper((unsigned char) *s );
+    }
+
     return((uint32_t) strlen( buf ));
 }
 
@@ -145,6 +180,11 @@ int main( int argc, const char * argv[] ) {
             if ( arg != nullptr ) testAsmDisAsm( arg );
             else printf( "Expected assembler input string\n" );
         }  
+        else if ( strcmp( cmd, "F" ) == 0 ) {
+        
+            if ( arg != nullptr ) assembleFile( arg );
+            else printf( "Expected a source file name\n" );
+        }
         else if ( strcmp( cmd, "E" ) == 0 ) {
         
             break;
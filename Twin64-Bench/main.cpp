@@ -0,0 +1,659 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - Simulator Benchmark Program.
+//
+//----------------------------------------------------------------------------------------
+// Bench is a simple program for measuring the speed of the simulator. It builds a
+// T64 system without the simulator windows, loads a small guest kernel and runs
+// it for a fixed number of instructions on one or more processors. The result
+// is one line per kernel in JSON format, with the instructions per second, the
+// time per instruction and the processor counters. The kernels are:
+//
+//  alu     -> ALU instruction loop
+//  stride  -> load and store with a 64 byte stride
+//  branch  -> branch heavy code
+//  tlb     -> data TLB thrash loop with a TLB miss handler
+//  trap    -> trap storm with a trap handler
+//  ovfl    -> overflow trap storm with a trap handler
+//  ldrstc  -> LDR/STC counter increments, contended across processors
+//
+// The program options are:
+//
+//  -k <name>   -> run only the named kernel
+//  -n <num>    -> number of instructions per processor
+//  -p <num>    -> number of processors, overrides the kernel default
+//  -o <num>    -> processor options, e.g. 1 = PREDECODE, 2 = DIRECT_MEM,
+//                 5 = PREDECODE and BLOCKS, 16 = TIMING
+//  -c <num>    -> processor cache type, e.g. 2 = T64_CT_4W_128S_4L
+//  -s <ff>,<warm>,<len>[,<gap>]
+//              -> sampling: fast forward, warmup and sample length, the
+//                 optional sample gap repeats the sampling
+//  -t <file>   -> trace each processor to the file "<file>.<procIndex>"
+//  -m <num>    -> memory module size in MBytes, the default is 16
+//  -r <mode>[,<quantum>[,<workers>]]
+//              -> run the processors with the system scheduler, mode 1 is
+//                 lockstep, mode 2 is relaxed and mode 3 is reproducible. The
+//                 default quantum is 1024 units, the default worker count is
+//                 the host core count. Only mode 3 gives the same result each
+//                 run, it always uses one worker
+//  -x <file>[,<ms>]
+//              -> export the module performance counters to the file, every
+//                 interval during the run or once at its end. A file name 
+//                 ending in ".csv" selects CSV, otherwise JSON lines. Without
+//                 a kernel name, the kernel name is appended to the file
+//  -l          -> list the kernels
+//
+// With sampling, the JSON line also contains the number of samples, the 
+// measured instructions and the TLB and cache misses in the measured regions.
+// With the system scheduler, it contains the mode and the quanta executed.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Benchmark
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details. You should have received a copy of the GNU General Public
+// License along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-System.h"
+#include "T64-Processor.h"
+#include "T64-Memory.h"
+#include "T64-Tlb.h"
+#include "T64-InlineAsm.h"
+
+#include <chrono>
+
+//----------------------------------------------------------------------------------------
+// Local declarations. The system has a global TLB, one memory module and the
+// processors. The kernel code is loaded at address zero, the trap handlers at
+// the IVA address. The kernels use general registers R10 to R15 for their
+// setup, R15 counts the traps taken by a handler.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+const int       BENCH_MAX_PROCS     = 8;
+const int       BENCH_GTLB_MOD_NUM  = 0;
+const int       BENCH_MEM_MOD_NUM   = 2;
+const int       BENCH_PROC_MOD_NUM  = 4;
+const T64Word   BENCH_MEM_SIZE_MB   = 16;
+const T64Word   BENCH_CODE_ADR      = 0x0;
+const T64Word   BENCH_IVA_ADR       = 0x1000;
+const T64Word   BENCH_DATA_ADR      = 0x100000;
+const T64Word   BENCH_PAGE_ADR      = 0x200000;
+const T64Word   BENCH_VIRT_ADR      = 0x100000000000;
+const int       BENCH_TRAP_CNT_REG  = 15;
+
+struct BenchReg {
+
+    int         regNum;
+    T64Word     val;
+};
+
+struct BenchKernel {
+
+    const char  *name;
+    const char  *info;
+    int         procs;
+    const char  *code[ 8 ];
+    T64TrapCode trapCode;
+    const char  *handler[ 8 ];
+    BenchReg    regs[ 4 ];
+};
+
+//----------------------------------------------------------------------------------------
+// The kernel table. Each kernel is an endless loop, the benchmark runs it for
+// a fixed number of instructions. The code and the handler lists end with a
+// null entry. The trap storm handlers return to the trapping instruction itself,
+// so the kernel traps over and over.
+//
+//----------------------------------------------------------------------------------------
+const BenchKernel benchKernels[ ] = {
+
+    {   .name       = "alu",
+        .info       = "ALU instruction loop",
+        .procs      = 1,
+        .code       = { "ADD R2,R2,1", "XOR R3,R3,R2", "SUB R4,R4,R3",
+                        "OR R5,R4,R2", "AND R6,R5,R3", "B -20", nullptr },
+        .trapCode   = NO_TRAP,
+        .handler    = { nullptr },
+        .regs       = {{ 0, 0 }}
+    },
+
+    {   .name       = "stride",
+        .info       = "load and store with a 64 byte stride",
+        .procs      = 1,
+        .code       = { "ADD R9,R9,64", "AND R9,R9,R11", "ST.D R2,R9(R10)",
+                        "LD.D R4,R9(R10)", "ADD R2,R2,1", "B -20", nullptr },
+        .trapCode   = NO_TRAP,
+        .handler    = { nullptr },
+        .regs       = {{ 10, BENCH_DATA_ADR }, { 11, 0xFFFC0 }}
+    },
+
+    {   .name       = "branch",
+        .info       = "branch heavy code",
+        .procs      = 1,
+        .code       = { "ADD R2,R2,1", "BB.T R2,0,8", "ADD R3,R3,1",
+                        "BB.F R2,1,8", "ADD R4,R4,1", "B -20", nullptr },
+        .trapCode   = NO_TRAP,
+        .handler    = { nullptr },
+        .regs       = {{ 0, 0 }}
+    },
+
+    {   .name       = "tlb",
+        .info       = "data TLB thrash loop with a TLB miss handler",
+        .procs      = 1,
+        .code       = { "ADD R9,R9,4096", "AND R9,R9,R11", "LD.D R4,R9(R10)",
+                        "B -12", nullptr },
+        .trapCode   = DATA_TLB_MISS_TRAP,
+        .handler    = { "MFCR R12,CR12", "IDTLB R13,R12,R14", "ADD R15,R15,1",
+                        "RFI", nullptr },
+        .regs       = {{ 10, BENCH_VIRT_ADR }, { 11, 0x3F000 }, { 14, BENCH_PAGE_ADR }}
+    },
+
+    {   .name       = "trap",
+        .info       = "trap storm with a trap handler",
+        .procs      = 1,
+        .code       = { "TRAP 1,R0,R0", nullptr },
+        .trapCode   = USER_DEFINED_TRAP,
+        .handler    = { "ADD R15,R15,1", "RFI", nullptr },
+        .regs       = {{ 0, 0 }}
+    },
+
+    {   .name       = "ovfl",
+        .info       = "overflow trap storm with a trap handler",
+        .procs      = 1,
+        .code       = { "ADD R2,R3,R3", nullptr },
+        .trapCode   = OVERFLOW_TRAP,
+        .handler    = { "ADD R15,R15,1", "RFI", nullptr },
+        .regs       = {{ 3, 0x7FFFFFFFFFFFFFFF }}
+    },
+
+    {   .name       = "ldrstc",
+        .info       = "LDR/STC counter increments, contended across processors",
+        .procs      = 4,
+        .code       = { "LDR R2,0(R10)", "ADD R2,R2,1", "STC R2,0(R10)",
+                        "BB.F R2,0,-12", "B -16", nullptr },
+        .trapCode   = NO_TRAP,
+        .handler    = { nullptr },
+        .regs       = {{ 10, BENCH_DATA_ADR }}
+    }
+};
+
+const int BENCH_KERNELS = sizeof( benchKernels ) / sizeof( benchKernels[ 0 ] );
+
+//----------------------------------------------------------------------------------------
+// Program input parameters.
+//
+//----------------------------------------------------------------------------------------
+const char  *kernelName = nullptr;
+int         instrCount  = 10000000;
+int         procCount   = 0;
+T64Options  procOptions = T64_PO_NIL;
+int         cacheType   = T64_CT_NIL;
+bool        sampling    = false;
+const char  *traceName  = nullptr;
+T64Word     memSizeMb   = BENCH_MEM_SIZE_MB;
+int         schedMode   = T64_SCHED_THREADS;
+int         schedQuantum = T64_PROC_UNIT_BATCH;
+int         schedWorkers = 0;
+const char  *perfName   = nullptr;
+int         perfInterval = 0;
+T64SampleConfig sampleCfg;
+
+bool parseParameters( int argc, const char * argv[] ) {
+
+    for ( int i = 1; i < argc; i++ ) {
+
+        if (( strcmp( argv[ i ], "-k" ) == 0 ) && ( i + 1 < argc )) {
+
+            kernelName = argv[ ++ i ];
+        }
+        else if (( strcmp( argv[ i ], "-n" ) == 0 ) && ( i + 1 < argc )) {
+
+            instrCount = atoi( argv[ ++ i ] );
+        }
+        else if (( strcmp( argv[ i ], "-p" ) == 0 ) && ( i + 1 < argc )) {
+
+            procCount = atoi( argv[ ++ i ] );
+        }
+        else if (( strcmp( argv[ i ], "-o" ) == 0 ) && ( i + 1 < argc )) {
+
+            procOptions = (T64Options) atoi( argv[ ++ i ] );
+        }
+        else if (( strcmp( argv[ i ], "-c" ) == 0 ) && ( i + 1 < argc )) {
+
+            cacheType = atoi( argv[ ++ i ] );
+        }
+        else if (( strcmp( argv[ i ], "-s" ) == 0 ) && ( i + 1 < argc )) {
+
+            long long ff    = 0;
+            long long warm  = 0;
+            long long len   = 0;
+            long long gap   = 0;
+            
+            if ( sscanf( argv[ ++ i ], "%lld,%lld,%lld,%lld", &ff, &warm, &len, &gap ) < 3 ) {
+                
+                printf( "Invalid sample parameter\n" );
+                return( false );
+            }
+
+            sampleCfg.ffInstrs      = ff;
+            sampleCfg.warmInstrs    = warm;
+            sampleCfg.sampleInstrs  = len;
+            sampleCfg.sampleGap     = gap;
+            sampling                = true;
+        }
+        else if (( strcmp( argv[ i ], "-t" ) == 0 ) && ( i + 1 < argc )) {
+
+            traceName = argv[ ++ i ];
+        }
+        else if (( strcmp( argv[ i ], "-m" ) == 0 ) && ( i + 1 < argc )) {
+
+            memSizeMb = atoll( argv[ ++ i ] );
+        }
+        else if (( strcmp( argv[ i ], "-r" ) == 0 ) && ( i + 1 < argc )) {
+
+            if ( sscanf( argv[ ++ i ], "%d,%d,%d", 
+                         &schedMode, &schedQuantum, &schedWorkers ) < 1 ) {
+                
+                printf( "Invalid scheduler parameter\n" );
+                return( false );
+            }
+        }
+        else if (( strcmp( argv[ i ], "-x" ) == 0 ) && ( i + 1 < argc )) {
+
+            static char perfBuf[ 256 ];
+            char        *sep = nullptr;
+
+            strncpy( perfBuf, argv[ ++ i ], sizeof( perfBuf ) - 1 );
+            
+            if (( sep = strchr( perfBuf, ',' )) != nullptr ) {
+
+                *sep         = '\0';
+                perfInterval = atoi( sep + 1 );
+            }
+
+            perfName = perfBuf;
+        }
+        else if ( strcmp( argv[ i ], "-l" ) == 0 ) {
+
+            for ( int k = 0; k < BENCH_KERNELS; k++ ) {
+
+                printf( "%-8s -> %s\n", benchKernels[ k ].name, benchKernels[ k ].info );
+            }
+
+            exit( 0 );
+        }
+        else {
+
+            printf( "Usage: Twin64-Bench [ -k <name> ] [ -n <num> ] " );
+            printf( "[ -p <num> ] [ -o <num> ] [ -c <num> ] [ -s <ff>,<warm>,<len>[,<gap>] ] [ -t <file> ] [ -m <num> ] " );
+            printf( "[ -r <mode>[,<quantum>[,<workers>]] ] [ -x <file>[,<ms>] ] [ -l ]\n" );
+            return( false );
+        }
+    }
+
+    if (( instrCount < 1 ) || ( procCount < 0 ) || ( procCount > BENCH_MAX_PROCS ) ||
+        ( cacheType < T64_CT_NIL ) || ( cacheType > T64_CT_8W_64S_8L ) ||
+        ( sampleCfg.ffInstrs < 0 ) || ( sampleCfg.warmInstrs < 0 ) || 
+        ( sampleCfg.sampleInstrs < 0 ) || ( sampleCfg.sampleGap < 0 ) ||
+        ( memSizeMb < 4 ) || ( memSizeMb * 1024 * 1024 > T64_MAX_PHYS_MEM_LIMIT ) ||
+        ( schedMode < T64_SCHED_THREADS ) || ( schedMode > T64_SCHED_REPRODUCIBLE ) ||
+        ( schedQuantum < 1 ) || ( schedWorkers < 0 ) || 
+        ( schedWorkers > T64_SCHED_MAX_WORKERS ) || ( perfInterval < 0 )) {
+
+        printf( "Invalid parameter value\n" );
+        return( false );
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Assemble a list of instructions and store them in physical memory. The
+// assembler expects uppercase input, our kernel table is written that way.
+//
+//----------------------------------------------------------------------------------------
+bool loadCode( T64System *sys, T64Assemble *doAsm, T64Word adr, const char * const *code ) {
+
+    for ( int i = 0; code[ i ] != nullptr; i++ ) {
+
+        char        buf[ 128 ];
+        uint32_t    instr = 0;
+
+        strncpy( buf, code[ i ], sizeof( buf ) - 1 );
+        buf[ sizeof( buf ) - 1 ] = '\0';
+
+        if ( doAsm -> assembleInstr( buf, &instr ) != 0 ) {
+
+            printf( "Assembler error: \"%s\": %s\n",
+                    code[ i ], doAsm -> getErrStr( doAsm -> getErrId( )));
+            return( false );
+        }
+
+        copyEndianAware((uint8_t *) &instr, (uint8_t *) &instr, 4 );
+
+        if ( ! sys -> busOpWrite( nullptr, adr + ( i * 4 ), (uint8_t *) &instr, 4 )) {
+
+            return( false );
+        }
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Run a kernel. We build a fresh system for each kernel, so that the counters
+// and caches start out empty. The processors run in their module threads. A
+// processor is reset first, which also makes sure that its thread is up and 
+// waiting. We then start them all and wait until each one executed its 
+// instructions. With the system scheduler, the system run routine does this
+// on the scheduler workers instead.
+//
+//----------------------------------------------------------------------------------------
+bool runKernel( const BenchKernel *k, T64Assemble *doAsm ) {
+
+    int         procs = ( procCount > 0 ) ? procCount : k -> procs;
+    T64System   *sys  = new T64System( );
+
+    T64Processor *procTab[ BENCH_MAX_PROCS ];
+    T64Tracer    *traceTab[ BENCH_MAX_PROCS ] = { };
+
+    sys -> addModule( new T64GlobalTlb( MT_GTLB,
+                                        BENCH_GTLB_MOD_NUM,
+                                        T64_TK_GLOBAL_TLB,
+                                        T64_TT_FA_16S ));
+
+    T64Memory *mem = new T64Memory( sys,
+                                    BENCH_MEM_MOD_NUM,
+                                    T64_MK_NIL,
+                                    T64_MT_RAM,
+                                    0,
+                                    memSizeMb * 1024 * 1024 );
+    
+    sys -> addModule( mem );
+
+    if ( ! loadCode( sys, doAsm, BENCH_CODE_ADR, k -> code )) return( false );
+
+    if (( k -> trapCode != NO_TRAP ) &&
+        ( ! loadCode( sys, doAsm, BENCH_IVA_ADR + ( k -> trapCode * 32 ), k -> handler ))) {
+
+        return( false );
+    }
+
+    for ( int i = 0; i < procs; i++ ) {
+
+        procTab[ i ] = new T64Processor( sys,
+                                         BENCH_PROC_MOD_NUM + i,
+                                         procOptions,
+                                         T64_CPU_T_NIL,
+                                         T64_TT_FA_4U,
+                                         (T64CacheType) cacheType );
+
+        sys -> addModule( procTab[ i ] );
+
+        procTab[ i ] -> resetModule( );
+        procTab[ i ] -> waitUntilStopped( );
+
+        if ( sampling ) procTab[ i ] -> setSampleConfig( sampleCfg );
+
+        if ( traceName != nullptr ) {
+
+            char fName[ 256 ];
+
+            snprintf( fName, sizeof( fName ), "%s.%d", traceName, i );
+
+            traceTab[ i ] = new T64Tracer( BENCH_PROC_MOD_NUM + i );
+
+            if ( ! traceTab[ i ] -> open( fName )) {
+
+                printf( "Cannot open trace file: %s\n", fName );
+                return( false );
+            }
+
+            procTab[ i ] -> setTracer( traceTab[ i ] );
+        }
+
+        T64Cpu *cpu = procTab[ i ] -> getCpuPtr( );
+
+        cpu -> setPsrReg( BENCH_CODE_ADR );
+        cpu -> setControlReg( CTL_REG_IVA, BENCH_IVA_ADR );
+
+        for ( int r = 0; r < 4; r++ ) {
+
+            if ( k -> regs[ r ].regNum > 0 ) {
+
+                cpu -> setGeneralReg( k -> regs[ r ].regNum, k -> regs[ r ].val );
+            }
+        }
+    }
+
+    T64PerfExport   perfExport( sys );
+    T64PerfFormat   perfFmt = T64_PERF_FMT_JSON;
+    char            perfFile[ 256 ];
+
+    if ( perfName != nullptr ) {
+
+        size_t len = strlen( perfName );
+        
+        if (( len > 4 ) && ( strcmp( perfName + len - 4, ".csv" ) == 0 )) perfFmt = T64_PERF_FMT_CSV;
+
+        if ( kernelName != nullptr ) snprintf( perfFile, sizeof( perfFile ), "%s", perfName );
+        else snprintf( perfFile, sizeof( perfFile ), "%s.%s", perfName, k -> name );
+
+        if ( ! perfExport.start( perfFile, perfFmt, perfInterval )) {
+
+            printf( "Cannot open counter file: %s\n", perfFile );
+            return( false );
+        }
+    }
+
+    auto startTime = std::chrono::steady_clock::now( );
+
+    if ( schedMode == T64_SCHED_THREADS ) {
+
+        for ( int i = 0; i < procs; i++ ) procTab[ i ] -> execModule( instrCount, false );
+        for ( int i = 0; i < procs; i++ ) procTab[ i ] -> waitUntilStopped( );
+    }
+    else {
+
+        sys -> setSchedMode((T64SchedMode) schedMode, schedQuantum, schedWorkers );
+        sys -> run( instrCount );
+    }
+
+    auto endTime = std::chrono::steady_clock::now( );
+
+    if ( perfName != nullptr ) {
+
+        if ( perfInterval > 0 ) perfExport.stop( );
+        else perfExport.start( perfFile, perfFmt, 0 );
+    }
+
+    double      secs        = std::chrono::duration<double>( endTime - startTime ).count( );
+    double      instrs      = (double) instrCount * procs;
+    T64Word     traps       = 0;
+    T64Word     iTlbHits    = 0;
+    T64Word     iTlbMisses  = 0;
+    T64Word     dTlbHits    = 0;
+    T64Word     dTlbMisses  = 0;
+    T64Word     gTlbHits    = 0;
+    T64Word     gTlbMisses  = 0;
+    T64Word     ccHits      = 0;
+    T64Word     ccMisses    = 0;
+    T64Word     ccPurges    = 0;
+    T64Word     icHits      = 0;
+    T64Word     icMisses    = 0;
+    T64Word     dcHits      = 0;
+    T64Word     dcMisses    = 0;
+    T64Word     dcWbacks    = 0;
+    T64Word     cycles      = 0;
+    T64Word     memData     = 0;
+    T64SampleStats sTotal;
+
+    for ( int i = 0; i < procs; i++ ) {
+
+        T64LocalTlb  *tlb = procTab[ i ] -> getLocalTlbPtr( );
+        T64CodeCache *cc  = procTab[ i ] -> getCodeCachePtr( );
+        T64Cache     *ic  = procTab[ i ] -> getICachePtr( );
+        T64Cache     *dc  = procTab[ i ] -> getDCachePtr( );
+
+        traps       += procTab[ i ] -> getCpuPtr( ) -> getGeneralReg( BENCH_TRAP_CNT_REG );
+        iTlbHits    += tlb -> getItlbHits( );
+        iTlbMisses  += tlb -> getItlbMisses( );
+        dTlbHits    += tlb -> getDtlbHits( );
+        dTlbMisses  += tlb -> getDtlbMisses( );
+        gTlbHits    += tlb -> getItlbMissGTlbHits( ) + tlb -> getDtlbMissGTlbHits( );
+        gTlbMisses  += tlb -> getItlbMissGTlbMisses( ) + tlb -> getDtlbMissGTlbMisses( );
+        cycles      += procTab[ i ] -> getCycles( );
+
+        if ( cc != nullptr ) {
+
+            ccHits      += cc -> getHits( );
+            ccMisses    += cc -> getMisses( );
+            ccPurges    += cc -> getPurges( );
+        }
+
+        if ( ic != nullptr ) {
+
+            icHits      += ic -> getHits( );
+            icMisses    += ic -> getMisses( );
+        }
+
+        if ( dc != nullptr ) {
+
+            dcHits      += dc -> getHits( );
+            dcMisses    += dc -> getMisses( );
+            dcWbacks    += dc -> getWriteBacks( );
+        }
+
+        if ( sampling ) {
+
+            T64SampleStats ss;
+
+            procTab[ i ] -> getSampleStats( &ss );
+
+            sTotal.samples      += ss.samples;
+            sTotal.detailInstrs += ss.detailInstrs;
+            sTotal.iTlbMisses   += ss.iTlbMisses;
+            sTotal.dTlbMisses   += ss.dTlbMisses;
+            sTotal.iCacheMisses += ss.iCacheMisses;
+            sTotal.dCacheMisses += ss.dCacheMisses;
+        }
+    }
+
+    sys -> busOpRead( nullptr, BENCH_DATA_ADR, (uint8_t *) &memData, 8 );
+    copyEndianAware((uint8_t *) &memData, (uint8_t *) &memData, 8 );
+
+    printf( "{ \"kernel\": \"%s\", \"procs\": %d, \"options\": %d, ",
+            k -> name, procs, (int) procOptions );
+    printf( "\"instrs\": %.0f, \"seconds\": %.6f, \"mips\": %.3f, \"nsPerInstr\": %.3f, ",
+            instrs, secs, instrs / secs / 1.0e6, secs * 1.0e9 / instrs );
+    printf( "\"traps\": %lld, ", (long long) traps );
+    printf( "\"iTlbHits\": %lld, \"iTlbMisses\": %lld, ",
+            (long long) iTlbHits, (long long) iTlbMisses );
+    printf( "\"dTlbHits\": %lld, \"dTlbMisses\": %lld, ",
+            (long long) dTlbHits, (long long) dTlbMisses );
+    printf( "\"gTlbHits\": %lld, \"gTlbMisses\": %lld, ",
+            (long long) gTlbHits, (long long) gTlbMisses );
+    printf( "\"ccHits\": %lld, \"ccMisses\": %lld, \"ccPurges\": %lld, ",
+            (long long) ccHits, (long long) ccMisses, (long long) ccPurges );
+    printf( "\"icHits\": %lld, \"icMisses\": %lld, ",
+            (long long) icHits, (long long) icMisses );
+    printf( "\"dcHits\": %lld, \"dcMisses\": %lld, \"dcWriteBacks\": %lld, ",
+            (long long) dcHits, (long long) dcMisses, (long long) dcWbacks );
+
+    if ( procOptions & T64_PO_TIMING ) {
+
+        printf( "\"cycles\": %lld, \"cpi\": %.3f, ", (long long) cycles, cycles / instrs );
+    }
+
+    if ( sampling ) {
+
+        printf( "\"samples\": %lld, \"sampleInstrs\": %lld, ",
+                (long long) sTotal.samples, (long long) sTotal.detailInstrs );
+        printf( "\"sampleItlbMisses\": %lld, \"sampleDtlbMisses\": %lld, ",
+                (long long) sTotal.iTlbMisses, (long long) sTotal.dTlbMisses );
+        printf( "\"sampleIcMisses\": %lld, \"sampleDcMisses\": %lld, ",
+                (long long) sTotal.iCacheMisses, (long long) sTotal.dCacheMisses );
+    }
+
+    if ( traceName != nullptr ) {
+
+        T64Word records = 0;
+        T64Word waits   = 0;
+
+        for ( int i = 0; i < procs; i++ ) {
+
+            traceTab[ i ] -> close( );
+            records += traceTab[ i ] -> getRecords( );
+            waits   += traceTab[ i ] -> getWaits( );
+        }
+
+        printf( "\"traceRecords\": %lld, \"traceWaits\": %lld, ",
+                (long long) records, (long long) waits );
+    }
+
+    if ( schedMode != T64_SCHED_THREADS ) {
+
+        printf( "\"sched\": %d, \"quanta\": %lld, ",
+                schedMode, (long long) sys -> getScheduler( ) -> getQuanta( ));
+    }
+
+    printf( "\"memPages\": %lld, \"memTouchedPages\": %lld, ",
+            (long long) mem -> getPageCount( ), (long long) mem -> getTouchedPages( ));
+
+    printf( "\"memData\": %lld }\n", (long long) memData );
+    fflush( stdout );
+
+    for ( int i = 0; i < procs; i++ ) {
+
+        sys -> removeModule( procTab[ i ] );
+        delete traceTab[ i ];
+    }
+
+    return( true );
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------------------
+// Here we go.
+//
+//----------------------------------------------------------------------------------------
+int main( int argc, const char * argv[] ) {
+
+    if ( ! parseParameters( argc, argv )) return( 1 );
+
+    T64Assemble *doAsm = new T64Assemble( );
+    bool        found  = false;
+
+    for ( int k = 0; k < BENCH_KERNELS; k++ ) {
+
+        if (( kernelName != nullptr ) && ( strcmp( kernelName, benchKernels[ k ].name ) != 0 )) {
+
+            continue;
+        }
+
+        found = true;
+        if ( ! runKernel( &benchKernels[ k ], doAsm )) return( 1 );
+    }
+
+    if ( ! found ) {
+
+        printf( "Unknown kernel: %s\n", kernelName );
+        return( 1 );
+    }
+
+    return 0;
+}
@@ -46,6 +46,7 @@
 #include <iostream>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 #else
 #define NOMINMAX
 #include <windows.h>
@@ -133,7 +134,9 @@ enum T64AccMode : uint8_t {
 
 //----------------------------------------------------------------------------------------
 // T64 Traps. Traps are identified by their number. A trap handler is passed 
-// further information via the control registers.
+// further information via the control registers. The debug break event is not
+// an architected trap and never delivered. A processor reports it when a 
+// breakpoint or watchpoint stops the execution.
 //
 //----------------------------------------------------------------------------------------
 enum T64TrapCode : int {
@@ -165,7 +168,9 @@ enum T64TrapCode : int {
     PAGE_REF_TRAP                   = 19,
     BREAK_INSTR_TRAP                = 20,
 
-    USER_DEFINED_TRAP               = 21
+    USER_DEFINED_TRAP               = 21,
+
+    DEBUG_BREAK_EVENT               = 64
 };
 
 //----------------------------------------------------------------------------------------
@@ -204,7 +209,7 @@ enum ControlRegId : int {
     CTL_REG_CPU_INFO    = 0,
     CTL_REG_SHAMT       = 1,
     CTL_REG_REC_CNTR    = 2,
-    CTL_REG_RESERVED_3  = 3,
+    CTL_REG_CYCLES      = 3,
 
     CTL_REG_PID_0       = 4,
     CTL_REG_PID_1       = 5,
@@ -307,13 +312,16 @@ enum T64IoRegIndex : int {
 //----------------------------------------------------------------------------------------
 // TLBs. A translation lookaside buffer is essential. The TLB kind specifies 
 // the kind of TLB, i.e. instruction, data or unified TLB. The TLB type specifies
-// type of TLB. Currently there are fully associative TLBs defined. The TLB  
-// configuration is encoded as follows:
+// type of TLB. There are fully associative ( FA ) and 4-way set associative 
+// ( SA ) TLBs defined. The lookup cost of a set associative TLB does not grow
+// with its size, it is indexed per page size. The TLB configuration is encoded
+// as follows:
 //
-//  T64_TT_<type>_<sets>S
+//  T64_TT_<type>_<entries>S
 //
 // Currently, the processor supports a unified TLB with two small sets of an
-// instruction and data translation buffer on top.
+// instruction and data translation buffer on top. Their types are marked with 
+// a "U" instead of the "S".
 // 
 //----------------------------------------------------------------------------------------
 enum T64TlbKind : int {
@@ -332,9 +340,17 @@ enum T64TlbType : int {
     T64_TT_FA_16S       = 2,
     T64_TT_FA_32S       = 3,
     T64_TT_FA_64S       = 4,
-    T64_TT_FA_128S      = 5
+    T64_TT_FA_128S      = 5,
+    T64_TT_SA_256S      = 6,
+    T64_TT_SA_1024S     = 7,
+    T64_TT_SA_4096S     = 8,
+    T64_TT_SA_64U       = 9,
+    T64_TT_SA_256U      = 10
 };
 
+const int T64_TLB_SA_WAYS       = 4;
+const int T64_TLB_PAGE_SIZES    = 4;
+
 //----------------------------------------------------------------------------------------
 // A TLB entry in the a TLB table. There are the virtual starting address and
 // the corresponding physical page address. The range and alignment is encoded
@@ -368,9 +384,9 @@ struct T64TlbEntry {
 //
 //  T64_CT_<ways>W_<sets>S_<words>L
 //
-// Currently, we do not support caches. The simulator will run with a single 
-// cycle memory access. We may change this one day to learn about cache 
-// coherence and so on.
+// Caches are optional. A processor without caches runs with a single cycle
+// memory access. A processor with caches gets an instruction and a data cache
+// of the configured type, which are kept coherent with the other caches.
 //
 //----------------------------------------------------------------------------------------
 enum T64CacheKind : int {
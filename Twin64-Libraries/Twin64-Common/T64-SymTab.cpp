@@ -0,0 +1,258 @@
+//----------------------------------------------------------------------------------------
+//
+//  Twin64Sim - A 64-bit CPU Simulator - Symbol table
+//
+//----------------------------------------------------------------------------------------
+// The symbol table is built from the symbols added. The symbols are sorted by
+// address and from several symbols at the same address the first one added is
+// kept. The names are kept in one character pool, the symbol entries refer to
+// their name by offset. The bucket array is built next. When the address range
+// of the symbols has more pages than we want buckets, a bucket covers several
+// pages.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin64Sim - A 64-bit CPU Simulator - Symbol table
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You
+// should have received a copy of the GNU General Public License along with this
+// program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-SymTab.h"
+#include <algorithm>
+#include <elfio/elfio.hpp>
+
+using namespace ELFIO;
+
+//----------------------------------------------------------------------------------------
+// Object constructor. We start with an empty table.
+//
+//----------------------------------------------------------------------------------------
+T64SymTab::T64SymTab( ) { }
+
+//----------------------------------------------------------------------------------------
+// Clear the table.
+//
+//----------------------------------------------------------------------------------------
+void T64SymTab::clear( ) {
+
+    syms.clear( );
+    names.clear( );
+    buckets.clear( );
+    byName.clear( );
+
+    bucketBase  = 0;
+    lastAdr     = 0;
+    bucketShift = T64_SYM_BUCKET_SHIFT;
+    built       = false;
+}
+
+//----------------------------------------------------------------------------------------
+// Add a symbol. The table needs to be built again before the next address
+// lookup. The name lookup works right away, for a name added more than once
+// the first value is kept.
+//
+//----------------------------------------------------------------------------------------
+bool T64SymTab::add( const char *name, T64Word adr, T64Word size ) {
+
+    if (( name == nullptr ) || ( *name == 0 ) || ( size < 0 )) return( false );
+
+    T64Symbol sym;
+
+    sym.adr     = adr;
+    sym.size    = size;
+    sym.nameOfs = (uint32_t) names.size( );
+
+    names.insert( names.end( ), name, name + strlen( name ) + 1 );
+    syms.push_back( sym );
+    byName.emplace( name, adr );
+
+    built = false;
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Build the table. After sorting and removing the duplicate addresses, each
+// bucket is set to the index of the first symbol at or above the bucket start
+// address. There is one more bucket entry at the end, so that the symbols of
+// bucket "b" are always the ones from "buckets[ b ]" up to "buckets[ b + 1 ]".
+//
+//----------------------------------------------------------------------------------------
+void T64SymTab::build( ) {
+
+    std::stable_sort( syms.begin( ), syms.end( ),
+                      []( const T64Symbol &a, const T64Symbol &b ) {
+
+        return( a.adr < b.adr );
+    });
+
+    syms.erase( std::unique( syms.begin( ), syms.end( ),
+                             []( const T64Symbol &a, const T64Symbol &b ) {
+
+                    return( a.adr == b.adr );
+                }), syms.end( ));
+
+    buckets.clear( );
+    bucketShift = T64_SYM_BUCKET_SHIFT;
+    built       = true;
+
+    if ( syms.empty( )) return;
+
+    bucketBase  = syms.front( ).adr & ~(( 1LL << bucketShift ) - 1 );
+    lastAdr     = syms.back( ).adr;
+
+    while ((( lastAdr - bucketBase ) >> bucketShift ) >= T64_SYM_MAX_BUCKETS ) bucketShift++;
+
+    int nBuckets    = (int) (( lastAdr - bucketBase ) >> bucketShift ) + 1;
+    int n           = (int) syms.size( );
+    int k           = 0;
+
+    buckets.resize( nBuckets + 1 );
+
+    for ( int b = 0; b < nBuckets; b++ ) {
+
+        T64Word start = bucketBase + ((T64Word) b << bucketShift );
+
+        while (( k < n ) && ( syms[ k ].adr < start )) k++;
+        buckets[ b ] = k;
+    }
+
+    buckets[ nBuckets ] = n;
+}
+
+//----------------------------------------------------------------------------------------
+// Load the symbols of an ELF file. The table is cleared and filled with the
+// function, object and untyped symbols of the symbol table sections. Undefined
+// and absolute symbols have no address in the program and are skipped. We
+// return false when the file cannot be read, the table is then empty. A caller
+// that already has the file loaded passes its reader, the file is then not 
+// read a second time.
+//
+//----------------------------------------------------------------------------------------
+bool T64SymTab::loadElf( const char *fileName ) {
+
+    elfio reader;
+
+    if ( ! reader.load( fileName )) {
+
+        clear( );
+        return( false );
+    }
+
+    return( loadElf( reader ));
+}
+
+bool T64SymTab::loadElf( const elfio &reader ) {
+
+    clear( );
+
+    for ( int i = 0; i < (int) reader.sections.size( ); i++ ) {
+
+        section *sec = reader.sections[ i ];
+
+        if ( sec -> get_type( ) != SHT_SYMTAB ) continue;
+
+        symbol_section_accessor symbols( reader, sec );
+
+        for ( Elf_Xword k = 0; k < symbols.get_symbols_num( ); k++ ) {
+
+            std::string     name;
+            Elf64_Addr      value       = 0;
+            Elf_Xword       size        = 0;
+            unsigned char   bind        = 0;
+            unsigned char   type        = 0;
+            Elf_Half        secIndex    = 0;
+            unsigned char   other       = 0;
+
+            if ( ! symbols.get_symbol( k, name, value, size, bind, type, secIndex, other )) continue;
+
+            if (( secIndex == SHN_UNDEF ) || ( secIndex == SHN_ABS )) continue;
+
+            if (( type == STT_FUNC ) || ( type == STT_OBJECT ) || ( type == STT_NOTYPE )) {
+
+                add( name.c_str( ), (T64Word) value, (T64Word) size );
+            }
+        }
+    }
+
+    build( );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Lookups. For an address, we find its bucket and search the symbols of the
+// bucket for the last one at or below the address. When there is none, it is
+// the last symbol of an earlier bucket, which is the one just before the
+// bucket's first symbol. The name and the offset into the symbol are returned,
+// or a null pointer when the address has no symbol.
+//
+//----------------------------------------------------------------------------------------
+int T64SymTab::getCount( ) {
+
+    return((int) syms.size( ));
+}
+
+const char *T64SymTab::lookup( T64Word adr, T64Word *ofs ) {
+
+    if (( ! built ) || ( syms.empty( )) || ( adr < syms.front( ).adr )) return( nullptr );
+
+    int index = (int) syms.size( ) - 1;
+
+    if ( adr <= lastAdr ) {
+
+        int b   = (int) (( adr - bucketBase ) >> bucketShift );
+        auto it = std::upper_bound( syms.begin( ) + buckets[ b ],
+                                    syms.begin( ) + buckets[ b + 1 ],
+                                    adr,
+                                    []( T64Word a, const T64Symbol &s ) {
+
+                        return( a < s.adr );
+                    });
+
+        index = (int) ( it - syms.begin( )) - 1;
+    }
+
+    const T64Symbol &sym = syms[ index ];
+
+    if (( sym.size > 0 ) && ( adr >= sym.adr + sym.size )) return( nullptr );
+
+    if ( ofs != nullptr ) *ofs = adr - sym.adr;
+    return( &names[ sym.nameOfs ] );
+}
+
+bool T64SymTab::find( const char *name, T64Word *adr ) {
+
+    auto it = byName.find( name );
+    if ( it == byName.end( )) return( false );
+
+    *adr = it -> second;
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Format an address as "name" or "name+0x<ofs>". We return the length of the
+// string, zero when there is no symbol for the address.
+//
+//----------------------------------------------------------------------------------------
+int T64SymTab::formatAdr( char *buf, int bufLen, T64Word adr ) {
+
+    T64Word     ofs     = 0;
+    const char  *name   = lookup( adr, &ofs );
+    int         len     = 0;
+
+    if ( bufLen > 0 ) buf[ 0 ] = 0;
+    if ( name == nullptr ) return( 0 );
+
+    if ( ofs == 0 ) len = snprintf( buf, bufLen, "%s", name );
+    else            len = snprintf( buf, bufLen, "%s+0x%" PRIx64, name, (uint64_t) ofs );
+
+    return(( len < bufLen ) ? len : bufLen - 1 );
+}
@@ -0,0 +1,84 @@
+//----------------------------------------------------------------------------------------
+//
+//  Twin64Sim - A 64-bit CPU Simulator - Symbol table
+//
+//----------------------------------------------------------------------------------------
+// The symbol table maps addresses to the symbols of a program and symbol names
+// to their values. The symbols are typically loaded from the symbol table of an
+// ELF file. Once built, the symbols are kept in an array sorted by address. An
+// address lookup uses a bucket array with an entry for each page in the range
+// of symbol addresses, which gives the first symbol at or above the start of
+// the page. A lookup thus only searches the few symbols on one page, so that
+// symbolizing long listings, traces and profiles stays fast.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin64Sim - A 64-bit CPU Simulator - Symbol table
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You
+// should have received a copy of the GNU General Public License along with this
+// program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#pragma once
+#include "T64-Common.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace ELFIO { class elfio; }
+
+//----------------------------------------------------------------------------------------
+// Symbol table. Symbols are added and then the table is built, only a built
+// table answers lookups. An address belongs to the symbol at or before it. A
+// symbol with a size covers only its size, a symbol without a size reaches up
+// to the next symbol. The formatted form of an address is the symbol name and,
+// when not zero, the offset from the symbol start.
+//
+//----------------------------------------------------------------------------------------
+const int T64_SYM_BUCKET_SHIFT  = 12;
+const int T64_SYM_MAX_BUCKETS   = 1024 * 1024;
+
+struct T64Symbol {
+
+    T64Word     adr         = 0;
+    T64Word     size        = 0;
+    uint32_t    nameOfs     = 0;
+};
+
+struct T64SymTab {
+
+    public:
+
+    T64SymTab( );
+
+    void            clear( );
+    bool            add( const char *name, T64Word adr, T64Word size );
+    void            build( );
+    bool            loadElf( const char *fileName );
+    bool            loadElf( const ELFIO::elfio &reader );
+
+    int             getCount( );
+    const char      *lookup( T64Word adr, T64Word *ofs );
+    bool            find( const char *name, T64Word *adr );
+    int             formatAdr( char *buf, int bufLen, T64Word adr );
+
+    private:
+
+    std::vector<T64Symbol>                      syms;
+    std::vector<char>                           names;
+    std::vector<int>                            buckets;
+    std::unordered_map<std::string, T64Word>    byName;
+    T64Word                                     bucketBase  = 0;
+    T64Word                                     lastAdr     = 0;
+    int                                         bucketShift = T64_SYM_BUCKET_SHIFT;
+    bool                                        built       = false;
+};
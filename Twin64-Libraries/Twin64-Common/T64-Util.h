@@ -170,6 +170,216 @@ inline bool copyEndianAware( uint8_t *dst, uint8_t *src, int len ) {
     return( true );
 }
 
+//----------------------------------------------------------------------------------------
+// "loadDataItem" and "storeDataItem" access a data item of 1, 2, 4 or 8 bytes
+// in host memory that is shared between processor threads. The address must
+// be aligned to the item length. An aligned item is accessed with a single
+// host load or store, so a concurrent access by another thread will never see
+// a partially written item. No ordering beyond the item itself is implied.
+//
+//----------------------------------------------------------------------------------------
+#if defined(_MSC_VER)
+  #define T64_LOAD_ITEM( type, ptr )        ( *((volatile type *) ( ptr )))
+  #define T64_STORE_ITEM( type, ptr, val )  ( *((volatile type *) ( ptr )) = ( val ))
+#else
+  #define T64_LOAD_ITEM( type, ptr )        __atomic_load_n((type *) ( ptr ), __ATOMIC_RELAXED )
+  #define T64_STORE_ITEM( type, ptr, val )  __atomic_store_n((type *) ( ptr ), ( val ), __ATOMIC_RELAXED )
+#endif
+
+inline void loadDataItem( uint8_t *dst, uint8_t *src, int len ) {
+
+    switch ( len ) {
+
+        case 1: *dst = T64_LOAD_ITEM( uint8_t, src ); break;
+
+        case 2: {
+
+            uint16_t val = T64_LOAD_ITEM( uint16_t, src );
+            memcpy( dst, &val, sizeof( val ));
+
+        } break;
+
+        case 4: {
+
+            uint32_t val = T64_LOAD_ITEM( uint32_t, src );
+            memcpy( dst, &val, sizeof( val ));
+
+        } break;
+
+        case 8: {
+
+            uint64_t val = T64_LOAD_ITEM( uint64_t, src );
+            memcpy( dst, &val, sizeof( val ));
+
+        } break;
+
+        default: memcpy( dst, src, len );
+    }
+}
+
+inline void storeDataItem( uint8_t *dst, uint8_t *src, int len ) {
+
+    switch ( len ) {
+
+        case 1: T64_STORE_ITEM( uint8_t, dst, *src ); break;
+
+        case 2: {
+
+            uint16_t val;
+            memcpy( &val, src, sizeof( val ));
+            T64_STORE_ITEM( uint16_t, dst, val );
+
+        } break;
+
+        case 4: {
+
+            uint32_t val;
+            memcpy( &val, src, sizeof( val ));
+            T64_STORE_ITEM( uint32_t, dst, val );
+
+        } break;
+
+        case 8: {
+
+            uint64_t val;
+            memcpy( &val, src, sizeof( val ));
+            T64_STORE_ITEM( uint64_t, dst, val );
+
+        } break;
+
+        default: memcpy( dst, src, len );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// "casDataItem" replaces an aligned data item in shared host memory with the 
+// new data only when it still holds the expected data. The comparison and the
+// store are one host atomic operation, a store by another thread happens either
+// before, and the comparison fails, or after. We return true when the item was
+// written.
+//
+//----------------------------------------------------------------------------------------
+#if defined(_MSC_VER)
+  #include <atomic>
+  #define T64_CAS_ITEM( type, ptr, exp, val ) \
+    ( std::atomic_ref<type>( *((type *) ( ptr ))).compare_exchange_strong( exp, val ))
+#else
+  #define T64_CAS_ITEM( type, ptr, exp, val ) \
+    __atomic_compare_exchange_n((type *) ( ptr ), &( exp ), ( val ), false, \
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST )
+#endif
+
+template <typename T>
+inline bool casItem( uint8_t *dst, const uint8_t *expected, const uint8_t *src ) {
+
+    T exp;
+    T val;
+
+    memcpy( &exp, expected, sizeof( T ));
+    memcpy( &val, src, sizeof( T ));
+
+    return( T64_CAS_ITEM( T, dst, exp, val ));
+}
+
+inline bool casDataItem( uint8_t *dst, const uint8_t *expected, const uint8_t *src, int len ) {
+
+    switch ( len ) {
+
+        case 1:  return( casItem<uint8_t>( dst, expected, src ));
+        case 2:  return( casItem<uint16_t>( dst, expected, src ));
+        case 4:  return( casItem<uint32_t>( dst, expected, src ));
+        case 8:  return( casItem<uint64_t>( dst, expected, src ));
+        default: return( false );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Big endian accessors specialized at compile time for the data item length. 
+// Memory holds the data in big endian format. "loadBigEndian" reads an item of
+// LEN bytes and returns it right justified in host order, "storeBigEndian" 
+// does the reverse. The shared variants access the item with a single host 
+// load or store, just like "loadDataItem" and "storeDataItem". The processor 
+// data path uses these routines instead of the length switch in the routines 
+// above, the byte swap is a single host instruction.
+//
+//----------------------------------------------------------------------------------------
+template <int LEN>
+inline T64Word loadBigEndian( const uint8_t *src ) {
+
+    static_assert(( LEN == 1 ) || ( LEN == 2 ) || ( LEN == 4 ) || ( LEN == 8 ));
+
+    if constexpr ( LEN == 1 ) {
+
+        return( *src );
+    }
+    else if constexpr ( LEN == 2 ) {
+
+        uint16_t val;
+        memcpy( &val, src, sizeof( val ));
+        return( toBigEndian16( val ));
+    }
+    else if constexpr ( LEN == 4 ) {
+
+        uint32_t val;
+        memcpy( &val, src, sizeof( val ));
+        return( toBigEndian32( val ));
+    }
+    else {
+
+        uint64_t val;
+        memcpy( &val, src, sizeof( val ));
+        return((T64Word) toBigEndian64( val ));
+    }
+}
+
+template <int LEN>
+inline void storeBigEndian( uint8_t *dst, T64Word data ) {
+
+    static_assert(( LEN == 1 ) || ( LEN == 2 ) || ( LEN == 4 ) || ( LEN == 8 ));
+
+    if constexpr ( LEN == 1 ) {
+
+        *dst = (uint8_t) data;
+    }
+    else if constexpr ( LEN == 2 ) {
+
+        uint16_t val = toBigEndian16((uint16_t) data );
+        memcpy( dst, &val, sizeof( val ));
+    }
+    else if constexpr ( LEN == 4 ) {
+
+        uint32_t val = toBigEndian32((uint32_t) data );
+        memcpy( dst, &val, sizeof( val ));
+    }
+    else {
+
+        uint64_t val = toBigEndian64((uint64_t) data );
+        memcpy( dst, &val, sizeof( val ));
+    }
+}
+
+template <int LEN>
+inline T64Word loadSharedBigEndian( uint8_t *src ) {
+
+    static_assert(( LEN == 1 ) || ( LEN == 2 ) || ( LEN == 4 ) || ( LEN == 8 ));
+
+    if constexpr ( LEN == 1 )       return( T64_LOAD_ITEM( uint8_t, src ));
+    else if constexpr ( LEN == 2 )  return( toBigEndian16( T64_LOAD_ITEM( uint16_t, src )));
+    else if constexpr ( LEN == 4 )  return( toBigEndian32( T64_LOAD_ITEM( uint32_t, src )));
+    else                            return((T64Word) toBigEndian64( T64_LOAD_ITEM( uint64_t, src )));
+}
+
+template <int LEN>
+inline void storeSharedBigEndian( uint8_t *dst, T64Word data ) {
+
+    static_assert(( LEN == 1 ) || ( LEN == 2 ) || ( LEN == 4 ) || ( LEN == 8 ));
+
+    if constexpr ( LEN == 1 )       T64_STORE_ITEM( uint8_t, dst, (uint8_t) data );
+    else if constexpr ( LEN == 2 )  T64_STORE_ITEM( uint16_t, dst, toBigEndian16((uint16_t) data ));
+    else if constexpr ( LEN == 4 )  T64_STORE_ITEM( uint32_t, dst, toBigEndian32((uint32_t) data ));
+    else                            T64_STORE_ITEM( uint64_t, dst, toBigEndian64((uint64_t) data ));
+}
+
 //----------------------------------------------------------------------------------------
 // We often need a portion of a memory mapped register. These registers are 
 // T64Words, stored in the simulator endianess. When we display them as memory,
@@ -178,8 +388,10 @@ inline bool copyEndianAware( uint8_t *dst, uint8_t *src, int len ) {
 //----------------------------------------------------------------------------------------
 inline void copyFromReg( uint8_t *dst, T64Word reg, int ofs, int len ) {
 
-    copyEndianAware((uint8_t *) &reg, (uint8_t *) &reg, sizeof( T64Word ));
-    memcpy( dst,  ((uint8_t *) &reg + ofs % sizeof( T64Word )), len );
+    uint8_t buf[ sizeof( T64Word ) ];
+
+    storeBigEndian<sizeof( T64Word )>( buf, reg );
+    memcpy( dst, buf + ofs % sizeof( T64Word ), len );
 }
 
 //----------------------------------------------------------------------------------------
@@ -583,6 +795,17 @@ inline uint8_t tlbInfoPageSize( T64Word tlbInfo ) {
     return( tlbInfo & 0xF );
 }
 
+//----------------------------------------------------------------------------------------
+// Set index of a set associative TLB. Each page size has its own index, 
+// computed from the virtual page number for that page size. The number of sets
+// is a power of two.
+//
+//----------------------------------------------------------------------------------------
+inline int tlbSetIndex( T64Word vAdr, int pSize, int sets ) {
+
+    return((int) (( vAdr >> ( T64_PAGE_OFS_BITS + pSize * 4 )) & ( sets - 1 )));
+}
+
 //----------------------------------------------------------------------------------------
 // Address arithmetic. Address are computed using an unsigned 32-bit arithmetic.
 // The address "adr" is a 64 bit address to which we will add in the offset 
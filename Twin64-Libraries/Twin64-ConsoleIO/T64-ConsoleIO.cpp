@@ -54,17 +54,102 @@ void restoreTerminal( ) {
 #endif
 
 //----------------------------------------------------------------------------------------
-// The output buffer. We actually have two buffers. The first is the standard
-// output buffer used with MAC and Linux, the second is the wide character 
-// buffer for windows.
+// The output buffers. The first is the format buffer for a single write call. 
+// The characters are then collected in the write buffer, which is sent to the 
+// terminal as a whole. On windows, there is the wide character buffer in 
+// addition.
 //
 //----------------------------------------------------------------------------------------
+const int   WRITE_BUF_SIZE = 64 * 1024;
+
 char        outputBuffer[ 1024 ];
+char        writeBuffer[ WRITE_BUF_SIZE ];
+int         writeLen = 0;
 
 #ifdef _WIN32
-wchar_t     wideBuf[ 1024 ];
+wchar_t     wideBuf[ WRITE_BUF_SIZE ];
 #endif
 
+//----------------------------------------------------------------------------------------
+// Send the write buffer to the terminal. On Mac or Linux, we still try to send 
+// out the data in batches to the terminal emulator for better stability. In 
+// Windows we additionally face the issue handling wide characters. The code 
+// below uses UTF16 characters when printing. The routine is also registered to
+// run at program exit, so that no output is lost.
+//
+//----------------------------------------------------------------------------------------
+void flushOutput( ) {
+
+    if ( writeLen <= 0 ) return;
+
+    #if __APPLE__ || __linux__
+
+    const char  *p          = writeBuffer;
+    size_t      remaining   = writeLen;
+
+    while ( remaining > 0   ) {
+
+        ssize_t n = write( STDOUT_FILENO, p, remaining );
+
+        if (( n < 0 ) && ( errno == EINTR )) continue;
+        if ( n <= 0 ) break;
+        
+        p         += n;
+        remaining -= n;
+    }
+
+    tcdrain( STDOUT_FILENO );
+   
+    #else
+
+    int wlen = MultiByteToWideChar( CP_UTF8,
+                                    0,
+                                    writeBuffer,
+                                    writeLen,
+                                    wideBuf,
+                                    sizeof(wideBuf) / sizeof( wideBuf[0] )
+    );
+
+    DWORD written;
+
+    WriteConsoleW( GetStdHandle(STD_OUTPUT_HANDLE),
+                   wideBuf,
+                   wlen,
+                   &written,
+                   NULL
+                 );
+
+    #endif
+
+    writeLen = 0;
+}
+
+void appendOutput( const char *buf, int len ) {
+
+    if ( writeLen + len > WRITE_BUF_SIZE ) flushOutput( );
+
+    memcpy( writeBuffer + writeLen, buf, len );
+    writeLen += len;
+}
+
+//----------------------------------------------------------------------------------------
+// Escape sequence parser states for the screen frame.
+//
+//----------------------------------------------------------------------------------------
+enum FrameEscState : int {
+
+    ESC_NONE    = 0,
+    ESC_START   = 1,
+    ESC_CSI     = 2
+};
+
+bool sameCell( SimScreenCell *a, SimScreenCell *b ) {
+
+    return(( a -> len == b -> len ) && 
+           ( a -> attr == b -> attr ) && 
+           ( memcmp( a -> glyph, b -> glyph, a -> len ) == 0 ));
+}
+
 //----------------------------------------------------------------------------------------
 // Sometimes we need to delay a little, and sure enough WIN and Mac have different 
 // routines to do so.
@@ -93,9 +178,15 @@ SimConsoleIO::SimConsoleIO( ) {
     atexit( restoreTerminal );
 
     #endif  
+
+    atexit( flushOutput );
+    frame = new SimScreenFrame( );
 }
 
 SimConsoleIO::~SimConsoleIO( ) {
+
+    flushOutput( );
+    delete frame;
     
     #if __APPLE__
 
@@ -251,6 +342,8 @@ void SimConsoleIO::setBlockingMode( bool enabled ) {
 //
 //----------------------------------------------------------------------------------------
 int SimConsoleIO::readChar( ) {
+
+    flushOutput( );
     
     #if __APPLE__
 
@@ -279,10 +372,39 @@ int SimConsoleIO::readChar( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// "writeChars" is the single entry point to write to the terminal. On Mac or 
-// Linux, we still try to send out the data in batches to the terminal emulator 
-// for better stability. In Windows we additionally face the issue handling
-// wide characters. The code below uses UTF16 characters when printing.
+// "waitForInput" waits for a keyboard input for at most the time given. We 
+// return true when a character can be read. The output is flushed before we 
+// wait, just as for reading a character. This allows the command interpreter to
+// do something else, such as refreshing the windows, while nothing is typed.
+//
+//----------------------------------------------------------------------------------------
+bool SimConsoleIO::waitForInput( int timeoutMs ) {
+
+    flushOutput( );
+
+    #if __APPLE__
+
+    struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+    return( poll( &pfd, 1, timeoutMs ) > 0 );
+
+    #else
+
+    for ( int waited = 0; waited < timeoutMs; waited += 10 ) {
+
+        if ( _kbhit( )) return( true );
+        Sleep( 10 );
+    }
+
+    return( _kbhit( ) != 0 );
+
+    #endif
+}
+
+//----------------------------------------------------------------------------------------
+// "writeChars" is the single entry point to write to the terminal. The formatted 
+// characters are placed into the write buffer, or into the screen frame while a
+// frame is drawn. Outside a frame, the frame still needs to see the escape 
+// sequences that change the entire screen.
 //
 //----------------------------------------------------------------------------------------
 int SimConsoleIO::writeChars( const char *format, ... ) {
@@ -292,48 +414,599 @@ int SimConsoleIO::writeChars( const char *format, ... ) {
     int len = vsnprintf( outputBuffer, sizeof( outputBuffer ), format, args );
     va_end( args );
 
-     if (len <= 0) return 0;
+    if ( len <= 0 ) return 0;
+    if ( len >= (int) sizeof( outputBuffer )) len = sizeof( outputBuffer ) - 1;
 
-    #if __APPLE__ || __linux__
+    if ( frameMode ) {
 
-    const char  *p          = outputBuffer;
-    size_t      remaining   = len;
+        frame -> putChars( outputBuffer, len );
+    }
+    else {
 
-    while ( remaining > 0   ) {
+        if ( ! frameEmit ) frame -> trackChars( outputBuffer, len );
+        appendOutput( outputBuffer, len );
+    }
 
-        ssize_t n = write( STDOUT_FILENO, p, remaining );
+    return ( len );
+}
 
-        if (( n < 0 ) && ( errno == EINTR )) continue;
-        if ( n <= 0 ) break;
-        
-        p         += n;
-        remaining -= n;
+//----------------------------------------------------------------------------------------
+// A screen redraw is enclosed in a begin and end frame call. The end of the frame
+// sends the changed cells and the entire output in one write to the terminal.
+// "flush" just sends what is in the write buffer.
+//
+//----------------------------------------------------------------------------------------
+void SimConsoleIO::beginFrame( int rows, int cols ) {
+
+    frame -> beginFrame( rows, cols );
+    frameMode = true;
+}
+
+void SimConsoleIO::endFrame( ) {
+
+    if ( ! frameMode ) return;
+
+    frameMode = false;
+    frameEmit = true;
+    frame -> emitFrame( this );
+    frameEmit = false;
+    flushOutput( );
+}
+
+void SimConsoleIO::flush( ) {
+
+    flushOutput( );
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Screen frame routines.
+//
+//----------------------------------------------------------------------------------------
+// The screen frame keeps two grids of cells, the frame currently drawn and the 
+// frame last sent to the terminal. Both grids start empty and grow with the size
+// of the screen. The attribute of a cell is an index into a table of the escape
+// sequences that set the attribute, the first entry is the default setting.
+//
+//----------------------------------------------------------------------------------------
+SimScreenFrame::SimScreenFrame( ) {
+
+    attrTab[ 0 ][ 0 ]   = '\0';
+    attrStr[ 0 ]        = '\0';
+}
+
+SimScreenFrame::~SimScreenFrame( ) {
+
+    free( cur );
+    free( prev );
+    free( touchFirst );
+    free( touchLast );
+}
+
+//----------------------------------------------------------------------------------------
+// Make the grids at least the size passed. The content is kept. We do not know
+// what the terminal shows in the new area, so the next frame sends all cells.
+//
+//----------------------------------------------------------------------------------------
+bool SimScreenFrame::ensureSize( int rows, int cols ) {
+
+    if ( rows > MAX_FRAME_ROWS ) rows = MAX_FRAME_ROWS;
+    if ( cols > MAX_FRAME_COLS ) cols = MAX_FRAME_COLS;
+    if ( rows < this -> rows ) rows = this -> rows;
+    if ( cols < this -> cols ) cols = this -> cols;
+
+    if (( rows == this -> rows ) && ( cols == this -> cols )) return( false );
+
+    SimScreenCell   *newCur     = (SimScreenCell *) calloc( rows * cols, sizeof( SimScreenCell ));
+    SimScreenCell   *newPrev    = (SimScreenCell *) calloc( rows * cols, sizeof( SimScreenCell ));
+    int             *newFirst   = (int *) malloc( rows * sizeof( int ));
+    int             *newLast    = (int *) malloc( rows * sizeof( int ));
+
+    for ( int r = 0; r < rows; r++ ) {
+
+        newFirst[ r ]   = cols;
+        newLast[ r ]    = -1;
+
+        for ( int c = 0; c < cols; c++ ) {
+
+            SimScreenCell *cCell = &newCur[ r * cols + c ];
+            SimScreenCell *pCell = &newPrev[ r * cols + c ];
+
+            if (( r < this -> rows ) && ( c < this -> cols )) {
+
+                *cCell = cur[ r * this -> cols + c ];
+                *pCell = prev[ r * this -> cols + c ];
+            }
+            else {
+
+                cCell -> glyph[ 0 ] = ' ';
+                cCell -> len        = 1;
+                *pCell              = *cCell;
+            }
+        }
+
+        if ( r < this -> rows ) {
+
+            newFirst[ r ]   = touchFirst[ r ];
+            newLast[ r ]    = touchLast[ r ];
+        }
     }
 
-    tcdrain( STDOUT_FILENO );
-   
-    #else
+    free( cur );
+    free( prev );
+    free( touchFirst );
+    free( touchLast );
+
+    cur         = newCur;
+    prev        = newPrev;
+    touchFirst  = newFirst;
+    touchLast   = newLast;
+    lastCell    = -1;
+    lost        = true;
+
+    this -> rows = rows;
+    this -> cols = cols;
+    return( true );
+}
 
-    int wlen = MultiByteToWideChar( CP_UTF8,
-                                    0,
-                                    outputBuffer,
-                                    len,
-                                    wideBuf,
-                                    sizeof(wideBuf) / sizeof( wideBuf[0] )
-    );
+//----------------------------------------------------------------------------------------
+// Start a new frame. The new frame is the previous frame, the windows then draw
+// over it what they show now.
+//
+//----------------------------------------------------------------------------------------
+void SimScreenFrame::beginFrame( int rows, int cols ) {
 
-    DWORD written;
+    ensureSize( rows, cols );
+    passLen = 0;
+}
 
-    WriteConsoleW( GetStdHandle(STD_OUTPUT_HANDLE),
-                   wideBuf,
-                   wlen,
-                   &written,
-                   NULL
-                 );
+//----------------------------------------------------------------------------------------
+// Characters written during the frame, and characters written outside of it. 
+// Outside a frame, we only look for the escape sequences that set the screen 
+// size, the scroll area or clear the screen.
+//
+//----------------------------------------------------------------------------------------
+void SimScreenFrame::putChars( const char *buf, int len ) {
 
-    #endif
+    parseChars( buf, len, false );
+}
 
-    return ( len );
+void SimScreenFrame::trackChars( const char *buf, int len ) {
+
+    parseChars( buf, len, true );
+}
+
+//----------------------------------------------------------------------------------------
+// The character parser. We understand the control characters and escape 
+// sequences the formatter routines emit. UTF-8 continuation bytes are appended
+// to the cell written last, a cell holds a character of up to four bytes.
+//
+//----------------------------------------------------------------------------------------
+void SimScreenFrame::parseChars( const char *buf, int len, bool track ) {
+
+    for ( int i = 0; i < len; i++ ) {
+
+        uint8_t ch = (uint8_t) buf[ i ];
+
+        if ( escState == ESC_START ) {
+
+            if ( ch == '[' ) {
+
+                escBuf[ escLen++ ] = ch;
+                escState = ESC_CSI;
+            }
+            else {
+
+                escBuf[ escLen++ ] = ch;
+                escState = ESC_NONE;
+
+                if ( ! track ) {
+
+                    addPassThrough( );
+                    lost = true;
+                }
+            }
+        }
+        else if ( escState == ESC_CSI ) {
+
+            if ( escLen < (int) sizeof( escBuf ) - 1 ) escBuf[ escLen++ ] = ch;
+
+            if (( ch >= 0x40 ) && ( ch <= 0x7E )) {
+
+                escState = ESC_NONE;
+                doEscSeq( ch, track );
+            }
+        }
+        else if ( ch == 0x1B ) {
+
+            escBuf[ 0 ] = ch;
+            escLen      = 1;
+            escState    = ESC_START;
+        }
+        else if ( track ) {
+
+            continue;
+        }
+        else if ( ch == '\r' ) {
+
+            curCol      = 0;
+            lastCell    = -1;
+        }
+        else if ( ch == '\n' ) {
+
+            curRow ++;
+            lastCell    = -1;
+        }
+        else if ( ch == '\b' ) {
+
+            if ( curCol > 0 ) curCol --;
+            lastCell = -1;
+        }
+        else if ( ch == '\t' ) {
+
+            curCol      = ( curCol + 8 ) & ~7;
+            lastCell    = -1;
+        }
+        else if ( ch >= 0x20 ) putGlyph( ch );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Handle an escape sequence. The CSI parameters are at most two numbers, a 
+// missing parameter is a zero. The attribute sequences are collected into the 
+// current attribute string, a reset starts a new one.
+//
+//----------------------------------------------------------------------------------------
+void SimScreenFrame::doEscSeq( char cmd, bool track ) {
+
+    int args[ 2 ]   = { 0, 0 };
+    int argCount    = 0;
+
+    for ( int i = 2; ( i < escLen - 1 ) && ( argCount < 2 ); i++ ) {
+
+        if      ( isdigit( escBuf[ i ] )) args[ argCount ] = args[ argCount ] * 10 + ( escBuf[ i ] - '0' );
+        else if ( escBuf[ i ] == ';' )    argCount ++;
+    }
+
+    if ( track ) {
+
+        if      ( cmd == 'J' ) clearFrame( );
+        else if ( cmd == 'r' ) { scrollTop = args[ 0 ]; scrollBottom = args[ 1 ]; }
+        else if (( cmd == 't' ) && ( args[ 0 ] == 8 )) ensureSize( args[ 1 ], cols );
+
+        return;
+    }
+
+    switch ( cmd ) {
+
+        case 'H': {
+
+            curRow = ( args[ 0 ] > 0 ) ? args[ 0 ] - 1 : 0;
+            curCol = ( args[ 1 ] > 0 ) ? args[ 1 ] - 1 : 0;
+
+        } break;
+
+        case 'G': curCol = ( args[ 0 ] > 0 ) ? args[ 0 ] - 1 : 0; break;
+        case 'C': curCol += ( args[ 0 ] > 0 ) ? args[ 0 ] : 1; break;
+
+        case 'D': {
+
+            curCol -= ( args[ 0 ] > 0 ) ? args[ 0 ] : 1;
+            if ( curCol < 0 ) curCol = 0;
+
+        } break;
+
+        case 'K': {
+
+            if      ( args[ 0 ] == 2 ) clearCells( curRow, 0, cols - 1 );
+            else if ( args[ 0 ] == 1 ) clearCells( curRow, 0, curCol );
+            else                       clearCells( curRow, curCol, cols - 1 );
+
+        } break;
+
+        case 'J': {
+
+            addPassThrough( );
+            clearFrame( );
+
+        } break;
+
+        case 'm': {
+
+            if (( escLen <= 3 ) || (( escLen == 4 ) && ( escBuf[ 2 ] == '0' ))) {
+
+                attrStr[ 0 ] = '\0';
+            }
+            else {
+
+                int sLen = (int) strlen( attrStr );
+
+                if ( sLen + escLen < MAX_FRAME_ATTR_LEN ) {
+
+                    memcpy( attrStr + sLen, escBuf, escLen );
+                    attrStr[ sLen + escLen ] = '\0';
+                }
+            }
+
+            attrValid = false;
+
+        } break;
+
+        case 'r': {
+
+            addPassThrough( );
+            scrollTop       = args[ 0 ];
+            scrollBottom    = args[ 1 ];
+
+        } break;
+
+        case 't': {
+
+            addPassThrough( );
+            if ( args[ 0 ] == 8 ) ensureSize( args[ 1 ], cols );
+
+        } break;
+
+        default: {
+
+            addPassThrough( );
+            lost = true;
+        }
+    }
+
+    lastCell = -1;
+}
+
+//----------------------------------------------------------------------------------------
+// Pass the escape sequence just parsed to the terminal. When the buffer is full, 
+// the sequence is lost and so is our knowledge of the screen.
+//
+//----------------------------------------------------------------------------------------
+void SimScreenFrame::addPassThrough( ) {
+
+    if ( passLen + escLen < MAX_FRAME_PASS_LEN ) {
+
+        memcpy( passBuf + passLen, escBuf, escLen );
+        passLen += escLen;
+    }
+    else lost = true;
+}
+
+//----------------------------------------------------------------------------------------
+// The attribute index for the current attribute string. The string is looked up
+// when a cell is written after an attribute change. When the table is full, the 
+// default attribute is used.
+//
+//----------------------------------------------------------------------------------------
+int SimScreenFrame::curAttrIndex( ) {
+
+    if ( attrValid ) return( attrIndex );
+
+    attrIndex = 0;
+    attrValid = true;
+
+    for ( int i = 0; i < attrCount; i++ ) {
+
+        if ( strcmp( attrTab[ i ], attrStr ) == 0 ) {
+
+            attrIndex = i;
+            return( attrIndex );
+        }
+    }
+
+    if ( attrCount < MAX_FRAME_ATTR ) {
+
+        strcpy( attrTab[ attrCount ], attrStr );
+        attrIndex = attrCount++;
+    }
+
+    return( attrIndex );
+}
+
+//----------------------------------------------------------------------------------------
+// Write a character at the cursor position and advance the cursor. Characters 
+// beyond the largest screen size are dropped.
+//
+//----------------------------------------------------------------------------------------
+void SimScreenFrame::putGlyph( uint8_t ch ) {
+
+    if (( ch >= 0x80 ) && ( ch < 0xC0 )) {
+
+        if (( lastCell >= 0 ) && ( cur[ lastCell ].len < 4 )) {
+
+            cur[ lastCell ].glyph[ cur[ lastCell ].len++ ] = ch;
+        }
+
+        return;
+    }
+
+    ensureSize( curRow + 1, curCol + 1 );
+
+    if (( curRow >= rows ) || ( curCol >= cols )) {
+
+        lastCell = -1;
+        curCol ++;
+        return;
+    }
+
+    lastCell = curRow * cols + curCol;
+
+    memset( cur[ lastCell ].glyph, 0, sizeof( cur[ lastCell ].glyph ));
+    cur[ lastCell ].glyph[ 0 ]  = ch;
+    cur[ lastCell ].len         = 1;
+    cur[ lastCell ].attr        = curAttrIndex( );
+
+    touchCells( curRow, curCol, curCol );
+    curCol ++;
+}
+
+//----------------------------------------------------------------------------------------
+// Clear a range of cells in a row. The cleared cells get the current attribute, 
+// just like the terminal would do it.
+//
+//----------------------------------------------------------------------------------------
+void SimScreenFrame::clearCells( int row, int first, int last ) {
+
+    ensureSize( row + 1, cols );
+
+    if (( row < 0 ) || ( row >= rows )) return;
+    if ( last >= cols ) last = cols - 1;
+    if ( first > last ) return;
+
+    int attr = curAttrIndex( );
+
+    for ( int c = first; c <= last; c++ ) {
+
+        SimScreenCell *cell = &cur[ row * cols + c ];
+
+        cell -> glyph[ 0 ]  = ' ';
+        cell -> len         = 1;
+        cell -> attr        = attr;
+    }
+
+    touchCells( row, first, last );
+}
+
+//----------------------------------------------------------------------------------------
+// The screen was cleared. Both grids are blank now and match the terminal again.
+//
+//----------------------------------------------------------------------------------------
+void SimScreenFrame::clearFrame( ) {
+
+    for ( int i = 0; i < rows * cols; i++ ) {
+
+        cur[ i ].glyph[ 0 ] = ' ';
+        cur[ i ].len        = 1;
+        cur[ i ].attr       = 0;
+        prev[ i ]           = cur[ i ];
+    }
+
+    for ( int r = 0; r < rows; r++ ) {
+
+        touchFirst[ r ] = cols;
+        touchLast[ r ]  = -1;
+    }
+
+    lastCell    = -1;
+    lost        = false;
+}
+
+void SimScreenFrame::touchCells( int row, int first, int last ) {
+
+    if ( first < touchFirst[ row ] ) touchFirst[ row ] = first;
+    if ( last > touchLast[ row ] )   touchLast[ row ]  = last;
+}
+
+bool SimScreenFrame::isScrollRow( int row ) {
+
+    return(( scrollTop > 0 ) && ( row + 1 >= scrollTop ) && ( row + 1 <= scrollBottom ));
+}
+
+//----------------------------------------------------------------------------------------
+// Emit the frame. The passed through escape sequences go first. Then, for each 
+// row, we find the range of cells to send. In a scroll area row, these are the 
+// cells written in this frame, in the other rows the cells that differ from the 
+// previous frame. The cell characters are collected in a local buffer, setting 
+// the attribute only when it changes. Blank cells at the end of a row are 
+// cleared with a single escape sequence. Finally, the cursor position and the 
+// attribute setting are restored to where the drawing left them.
+//
+//----------------------------------------------------------------------------------------
+void SimScreenFrame::emitFrame( SimFormatter *out ) {
+
+    char    runBuf[ 512 ];
+    int     runLen      = 0;
+    int     outAttr     = -1;
+
+    if ( passLen > 0 ) out -> writeChars( "%.*s", passLen, passBuf );
+
+    for ( int r = 0; r < rows; r++ ) {
+
+        SimScreenCell   *rowCells   = &cur[ r * cols ];
+        SimScreenCell   *prevCells  = &prev[ r * cols ];
+        int             first       = 0;
+        int             last        = cols - 1;
+
+        if ( isScrollRow( r )) {
+
+            first   = touchFirst[ r ];
+            last    = touchLast[ r ];
+        }
+        else if ( ! lost ) {
+
+            while (( first <= last ) && 
+                   ( sameCell( &rowCells[ first ], &prevCells[ first ] ))) {
+
+                first ++;
+            }
+
+            while (( last >= first ) &&
+                   ( sameCell( &rowCells[ last ], &prevCells[ last ] ))) {
+
+                last --;
+            }
+        }
+
+        touchFirst[ r ] = cols;
+        touchLast[ r ]  = -1;
+
+        if ( first > last ) continue;
+
+        bool clearTail = false;
+
+        if ( last == cols - 1 ) {
+
+            while (( last >= first ) && 
+                   ( rowCells[ last ].attr == 0 ) &&
+                   ( rowCells[ last ].len == 1 ) &&
+                   ( rowCells[ last ].glyph[ 0 ] == ' ' )) {
+                
+                last --;
+                clearTail = true;
+            }
+        }
+
+        out -> setAbsCursor( r + 1, first + 1 );
+
+        for ( int c = first; c <= last; c++ ) {
+
+            SimScreenCell *cell = &rowCells[ c ];
+
+            if (( cell -> attr != outAttr ) || ( runLen + 4 > (int) sizeof( runBuf ))) {
+
+                if ( runLen > 0 ) out -> writeChars( "%.*s", runLen, runBuf );
+                runLen = 0;
+
+                if ( cell -> attr != outAttr ) {
+
+                    out -> writeChars( "\x1b[0m%s", attrTab[ cell -> attr ] );
+                    outAttr = cell -> attr;
+                }
+            }
+
+            memcpy( runBuf + runLen, cell -> glyph, cell -> len );
+            runLen += cell -> len;
+        }
+
+        if ( runLen > 0 ) out -> writeChars( "%.*s", runLen, runBuf );
+        runLen = 0;
+
+        if ( clearTail ) {
+
+            if ( outAttr != 0 ) out -> writeChars( "\x1b[0m" );
+            out -> clearToEndOfLine( );
+            outAttr = 0;
+        }
+    }
+
+    out -> writeChars( "\x1b[0m%s", attrStr );
+    out -> setAbsCursor( curRow + 1, curCol + 1 );
+
+    memcpy( prev, cur, rows * cols * sizeof( SimScreenCell ));
+    passLen     = 0;
+    lastCell    = -1;
+    lost        = false;
 }
 
 //****************************************************************************************
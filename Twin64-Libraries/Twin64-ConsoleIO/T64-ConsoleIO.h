@@ -184,6 +184,89 @@ struct SimFormatter {
     char            printBit( T64Word val, int pos, char printChar );
 };
 
+//----------------------------------------------------------------------------------------
+// The screen frame. When the simulator redraws its windows, the output is not sent
+// to the terminal right away. Instead, the characters and escape sequences are 
+// interpreted and placed into a grid of cells, each with the character and the 
+// attribute setting in effect when it was written. At the end of the frame, the
+// grid is compared with the grid of the previous frame and only the changed cells 
+// are sent to the terminal. The rows in the scroll area are also used for the 
+// command line input outside of a frame, we cannot know their content. For them,
+// the cells written during the frame are always sent.
+//
+// Escape sequences that do not write to the screen, such as setting the scroll 
+// area or the window size, are passed through in the order seen. A clear screen 
+// is passed through as well and leaves us with a blank previous frame. Any other
+// sequence is passed through too, but then we no longer know what the screen 
+// shows and the frame sends all cells.
+//
+//----------------------------------------------------------------------------------------
+const int MAX_FRAME_ROWS        = 256;
+const int MAX_FRAME_COLS        = 512;
+const int MAX_FRAME_ATTR        = 512;
+const int MAX_FRAME_ATTR_LEN    = 64;
+const int MAX_FRAME_PASS_LEN    = 1024;
+
+struct SimScreenCell {
+
+    char        glyph[ 4 ];
+    uint8_t     len;
+    uint16_t    attr;
+};
+
+struct SimScreenFrame {
+
+    public:
+
+    SimScreenFrame( );
+    ~SimScreenFrame( );
+
+    void            beginFrame( int rows, int cols );
+    void            putChars( const char *buf, int len );
+    void            trackChars( const char *buf, int len );
+    void            emitFrame( SimFormatter *out );
+
+    private:
+
+    void            parseChars( const char *buf, int len, bool track );
+    void            doEscSeq( char cmd, bool track );
+    void            putGlyph( uint8_t ch );
+    void            clearCells( int row, int first, int last );
+    void            clearFrame( );
+    void            touchCells( int row, int first, int last );
+    bool            ensureSize( int rows, int cols );
+    bool            isScrollRow( int row );
+    int             curAttrIndex( );
+    void            addPassThrough( );
+
+    SimScreenCell   *cur                            = nullptr;
+    SimScreenCell   *prev                           = nullptr;
+    int             *touchFirst                     = nullptr;
+    int             *touchLast                      = nullptr;
+    int             rows                            = 0;
+    int             cols                            = 0;
+    bool            lost                            = true;
+
+    int             curRow                          = 0;
+    int             curCol                          = 0;
+    int             lastCell                        = -1;
+    int             scrollTop                       = 0;
+    int             scrollBottom                    = 0;
+
+    int             escState                        = 0;
+    char            escBuf[ 32 ];
+    int             escLen                          = 0;
+   
+    char            passBuf[ MAX_FRAME_PASS_LEN ];
+    int             passLen                         = 0;
+
+    char            attrTab[ MAX_FRAME_ATTR ][ MAX_FRAME_ATTR_LEN ];
+    int             attrCount                       = 1;
+    char            attrStr[ MAX_FRAME_ATTR_LEN ];
+    int             attrIndex                       = 0;
+    bool            attrValid                       = true;
+};
+
 //----------------------------------------------------------------------------------------
 // Console IO object. The simulator is a character based interface. The typical terminal
 // IO functionality such as buffered data input and output needs to be disabled. We run
@@ -192,6 +275,9 @@ struct SimFormatter {
 // CPU code, the console IO is mapped to a virtual console configured in the IO address
 // space. This interface will also write and read a character at a time.
 //
+// The output is collected in a buffer and sent to the terminal in one write when
+// a frame ends, when the buffer is full and before we wait for input. 
+//
 //----------------------------------------------------------------------------------------
 struct SimConsoleIO : SimFormatter {
     
@@ -205,11 +291,19 @@ struct SimConsoleIO : SimFormatter {
     bool    isConsole( );
     int     getConsoleSize( int *rows, int *cols );
     int     readChar( );
+    bool    waitForInput( int timeoutMs );
     int     writeChars( const char *format, ... );
+
+    void    beginFrame( int rows, int cols );
+    void    endFrame( );
+    void    flush( );
     
     private:
     
-    bool    blockingMode = false;
+    bool            blockingMode    = false;
+    bool            frameMode       = false;
+    bool            frameEmit       = false;
+    SimScreenFrame  *frame          = nullptr;
 };
 
 #endif // T64_ConsoleIO_h
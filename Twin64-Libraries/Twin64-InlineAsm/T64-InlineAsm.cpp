@@ -11,6 +11,15 @@
 // escape when an error is detected. Considering that we only have one line to 
 // parse, there is no need to implement a better parser error recovery method.
 //
+// The program assembler runs the same parser over each line of a source text.
+// Lines can define labels, and identifiers in expressions refer to the symbol
+// table. A line with a forward reference is assembled again at the end, so the
+// source is only tokenized once, except for these lines.
+//
+// The tokenizer and the program context are local to the thread. Assemblers on
+// different threads, such as the test cases of a parallel test run, do not see 
+// each other.
+//
 //----------------------------------------------------------------------------------------
 //
 // T64 - A 64-bit Processor - One Line Assembler
@@ -39,9 +48,10 @@ namespace {
 // General constants.
 //
 //----------------------------------------------------------------------------------------
-const int   MAX_INPUT_LINE_SIZE = 256;
-const int   MAX_TOKEN_NAME_SIZE = 32;
-const char  EOS_CHAR            = 0;
+const int       MAX_INPUT_LINE_SIZE = 256;
+const int       MAX_TOKEN_NAME_SIZE = 32;
+const char      EOS_CHAR            = 0;
+const T64Word   MAX_ASM_IMAGE_SIZE  = 256 * 1024 * 1024;
 
 //----------------------------------------------------------------------------------------
 // Assembler error codes.
@@ -81,7 +91,18 @@ enum ErrId : int {
     ERR_EXPR_TYPE_MATCH             = 40,
     ERR_NUMERIC_OVERFLOW            = 41,
     ERR_IMM_VAL_RANGE               = 42,
-    ERR_DUPLICATE_INSTR_OPT         = 43
+    ERR_DUPLICATE_INSTR_OPT         = 43,
+    ERR_IDENT_TOO_LONG              = 44,
+    ERR_LINE_TOO_LONG               = 45,
+
+    ERR_DUPLICATE_SYMBOL            = 50,
+    ERR_UNDEFINED_SYMBOL            = 51,
+    ERR_INVALID_DIRECTIVE           = 52,
+    ERR_EXPECTED_IDENT              = 53,
+    ERR_EXPECTED_COLON              = 54,
+    ERR_IMAGE_ADR_RANGE             = 55,
+    ERR_INSTR_ALIGNMENT             = 56,
+    ERR_FILE_OPEN                   = 57
 };
 
 //----------------------------------------------------------------------------------------
@@ -128,7 +149,18 @@ const ErrMsg ErrMsgTable[ ] = {
    
     { ERR_EXPR_TYPE_MATCH ,         (char *) "Expression type mismatch" },
     { ERR_IMM_VAL_RANGE,            (char *) "Value range error " },
-    { ERR_DUPLICATE_INSTR_OPT,      (char *) "Duplicate Instruction option " }
+    { ERR_DUPLICATE_INSTR_OPT,      (char *) "Duplicate Instruction option " },
+    { ERR_IDENT_TOO_LONG,           (char *) "Identifier is too long" },
+    { ERR_LINE_TOO_LONG,            (char *) "Input line is too long" },
+
+    { ERR_DUPLICATE_SYMBOL,         (char *) "Duplicate symbol" },
+    { ERR_UNDEFINED_SYMBOL,         (char *) "Undefined symbol" },
+    { ERR_INVALID_DIRECTIVE,        (char *) "Invalid directive" },
+    { ERR_EXPECTED_IDENT,           (char *) "Expected an identifier" },
+    { ERR_EXPECTED_COLON,           (char *) "Expected a colon" },
+    { ERR_IMAGE_ADR_RANGE,          (char *) "Address outside the program image" },
+    { ERR_INSTR_ALIGNMENT,          (char *) "Instruction is not word aligned" },
+    { ERR_FILE_OPEN,                (char *) "Cannot open the source file" }
 };
 
 const int MAX_ERR_MSG_TAB = sizeof( ErrMsgTable ) / sizeof( ErrMsg );
@@ -163,7 +195,7 @@ enum TokId : int {
     //------------------------------------------------------------------------------------
     TOK_NIL         = 0,    TOK_ERR         = 1,    TOK_EOS         = 2,        
     TOK_COMMA       = 3,    TOK_PERIOD      = 4,    TOK_LPAREN      = 5,
-    TOK_RPAREN      = 6,    TOK_PLUS        = 8,    TOK_MINUS       = 9,        
+    TOK_RPAREN      = 6,    TOK_COLON       = 7,    TOK_PLUS        = 8,    TOK_MINUS       = 9,        
     TOK_MULT        = 10,   TOK_DIV         = 11,   TOK_MOD         = 12,       
     TOK_REM         = 13,   TOK_NEG         = 14,   TOK_AND         = 15,       
     TOK_OR          = 16,   TOK_XOR         = 17,   TOK_IDENT       = 24,       
@@ -381,7 +413,7 @@ enum InstrFlags : uint32_t {
 // an expression.
 //
 //----------------------------------------------------------------------------------------
-const Token AsmTokTab[ ] = {
+constexpr Token AsmTokTab[ ] = {
     
     //------------------------------------------------------------------------------------
     // General registers.
@@ -613,6 +645,87 @@ const Token AsmTokTab[ ] = {
 
 const int MAX_ASM_TOKEN_TAB = sizeof( AsmTokTab ) / sizeof( Token );
 
+//----------------------------------------------------------------------------------------
+// The token table is looked up through a perfect hash table built at compile 
+// time. We search for a hash seed that places every name in a slot of its own.
+// A lookup is then one hash and one string compare. A slot holds the token table
+// index plus one, zero is an empty slot. When a name occurs twice in the token 
+// table, the first entry is used, just as the linear search did.
+//
+//----------------------------------------------------------------------------------------
+const int       ASM_TOK_HASH_SIZE       = 4096;
+const uint32_t  ASM_TOK_HASH_MAX_SEEDS  = 256;
+
+struct TokHashTab {
+    
+    uint32_t    seed                        = 0;
+    uint8_t     slot[ ASM_TOK_HASH_SIZE ]   = { };
+};
+
+constexpr uint32_t hashTokName( const char *str, uint32_t seed ) {
+    
+    uint32_t hash = 2166136261u ^ seed;
+    
+    for ( ; *str != 0; str++ ) hash = ( hash ^ (uint8_t) *str ) * 16777619u;
+
+    return ( hash ^ ( hash >> 16 ));
+}
+
+constexpr bool isSameTokName( const char *a, const char *b ) {
+    
+    for ( ; ( *a != 0 ) && ( *a == *b ); a++, b++ );
+    
+    return ( *a == *b );
+}
+
+constexpr TokHashTab buildTokHashTab( ) {
+    
+    bool isFirst[ MAX_ASM_TOKEN_TAB ] = { };
+    
+    for ( int i = 0; i < MAX_ASM_TOKEN_TAB; i++ ) {
+        
+        isFirst[ i ] = true;
+        
+        for ( int k = 0; k < i; k++ ) {
+            
+            if ( isSameTokName( AsmTokTab[ i ].name, AsmTokTab[ k ].name )) {
+                
+                isFirst[ i ] = false;
+                break;
+            }
+        }
+    }
+    
+    for ( uint32_t seed = 1; seed <= ASM_TOK_HASH_MAX_SEEDS; seed++ ) {
+        
+        TokHashTab  tab     = { };
+        bool        isOk    = true;
+        
+        for ( int i = 0; ( i < MAX_ASM_TOKEN_TAB ) && ( isOk ); i++ ) {
+            
+            if ( ! isFirst[ i ] ) continue;
+            
+            uint32_t index = hashTokName( AsmTokTab[ i ].name, seed ) % ASM_TOK_HASH_SIZE;
+            
+            if ( tab.slot[ index ] != 0 ) isOk = false;
+            else tab.slot[ index ] = (uint8_t) ( i + 1 );
+        }
+        
+        if ( isOk ) {
+            
+            tab.seed = seed;
+            return ( tab );
+        }
+    }
+    
+    return ( TokHashTab { } );
+}
+
+constexpr TokHashTab AsmTokHashTab = buildTokHashTab( );
+
+static_assert( MAX_ASM_TOKEN_TAB < 255, "Token table too large for the hash table" );
+static_assert( AsmTokHashTab.seed != 0, "No perfect hash seed for the token table" );
+
 //----------------------------------------------------------------------------------------
 // Expression value. The analysis of an expression results in a value. Depending
 // on the expression type, the values are simple scalar values or a structured 
@@ -623,21 +736,51 @@ struct Expr {
     
     TokTypeId  typ;
     T64Word    val;  
+    bool       adr;
 };
 
-const Expr INIT_EXPR = { .typ = TYP_NIL, .val = 0 }; 
+const Expr INIT_EXPR = { .typ = TYP_NIL, .val = 0, .adr = false }; 
 
 //----------------------------------------------------------------------------------------
-// Global variables for the tokenizer.
+// The program assembler context. It is only set while a program is assembled, 
+// the one line assembler does not know about identifiers. A label value is an 
+// address, which is turned into an offset when used as a branch target. During
+// the first pass over the source, a reference to an undefined symbol yields the
+// current location and marks the statement for assembling it again at the end.
 //
 //----------------------------------------------------------------------------------------
-int     lastErr                             = NO_ERR;
-char    tokenLine[ MAX_INPUT_LINE_SIZE ]    = { 0 };
-int     currentLineLen                      = 0;
-int     currentCharIndex                    = 0;
-int     currentTokCharIndex                 = 0;
-char    currentChar                         = ' ';
-Token   currentToken;
+struct AsmProgCtx {
+    
+    std::unordered_map<std::string, T64AsmSymbol>   *symTab     = nullptr;
+    std::vector<uint8_t>                            *image      = nullptr;
+    T64Word                                         imageAdr    = 0;
+    T64Word                                         location    = 0;
+    T64Word                                         entryAdr    = 0;
+    bool                                            finalPass   = false;
+    bool                                            undefRef    = false;
+};
+
+struct AsmFixup {
+    
+    const char  *lineStr;
+    size_t      lineLen;
+    T64Word     adr;
+    int         lineNum;
+};
+
+thread_local AsmProgCtx *progCtx = nullptr;
+
+//----------------------------------------------------------------------------------------
+// Global variables for the tokenizer. There is one set for each thread.
+//
+//----------------------------------------------------------------------------------------
+thread_local int     lastErr                             = NO_ERR;
+thread_local char    tokenLine[ MAX_INPUT_LINE_SIZE ]    = { 0 };
+thread_local int     currentLineLen                      = 0;
+thread_local int     currentCharIndex                    = 0;
+thread_local int     currentTokCharIndex                 = 0;
+thread_local char    currentChar                         = ' ';
+thread_local Token   currentToken;
 
 //----------------------------------------------------------------------------------------
 // Forward declarations.
@@ -646,17 +789,21 @@ Token   currentToken;
 void parseExpr( Expr *rExpr );
 
 //----------------------------------------------------------------------------------------
-// The token lookup function. We just do a linear search.
+// The token lookup function. The name hashes to exactly one slot of the token
+// hash table. The name is a token when it matches the token in that slot.
 //
 //----------------------------------------------------------------------------------------
-int lookupToken( char *inputStr, const Token *tokTab ) {
+int lookupToken( const char *inputStr ) {
     
-    if (( strlen( inputStr ) == 0 ) || 
+    if (( inputStr[ 0 ] == 0 ) || 
         ( strlen ( inputStr ) > MAX_TOKEN_NAME_SIZE )) return ( -1 );
     
-    for ( int i = 0; i < MAX_ASM_TOKEN_TAB; i++  ) {
+    uint32_t    hash    = hashTokName( inputStr, AsmTokHashTab.seed );
+    int         index   = AsmTokHashTab.slot[ hash % ASM_TOK_HASH_SIZE ] - 1;
+    
+    if (( index >= 0 ) && ( strcmp( inputStr, AsmTokTab[ index ].name ) == 0 )) {
         
-        if ( strcmp( inputStr, tokTab[ i ].name ) == 0 ) return ( i );
+        return ( index );
     }
     
     return ( -1 );
@@ -945,10 +1092,12 @@ void parseIdent( ) {
     
     upshiftStr( identBuf );
     
-    int index = lookupToken( identBuf, AsmTokTab );
+    int index = lookupToken( identBuf );
     
     if ( index == - 1 ) {
         
+        if ( strlen( identBuf ) >= MAX_TOKEN_NAME_SIZE ) throw ( ERR_IDENT_TOO_LONG );
+        
         strcpy( currentToken.name, identBuf );
         currentToken.typ = TYP_IDENT;
         currentToken.tid = TOK_IDENT;
@@ -969,6 +1118,7 @@ void nextToken( ) {
     currentToken.val        = 0;
     
     while (( currentChar == ' ' ) || 
+            ( currentChar == '\t' ) || 
             ( currentChar == '\n' ) || 
             ( currentChar == '\r' )) nextChar( );
     
@@ -1059,6 +1209,12 @@ void nextToken( ) {
         currentToken.tid    = TOK_COMMA;
         nextChar( );
     }
+    else if ( currentChar == ':' ) {
+        
+        currentToken.typ    = TYP_SYM;
+        currentToken.tid    = TOK_COLON;
+        nextChar( );
+    }
     else if ( currentChar == ';' ) {
         
         currentCharIndex    = currentLineLen;
@@ -1078,12 +1234,16 @@ void nextToken( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Initialize the tokenizer and get the first token.
+// Initialize the tokenizer and get the first token. The input string does not
+// need to be terminated, the program assembler passes a line of the source.
 //
 //----------------------------------------------------------------------------------------
-void setupTokenizer( char *inputStr ) {
+void setupTokenizer( const char *inputStr, size_t len ) {
     
-    strcpy( tokenLine, inputStr );
+    if ( len >= MAX_INPUT_LINE_SIZE ) throw ( ERR_LINE_TOO_LONG );
+
+    memcpy( tokenLine, inputStr, len );
+    tokenLine[ len ] = 0;
     upshiftStr( tokenLine );
     
     currentLineLen          = (int) strlen( tokenLine);
@@ -1137,14 +1297,18 @@ static inline void acceptRparen( ) {
 //      <factor> -> <number>            |
 //                  <gregId>            |
 //                  <cregId>            |
+//                  <symbol>            |
 //                  "~" <factor>        |
 //                  "(" <expr> ")"
 //
+// Symbols are only known to the program assembler.
+//
 //----------------------------------------------------------------------------------------
 void parseFactor( Expr *rExpr ) {
     
     rExpr -> typ  = TYP_NIL;
     rExpr -> val = 0;
+    rExpr -> adr = false;
     
     if ( isToken( TOK_NUM )) {
         
@@ -1164,6 +1328,26 @@ void parseFactor( Expr *rExpr ) {
         rExpr -> val = currentToken.val;
         nextToken( );
     }
+    else if (( isToken( TOK_IDENT )) && ( progCtx != nullptr )) {
+        
+        auto sym = progCtx -> symTab -> find( currentToken.name );
+        
+        if ( sym != progCtx -> symTab -> end( )) {
+            
+            rExpr -> val = sym -> second.val;
+            rExpr -> adr = sym -> second.isLabel;
+        }
+        else if ( ! progCtx -> finalPass ) {
+            
+            rExpr -> val        = progCtx -> location;
+            rExpr -> adr        = true;
+            progCtx -> undefRef = true;
+        }
+        else throw ( ERR_UNDEFINED_SYMBOL );
+        
+        rExpr -> typ = TYP_NUM;
+        nextToken( );
+    }
     else if ( isToken( TOK_NEG )) {
         
         parseFactor( rExpr );
@@ -1210,6 +1394,8 @@ void parseTerm( Expr *rExpr ) {
             case TOK_MOD:  rExpr -> val = modOp( rExpr, &lExpr );   break;
             case TOK_AND:  rExpr -> val = rExpr -> val & lExpr.val; break;
         }
+        
+        rExpr -> adr = false;
     }
 }
 
@@ -1219,6 +1405,9 @@ void parseTerm( Expr *rExpr ) {
 //      <expr>      ->  [ ( "+" | "-" ) ] <term> { <exprOp> <term> }
 //      <exprOp>    ->  "+" | "-" | "|" | "^"
 //
+// An address plus or minus a number is an address, the difference of two 
+// addresses is a number. Any other use of an address yields a number.
+//
 //----------------------------------------------------------------------------------------
 void parseExpr( Expr *rExpr ) {
     
@@ -1238,6 +1427,8 @@ void parseExpr( Expr *rExpr ) {
 
         if ( rExpr -> typ == TYP_NUM ) rExpr -> val = - rExpr -> val;
         else throw ( ERR_EXPECTED_NUMERIC );
+
+        rExpr -> adr = false;
     }
     else parseTerm( rExpr );
     
@@ -1253,6 +1444,16 @@ void parseExpr( Expr *rExpr ) {
         
         if ( rExpr -> typ != lExpr.typ ) throw ( ERR_EXPR_TYPE_MATCH );
         
+        if (( op == TOK_PLUS ) && ( rExpr -> adr ) && ( lExpr.adr )) {
+            
+            throw ( ERR_EXPR_TYPE_MATCH );
+        }
+        
+        if (( op == TOK_MINUS ) && ( ! rExpr -> adr ) && ( lExpr.adr )) {
+            
+            throw ( ERR_EXPR_TYPE_MATCH );
+        }
+        
         switch ( op ) {
    
             case TOK_PLUS:  rExpr -> val = addOp( rExpr, &lExpr );      break;
@@ -1260,6 +1461,25 @@ void parseExpr( Expr *rExpr ) {
             case TOK_OR:    rExpr -> val = rExpr -> val | lExpr.val;    break;
             case TOK_XOR:   rExpr -> val = rExpr -> val ^ lExpr.val;    break;
         }
+        
+        if      ( op == TOK_PLUS  ) rExpr -> adr = rExpr -> adr || lExpr.adr;
+        else if ( op == TOK_MINUS ) rExpr -> adr = rExpr -> adr && ( ! lExpr.adr );
+        else                        rExpr -> adr = false;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// "toBranchOfs" turns an address into the IA-relative offset used by branch 
+// instructions. The location is the address of the branch instruction. Numbers
+// are offsets already.
+//
+//----------------------------------------------------------------------------------------
+void toBranchOfs( Expr *rExpr ) {
+    
+    if (( rExpr -> adr ) && ( progCtx != nullptr )) {
+        
+        rExpr -> val = rExpr -> val - progCtx -> location;
+        rExpr -> adr = false;
     }
 }
 
@@ -2231,6 +2451,7 @@ void parseInstrB( uint32_t *instr, uint32_t instrOpToken ) {
     if ( instrFlags & IF_G ) depositInstrBit( instr, 19, true );
 
     parseExpr( &rExpr );
+    toBranchOfs( &rExpr );
     if ( rExpr.typ == TYP_NUM ) {
 
         if ( ! isAlignedOfs( rExpr.val, 4 )) throw( ERR_INVALID_OFS );
@@ -2402,6 +2623,7 @@ void parseInstrBB( uint32_t *instr, uint32_t instrOpToken ) {
     acceptComma( );
 
     parseExpr( &rExpr );
+    toBranchOfs( &rExpr );
     if ( rExpr.typ == TYP_NUM ) {
      
         if ( ! isAlignedOfs( rExpr.val, 4 )) throw( ERR_INVALID_OFS );
@@ -2438,6 +2660,7 @@ void parseInstrXBR( uint32_t *instr, uint32_t instrOpToken ) {
     acceptComma( );
     
     parseExpr( &rExpr );
+    toBranchOfs( &rExpr );
     if ( rExpr.typ == TYP_NUM ) {
 
         if ( ! isAlignedOfs( rExpr.val, 4 )) throw( ERR_INVALID_OFS );
@@ -2790,14 +3013,11 @@ void parseInstrTrapOp( uint32_t *instr, uint32_t instrOpToken ) {
 }
 
 //----------------------------------------------------------------------------------------
-// "parseLine" will take the input string and parse the line for an instruction.
-// In the one-line case, there is only the opCode mnemonic and the argument list.
-// No labels, comments are ignored.
+// "parseInstr" parses an instruction starting with the current token, which is
+// the opCode mnemonic, followed by the argument list.
 //
 //----------------------------------------------------------------------------------------
-void parseLine( char *inputStr, uint32_t *instr ) {
-    
-    setupTokenizer( inputStr );
+void parseInstr( uint32_t *instr ) {
  
     if ( isTokenTyp( TYP_OP_CODE )) {
         
@@ -2884,6 +3104,315 @@ void parseLine( char *inputStr, uint32_t *instr ) {
     else throw ( ERR_EXPECTED_OPCODE );
 }
 
+//----------------------------------------------------------------------------------------
+// "parseLine" will take the input string and parse the line for an instruction.
+// In the one-line case, there is only the opCode mnemonic and the argument list.
+// No labels, comments are ignored.
+//
+//----------------------------------------------------------------------------------------
+void parseLine( char *inputStr, uint32_t *instr ) {
+    
+    setupTokenizer( inputStr, strlen( inputStr ));
+    parseInstr( instr );
+}
+
+//----------------------------------------------------------------------------------------
+// The program assembler directives. A directive is a period followed by the 
+// directive name.
+//
+//----------------------------------------------------------------------------------------
+enum DirId : int {
+    
+    DIR_NIL     = 0,    DIR_ORG     = 1,    DIR_ALIGN   = 2,    DIR_SPACE   = 3,
+    DIR_BYTE    = 4,    DIR_HALF    = 5,    DIR_WORD    = 6,    DIR_DWORD   = 7,
+    DIR_EQU     = 8,    DIR_ENTRY   = 9
+};
+
+struct Directive {
+    
+    char    name[ 8 ];
+    DirId   dir;
+};
+
+const Directive AsmDirTab[ ] = {
+    
+    { "ORG",    DIR_ORG     },  { "ALIGN",  DIR_ALIGN   },  { "SPACE",  DIR_SPACE   },
+    { "BYTE",   DIR_BYTE    },  { "HALF",   DIR_HALF    },  { "WORD",   DIR_WORD    },
+    { "DWORD",  DIR_DWORD   },  { "EQU",    DIR_EQU     },  { "ENTRY",  DIR_ENTRY   }
+};
+
+const int MAX_ASM_DIR_TAB = sizeof( AsmDirTab ) / sizeof( Directive );
+
+//----------------------------------------------------------------------------------------
+// Program image helpers. The image starts at the base address and grows with 
+// the highest location written. Gaps are zero. Data is stored in big endian 
+// byte order, just like the memory of the system.
+//
+//----------------------------------------------------------------------------------------
+void putBigEndian( uint8_t *buf, T64Word val, int len ) {
+    
+    for ( int i = 0; i < len; i++ ) buf[ i ] = (uint8_t) ( val >> (( len - 1 - i ) * 8 ));
+}
+
+uint8_t *reserveImage( T64Word len ) {
+    
+    T64Word ofs = progCtx -> location - progCtx -> imageAdr;
+    
+    if (( ofs < 0 ) || ( len < 0 ) || ( ofs + len > MAX_ASM_IMAGE_SIZE )) {
+        
+        throw ( ERR_IMAGE_ADR_RANGE );
+    }
+    
+    std::vector<uint8_t> &image = *progCtx -> image;
+    
+    if ( ofs + len > (T64Word) image.size( )) image.resize( ofs + len, 0 );
+    
+    progCtx -> location += len;
+    return ( image.data( ) + ofs );
+}
+
+void emitData( T64Word val, int len ) {
+    
+    putBigEndian( reserveImage( len ), val, len );
+}
+
+bool isInRangeForData( T64Word val, int len ) {
+    
+    if ( len >= 8 ) return ( true );
+    
+    T64Word lim = (T64Word) 1 << ( len * 8 );
+    return (( val >= - ( lim / 2 )) && ( val < lim ));
+}
+
+//----------------------------------------------------------------------------------------
+// "parseDefinedExpr" parses a numeric expression whose symbols must be defined
+// already. These are the expressions that decide where the following lines go.
+//
+//----------------------------------------------------------------------------------------
+T64Word parseDefinedExpr( ) {
+    
+    Expr rExpr = INIT_EXPR;
+    
+    parseExpr( &rExpr );
+    if ( rExpr.typ != TYP_NUM ) throw ( ERR_EXPECTED_NUMERIC );
+    if ( progCtx -> undefRef ) throw ( ERR_UNDEFINED_SYMBOL );
+    
+    return ( rExpr.val );
+}
+
+//----------------------------------------------------------------------------------------
+// "parseDataList" stores a list of values with the data size. The range check
+// is done when all symbols are known.
+//
+//      <dataList>  ->  <expr> { "," <expr> }
+//
+//----------------------------------------------------------------------------------------
+void parseDataList( int len ) {
+    
+    Expr rExpr = INIT_EXPR;
+    
+    while ( true ) {
+        
+        parseExpr( &rExpr );
+        if ( rExpr.typ != TYP_NUM ) throw ( ERR_EXPECTED_NUMERIC );
+
+        if (( ! progCtx -> undefRef ) && ( ! isInRangeForData( rExpr.val, len ))) {
+           
+            throw ( ERR_IMM_VAL_RANGE );
+        }
+        
+        emitData( rExpr.val, len );
+        
+        if ( isToken( TOK_COMMA )) nextToken( );
+        else break;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// "parseDirective" handles the program assembler directives.
+//
+//      ".ORG"   <expr>
+//      ".ALIGN" <expr>
+//      ".SPACE" <expr>
+//      ".BYTE"  <dataList>
+//      ".HALF"  <dataList>
+//      ".WORD"  <dataList>
+//      ".DWORD" <dataList>
+//      ".EQU"   <ident> "," <expr>
+//      ".ENTRY" <expr>
+//
+//----------------------------------------------------------------------------------------
+void parseDirective( ) {
+    
+    DirId dir = DIR_NIL;
+    
+    if ( isToken( TOK_IDENT )) {
+        
+        for ( int i = 0; i < MAX_ASM_DIR_TAB; i++ ) {
+            
+            if ( strcmp( currentToken.name, AsmDirTab[ i ].name ) == 0 ) {
+                
+                dir = AsmDirTab[ i ].dir;
+                break;
+            }
+        }
+    }
+    
+    if ( dir == DIR_NIL ) throw ( ERR_INVALID_DIRECTIVE );
+    
+    nextToken( );
+    
+    switch ( dir ) {
+            
+        case DIR_ORG: {
+            
+            progCtx -> location = parseDefinedExpr( );
+            
+        } break;
+            
+        case DIR_ALIGN: {
+            
+            T64Word align = parseDefinedExpr( );
+            
+            if (( align <= 0 ) || (( align & ( align - 1 )) != 0 )) throw ( ERR_IMM_VAL_RANGE );
+            
+            T64Word alignAdr = ( progCtx -> location + align - 1 ) & ( ~ ( align - 1 ));
+            
+            reserveImage( alignAdr - progCtx -> location );
+            
+        } break;
+            
+        case DIR_SPACE: {
+            
+            reserveImage( parseDefinedExpr( ));
+            
+        } break;
+            
+        case DIR_BYTE:  parseDataList( 1 ); break;
+        case DIR_HALF:  parseDataList( 2 ); break;
+        case DIR_WORD:  parseDataList( 4 ); break;
+        case DIR_DWORD: parseDataList( 8 ); break;
+            
+        case DIR_EQU: {
+            
+            if ( ! isToken( TOK_IDENT )) throw ( ERR_EXPECTED_IDENT );
+            
+            std::string name( currentToken.name );
+            
+            nextToken( );
+            acceptComma( );
+            
+            T64AsmSymbol sym = { .val = parseDefinedExpr( ), .isLabel = false };
+            
+            if ( ! progCtx -> symTab -> emplace( name, sym ).second ) {
+                
+                throw ( ERR_DUPLICATE_SYMBOL );
+            }
+            
+        } break;
+            
+        case DIR_ENTRY: {
+            
+            Expr rExpr = INIT_EXPR;
+            
+            parseExpr( &rExpr );
+            if ( rExpr.typ != TYP_NUM ) throw ( ERR_EXPECTED_NUMERIC );
+            
+            progCtx -> entryAdr = rExpr.val;
+            
+        } break;
+            
+        default: throw ( ERR_INVALID_DIRECTIVE );
+    }
+    
+    acceptEOS( );
+}
+
+//----------------------------------------------------------------------------------------
+// "parseStatement" assembles the statement of a program line at the current 
+// location. When an instruction refers to a symbol not yet defined, errors are
+// ignored and the instruction word is reserved. The statement is assembled 
+// again once all symbols are known.
+//
+//      <stmt>      ->  <instr> | "." <directive> | <empty>
+//
+//----------------------------------------------------------------------------------------
+void parseStatement( ) {
+    
+    if ( isToken( TOK_EOS )) return;
+    
+    if ( isToken( TOK_PERIOD )) {
+        
+        nextToken( );
+        parseDirective( );
+    }
+    else if ( isTokenTyp( TYP_OP_CODE )) {
+        
+        uint32_t instr = 0;
+        
+        if ( ! isAlignedOfs( progCtx -> location, 4 )) throw ( ERR_INSTR_ALIGNMENT );
+        
+        try {
+            
+            parseInstr( &instr );
+        }
+        catch ( ErrId ) {
+            
+            if ( ! progCtx -> undefRef ) throw;
+        }
+        
+        emitData( instr, 4 );
+    }
+    else throw ( ERR_EXPECTED_OPCODE );
+}
+
+//----------------------------------------------------------------------------------------
+// "parseProgLine" assembles one line of a program. A label is defined with the
+// current location. A line with a statement referring to an undefined symbol is
+// added to the fixup list. When the line is assembled again, the label is just 
+// skipped.
+//
+//      <line>      ->  [ <ident> ":" ] <stmt> [ ";" <comment> ]
+//
+//----------------------------------------------------------------------------------------
+void parseProgLine( const char *lineStr, 
+                    size_t lineLen, 
+                    int lineNum, 
+                    std::vector<AsmFixup> *fixups ) {
+    
+    setupTokenizer( lineStr, lineLen );
+    progCtx -> undefRef = false;
+    
+    if ( isToken( TOK_IDENT )) {
+        
+        std::string name( currentToken.name );
+        
+        nextToken( );
+        if ( ! isToken( TOK_COLON )) throw ( ERR_EXPECTED_COLON );
+        
+        if ( ! progCtx -> finalPass ) {
+            
+            T64AsmSymbol sym = { .val = progCtx -> location, .isLabel = true };
+            
+            if ( ! progCtx -> symTab -> emplace( name, sym ).second ) {
+                
+                throw ( ERR_DUPLICATE_SYMBOL );
+            }
+        }
+        
+        nextToken( );
+    }
+    
+    T64Word stmtAdr = progCtx -> location;
+    
+    parseStatement( );
+    
+    if (( progCtx -> undefRef ) && ( fixups != nullptr )) {
+        
+        fixups -> push_back( { lineStr, lineLen, stmtAdr, lineNum } );
+    }
+}
+
 } // namespace
 
 //----------------------------------------------------------------------------------------
@@ -2909,6 +3438,217 @@ int T64Assemble::assembleInstr( char *inputStr, uint32_t *instr ) {
     }
 }
 
+//----------------------------------------------------------------------------------------
+// The program assembler. The source text is assembled line by line in one pass
+// into the memory image, which starts at the base address. The statements with
+// forward references are then assembled again at their location. The entry 
+// point is the base address, unless set by the ".ENTRY" directive.
+//
+//----------------------------------------------------------------------------------------
+int T64Assemble::assembleProgram( const char *srcStr, size_t srcLen, T64Word baseAdr ) {
+    
+    AsmProgCtx              ctx;
+    std::vector<AsmFixup>   fixups;
+    
+    image.clear( );
+    symTab.clear( );
+    image.reserve( srcLen / 4 );
+    symTab.reserve( srcLen / 64 );
+    
+    imageAdr        = baseAdr;
+    entryAdr        = baseAdr;
+    lineCount       = 0;
+    errLine         = 0;
+    lastErr         = NO_ERR;
+    
+    ctx.symTab      = &symTab;
+    ctx.image       = &image;
+    ctx.imageAdr    = baseAdr;
+    ctx.location    = baseAdr;
+    ctx.entryAdr    = baseAdr;
+    progCtx         = &ctx;
+    
+    try {
+        
+        size_t pos = 0;
+        
+        while ( pos < srcLen ) {
+            
+            const char  *lineStr    = srcStr + pos;
+            const char  *eolPtr     = (const char *) memchr( lineStr, '\n', srcLen - pos );
+            size_t      lineLen     = ( eolPtr != nullptr ) ? eolPtr - lineStr : srcLen - pos;
+            
+            pos += lineLen + 1;
+            lineCount ++;
+            errLine = lineCount;
+            
+            parseProgLine( lineStr, lineLen, lineCount, &fixups );
+        }
+        
+        ctx.finalPass = true;
+        
+        for ( AsmFixup &fix : fixups ) {
+            
+            errLine         = fix.lineNum;
+            ctx.location    = fix.adr;
+            
+            parseProgLine( fix.lineStr, fix.lineLen, fix.lineNum, nullptr );
+        }
+        
+        errLine     = 0;
+        entryAdr    = ctx.entryAdr;
+        progCtx     = nullptr;
+        return ( NO_ERR );
+    }
+    catch ( ErrId errNum ) {
+        
+        progCtx = nullptr;
+        lastErr = errNum;
+        return ( errNum );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Assemble a source file. The file is read as a whole and passed to the program
+// assembler.
+//
+//----------------------------------------------------------------------------------------
+int T64Assemble::assembleFile( const char *fileName, T64Word baseAdr ) {
+    
+    FILE                *f      = fopen( fileName, "rb" );
+    std::vector<char>   srcBuf;
+    char                buf[ 64 * 1024 ];
+    size_t              len     = 0;
+    
+    if ( f == nullptr ) {
+        
+        errLine = 0;
+        lastErr = ERR_FILE_OPEN;
+        return ( ERR_FILE_OPEN );
+    }
+    
+    while (( len = fread( buf, 1, sizeof( buf ), f )) > 0 ) {
+        
+        srcBuf.insert( srcBuf.end( ), buf, buf + len );
+    }
+    
+    fclose( f );
+    return ( assembleProgram( srcBuf.data( ), srcBuf.size( ), baseAdr ));
+}
+
+//----------------------------------------------------------------------------------------
+// Program assembler results.
+//
+//----------------------------------------------------------------------------------------
+T64Word T64Assemble::getImageAdr( ) {
+    
+    return ( imageAdr );
+}
+
+T64Word T64Assemble::getImageSize( ) {
+    
+    return ((T64Word) image.size( ));
+}
+
+const uint8_t *T64Assemble::getImageData( ) {
+    
+    return ( image.data( ));
+}
+
+T64Word T64Assemble::getEntryAdr( ) {
+    
+    return ( entryAdr );
+}
+
+int T64Assemble::getLineCount( ) {
+    
+    return ( lineCount );
+}
+
+bool T64Assemble::lookupSymbol( const char *name, T64Word *val ) {
+    
+    char nameBuf[ MAX_TOKEN_NAME_SIZE ];
+    
+    if ( strlen( name ) >= MAX_TOKEN_NAME_SIZE ) return ( false );
+    
+    strcpy( nameBuf, name );
+    upshiftStr( nameBuf );
+    
+    auto sym = symTab.find( nameBuf );
+    if ( sym == symTab.end( )) return ( false );
+    
+    *val = sym -> second.val;
+    return ( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Write the program image as a raw binary file.
+//
+//----------------------------------------------------------------------------------------
+bool T64Assemble::writeImageFile( const char *fileName ) {
+    
+    FILE *f = fopen( fileName, "wb" );
+    if ( f == nullptr ) return ( false );
+    
+    bool rStat = ( image.size( ) == 0 ) || 
+                 ( fwrite( image.data( ), image.size( ), 1, f ) == 1 );
+    
+    return (( fclose( f ) == 0 ) && ( rStat ));
+}
+
+//----------------------------------------------------------------------------------------
+// Write the program image as an ELF file. The file is a 64-bit big endian 
+// executable with one loadable segment at the image address, which is what the
+// simulator ELF loader expects. There are no sections.
+//
+//----------------------------------------------------------------------------------------
+bool T64Assemble::writeElfFile( const char *fileName ) {
+    
+    const int   ELF_HDR_SIZE    = 64;
+    const int   ELF_PHDR_SIZE   = 56;
+    const int   ELF_DATA_OFS    = 128;
+    
+    uint8_t     hdr[ ELF_DATA_OFS ] = { };
+    T64Word     size                = (T64Word) image.size( );
+    
+    hdr[ 0 ] = 0x7F;
+    hdr[ 1 ] = 'E';
+    hdr[ 2 ] = 'L';
+    hdr[ 3 ] = 'F';
+    hdr[ 4 ] = 2;                                       // ELFCLASS64
+    hdr[ 5 ] = 2;                                       // ELFDATA2MSB
+    hdr[ 6 ] = 1;                                       // EV_CURRENT
+    
+    putBigEndian( &hdr[ 16 ], 2, 2 );                   // ET_EXEC
+    putBigEndian( &hdr[ 18 ], 0, 2 );                   // EM_NONE
+    putBigEndian( &hdr[ 20 ], 1, 4 );
+    putBigEndian( &hdr[ 24 ], entryAdr, 8 );
+    putBigEndian( &hdr[ 32 ], ELF_HDR_SIZE, 8 );
+    putBigEndian( &hdr[ 52 ], ELF_HDR_SIZE, 2 );
+    putBigEndian( &hdr[ 54 ], ELF_PHDR_SIZE, 2 );
+    putBigEndian( &hdr[ 56 ], 1, 2 );
+    
+    uint8_t *phdr = &hdr[ ELF_HDR_SIZE ];
+    
+    putBigEndian( &phdr[ 0 ], 1, 4 );                   // PT_LOAD
+    putBigEndian( &phdr[ 4 ], 7, 4 );                   // PF_R | PF_W | PF_X
+    putBigEndian( &phdr[ 8 ], ELF_DATA_OFS, 8 );
+    putBigEndian( &phdr[ 16 ], imageAdr, 8 );
+    putBigEndian( &phdr[ 24 ], imageAdr, 8 );
+    putBigEndian( &phdr[ 32 ], size, 8 );
+    putBigEndian( &phdr[ 40 ], size, 8 );
+    putBigEndian( &phdr[ 48 ], 1, 8 );
+    
+    FILE *f = fopen( fileName, "wb" );
+    if ( f == nullptr ) return ( false );
+    
+    bool rStat = ( fwrite( hdr, sizeof( hdr ), 1, f ) == 1 );
+    
+    if (( rStat ) && ( size > 0 )) rStat = ( fwrite( image.data( ), size, 1, f ) == 1 );
+    
+    return (( fclose( f ) == 0 ) && ( rStat ));
+}
+
 int T64Assemble::getErrId( ) {
     
     return ( lastErr );
@@ -2919,6 +3659,11 @@ int T64Assemble::getErrPos( ) {
     return ( currentTokCharIndex );
 }
 
+int T64Assemble::getErrLine( ) {
+    
+    return ( errLine );
+}
+
 const char *T64Assemble::getErrStr( int errId ) {
     
     for ( int i = 0; i < MAX_ERR_MSG_TAB; i++ ) {
@@ -11,6 +11,13 @@
 // an error is detected. Considering that we only have one line to parse, there
 // is no need to implement a better parser error recovery method.
 //
+// The program assembler uses the same parser for a source text with many lines.
+// A line can define a label and contain an instruction or a data directive. The
+// labels are kept in a symbol table. A reference to a label not yet defined is
+// remembered and the line is assembled again once the source text is done. The
+// result is a memory image, which can be written as a raw file or an ELF file.
+// The first error found ends the assembly.
+//
 //----------------------------------------------------------------------------------------
 //
 // T64 - A 64-bit Processor - InLine Assembler
@@ -32,6 +39,22 @@
 
 #include "T64-Common.h"
 #include "T64-Util.h"
+#include "T64-SymTab.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+//----------------------------------------------------------------------------------------
+// A symbol of the program assembler. A symbol is a label, whose value is the 
+// address where it was defined, or a constant defined with the ".EQU" directive.
+//
+//----------------------------------------------------------------------------------------
+struct T64AsmSymbol {
+
+    T64Word     val     = 0;
+    bool        isLabel = false;
+};
 
 //----------------------------------------------------------------------------------------
 // "T64Assemble" is a one line assembler. It just parses the instruction string
@@ -48,9 +71,32 @@ public:
     
     int         assembleInstr( char *inputStr, uint32_t *instr );
 
+    int         assembleProgram( const char *srcStr, size_t srcLen, T64Word baseAdr );
+    int         assembleFile( const char *fileName, T64Word baseAdr );
+    
+    T64Word     getImageAdr( );
+    T64Word     getImageSize( );
+    const uint8_t *getImageData( );
+    T64Word     getEntryAdr( );
+    int         getLineCount( );
+    bool        lookupSymbol( const char *name, T64Word *val );
+
+    bool        writeImageFile( const char *fileName );
+    bool        writeElfFile( const char *fileName );
+
     int         getErrId( );
     int         getErrPos( );
+    int         getErrLine( );
     const char  *getErrStr( int errId );
+
+private:
+
+    std::vector<uint8_t>                            image;
+    std::unordered_map<std::string, T64AsmSymbol>   symTab;
+    T64Word                                         imageAdr    = 0;
+    T64Word                                         entryAdr    = 0;
+    int                                             lineCount   = 0;
+    int                                             errLine     = 0;
 };
 
 //----------------------------------------------------------------------------------------
@@ -58,7 +104,10 @@ public:
 // form. The disassembled string can also contains  two parts, which are the 
 // opcode part and the operand part. There are options to just one of the parts
 // or both. The split allows for displaying the disassembled instruction in an 
-// aligned fashion, when printing several lines.
+// aligned fashion, when printing several lines. The instruction list routine 
+// formats a range of instruction words, one per line, for bulk listings. With
+// a symbol table set, the target of an instruction address relative branch 
+// can be formatted as a symbol. The instruction address is needed for this.
 //
 //----------------------------------------------------------------------------------------
 struct T64DisAssemble {
@@ -70,8 +119,17 @@ public:
     int formatInstr( char *buf, int bufLen, uint32_t instr, int rdx );
     int formatOpCode( char *buf, int bufLen, uint32_t instr );
     int formatOperands( char *buf, int bufLen, uint32_t instr, int rdx );
+    int formatInstrList( char *buf, int bufLen, const uint32_t *instr, int count, 
+                         int rdx, int *len = nullptr );
+    int formatTarget( char *buf, int bufLen, uint32_t instr, T64Word adr );
     int getOpCodeFieldWidth( );
     int getOperandsFieldWidth( );
+
+    void setSymTab( T64SymTab *symTab );
+
+private:
+
+    T64SymTab   *symTab     = nullptr;
 };
 
 #endif // T64_InlineAsm_h
@@ -12,7 +12,11 @@
 // instruction portion in the above order. The result is a string with the 
 // disassembled instruction.
 //
-//
+// The instruction formats are described in a decode table, which the compiler
+// builds from the format descriptions in "buildDisEntry". Formatting is then a
+// table lookup, a string copy for the opCode and a small interpreter for the 
+// operand format string. There is no "snprintf" per field, so that long code 
+// listings and trace files are formatted quickly.
 //----------------------------------------------------------------------------------------
 //
 // T64 - A 64-bit Processor - DisAssembler
@@ -38,6 +42,7 @@
 //----------------------------------------------------------------------------------------
 namespace {
 
+
 //----------------------------------------------------------------------------------------
 // The disassemble string consists of two parts. Normally, the string is just 
 // one string with both opCode and operand parts. For an aligned display of 
@@ -49,947 +54,574 @@ const int LEN_16 = 16;
 const int LEN_32 = 32;
 
 //----------------------------------------------------------------------------------------
-// A little helper function to display the comparison condition codes in human 
-// readable form. The function returns the characters written.
+// The decode table is indexed by the opCode, i.e. the instruction group and 
+// opCode family bits, and the option field in bits 19 .. 21. Most of the opCode
+// options and operand forms are known from these bits. When an entry depends on
+// further instruction bits, such as the data width field, the entry has up to 
+// four variants and the selector bit field picks one of them. The opCode strings
+// are complete strings built at compile time. The operand part is a format 
+// string, interpreted by "buildOperandStr". Its "%" sequences are:
+//
+//      %r %b %a    - general register R, B or A, as "R<n>"
+//      %n          - register B number only
+//      %i %I       - signed imm15, unscaled and times four
+//      %J %K       - signed imm19 and imm13, times four
+//      %s          - signed imm13 scaled by the data width
+//      %u          - imm20
+//      %l %p       - bit field 0 .. 5 and 6 .. 11
+//      %q %o %m    - bit field 15 .. 18, 13 .. 18 and 13 .. 14
+//      %t          - trap info, opt field times four plus bit field 13 .. 14
+//      %c          - the opCode number
+//      %R %P       - ",R<n>" and "R<n>," for register R, when not zero
+//      %A          - "R<n>" for register A, when not zero
+//      %E          - signed imm15 times four, when not zero
 //
 //----------------------------------------------------------------------------------------
-int printCondField( char *buf, uint32_t cmpCode ) {
+const int DIS_TAB_SIZE      = 64 * 8;
+const int DIS_OP_STR_LEN    = 12;
+const int DIS_LINE_LEN      = LEN_16 + 1 + LEN_32 + 1;
+
+struct DisEntry {
     
-    switch( cmpCode ) {
-            
-        case 0:  return ( snprintf( buf, 4, ".EQ" ));
-        case 1:  return ( snprintf( buf, 4, ".LT" ));
-        case 2:  return ( snprintf( buf, 4, ".GT" ));
-        case 3:  return ( snprintf( buf, 4, ".EV" ));
-        case 4:  return ( snprintf( buf, 4, ".NE" ));
-        case 5:  return ( snprintf( buf, 4, ".GE" ));
-        case 6:  return ( snprintf( buf, 4, ".LE" ));
-        case 7:  return ( snprintf( buf, 4, ".OD" ));
-        default: return ( snprintf( buf, 4, ".**" ));
-    }
-}
+    char        opStr[ 4 ][ DIS_OP_STR_LEN ]    = { };
+    const char  *fmt[ 4 ]                       = { "", "", "", "" };
+    uint8_t     opSelPos                        = 0;
+    uint8_t     opSelLen                        = 0;
+    uint8_t     fmtSelPos                       = 0;
+    uint8_t     fmtSelLen                       = 0;
+};
+
+struct DisTab {
+    
+    DisEntry    entry[ DIS_TAB_SIZE ];
+};
+
+const char *const CondStr[ 8 ] = { 
+
+    ".EQ", ".LT", ".GT", ".EV", ".NE", ".GE", ".LE", ".OD" 
+};
+
+//----------------------------------------------------------------------------------------
+// Note that we do not display the "D" option for the data width field. It is 
+// the default and thus will not be shown.
+//
+//----------------------------------------------------------------------------------------
+const char *const DwStr[ 4 ] = { ".B", ".H", ".W", "" };
 
 //----------------------------------------------------------------------------------------
-// A little helper function to display the DW field. Note that we do not display 
-// the "D" option. It is the default and thus will not be shown.
+// Compile time helpers for building the opCode strings.
 //
 //----------------------------------------------------------------------------------------
-int printDwField( char *buf, uint32_t dw ) {
+constexpr void addStr( char *buf, const char *str ) {
     
-    switch( dw ) {
-            
-        case 0:  return ( snprintf( buf, 4, ".B" ));
-        case 1:  return ( snprintf( buf, 4, ".H" ));
-        case 2:  return ( snprintf( buf, 4, ".W" ));
-        case 3:  return ( 0 );
-        default: return ( snprintf( buf, 8, ".*dw*" ));
+    int len = 0;
+    
+    while ( buf[ len ] != 0 ) len ++;
+    
+    for ( ; ( *str != 0 ) && ( len < DIS_OP_STR_LEN - 1 ); str++ ) buf[ len++ ] = *str;
+}
+
+constexpr void addNum( char *buf, int val ) {
+    
+    char    digits[ 8 ] = { };
+    int     i           = 7;
+    
+    do {
+        
+        digits[ --i ] = (char) ( '0' + ( val % 10 ));
+        val /= 10;
+    }
+    while (( val > 0 ) && ( i > 0 ));
+    
+    addStr( buf, &digits[ i ] );
+}
+
+constexpr void setOpStr( DisEntry &e, const char *s1, const char *s2 = "", const char *s3 = "" ) {
+    
+    for ( int i = 0; i < 4; i++ ) {
+        
+        addStr( e.opStr[ i ], s1 );
+        addStr( e.opStr[ i ], s2 );
+        addStr( e.opStr[ i ], s3 );
     }
 }
 
+constexpr void setOpStrDw( DisEntry &e, const char *s1, const char *s2 = "", 
+                           const char *s3 = "", const char *s4 = "" ) {
+    
+    e.opSelPos = 13;
+    e.opSelLen = 2;
+    
+    for ( int i = 0; i < 4; i++ ) {
+        
+        addStr( e.opStr[ i ], s1 );
+        addStr( e.opStr[ i ], s2 );
+        addStr( e.opStr[ i ], DwStr[ i ] );
+        addStr( e.opStr[ i ], s3 );
+        addStr( e.opStr[ i ], s4 );
+    }
+}
+
+constexpr void setOpStrSel( DisEntry &e, int pos, int len, 
+                            const char *s0, const char *s1, 
+                            const char *s2 = "", const char *s3 = "" ) {
+    
+    e.opSelPos = (uint8_t) pos;
+    e.opSelLen = (uint8_t) len;
+    
+    addStr( e.opStr[ 0 ], s0 );
+    addStr( e.opStr[ 1 ], s1 );
+    addStr( e.opStr[ 2 ], s2 );
+    addStr( e.opStr[ 3 ], s3 );
+}
+
+constexpr void setFmt( DisEntry &e, const char *fmt ) {
+    
+    for ( int i = 0; i < 4; i++ ) e.fmt[ i ] = fmt;
+}
+
+constexpr void setFmtSel( DisEntry &e, int pos, int len, 
+                          const char *f0, const char *f1, 
+                          const char *f2 = "", const char *f3 = "" ) {
+    
+    e.fmtSelPos = (uint8_t) pos;
+    e.fmtSelLen = (uint8_t) len;
+    e.fmt[ 0 ]  = f0;
+    e.fmt[ 1 ]  = f1;
+    e.fmt[ 2 ]  = f2;
+    e.fmt[ 3 ]  = f3;
+}
+
 //----------------------------------------------------------------------------------------
-// Decode the opcode and opcode option portion. An opcode consist of the 
-// instruction group and the opcode family. We construct the final opcode for
-// the case statement.
+// Build the decode table entry for an opCode and option field value. This is 
+// where the instruction formats are described. The routine is only run by the 
+// compiler to build the decode table.
 //
 //----------------------------------------------------------------------------------------
-int buildOpCodeStr( char *buf, T64Instr instr ) {
+constexpr DisEntry buildDisEntry( uint32_t opCode, uint32_t opt ) {
     
-    uint32_t opCode = extractInstrOpGroup( instr ) * 16 + extractInstrOpNum( instr );
-
-    switch( opCode ) {
-            
-        case ( OPC_GRP_ALU * 16 + OPC_ADD ): {
-            
-            return ( snprintf( buf, LEN_16, "ADD" ));
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_ADD ): {
-            
-            int cursor = snprintf( buf, LEN_16, "ADD" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_SUB ): {
-            
-            return ( snprintf( buf, LEN_16, "SUB" ));
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_SUB ): {
-            
-            int cursor = snprintf( buf, LEN_16, "SUB" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_AND ): {
-            
-            int cursor = snprintf( buf, LEN_16, "AND" );
-            if ( extractInstrBit( instr, 20 )) 
-               cursor += snprintf( buf + cursor, 4, ".C" );
-            if ( extractInstrBit( instr, 21 )) 
-               cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_AND ): {
-            
-            int cursor = snprintf( buf, LEN_16, "AND" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".C" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_OR ): {
-            
-            int cursor = snprintf( buf, LEN_16, "OR" );
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".C" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_OR ): {
-            
-            int cursor = snprintf( buf, LEN_16, "OR" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".C" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_XOR ): {
-            
-            int cursor = snprintf( buf, LEN_16, "XOR" );
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
+    DisEntry    e;
+    bool        b19     = ( opt & 1 ) != 0;
+    bool        b20     = ( opt & 2 ) != 0;
+    bool        b21     = ( opt & 4 ) != 0;
+    const char  *cn     = b20 ? ".C" : "";
+    const char  *nn     = b21 ? ".N" : "";
+    const char  *aluFmt = b19 ? "%r,%b,%i" : "%r,%b,%a";
+    const char  *memFmt = b19 ? "%r,%a(%b)" : "%r,%s(%b)";
+  
+    switch ( opCode ) {
             
-        case ( OPC_GRP_MEM * 16 + OPC_XOR ): {
+        case ( OPC_GRP_ALU * 16 + OPC_NOP ): {
             
-            int cursor = snprintf( buf, LEN_16, "XOR" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
+            setOpStr( e, "NOP" );
             
-        case ( OPC_GRP_ALU * 16 + OPC_CMP_A ): 
-        case ( OPC_GRP_ALU * 16 + OPC_CMP_B ): {
+        } break;
             
-            int cursor = snprintf( buf, LEN_16, "CMP" );
-            cursor += printCondField( buf + cursor, extractInstrFieldU( instr, 19, 3 ));
-            return ( cursor );
-        }
+        case ( OPC_GRP_ALU * 16 + OPC_ADD ): setOpStr( e, "ADD" ); setFmt( e, aluFmt ); break;
+        case ( OPC_GRP_ALU * 16 + OPC_SUB ): setOpStr( e, "SUB" ); setFmt( e, aluFmt ); break;
+        case ( OPC_GRP_ALU * 16 + OPC_AND ): setOpStr( e, "AND", cn, nn ); setFmt( e, aluFmt ); break;
+        case ( OPC_GRP_ALU * 16 + OPC_OR ):  setOpStr( e, "OR", cn, nn ); setFmt( e, aluFmt ); break;
+        case ( OPC_GRP_ALU * 16 + OPC_XOR ): setOpStr( e, "XOR", b20 ? ".**" : "", nn ); setFmt( e, aluFmt ); break;
             
-        case ( OPC_GRP_MEM * 16 + OPC_CMP_A ):
-        case ( OPC_GRP_MEM * 16 + OPC_CMP_B ): {
+        case ( OPC_GRP_MEM * 16 + OPC_ADD ): setOpStrDw( e, "ADD" ); setFmt( e, memFmt ); break;
+        case ( OPC_GRP_MEM * 16 + OPC_SUB ): setOpStrDw( e, "SUB" ); setFmt( e, memFmt ); break;
+        case ( OPC_GRP_MEM * 16 + OPC_AND ): setOpStrDw( e, "AND", "", cn, nn ); setFmt( e, memFmt ); break;
+        case ( OPC_GRP_MEM * 16 + OPC_OR ):  setOpStrDw( e, "OR", "", cn, nn ); setFmt( e, memFmt ); break;
+        case ( OPC_GRP_MEM * 16 + OPC_XOR ): setOpStrDw( e, "XOR", "", b20 ? ".**" : "", nn ); setFmt( e, memFmt ); break;
             
-            int cursor = snprintf( buf, LEN_16, "CMP" );
-            cursor += printCondField( buf + cursor, extractInstrFieldU( instr, 19, 3 ));
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            return ( cursor );
-        }
+        case ( OPC_GRP_ALU * 16 + OPC_CMP_A ): setOpStr( e, "CMP", CondStr[ opt ] ); setFmt( e, "%r,%b,%a" ); break;
+        case ( OPC_GRP_ALU * 16 + OPC_CMP_B ): setOpStr( e, "CMP", CondStr[ opt ] ); setFmt( e, "%r,%b,%i" ); break;
+        case ( OPC_GRP_MEM * 16 + OPC_CMP_A ): setOpStrDw( e, "CMP", CondStr[ opt ] ); setFmt( e, "%r,%s(%b)" ); break;
+        case ( OPC_GRP_MEM * 16 + OPC_CMP_B ): setOpStrDw( e, "CMP", CondStr[ opt ] ); setFmt( e, "%r,%a(%b)" ); break;
             
         case ( OPC_GRP_ALU * 16 + OPC_BITOP ): {
             
-            switch ( extractInstrFieldU( instr, 19, 3 )) {
-                    
-                case 0: { // EXTR
-                    
-                    int cursor = snprintf( buf, LEN_16, "EXTR" );
-                    if ( extractInstrBit( instr, 12 )) 
-                        cursor += snprintf( buf + cursor, 4, ".S" );
-                    return ( cursor );
-                }
-                    
-                case 1: { // DEP
-                    
-                    int cursor = snprintf( buf, LEN_16, "DEP" );
-                    if ( extractInstrBit( instr, 12 )) 
-                        cursor += snprintf( buf + cursor, 4, ".Z" );
-                    return ( cursor );
-                }
-                    
-                case 2: { // DSR
-                    
-                    return ( snprintf( buf, LEN_16, "DSR" ));
-                }
-                    
-                default: {
-                    
-                    return ( snprintf( buf, LEN_16, "**BITOP**" ));
-                }
+            if ( opt == 0 ) {
+                
+                setOpStrSel( e, 12, 1, "EXTR", "EXTR.S" );
+                setFmtSel( e, 13, 1, "%r,%b,%p,%l", "%r,%b,SAR,%l" );
             }
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_SHAOP ): {
-
-            switch ( extractInstrFieldU( instr, 19, 3 )) {
-                    
-                case 0:
-                case 1: {
-
-                    switch ( extractInstrFieldU( instr, 13, 2 )) {
-                    
-                        case 1: return ( snprintf( buf, LEN_16, "SHL1A" )); 
-                        case 2: return ( snprintf( buf, LEN_16, "SHL2A" ));
-                        case 3: return ( snprintf( buf, LEN_16, "SHL3A" )); 
-                        default: return ( snprintf( buf, LEN_16, "**SHAOP**" ));
-                    }
+            else if ( opt == 1 ) {
                 
-                } break;
-
-                case 2: 
-                case 3: {
-
-                    switch ( extractInstrFieldU( instr, 13, 2 )) {
-                    
-                        case 1: return ( snprintf( buf, LEN_16, "SHR1A" )); 
-                        case 2: return ( snprintf( buf, LEN_16, "SHR2A" ));
-                        case 3: return ( snprintf( buf, LEN_16, "SHR3A" )); 
-                        default: return ( snprintf( buf, LEN_16, "**SHAOP**" ));
-                    }
-                }  break;
-               
-                default: return ( snprintf( buf, LEN_16, "**SHAOP**" ));
+                setOpStrSel( e, 12, 1, "DEP", "DEP.Z" );
+                setFmtSel( e, 13, 2, "%r,%b,%p,%l", "%r,%b,SAR,%l", "%r,%q,%p,%l", "%r,%q,SAR,%l" );
+            }
+            else if ( opt == 2 ) {
+                
+                setOpStr( e, "DSR" );
+                setFmtSel( e, 13, 1, "%r,%b,%a,%l", "%r,%b,%a,SAR" );
+            }
+            else {
+                
+                setOpStr( e, "**BITOP**" );
+                setFmt( e, "**BITOP**" );
             }
-        }
             
-        case ( OPC_GRP_ALU * 16 + OPC_IMMOP ): {
+        } break;
             
-            switch ( extractInstrFieldU( instr, 20, 2 )) {
-                  
-                case 0:  return ( snprintf( buf, LEN_16, "ADDIL" ));
-                case 1:  return ( snprintf( buf, LEN_16, "LDI.L" ));
-                case 2:  return ( snprintf( buf, LEN_16, "LDI.M" ));
-                case 3:  return ( snprintf( buf, LEN_16, "LDI.U" ));
-            }
-        }
+        case ( OPC_GRP_ALU * 16 + OPC_SHAOP ): {
             
-        case ( OPC_GRP_ALU * 16 + OPC_LDO ): {
+            if      ( opt <= 1 ) setOpStrSel( e, 13, 2, "**SHAOP**", "SHL1A", "SHL2A", "SHL3A" );
+            else if ( opt <= 3 ) setOpStrSel( e, 13, 2, "**SHAOP**", "SHR1A", "SHR2A", "SHR3A" );
+            else                 setOpStr( e, "**SHAOP**" );
             
-            int cursor = snprintf( buf, LEN_16, "LDO" );
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) {
-                
-                cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            }
+            setFmt( e, aluFmt );
             
-            return ( cursor );
-        }
+        } break;
             
-        case ( OPC_GRP_MEM * 16 + OPC_LD ): {
+        case ( OPC_GRP_ALU * 16 + OPC_IMMOP ): {
             
-            int cursor = snprintf( buf, LEN_16, "LD" );
+            const char *name[ 4 ] = { "ADDIL", "LDI.L", "LDI.M", "LDI.U" };
             
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".U" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            return ( cursor );
-        }
+            setOpStr( e, name[ opt >> 1 ] );
+            setFmt( e, "%r,%u" );
             
-        case ( OPC_GRP_MEM * 16 + OPC_ST ): {
+        } break;
             
-            int cursor = snprintf( buf, LEN_16, "ST" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            return ( cursor );
-        }
+        case ( OPC_GRP_ALU * 16 + OPC_LDO ): {
             
-        case ( OPC_GRP_MEM * 16 + OPC_LDR ): {
+            if ( opt == 0 ) setOpStrDw( e, "LDO" );
+            else            setOpStr( e, "LDO" );
             
-            int cursor = snprintf( buf, LEN_16, "LDR" );
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".U" );
+            if      ( opt == 0 ) setFmt( e, "%r,%s(%b)" );
+            else if ( opt == 1 ) setFmt( e, "%r,%a(%b)" );
+            else                 setFmt( e, "***" );
             
-            return ( cursor );
-        }
+        } break;
             
-        case ( OPC_GRP_MEM * 16 + OPC_STC ): {
+        case ( OPC_GRP_MEM * 16 + OPC_LD ):  setOpStrDw( e, "LD", b20 ? ".U" : "" ); setFmt( e, memFmt ); break;
+        case ( OPC_GRP_MEM * 16 + OPC_ST ):  setOpStrDw( e, "ST" ); setFmt( e, memFmt ); break;
+        case ( OPC_GRP_MEM * 16 + OPC_LDR ): setOpStr( e, "LDR", b20 ? ".U" : "" ); setFmt( e, memFmt ); break;
+        case ( OPC_GRP_MEM * 16 + OPC_STC ): setOpStr( e, "STC", ( opt != 0 ) ? ".**" : "" ); setFmt( e, memFmt ); break;
             
-            int cursor = snprintf( buf, LEN_16, "STC" );
-            if ( extractInstrFieldU( instr, 19, 3) != 0 ) {
-                
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            }
-
-            return ( cursor );
-        }
+        case ( OPC_GRP_BR * 16 + OPC_B ):  {
             
-        case ( OPC_GRP_BR * 16 + OPC_B ): {
+            setOpStr( e, "B", ( opt >> 1 ) != 0 ? ".**" : "", b19 ? ".G" : "" );
+            setFmt( e, "%J%R" );
+            
+        } break;
             
-            int cursor = snprintf( buf, LEN_16, "B" );
-            if ( extractInstrFieldU( instr, 20, 2 ) != 0 ) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            if ( extractInstrBit( instr, 19 ))           
-                cursor += snprintf( buf + cursor, 4, ".G" );
-            return ( cursor );
-        }
-
         case ( OPC_GRP_BR * 16 + OPC_BE ): {
             
-            int cursor = snprintf( buf, LEN_16, "BE" );
-            if ( extractInstrFieldU( instr, 20, 2) != 0 ) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            if ( extractInstrBit( instr, 19 ))           
-                cursor += snprintf( buf + cursor, 4, ".G" );
-            return ( cursor );
-        }
-
+            setOpStr( e, "BE", ( opt >> 1 ) != 0 ? ".**" : "", b19 ? ".G" : "" );
+            setFmt( e, "%E(%b)%R" );
+            
+        } break;
+            
         case ( OPC_GRP_BR * 16 + OPC_BR ): 
         case ( OPC_GRP_BR * 16 + OPC_BV ): {
-
-            int cursor = snprintf( buf, LEN_16, "BR" );
-            if ( extractInstrFieldU( instr, 13, 2) == 0 ) 
-                cursor += snprintf( buf + cursor, 4, ".W" );
-            else if ( extractInstrFieldU( instr, 13, 2) == 1 )
-                cursor += snprintf( buf + cursor, 4, ".D" );
-            else if ( extractInstrFieldU( instr, 13, 2) == 2 )
-                cursor += snprintf( buf + cursor, 4, ".Q" );
-            else cursor += snprintf( buf + cursor, 4, ".**" );
-
-            return ( cursor );
-        }
+            
+            setOpStrSel( e, 13, 2, "BR.W", "BR.D", "BR.Q", "BR.**" );
+            setFmt( e, ( opCode == OPC_GRP_BR * 16 + OPC_BR ) ? "%b%R" : "%A(%b)%R" );
+            
+        } break;
             
         case ( OPC_GRP_BR * 16 + OPC_BB ): {
             
-            int cursor = snprintf( buf, LEN_16, "BB" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            if ( extractInstrBit( instr, 19 )) 
-                cursor += snprintf( buf + cursor, 4, ".T" );
-            else  cursor += snprintf( buf + cursor, 4, ".F" );
-            return ( cursor );
-        }
+            setOpStr( e, "BB", b21 ? ".**" : "", b19 ? ".T" : ".F" );
+            setFmt( e, b20 ? "%r,SAR,%K" : "%r,%o,%K" );
             
-        case ( OPC_GRP_BR * 16 + OPC_CBR ): {
+        } break;
             
-            int cursor = snprintf( buf, LEN_16, "CBR" );
-            cursor += printCondField( buf + cursor, 
-                                      extractInstrFieldU( instr, 19, 3 ));
-            return ( cursor );
-        }
+        case ( OPC_GRP_BR * 16 + OPC_CBR ): setOpStr( e, "CBR", CondStr[ opt ] ); setFmt( e, "%r,%b,%I" ); break;
+        case ( OPC_GRP_BR * 16 + OPC_MBR ): setOpStr( e, "MBR", CondStr[ opt ] ); setFmt( e, "%r,%b,%I" ); break;
+        case ( OPC_GRP_BR * 16 + OPC_ABR ): setOpStr( e, "ABR", CondStr[ opt ] ); setFmt( e, "%r,%b,%I" ); break;
             
-        case ( OPC_GRP_BR * 16 + OPC_MBR ): {
+        case ( OPC_GRP_SYS * 16 + OPC_MR ): {
             
-            int cursor = snprintf( buf, LEN_16, "MBR" );
-            cursor += printCondField( buf + cursor, 
-                                      extractInstrFieldU( instr, 19, 3 ));
-            return ( cursor );
-        }
+            const char *name[ 8 ] = { 
 
-        case ( OPC_GRP_BR * 16 + OPC_ABR ): {
+                "MFCR", "MTCR", "**MROP**", "**MROP**", "MFIA", "MFIA.L", "MFIA.R", "MFIA.U" 
+            };
             
-            int cursor = snprintf( buf, LEN_16, "ABR" );
-            cursor += printCondField( buf + cursor, 
-                                     extractInstrFieldU( instr, 19, 3 ));
-            return ( cursor );
-        }
+            setOpStr( e, name[ opt ] );
             
-        case ( OPC_GRP_SYS * 16 + OPC_MR ): {
-
-            switch ( extractInstrFieldU( instr, 19, 3 )) {
-
-                case 0: return ( snprintf( buf, 8, "MFCR"));
-                case 1: return ( snprintf( buf, 8, "MTCR"));
-
-                case 4: return ( snprintf( buf, 8, "MFIA"));
-                case 5: return ( snprintf( buf, 8, "MFIA.L"));
-                case 6: return ( snprintf( buf, 8, "MFIA.R"));
-                case 7: return ( snprintf( buf, 8, "MFIA.U"));
-
-                default: return ( snprintf( buf, LEN_16, "**MROP**" ));
-            }
-        }
+            if      ( opt == 0 ) setFmt( e, "%r, C%l" );
+            else if ( opt == 1 ) setFmt( e, "%r, C%n,R%l" );
+            else if ( b21 )      setFmt( e, "%r" );
+            else                 setFmt( e, "%r,%A(%b)" );
+            
+        } break;
             
         case ( OPC_GRP_SYS * 16 + OPC_LPA ): {
             
-            int cursor = 0;
-        
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) 
-                cursor = snprintf( buf, LEN_16, "LPA" );
-            else                                     
-                cursor = snprintf( buf, LEN_16, "**LPAOP**" );
+            setOpStr( e, ( opt == 0 ) ? "LPA" : "**LPAOP**" );
+            setFmt( e, "%r,%A(%b)" );
             
-            return ( cursor );
-        }
+        } break;
             
         case ( OPC_GRP_SYS * 16 + OPC_PRB ): {
             
-            int cursor = 0;
+            setOpStr( e, ( opt == 0 ) ? "PRB" : "**PRBOP**" );
+            setFmtSel( e, 13, 2, "%r,%b,%m", "%r,%b,%m", "%r,%b,%m", "%r,%b,%a" );
             
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) 
-                cursor = snprintf( buf, LEN_16, "PRB" );
-            else                                    
-                cursor = snprintf( buf, LEN_16, "**PRBOP**" );
-            return ( cursor );
-        }
+        } break;
             
         case ( OPC_GRP_SYS * 16 + OPC_TLB ): {
-
-            switch ( extractInstrFieldU( instr, 19, 3 )) {
-
-                case 0: return ( snprintf( buf, LEN_16, "IITLB" ));
-                case 1: return ( snprintf( buf, LEN_16, "IDTLB" ));
-                case 2: return ( snprintf( buf, LEN_16, "PITLB" ));
-                case 3: return ( snprintf( buf, LEN_16, "PDTLB" ));
-                default: return ( snprintf( buf, 8, "**TLB**" ));
-            }
-        }
             
-        case ( OPC_GRP_SYS * 16 + OPC_CA ): {
-
-            switch ( extractInstrFieldU( instr, 19, 3 )) {
-
-                case 0: return ( snprintf( buf, LEN_16, "PICA" ));
-                case 1: return ( snprintf( buf, LEN_16, "PDCA" ));
-                case 2: return ( snprintf( buf, LEN_16, "FICA" ));
-                case 3: return ( snprintf( buf, LEN_16, "FDCA" ));
-                default: return ( snprintf( buf, 8, "**CA**" ));
-            }
-        }
+            const char *name[ 4 ] = { "IITLB", "IDTLB", "PITLB", "PDTLB" };
             
-        case ( OPC_GRP_SYS * 16 + OPC_MST ): {
+            setOpStr( e, ( opt < 4 ) ? name[ opt ] : "**TLB**" );
             
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) 
-                return ( snprintf( buf, LEN_16, "RSM" ));
-            else if ( extractInstrFieldU( instr, 19, 3 ) == 1 )
-                 return ( snprintf( buf, LEN_16, "SSM" ));
-            else 
-                return ( snprintf( buf, 8, "**MST**" ));
-        }
+            if      ( opt <= 1 ) setFmt( e, "%r,%b,%a" );
+            else if ( opt <= 3 ) setFmt( e, "%P%A(%b)" );
             
-        case ( OPC_GRP_SYS * 16 + OPC_RFI ):   {
+        } break;
             
-            return ( snprintf( buf, LEN_16, "RFI" ));
-        }
+        case ( OPC_GRP_SYS * 16 + OPC_CA ): {
             
-        case ( OPC_GRP_SYS * 16 + OPC_TRAP ):  {
+            const char *name[ 4 ] = { "PICA", "PDCA", "FICA", "FDCA" };
             
-            return ( snprintf( buf, LEN_16, "TRAP" ));
-        }
+            setOpStr( e, ( opt < 4 ) ? name[ opt ] : "**CA**" );
+            setFmt( e, "%P%A(%b)" );
             
-        case ( OPC_GRP_SYS * 16 + OPC_DIAG ):  {
+        } break;
             
-            return ( snprintf( buf, LEN_16, "DIAG" ));
-        }
+        case ( OPC_GRP_SYS * 16 + OPC_MST ): {
             
-        case ( OPC_GRP_ALU * 16 + OPC_NOP ): {
+            setOpStr( e, ( opt == 0 ) ? "RSM" : (( opt == 1 ) ? "SSM" : "**MST**" ));
+            setFmt( e, "%r,%l" );
             
-            return ( snprintf( buf, LEN_16, "NOP" ));
-        }
+        } break;
+            
+        case ( OPC_GRP_SYS * 16 + OPC_RFI ):  setOpStr( e, "RFI" ); break;
+        case ( OPC_GRP_SYS * 16 + OPC_TRAP ): setOpStr( e, "TRAP" ); setFmt( e, "%t,%b,%a" ); break;
+        case ( OPC_GRP_SYS * 16 + OPC_DIAG ): setOpStr( e, "DIAG" ); setFmt( e, "%t, %b,%a%R" ); break;
             
         default: {
             
-            return ( snprintf( buf, LEN_16, "**OPC:%d**", opCode ));
+            for ( int i = 0; i < 4; i++ ) {
+                
+                addStr( e.opStr[ i ], "**OPC:" );
+                addNum( e.opStr[ i ], (int) opCode );
+                addStr( e.opStr[ i ], "**" );
+            }
+            
+            setFmt( e, "**OPC:%c**" );
         }
     }
+    
+    return ( e );
+}
+
+constexpr DisTab buildDisTab( ) {
+    
+    DisTab tab;
+    
+    for ( int i = 0; i < DIS_TAB_SIZE; i++ ) {
+        
+        tab.entry[ i ] = buildDisEntry((uint32_t) i >> 3, (uint32_t) i & 7 );
+    }
+    
+    return ( tab );
+}
+
+constexpr DisTab DisAsmTab = buildDisTab( );
+
+//----------------------------------------------------------------------------------------
+// Look up the decode table entry for an instruction and select the variant.
+//
+//----------------------------------------------------------------------------------------
+inline const DisEntry &lookupDisEntry( T64Instr instr ) {
+    
+    return ( DisAsmTab.entry[ (( instr >> 26 ) << 3 ) | (( instr >> 19 ) & 7 ) ] );
+}
+
+inline int selectVariant( T64Instr instr, int pos, int len ) {
+    
+    return ((int) ( instr >> pos ) & (( 1 << len ) - 1 ));
 }
 
 //----------------------------------------------------------------------------------------
-// Decode the instruction operands. An opcode consist of the instruction group and 
-// the opcode family. We construct the final opcode for the case statement.
+// Fast output helpers. They append to the buffer and return the new cursor.
+//
+//----------------------------------------------------------------------------------------
+inline int putStr( char *buf, int cursor, const char *str ) {
+    
+    while ( *str != 0 ) buf[ cursor++ ] = *str++;
+    return ( cursor );
+}
+
+inline int putNum( char *buf, int cursor, int val ) {
+    
+    char        digits[ 12 ];
+    int         i       = 0;
+    uint32_t    uVal    = ( val < 0 ) ? - (uint32_t) val : (uint32_t) val;
+    
+    if ( val < 0 ) buf[ cursor++ ] = '-';
+    
+    do {
+        
+        digits[ i++ ] = (char) ( '0' + ( uVal % 10 ));
+        uVal /= 10;
+    }
+    while ( uVal > 0 );
+    
+    while ( i > 0 ) buf[ cursor++ ] = digits[ --i ];
+    return ( cursor );
+}
+
+inline int putReg( char *buf, int cursor, int regNum ) {
+    
+    buf[ cursor++ ] = 'R';
+    return ( putNum( buf, cursor, regNum ));
+}
+
+//----------------------------------------------------------------------------------------
+// Decode the opcode and opcode option portion. The string is taken from the 
+// decode table. The buffer is at least "LEN_16" bytes long.
+//
+//----------------------------------------------------------------------------------------
+int buildOpCodeStr( char *buf, T64Instr instr ) {
+    
+    const DisEntry  &e      = lookupDisEntry( instr );
+    int             cursor  = putStr( buf, 0, e.opStr[ selectVariant( instr, 
+                                                                      e.opSelPos, 
+                                                                      e.opSelLen ) ] );
+    buf[ cursor ] = 0;
+    return ( cursor );
+}
+
+//----------------------------------------------------------------------------------------
+// Decode the instruction operands. The format string for the instruction is 
+// taken from the decode table and interpreted. The buffer is at least "LEN_32"
+// bytes long.
 //
 //----------------------------------------------------------------------------------------
 int buildOperandStr( char *buf, uint32_t instr, int rdx ) {
     
-    uint32_t opCode = 
-        extractInstrFieldU( instr, 30, 2 ) * 16 + extractInstrFieldU( instr, 26, 4 );
+    const DisEntry  &e      = lookupDisEntry( instr );
+    const char      *fmt    = e.fmt[ selectVariant( instr, e.fmtSelPos, e.fmtSelLen ) ];
+    int             cursor  = 0;
     
-    switch ( opCode ) {
-            
-        case ( OPC_GRP_ALU * 16 + OPC_ADD   ):
-        case ( OPC_GRP_ALU * 16 + OPC_SUB   ):
-        case ( OPC_GRP_ALU * 16 + OPC_AND   ):
-        case ( OPC_GRP_ALU * 16 + OPC_OR    ):
-        case ( OPC_GRP_ALU * 16 + OPC_XOR   ): {
+    for ( ; *fmt != 0; fmt++ ) {
+        
+        if ( *fmt != '%' ) {
             
-            if ( extractInstrBit( instr, 19 )) {
+            buf[ cursor++ ] = *fmt;
+            continue;
+        }
+        
+        switch ( *( ++ fmt )) {
                 
-                return ( snprintf( buf, LEN_32, "R%d,R%d,%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrSignedImm15( instr )));
-            }
-            else {
+            case 'r': cursor = putReg( buf, cursor, extractInstrRegR( instr )); break;
+            case 'b': cursor = putReg( buf, cursor, extractInstrRegB( instr )); break;
+            case 'a': cursor = putReg( buf, cursor, extractInstrRegA( instr )); break;
+            case 'n': cursor = putNum( buf, cursor, extractInstrRegB( instr )); break;
                 
-                return ( snprintf( buf, LEN_32, "R%d,R%d,R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrRegA( instr )));
-            }
-        }
-
-        case ( OPC_GRP_ALU * 16 + OPC_CMP_A ):
-        case ( OPC_GRP_ALU * 16 + OPC_CMP_B ): {
-            
-            if ( extractInstrBit( instr, 26 )) {
+            case 'i': cursor = putNum( buf, cursor, extractInstrSignedImm15( instr )); break;
+            case 'I': cursor = putNum( buf, cursor, extractInstrSignedImm15( instr ) << 2 ); break;
+            case 'J': cursor = putNum( buf, cursor, extractInstrSignedImm19( instr ) << 2 ); break;
+            case 'K': cursor = putNum( buf, cursor, extractInstrSignedImm13( instr ) << 2 ); break;
+            case 's': cursor = putNum( buf, cursor, extractInstrSignedScaledImm13( instr )); break;
+            case 'u': cursor = putNum( buf, cursor, extractInstrImm20( instr )); break;
                 
-                return ( snprintf( buf, LEN_32, "R%d,R%d,%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrSignedImm15( instr )));
-            }
-            else {
+            case 'l': cursor = putNum( buf, cursor, extractInstrFieldU( instr, 0, 6 )); break;
+            case 'p': cursor = putNum( buf, cursor, extractInstrFieldU( instr, 6, 6 )); break;
+            case 'q': cursor = putNum( buf, cursor, extractInstrFieldU( instr, 15, 4 )); break;
+            case 'o': cursor = putNum( buf, cursor, extractInstrFieldU( instr, 13, 6 )); break;
+            case 'm': cursor = putNum( buf, cursor, extractInstrFieldU( instr, 13, 2 )); break;
+            case 'c': cursor = putNum( buf, cursor, (int) ( instr >> 26 )); break;
                 
-                return ( snprintf( buf, LEN_32, "R%d,R%d,R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrRegA( instr )));
-            }
-        }
- 
-        case ( OPC_GRP_ALU * 16 + OPC_BITOP ): {
-            
-            switch ( extractInstrFieldU( instr, 19, 3 )) {
-                    
-                case 0: { // EXTR
+            case 't': {
+                
+                cursor = putNum( buf, cursor, 
+                                 ( extractInstrFieldU( instr, 19, 3 ) << 2 ) + 
+                                 extractInstrFieldU( instr, 13, 2 ));
+            } break;
+                
+            case 'R': {
+                
+                if ( extractInstrRegR( instr ) != 0 ) {
                     
-                    if ( extractInstrBit( instr, 13 )) {
-                        
-                        return ( snprintf( buf, LEN_32, "R%d,R%d,SAR,%d",
-                                           extractInstrRegR( instr ),
-                                           extractInstrRegB( instr ),
-                                           extractInstrFieldU( instr, 0, 6 )));
-                    }
-                    else {
-                        
-                        return ( snprintf( buf, LEN_32, "R%d,R%d,%d,%d",
-                                           extractInstrRegR( instr ),
-                                           extractInstrRegB( instr ),
-                                           extractInstrFieldU( instr, 6, 6 ),
-                                           extractInstrFieldU( instr, 0, 6 )));
-                    }
+                    buf[ cursor++ ] = ',';
+                    cursor = putReg( buf, cursor, extractInstrRegR( instr ));
                 }
+            } break;
+                
+            case 'P': {
+                
+                if ( extractInstrRegR( instr ) != 0 ) {
                     
-                case 1: { // DEP
-                    
-                    if ( extractInstrBit( instr, 14 )) {
-                        
-                        if ( extractInstrBit( instr, 13 )) {
-                            
-                            return ( snprintf( buf, LEN_32, "R%d,%d,SAR,%d",
-                                               extractInstrRegR( instr ),
-                                               extractInstrFieldU( instr, 15, 4 ),
-                                               extractInstrFieldU( instr, 0, 6 )));
-                        }
-                        else {
-                            
-                            return ( snprintf( buf, LEN_32, "R%d,%d,%d,%d",
-                                               extractInstrRegR( instr ),
-                                               extractInstrFieldU( instr, 15, 4 ),
-                                               extractInstrFieldU( instr, 6, 6 ),
-                                               extractInstrFieldU( instr, 0, 6 )));
-                        }
-                    }
-                    else {
-                        
-                        if ( extractInstrBit( instr, 13 )) {
-                            
-                            return ( snprintf( buf, LEN_32, "R%d,R%d,SAR,%d",
-                                               extractInstrRegR( instr ),
-                                               extractInstrRegB( instr ),
-                                               extractInstrFieldU( instr, 0, 6 )));
-                        }
-                        else {
-                            
-                            return ( snprintf( buf, LEN_32, "R%d,R%d,%d,%d",
-                                               extractInstrRegR( instr ),
-                                               extractInstrRegB( instr ),
-                                               extractInstrFieldU( instr, 6, 6 ),
-                                               extractInstrFieldU( instr, 0, 6 )));
-                        }
-                    }
+                    cursor = putReg( buf, cursor, extractInstrRegR( instr ));
+                    buf[ cursor++ ] = ',';
                 }
+            } break;
+                
+            case 'A': {
+                
+                if ( extractInstrRegA( instr ) != 0 ) {
                     
-                case 2: { // DSR
-                    
-                    if ( extractInstrBit( instr, 13 )) {
-                        
-                        return ( snprintf( buf, LEN_32, "R%d,R%d,R%d,SAR",
-                                           extractInstrRegR( instr ),
-                                           extractInstrRegB( instr ),
-                                           extractInstrRegA( instr )));
-                    }
-                    else {
-                        
-                        return ( snprintf( buf, LEN_32, "R%d,R%d,R%d,%d",
-                                           extractInstrRegR( instr ),
-                                           extractInstrRegB( instr ),
-                                           extractInstrRegA( instr ),
-                                           extractInstrFieldU( instr, 0, 6 )));
-                    }
+                    cursor = putReg( buf, cursor, extractInstrRegA( instr ));
                 }
-                    
-                default: return ( snprintf( buf, LEN_32, "**BITOP**" ));
-            }
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_SHAOP ): {
-            
-            if ( extractInstrBit( instr, 19 )) {
-                
-                return ( snprintf( buf, LEN_32, "R%d,R%d,%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrSignedImm15( instr )));
-            }
-            else {
+            } break;
                 
-                return ( snprintf( buf, LEN_32, "R%d,R%d,R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrRegA( instr )));
-            }
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_IMMOP ): {
-            
-            return ( snprintf( buf, LEN_32, "R%d,%d",
-                              extractInstrRegR( instr ),
-                              extractInstrImm20( instr )));
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_ADD   ):
-        case ( OPC_GRP_MEM * 16 + OPC_SUB   ):
-        case ( OPC_GRP_MEM * 16 + OPC_AND   ):
-        case ( OPC_GRP_MEM * 16 + OPC_OR    ):
-        case ( OPC_GRP_MEM * 16 + OPC_XOR   ):
-        case ( OPC_GRP_MEM * 16 + OPC_LD    ):
-        case ( OPC_GRP_MEM * 16 + OPC_ST    ):
-        case ( OPC_GRP_MEM * 16 + OPC_LDR   ):
-        case ( OPC_GRP_MEM * 16 + OPC_STC   ): {
-            
-            if ( extractInstrBit( instr, 19 ) == 0 ) {
+            case 'E': {
                 
-                return ( snprintf( buf, LEN_32, "R%d,%d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrSignedScaledImm13( instr ),
-                                   extractInstrRegB( instr )));
-            }
-            else {
+                if ( extractInstrSignedImm15( instr ) != 0 ) {
+                    
+                    cursor = putNum( buf, cursor, extractInstrSignedImm15( instr ) << 2 );
+                }
+            } break;
                 
-                return ( snprintf( buf, LEN_32, "R%d,R%d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegA( instr ),
-                                   extractInstrRegB( instr )));
-            }
+            default: buf[ cursor++ ] = '?';
         }
+    }
+    
+    buf[ cursor ] = 0;
+    return ( cursor );
+}
 
-        case ( OPC_GRP_MEM * 16 + OPC_CMP_A ):
-        case ( OPC_GRP_MEM * 16 + OPC_CMP_B ): {
-            
-            if ( extractInstrBit( instr, 26 ) == 0 ) {
-                
-                return ( snprintf( buf, LEN_32, "R%d,%d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrSignedScaledImm13( instr ),
-                                   extractInstrRegB( instr )));
-            }
-            else {
-                
-                return ( snprintf( buf, LEN_32, "R%d,R%d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegA( instr ),
-                                   extractInstrRegB( instr )));
-            }
-        }
+//----------------------------------------------------------------------------------------
+// The branch target of an instruction address relative branch. The offsets are
+// decoded the same way as for the operand string.
+//
+//----------------------------------------------------------------------------------------
+bool branchTarget( uint32_t instr, T64Word adr, T64Word *target ) {
 
-        case ( OPC_GRP_ALU * 16 + OPC_LDO ): {
+    switch ( instr >> 26 ) {
 
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) {
-                
-                return ( snprintf( buf, LEN_32, "R%d,%d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrSignedScaledImm13( instr ),
-                                   extractInstrRegB( instr )));
-            }
-            else if ( extractInstrFieldU( instr, 19, 3 ) == 1 ) {
-            
-                return ( snprintf( buf, LEN_32, "R%d,R%d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegA( instr ),
-                                   extractInstrRegB( instr )));
-            } 
-            else return( snprintf( buf, LEN_32, "***" ));
-        }
-            
         case ( OPC_GRP_BR * 16 + OPC_B ): {
-            
-            int cursor = snprintf( buf, LEN_32, "%d", 
-                                   extractInstrSignedImm19( instr ) << 2 );
-            
-            if ( extractInstrRegR( instr ) != 0 ) {
-
-                cursor += snprintf( buf + cursor, LEN_32, ",R%d", 
-                                    extractInstrRegR( instr ));
-            }
-            
-            return ( cursor );
-        }
-
-        case ( OPC_GRP_BR * 16 + OPC_BE ): {
-
-            int cursor = 0;
-            
-            if ( extractInstrSignedImm15( instr ) != 0 ) {
 
-                cursor += snprintf( buf, LEN_32, "%d", 
-                                    extractInstrSignedImm15( instr ) << 2 );
-            }
-
-            cursor += snprintf( buf + cursor, LEN_32, "(R%d)", 
-                                extractInstrRegB( instr ));
-            
-            if ( extractInstrRegR( instr ) != 0 ) {
-
-                cursor += snprintf( buf + cursor, LEN_32, ",R%d", 
-                                    extractInstrRegR( instr ));
-            }
-            
-            return ( cursor );
+            *target = adr + ( extractInstrSignedImm19( instr ) << 2 );
+            return( true );
         }
-            
-        case ( OPC_GRP_BR * 16 + OPC_BR ): {
 
-            int cursor = snprintf( buf, LEN_32, "R%d", extractInstrRegB( instr ));
-            
-            if ( extractInstrRegR( instr ) != 0 ) {
-
-                cursor += snprintf( buf + cursor, LEN_32, ",R%d", 
-                                    extractInstrRegR( instr ));
-            }
-        
-            return ( cursor ); 
-        }
-
-         case ( OPC_GRP_BR * 16 + OPC_BV ): {
-
-            int cursor = 0;
-
-            if ( extractInstrRegA( instr ) != 0 ) {
-
-                cursor += snprintf( buf + cursor, LEN_16, "R%d", 
-                                    extractInstrRegA( instr ));
-            }
-            
-            cursor += snprintf( buf + cursor, LEN_32, "(R%d)",
-                                extractInstrRegB( instr ));
-
-            if ( extractInstrRegR( instr ) != 0 ) {
-
-                cursor += snprintf( buf + cursor, LEN_32, ",R%d", 
-                                    extractInstrRegR( instr ));
-                }
-
-            return ( cursor );
-        }
-            
         case ( OPC_GRP_BR * 16 + OPC_BB ): {
-            
-            int cursor = snprintf( buf, LEN_32, "R%d", extractInstrRegR( instr ));
-            
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, LEN_32, ",SAR" );
-            else  
-                cursor += snprintf( buf + cursor, LEN_32, ",%d", 
-                                    extractInstrFieldU( instr, 13, 6 ));
-            
-            cursor += snprintf( buf + cursor, LEN_32, ",%d", 
-                                extractInstrSignedImm13( instr ) << 2 );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_BR * 16 + OPC_ABR ):
-        case ( OPC_GRP_BR * 16 + OPC_CBR ):
-        case ( OPC_GRP_BR * 16 + OPC_MBR ):  {
-            
-            int cursor = snprintf( buf, LEN_32, "R%d,R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ));
-            
-            cursor += snprintf( buf + cursor, LEN_32, ",%d", 
-                                extractInstrSignedImm15( instr ) << 2);
-            
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_MR ): {
-
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) {
-            
-                return ( snprintf( buf, LEN_32, "R%d, C%d",
-                                    extractInstrRegR( instr ),
-                                    extractInstrFieldU( instr, 0, 6 )));
-            }
-            else if (extractInstrFieldU( instr, 19, 3 ) == 1 ) {
-            
-                return ( snprintf( buf, LEN_32, "R%d, C%d,R%d",
-                                    extractInstrRegR( instr ),
-                                    extractInstrRegB( instr ),
-                                    extractInstrFieldU( instr, 0, 6 )));
-            }
-            else if ( extractInstrBit( instr, 21 )) {
-
-                return ( snprintf( buf, LEN_32, "R%d",
-                                    extractInstrRegR( instr )));
-            }
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_LPA ): {
-
-            int cursor = snprintf( buf, LEN_32, "R%d,", extractInstrRegR( instr ));
-
-            if ( extractInstrRegA( instr ) != 0 ) {
-
-                    cursor += snprintf( buf + cursor, LEN_32, "R%d", 
-                                        extractInstrRegA( instr ));
-            }
-
-            cursor += snprintf( buf + cursor, LEN_32, "(R%d)", 
-                                extractInstrRegB( instr ));
-            
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_PRB ): {
-
-            int mode = extractInstrFieldU( instr, 13, 2 );
-
-            if (( mode >= 0 ) && ( mode <= 2 )) {
-                
-                return ( snprintf( buf, LEN_32, "R%d,R%d,%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   mode ));
-            }
-            else if ( mode == 3 ) {
-                
-                return ( snprintf( buf, LEN_32, "R%d,R%d,R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrRegA( instr )));
-            }
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_TLB ): {
-
-            int cursor = 0;
-            int field = extractInstrFieldU( instr, 19, 3 );
-
-            if (( field == 0 ) || ( field == 1 )) {
-            
-                return ( snprintf( buf + cursor, LEN_32, "R%d,R%d,R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrRegA( instr )));
-            }
-            else if (( field == 2 ) || ( field == 3 )) {
-
-                if ( extractInstrRegR( instr ) != 0 ) {
 
-                    cursor += snprintf( buf + cursor, LEN_32, "R%d,", 
-                                        extractInstrRegR( instr ));
-                }
-
-                if ( extractInstrRegA( instr ) != 0 ) {
-
-                        cursor += snprintf( buf + cursor, LEN_32, "R%d", 
-                                            extractInstrRegA( instr ));
-                }
-
-                cursor += snprintf( buf + cursor, LEN_32, "(R%d)", 
-                                    extractInstrRegB( instr ));
-            }
-            
-            return ( cursor );
+            *target = adr + ( extractInstrSignedImm13( instr ) << 2 );
+            return( true );
         }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_CA ): {
-
-            int cursor = 0;
-
-            if ( extractInstrRegR( instr ) != 0 ) {
-
-                    cursor += snprintf( buf + cursor, LEN_32, "R%d,", 
-                                        extractInstrRegR( instr ));
-            }
 
-            if ( extractInstrRegA( instr ) != 0 ) {
-
-                cursor += snprintf( buf + cursor, LEN_32, "R%d", 
-                                    extractInstrRegA( instr ));
-            }
-
-            cursor += snprintf( buf + cursor, LEN_32, "(R%d)", 
-                                extractInstrRegB( instr ));
-            
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_MST ): {
-            
-            return ( snprintf( buf, LEN_32, "R%d,%d", 
-                               extractInstrRegR( instr ),
-                               extractInstrFieldU( instr, 0, 6 )));
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_RFI ): {
-            
-            return ( 0 );
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_TRAP ):  {
+        case ( OPC_GRP_BR * 16 + OPC_CBR ): 
+        case ( OPC_GRP_BR * 16 + OPC_MBR ):
+        case ( OPC_GRP_BR * 16 + OPC_ABR ): {
 
-            int info = ( extractInstrFieldU( instr, 19, 3 ) << 2 ) +
-                         extractInstrFieldU( instr, 13, 2 );
-            
-            
-            return ( snprintf( buf, LEN_32, "%d,R%d,R%d", 
-                               info, 
-                               extractInstrRegB( instr ), 
-                               extractInstrRegA( instr ) ));
+            *target = adr + ( extractInstrSignedImm15( instr ) << 2 );
+            return( true );
         }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_DIAG ):  {
-
-            int cursor = 0;
 
-            cursor = snprintf( buf, LEN_32, "%d, R%d,R%d",
-                               ( extractInstrFieldU( instr, 19, 3 ) << 2 ) + 
-                               extractInstrFieldU( instr, 13, 2 ),
-                               extractInstrRegB( instr ),
-                               extractInstrRegA( instr ));
-
-            if ( extractInstrRegR( instr ) != 0 ) {
-
-                cursor += snprintf( buf + cursor, LEN_32, ",R%d", 
-                                    extractInstrRegR( instr ));
-            }
-                
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_NOP ): {
-            
-            buf[0] = '\0';
-            return ( 0 );
-        }
-            
-        default: return ( snprintf( buf, LEN_32, "**OPC:%d**", opCode ));
+        default: return( false );
     }
 }
 
+//----------------------------------------------------------------------------------------
+// Format the instruction as opCode and operands separated by a blank.
+//
+//----------------------------------------------------------------------------------------
+int buildInstrStr( char *buf, uint32_t instr, int rdx ) {
+    
+    int cursor = buildOpCodeStr( buf, instr );
+    
+    buf[ cursor ] = ' ';
+    
+    int len = buildOperandStr( buf + cursor + 1, instr, rdx );
+    if ( len > 0 ) cursor += len + 1;
+    
+    buf[ cursor ] = 0;
+    return ( cursor );
+}
+
 } // namespace
 
 
@@ -1038,17 +670,58 @@ int T64DisAssemble::formatInstr( char *buf,
     
     if ( bufLen >= ( getOpCodeFieldWidth( ) + 1 + getOperandsFieldWidth( ))) {
         
-        char operandBuf[ LEN_32 ];
+        return ( buildInstrStr( buf, instr, rdx ));
+    }
+    else return ( -1 );
+}
 
-        int cursor = buildOpCodeStr( buf, instr );
-        
-        int len = buildOperandStr( operandBuf, instr, rdx );
-        if ( len > 0 ) {
-            
-            cursor += snprintf( buf + cursor, LEN_32, " %s", operandBuf );
-        }
+//----------------------------------------------------------------------------------------
+// Format a list of instructions, one per line. The lines are terminated by a 
+// newline character and the buffer is terminated by a zero byte. We format the
+// instructions as long as there is room for a full line. The function returns 
+// the number of instructions formatted, the length of the text is returned in 
+// "len" when specified.
+//
+//----------------------------------------------------------------------------------------
+int T64DisAssemble::formatInstrList( char            *buf, 
+                                     int             bufLen, 
+                                     const uint32_t  *instr, 
+                                     int             count, 
+                                     int             rdx, 
+                                     int             *len ) {
+    
+    int cursor  = 0;
+    int i       = 0;
+    
+    for ( ; ( i < count ) && ( cursor + DIS_LINE_LEN < bufLen ); i++ ) {
         
-        return ( cursor );
+        cursor += buildInstrStr( buf + cursor, instr[ i ], rdx );
+        buf[ cursor++ ] = '\n';
     }
-    else return ( -1 );
+    
+    if ( bufLen > 0 ) buf[ cursor ] = 0;
+    if ( len != nullptr ) *len = cursor;
+    return ( i );
+}
+
+//----------------------------------------------------------------------------------------
+// Format the branch target of the instruction at address "adr" as a symbol. We
+// return the length of the string, zero when the instruction is not a relative
+// branch, there is no symbol table or the target has no symbol.
+//
+//----------------------------------------------------------------------------------------
+void T64DisAssemble::setSymTab( T64SymTab *symTab ) {
+
+    this -> symTab = symTab;
+}
+
+int T64DisAssemble::formatTarget( char *buf, int bufLen, uint32_t instr, T64Word adr ) {
+
+    T64Word target = 0;
+
+    if ( bufLen > 0 ) buf[ 0 ] = 0;
+
+    if (( symTab == nullptr ) || ( ! branchTarget( instr, adr, &target ))) return( 0 );
+
+    return( symTab -> formatAdr( buf, bufLen, target ));
 }
@@ -9,8 +9,19 @@
 // possible to have several memory modules, each mapping a different range of 
 // physical memory. The read and write function merely copy data from and to 
 // memory. The address must however be aligned to the length of the data to 
-// fetch. The memory is protected by a lock, which is held during the entire 
-// read or write operation.
+// fetch. There is no lock for the read and write operation, the aligned data 
+// item is accessed with a single host load or store. Only the LDR / STC bus
+// operations lock the memory line they access.
+//
+// The memory data is allocated as an anonymous page aligned memory mapping that
+// only reserves the address space. Host pages are zero filled when they are 
+// first touched, a large memory module that the program hardly uses costs 
+// almost nothing. A reset just gives the host pages back. A
+// snapshot writes the memory data as an image file, which a restore maps copy
+// on write in place of the memory data. Restoring a large memory is therefore
+// cheap, pages are only read from the image when touched. The memory keeps a
+// dirty flag per page, so that an incremental snapshot only writes the pages
+// modified since the previous snapshot.
 //
 //----------------------------------------------------------------------------------------
 //
@@ -29,6 +40,212 @@
 //
 //----------------------------------------------------------------------------------------
 #include "T64-Memory.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <stdio.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+#endif
+
+//----------------------------------------------------------------------------------------
+// Name space for local routines.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// Snapshot record kinds and the image file name.
+//
+//----------------------------------------------------------------------------------------
+const uint32_t  MEM_SNAP_FULL           = 1;
+const uint32_t  MEM_SNAP_INCREMENTAL    = 2;
+const char      *MEM_SNAP_IMAGE_NAME    = "mem.img";
+
+//----------------------------------------------------------------------------------------
+// Host memory for the memory data. On a POSIX host, we allocate an anonymous
+// memory mapping without reserving swap space for it. Clearing anonymous memory
+// releases the host pages, the next touch will find a zero filled page. When an
+// image file is mapped, we map fresh anonymous pages at the same address. In
+// both cases, the direct pointers held by the processors stay valid. On a 
+// Windows host, we just allocate and clear the memory.
+//
+//----------------------------------------------------------------------------------------
+uint8_t *allocMemData( size_t len ) {
+
+#ifdef _WIN32
+    return((uint8_t *) calloc( len, sizeof( uint8_t )));
+#else
+    void *p = mmap( nullptr, len, PROT_READ | PROT_WRITE, 
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+
+    return(( p == MAP_FAILED ) ? nullptr : (uint8_t *) p );
+#endif
+}
+
+void freeMemData( uint8_t *memData, size_t len ) {
+
+#ifdef _WIN32
+    free( memData );
+#else
+    munmap( memData, len );
+#endif
+}
+
+void clearMemData( uint8_t *memData, size_t len, bool imageMapped ) {
+
+#ifdef _WIN32
+    memset( memData, 0, len );
+#else
+    if (( ! imageMapped ) && ( madvise( memData, len, MADV_DONTNEED ) == 0 )) return;
+
+    if ( mmap( memData, len, PROT_READ | PROT_WRITE, 
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, 
+               -1, 0 ) == MAP_FAILED ) {
+
+        memset( memData, 0, len );
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------------------
+// Block copy and fill. Processors may access the memory data concurrently, the
+// aligned words of a block are therefore loaded or stored with a single host 
+// access each, just like a word of a bus read or write event. Only the unaligned
+// head and tail are accessed byte by byte.
+//
+//----------------------------------------------------------------------------------------
+void loadBlock( uint8_t *dst, uint8_t *src, T64Word len ) {
+
+    T64Word i = 0;
+
+    for ( ; ( i < len ) && (((uintptr_t) ( src + i )) % sizeof( T64Word ) != 0 ); i++ ) {
+
+        loadDataItem( dst + i, src + i, 1 );
+    }
+
+    for ( ; i + sizeof( T64Word ) <= (size_t) len; i += sizeof( T64Word )) {
+
+        loadDataItem( dst + i, src + i, sizeof( T64Word ));
+    }
+
+    for ( ; i < len; i++ ) loadDataItem( dst + i, src + i, 1 );
+}
+
+void storeBlock( uint8_t *dst, const uint8_t *src, T64Word len ) {
+
+    T64Word i = 0;
+
+    for ( ; ( i < len ) && (((uintptr_t) ( dst + i )) % sizeof( T64Word ) != 0 ); i++ ) {
+
+        storeDataItem( dst + i, (uint8_t *) src + i, 1 );
+    }
+
+    for ( ; i + sizeof( T64Word ) <= (size_t) len; i += sizeof( T64Word )) {
+
+        storeDataItem( dst + i, (uint8_t *) src + i, sizeof( T64Word ));
+    }
+
+    for ( ; i < len; i++ ) storeDataItem( dst + i, (uint8_t *) src + i, 1 );
+}
+
+void fillBlock( uint8_t *dst, uint8_t val, T64Word len ) {
+
+    uint8_t buf[ sizeof( T64Word ) ];
+    memset( buf, val, sizeof( buf ));
+
+    T64Word i = 0;
+
+    for ( ; ( i < len ) && (((uintptr_t) ( dst + i )) % sizeof( T64Word ) != 0 ); i++ ) {
+
+        storeDataItem( dst + i, buf, 1 );
+    }
+
+    for ( ; i + sizeof( T64Word ) <= (size_t) len; i += sizeof( T64Word )) {
+
+        storeDataItem( dst + i, buf, sizeof( T64Word ));
+    }
+
+    for ( ; i < len; i++ ) storeDataItem( dst + i, buf, 1 );
+}
+
+//----------------------------------------------------------------------------------------
+// Count the host memory in use for the memory data. We ask the host which of
+// the host pages are resident. The hosts do not agree on the type of the page
+// vector, the little template takes whatever "mincore" expects. On a Windows 
+// host, all memory is in use.
+//
+//----------------------------------------------------------------------------------------
+#ifndef _WIN32
+template <typename A, typename T>
+int hostMincore( int (*fn)( A, size_t, T * ), void *adr, size_t len, unsigned char *vec ) {
+
+    return( fn( adr, len, (T *) vec ));
+}
+#endif
+
+size_t residentMemData( uint8_t *memData, size_t len ) {
+
+#ifdef _WIN32
+    return( len );
+#else
+    size_t hostPageSize = (size_t) sysconf( _SC_PAGESIZE );
+    size_t hostPages    = ( len + hostPageSize - 1 ) / hostPageSize;
+    size_t resident     = 0;
+
+    std::vector<unsigned char> vec( hostPages );
+
+    if ( hostMincore( mincore, memData, len, vec.data( )) != 0 ) return( len );
+
+    for ( size_t i = 0; i < hostPages; i++ ) {
+
+        if ( vec[ i ] & 1 ) resident ++;
+    }
+
+    return( std::min( resident * hostPageSize, len ));
+#endif
+}
+
+//----------------------------------------------------------------------------------------
+// Map an image file in place of the memory data. The mapping is private, our 
+// stores modify a copy of the page and never the image file. The image must 
+// have exactly the memory size. On a Windows host, the image is just read.
+//
+//----------------------------------------------------------------------------------------
+bool mapMemImage( uint8_t *memData, size_t len, const char *path ) {
+
+#ifdef _WIN32
+    FILE *f = fopen( path, "rb" );
+    if ( f == nullptr ) return( false );
+
+    bool rStat = ( fread( memData, 1, len, f ) == len );
+    fclose( f );
+    return( rStat );
+#else
+    int fd = open( path, O_RDONLY );
+    if ( fd < 0 ) return( false );
+
+    struct stat st;
+
+    if (( fstat( fd, &st ) != 0 ) || ((size_t) st.st_size != len )) {
+
+        close( fd );
+        return( false );
+    }
+
+    void *p = mmap( memData, len, PROT_READ | PROT_WRITE, 
+                    MAP_PRIVATE | MAP_FIXED, fd, 0 );
+
+    close( fd );
+    return( p != MAP_FAILED );
+#endif
+}
+
+}; // namespace
 
 //****************************************************************************************
 //****************************************************************************************
@@ -36,7 +253,7 @@
 // Physical memory
 //
 //----------------------------------------------------------------------------------------
-// Object constructor. We need to initialize the memory data and the lock.
+// Object constructor. We need to initialize the memory data and the line locks.
 //
 //----------------------------------------------------------------------------------------
 T64Memory::T64Memory( T64System     *sys, 
@@ -44,7 +261,7 @@ T64Memory::T64Memory( T64System     *sys,
                       T64MemKind    mKind,
                       T64MemType    mType,
                       T64Word       spaAdr,
-                      int           spaLen ) : 
+                      T64Word       spaLen ) : 
 
                       T64Module(    MT_MEM, 
                                     modNum,
@@ -56,7 +273,8 @@ T64Memory::T64Memory( T64System     *sys,
     this -> mKind   = mKind;
     this -> mType   = mType;
     this -> memData = nullptr;
-    this -> memLock = false;
+
+    for ( int i = 0; i < T64_MEM_LINE_LOCKS; i++ ) lineLock[ i ] = false;
 
     resetModule( );
 }
@@ -67,12 +285,17 @@ T64Memory::T64Memory( T64System     *sys,
 //----------------------------------------------------------------------------------------
 T64Memory:: ~T64Memory( ) { 
 
-    if ( memData != nullptr ) free( memData );
+    if ( memData != nullptr ) freeMemData( memData, spaLen );
+    if ( pageDirty != nullptr ) freeMemData( pageDirty, pageCount );
 }
 
 //----------------------------------------------------------------------------------------
-// Reset the memory module. We clear out the physical memory range. The easiest
-// way is to free the old memory and create a new one.
+// Reset the memory module. We clear out the physical memory range. The memory 
+// is allocated once and just cleared on a reset. Processors may hold direct
+// pointers into the memory data, which need to stay valid for the lifetime of
+// the module. A reset modifies all pages with respect to the last snapshot,
+// the dirty flags are cleared and all pages are considered dirty instead. The
+// number of pages touched counts from the reset.
 //
 //----------------------------------------------------------------------------------------
 void T64Memory::initModule( ) { 
@@ -82,8 +305,19 @@ void T64Memory::initModule( ) {
 
 void T64Memory::resetModule( ) {
 
-    if ( memData != nullptr ) free( memData );
-    this -> memData  = (uint8_t *) calloc( spaLen, sizeof( uint8_t ));
+    if ( memData == nullptr ) {
+        
+        this -> memData     = allocMemData( spaLen );
+        this -> pageCount   = (int) (( spaLen + T64_PAGE_SIZE_BYTES - 1 ) / 
+                                     T64_PAGE_SIZE_BYTES );
+        this -> pageDirty   = allocMemData( pageCount );
+    }
+    else clearMemData( memData, spaLen, imageMapped );
+
+    imageMapped = false;
+
+    if ( pageDirty != nullptr ) clearPagesDirty( );
+    allPagesDirty = true;
 }
 
 //----------------------------------------------------------------------------------------
@@ -98,26 +332,12 @@ bool T64Memory::busOpReadEvent( T64Word pAdr, uint8_t *data, int len ) {
         memset( data, 0, len );
         return ( false );
     }
-    else {
-
-        std::atomic<bool> *lockPtr = &memLock;
-        while ( lockPtr -> exchange( true )) { /* spin */ };
-            
-         if ( pAdr + len >= spaAdr + spaLen ) {
-            lockPtr -> store( false );
-            return( false );
-        }
-
-        if ( ! isAlignedAdr( pAdr, len )) {
-            lockPtr -> store( false );
-            return( false );
-        }
+    
+    if (( pAdr < spaAdr ) || ( pAdr + len > spaAdr + spaLen )) return( false );
+    if ( ! isAlignedAdr( pAdr, len )) return( false );
        
-        uint8_t *srcPtr = &memData[ pAdr - spaAdr ];
-        memcpy( data, srcPtr, len );
-        lockPtr -> store( false );
-        return( true );
-    }
+    loadDataItem( data, &memData[ pAdr - spaAdr ], len );
+    return( true );
 }
 
 //----------------------------------------------------------------------------------------
@@ -132,30 +352,82 @@ bool T64Memory::busOpWriteEvent( T64Word pAdr, uint8_t *data, int len ) {
         memset( data, 0, len );
         return ( false );
     }
-    else {
 
-        std::atomic<bool> *lockPtr = &memLock;
-        while ( lockPtr -> exchange( true )) { /* spin */ };
+    if (( pAdr < spaAdr ) || ( pAdr + len > spaAdr + spaLen )) return( false );
+    if ( ! isAlignedAdr( pAdr, len )) return( false );
+    if ( spaReadOnly ) return ( false );
 
-        if ( pAdr + len >= spaAdr + spaLen ) {
-            lockPtr -> store( false );
-            return( false );
-        }
-        if ( ! isAlignedAdr( pAdr, len )) {
-            lockPtr -> store( false );
-            return( false );
-        }
+    storeDataItem( &memData[ pAdr - spaAdr ], data, len );
+    markPageDirty( pAdr - spaAdr );
+    return( true );
+}
 
-        if ( spaReadOnly ) {
-            lockPtr -> store( false );
-            return ( false );
-        }
+//----------------------------------------------------------------------------------------
+// Conditional write to memory. The item is replaced with one host compare and 
+// exchange, so that a plain store by another processor, which does not take 
+// any lock, cannot get lost between the comparison and the write.
+//
+//----------------------------------------------------------------------------------------
+bool T64Memory::busOpWriteCondEvent( T64Word pAdr, uint8_t *expected, uint8_t *data, int len ) {
 
-        uint8_t *dstPtr = &memData[ pAdr - spaAdr ];
-        memcpy( dstPtr, data, len );
-        lockPtr -> store( false );
-        return( true );
-    }
+    if ( isInIoAdrRange( pAdr )) return ( false );
+    if (( pAdr < spaAdr ) || ( pAdr + len > spaAdr + spaLen )) return( false );
+    if ( ! isAlignedAdr( pAdr, len )) return( false );
+    if ( spaReadOnly ) return ( false );
+
+    if ( ! casDataItem( &memData[ pAdr - spaAdr ], expected, data, len )) return( false );
+
+    markPageDirty( pAdr - spaAdr );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Block events. The DMA bus operations read, write or fill a block within our
+// SPA range in one go. There is no alignment requirement.
+//
+//----------------------------------------------------------------------------------------
+bool T64Memory::isBlockInRange( T64Word pAdr, T64Word len ) {
+
+    return(( memData != nullptr ) &&
+           ( len >= 0 ) &&
+           ( pAdr >= spaAdr ) && 
+           ( pAdr - spaAdr <= spaLen - len ));
+}
+
+bool T64Memory::busOpReadBlockEvent( T64Word pAdr, uint8_t *data, T64Word len ) {
+
+    if ( ! isBlockInRange( pAdr, len )) return( false );
+
+    loadBlock( data, &memData[ pAdr - spaAdr ], len );
+    return( true );
+}
+
+bool T64Memory::busOpWriteBlockEvent( T64Word pAdr, const uint8_t *data, T64Word len ) {
+
+    if (( spaReadOnly ) || ( ! isBlockInRange( pAdr, len ))) return( false );
+
+    storeBlock( &memData[ pAdr - spaAdr ], data, len );
+    markPagesDirty( pAdr - spaAdr, len );
+    return( true );
+}
+
+bool T64Memory::busOpFillBlockEvent( T64Word pAdr, uint8_t val, T64Word len ) {
+
+    if (( spaReadOnly ) || ( ! isBlockInRange( pAdr, len ))) return( false );
+
+    fillBlock( &memData[ pAdr - spaAdr ], val, len );
+    markPagesDirty( pAdr - spaAdr, len );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Control events. There is nothing the memory module needs to know about, we 
+// do not subscribe to any event.
+//
+//----------------------------------------------------------------------------------------
+uint32_t T64Memory::getControlEventMask( ) {
+
+    return( 0 );
 }
 
 bool T64Memory::busOpControlEvent( T64BBusOpControlEvents id, 
@@ -165,6 +437,288 @@ bool T64Memory::busOpControlEvent( T64BBusOpControlEvents id,
     return( true );
 }
 
+//----------------------------------------------------------------------------------------
+// Direct memory access. We return the host address of the page that contains
+// the physical address. The page needs to be fully covered by our SPA range. 
+// Only a RAM module that is not set read only allows direct stores, all other 
+// stores go through the bus write operation. We cannot see the direct stores,
+// a page handed out for storing is therefore considered dirty. A page handed 
+// out for reading only is not marked, the caller asks again before its first 
+// direct store.
+//
+//----------------------------------------------------------------------------------------
+uint8_t *T64Memory::getHostPagePtr( T64Word pAdr, bool wMode, bool *writable ) {
+
+    T64Word pageAdr = rounddown( pAdr, T64_PAGE_SIZE_BYTES );
+
+    *writable = false;
+
+    if (( memData == nullptr ) ||
+        ( pageAdr < spaAdr ) ||
+        ( pageAdr + T64_PAGE_SIZE_BYTES > spaAdr + spaLen )) {
+        
+        return( nullptr );
+    }
+
+    *writable = (( mType == T64_MT_RAM ) && ( ! spaReadOnly ));
+    if (( wMode ) && ( *writable )) markPageDirty( pageAdr - spaAdr );
+
+    return( &memData[ pageAdr - spaAdr ] );
+}
+
+//----------------------------------------------------------------------------------------
+// Lock and unlock the memory line that contains the physical address. The line
+// address selects one of the line locks. Unrelated lines may share a lock, 
+// which only costs some waiting, never correctness.
+//
+//----------------------------------------------------------------------------------------
+void T64Memory::lockLine( T64Word pAdr ) {
+
+    std::atomic<bool> *lockPtr = 
+        &lineLock[ ( pAdr / T64_MEM_LINE_SIZE ) & ( T64_MEM_LINE_LOCKS - 1 ) ];
+
+    while ( lockPtr -> exchange( true, std::memory_order_acquire )) { /* spin */ };
+}
+
+void T64Memory::unlockLine( T64Word pAdr ) {
+
+    std::atomic<bool> *lockPtr = 
+        &lineLock[ ( pAdr / T64_MEM_LINE_SIZE ) & ( T64_MEM_LINE_LOCKS - 1 ) ];
+
+    lockPtr -> store( false, std::memory_order_release );
+}
+
+//----------------------------------------------------------------------------------------
+// Page dirty flags. A flag is only set when not already set, so that the stores
+// from several processors to the same page do not compete for the cache line.
+// The processor threads mark pages concurrently, the flags are therefore 
+// accessed as relaxed atomics. No ordering is needed, the flags are only read
+// when the processors are stopped.
+//
+//----------------------------------------------------------------------------------------
+void T64Memory::markPageDirty( T64Word ofs ) {
+
+    std::atomic_ref<uint8_t> flag( pageDirty[ ofs / T64_PAGE_SIZE_BYTES ] );
+    if ( flag.load( std::memory_order_relaxed ) == 0 ) flag.store( 1, std::memory_order_relaxed );
+}
+
+void T64Memory::markPagesDirty( T64Word ofs, T64Word len ) {
+
+    for ( T64Word i = ofs / T64_PAGE_SIZE_BYTES; i * T64_PAGE_SIZE_BYTES < ofs + len; i++ ) {
+        
+        markPageDirty( i * T64_PAGE_SIZE_BYTES );
+    }
+}
+
+void T64Memory::clearPagesDirty( ) {
+
+    clearMemData( pageDirty, pageCount, false );
+    allPagesDirty = false;
+}
+
+//----------------------------------------------------------------------------------------
+// Save the memory state. The record describes the image file content. A full
+// image contains the entire memory data. An incremental image contains only 
+// the dirty pages, each at its offset in the image file, and the record lists
+// the page numbers. After a reset, an incremental snapshot of the memory is a
+// full one. All pages are clean afterwards, the next incremental 
+// snapshot builds on this one. The caller makes sure that no processor keeps a
+// direct pointer across the snapshot.
+//
+//----------------------------------------------------------------------------------------
+bool T64Memory::saveState( T64Snapshot *snap ) {
+
+    snap -> beginModule( this );
+
+    if ( ! saveImage( snap, snap -> isIncremental( ) && ( ! allPagesDirty ))) return( false );
+
+    clearPagesDirty( );
+    return( true );
+}
+
+bool T64Memory::saveImage( T64Snapshot *snap, bool incremental ) {
+
+    char path[ T64_SNAP_MAX_PATH * 2 ];
+    if ( ! snap -> filePath( path, sizeof( path ), MEM_SNAP_IMAGE_NAME, moduleNum )) {
+
+        return( false );
+    }
+
+    FILE *f = fopen( path, "wb" );
+    if ( f == nullptr ) return( false );
+
+    uint32_t kind   = ( incremental ) ? MEM_SNAP_INCREMENTAL : MEM_SNAP_FULL;
+    uint64_t len    = spaLen;
+    bool     rStat  = true;
+
+    snap -> put( &kind, sizeof( kind ));
+    snap -> put( &len, sizeof( len ));
+
+    if ( incremental ) {
+
+        std::vector<uint32_t> pages;
+
+        for ( int i = 0; i < pageCount; i++ ) {
+
+            if ( pageDirty[ i ] == 0 ) continue;
+
+            T64Word ofs     = (T64Word) i * T64_PAGE_SIZE_BYTES;
+            size_t  pageLen = std::min<T64Word>( T64_PAGE_SIZE_BYTES, spaLen - ofs );
+
+            rStat = ( fseek( f, (long) ofs, SEEK_SET ) == 0 ) &&
+                    ( fwrite( &memData[ ofs ], 1, pageLen, f ) == pageLen );
+
+            if ( ! rStat ) break;
+            pages.push_back( i );
+        }
+
+        uint32_t n = (uint32_t) pages.size( );
+        snap -> put( &n, sizeof( n ));
+        if ( n > 0 ) snap -> put( pages.data( ), n * sizeof( uint32_t ));
+    }
+    else rStat = ( fwrite( memData, 1, spaLen, f ) == (size_t) spaLen );
+
+    if ( fclose( f ) != 0 ) rStat = false;
+    return( rStat );
+}
+
+//----------------------------------------------------------------------------------------
+// Restore the memory state. A full image is mapped in place of the memory data.
+// For an incremental image, we first restore the snapshot it is based on and
+// then copy the pages it contains. The memory data address does not change, 
+// but the processors need to give up their direct pointers, so that direct 
+// stores are seen again as dirty pages.
+//
+//----------------------------------------------------------------------------------------
+bool T64Memory::restoreState( T64Snapshot *snap ) {
+
+    if (( memData == nullptr ) || ( ! snap -> findModule( this ))) return( false );
+
+    if ( ! restoreImage( snap )) return( false );
+
+    clearPagesDirty( );
+    return( true );
+}
+
+bool T64Memory::restoreImage( T64Snapshot *snap ) {
+
+    uint32_t kind   = 0;
+    uint64_t len    = 0;
+
+    if (( ! snap -> get( &kind, sizeof( kind ))) || 
+        ( ! snap -> get( &len, sizeof( len )))   ||
+        ( len != (uint64_t) spaLen )) {
+        
+        return( false );
+    }
+
+    char path[ T64_SNAP_MAX_PATH * 2 ];
+    if ( ! snap -> filePath( path, sizeof( path ), MEM_SNAP_IMAGE_NAME, moduleNum )) {
+
+        return( false );
+    }
+
+    if ( kind == MEM_SNAP_FULL ) {
+        
+        imageMapped = mapMemImage( memData, spaLen, path );
+        return( imageMapped );
+    }
+
+    if ( kind != MEM_SNAP_INCREMENTAL ) return( false );
+
+    uint32_t n = 0;
+    if ( ! snap -> get( &n, sizeof( n ))) return( false );
+
+    std::vector<uint32_t> pages( n );
+    if (( n > 0 ) && ( ! snap -> get( pages.data( ), n * sizeof( uint32_t )))) return( false );
+
+    T64Snapshot base( snap -> getBaseDirName( ));
+
+    if (( ! base.load( )) || 
+        ( ! base.findModule( this )) || 
+        ( ! restoreImage( &base ))) {
+            
+        return( false );
+    }
+
+    FILE *f = fopen( path, "rb" );
+    if ( f == nullptr ) return( false );
+
+    bool rStat = true;
+
+    for ( uint32_t i = 0; ( rStat ) && ( i < n ); i++ ) {
+
+        if ( pages[ i ] >= (uint32_t) pageCount ) {
+            
+            rStat = false;
+            break;
+        }
+
+        T64Word ofs     = (T64Word) pages[ i ] * T64_PAGE_SIZE_BYTES;
+        size_t  pageLen = std::min<T64Word>( T64_PAGE_SIZE_BYTES, spaLen - ofs );
+
+        rStat = ( fseek( f, (long) ofs, SEEK_SET ) == 0 ) &&
+                ( fread( &memData[ ofs ], 1, pageLen, f ) == pageLen );
+    }
+
+    fclose( f );
+    return( rStat );
+}
+
+//----------------------------------------------------------------------------------------
+// Map a memory image file in place of the memory data. The image has exactly the
+// memory size, just as the image of a full snapshot. Any number of memory modules
+// can map the same image, also those of different systems in one program. They
+// share the host pages of the image, a module gets a private copy of a page when
+// it modifies it. All pages are then modified with respect to the last snapshot.
+// The image should be mapped before the processors run, they would otherwise
+// hold on to direct pointers and not mark their stores as dirty pages.
+//
+//----------------------------------------------------------------------------------------
+bool T64Memory::mapImageFile( const char *fileName ) {
+
+    if (( memData == nullptr ) || ( fileName == nullptr )) return( false );
+
+    if ( ! mapMemImage( memData, spaLen, fileName )) return( false );
+
+    imageMapped = true;
+
+    clearPagesDirty( );
+    allPagesDirty = true;
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Memory usage statistics. The page count is the size of the memory module in 
+// pages. The touched pages are the pages that currently occupy host memory, 
+// i.e. that were accessed since the last reset or mapped from a snapshot image
+// and accessed since the restore. The dirty pages are the pages modified since
+// the last snapshot.
+//
+//----------------------------------------------------------------------------------------
+T64Word T64Memory::getPageCount( ) {
+
+    return( pageCount );
+}
+
+T64Word T64Memory::getTouchedPages( ) {
+
+    if ( memData == nullptr ) return( 0 );
+
+    size_t bytes = residentMemData( memData, spaLen );
+    return(( bytes + T64_PAGE_SIZE_BYTES - 1 ) / T64_PAGE_SIZE_BYTES );
+}
+
+T64Word T64Memory::getDirtyPages( ) {
+
+    if ( allPagesDirty ) return( pageCount );
+
+    T64Word n = 0;
+
+    for ( int i = 0; i < pageCount; i++ ) if ( pageDirty[ i ] != 0 ) n ++;
+    return( n );
+}
+
 //----------------------------------------------------------------------------------------
 // A memory address range can be set road only, This is used when we model a ROM.
 //
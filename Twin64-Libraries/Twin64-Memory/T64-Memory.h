@@ -9,8 +9,11 @@
 // the SPA address range for the memory and the HPA address range for control 
 // registers.
 //
-// Access to the memory is protected by a lock. The lock is held during the 
-// entire bus operation, including the time it takes to read or write the memory. 
+// Read and write bus operations do not lock the memory. The data items are 
+// aligned and accessed with a single host load or store, so several processors
+// can access the memory concurrently. The LDR / STC bus operations lock the 
+// memory line containing the address. There is a fixed set of line locks, the
+// line address is hashed to one of them.
 //
 //----------------------------------------------------------------------------------------
 //
@@ -51,6 +54,14 @@ enum T64MemType : int {
     T64_MT_ROM  = 2
 };
 
+//----------------------------------------------------------------------------------------
+// Line locks. A line is a naturally aligned block of memory. The number of 
+// locks must be a power of two.
+//
+//----------------------------------------------------------------------------------------
+const int T64_MEM_LINE_SIZE     = 64;
+const int T64_MEM_LINE_LOCKS    = 64;
+
 //----------------------------------------------------------------------------------------
 // T64 Memory module object.
 //
@@ -64,7 +75,7 @@ public:
                T64MemKind   mKind,
                T64MemType   mType,
                T64Word      spaAdr,
-               int          spaLen );
+               T64Word      spaLen );
 
     virtual     ~ T64Memory( );
     
@@ -73,22 +84,52 @@ public:
  
     bool        busOpReadEvent( T64Word pAdr, uint8_t *data, int len );
     bool        busOpWriteEvent( T64Word pAdr, uint8_t *data, int len );
+    bool        busOpWriteCondEvent( T64Word pAdr, uint8_t *expected, uint8_t *data, int len );
 
     bool        busOpControlEvent( T64BBusOpControlEvents event, 
                                    T64Word            arg1, 
                                    T64Word            arg2 );
 
+    uint32_t    getControlEventMask( );
+
+    bool        busOpReadBlockEvent( T64Word pAdr, uint8_t *data, T64Word len );
+    bool        busOpWriteBlockEvent( T64Word pAdr, const uint8_t *data, T64Word len );
+    bool        busOpFillBlockEvent( T64Word pAdr, uint8_t val, T64Word len );
+
+    uint8_t     *getHostPagePtr( T64Word pAdr, bool wMode, bool *writable );
+    void        lockLine( T64Word pAdr );
+    void        unlockLine( T64Word pAdr );
+
+    bool        saveState( T64Snapshot *snap );
+    bool        restoreState( T64Snapshot *snap );
+    bool        mapImageFile( const char *fileName );
+
     T64MemKind  getMemKind( ) const;
     T64MemType  getMemType( ) const;
     char        *getMemTypeString( ) const;
     void        setSpaReadOnly( bool arg );
+
+    T64Word     getPageCount( );
+    T64Word     getTouchedPages( );
+    T64Word     getDirtyPages( );
                       
 private:
 
-    T64MemKind          mKind       = T64_MK_NIL;
-    T64MemType          mType       = T64_MT_NIL;
-    T64System           *sys        = nullptr;
-    uint8_t             *memData    = nullptr;
-    bool                spaReadOnly = false;
-    std::atomic<bool>   memLock     = false;
+    void        markPageDirty( T64Word ofs );
+    void        markPagesDirty( T64Word ofs, T64Word len );
+    bool        isBlockInRange( T64Word pAdr, T64Word len );
+    void        clearPagesDirty( );
+    bool        saveImage( T64Snapshot *snap, bool incremental );
+    bool        restoreImage( T64Snapshot *snap );
+
+    T64MemKind          mKind           = T64_MK_NIL;
+    T64MemType          mType           = T64_MT_NIL;
+    T64System           *sys            = nullptr;
+    uint8_t             *memData        = nullptr;
+    uint8_t             *pageDirty      = nullptr;
+    int                 pageCount       = 0;
+    bool                spaReadOnly     = false;
+    bool                imageMapped     = false;
+    bool                allPagesDirty   = false;
+    std::atomic<bool>   lineLock[ T64_MEM_LINE_LOCKS ];
 };
@@ -0,0 +1,415 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Breakpoints and watchpoints
+//
+//----------------------------------------------------------------------------------------
+// The break table holds the instruction breakpoints and data watchpoints of a
+// processor. The processor asks the table before each instruction when there is
+// an entry at all, the CPU asks it for a data access when the filter bit for the
+// page is set. An entry with a condition fires only when its condition code
+// evaluates to true. The condition code is checked once when the entry is set,
+// the evaluation does no further checking.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Breakpoints and watchpoints
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License along with
+// this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-Processor.h"
+
+//----------------------------------------------------------------------------------------
+// Local name space.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// The number of stack items an operation takes and leaves. A negative result
+// marks an invalid operation.
+//
+//----------------------------------------------------------------------------------------
+int condStackEffect( T64BreakCondOp op, int *takes ) {
+
+    switch ( op ) {
+
+        case T64_BC_NUM:
+        case T64_BC_GREG:
+        case T64_BC_CREG:
+        case T64_BC_IA:
+        case T64_BC_ST:     *takes = 0; return( 1 );
+
+        case T64_BC_NEG:
+        case T64_BC_LNOT:   *takes = 1; return( 1 );
+
+        case T64_BC_ADD:    case T64_BC_SUB:    case T64_BC_MUL:
+        case T64_BC_DIV:    case T64_BC_MOD:    case T64_BC_AND:
+        case T64_BC_OR:     case T64_BC_XOR:    case T64_BC_LAND:
+        case T64_BC_LOR:    case T64_BC_EQ:     case T64_BC_NE:
+        case T64_BC_LT:     case T64_BC_LE:     case T64_BC_GT:
+        case T64_BC_GE:     *takes = 2; return( 1 );
+
+        default:            *takes = 0; return( -1 );
+    }
+}
+
+}; // namespace
+
+//----------------------------------------------------------------------------------------
+// The break table object. It starts out empty.
+//
+//----------------------------------------------------------------------------------------
+T64BreakTable::T64BreakTable( T64Processor *proc ) {
+
+    this -> proc = proc;
+    reset( );
+}
+
+//----------------------------------------------------------------------------------------
+// Reset removes all entries. Clearing the hit just forgets a pending hit and the
+// address to resume at, the entries stay.
+//
+//----------------------------------------------------------------------------------------
+void T64BreakTable::reset( ) {
+
+    removeAll( );
+    clearHit( );
+}
+
+void T64BreakTable::clearHit( ) {
+
+    resumeAdr   = -1;
+    dataHit     = false;
+    hitValid    = false;
+    lastHit     = { };
+}
+
+//----------------------------------------------------------------------------------------
+// Check a condition code. A valid code is either empty, or each operation has
+// its operands on the stack, the stack never exceeds its size and exactly one
+// result is left.
+//
+//----------------------------------------------------------------------------------------
+bool T64BreakTable::validCond( const T64BreakCond *cond ) {
+
+    if ( cond == nullptr ) return( true );
+    if (( cond -> len < 0 ) || ( cond -> len > T64_BREAK_COND_CODE_LEN )) return( false );
+    if ( cond -> len == 0 ) return( true );
+
+    int depth = 0;
+
+    for ( int i = 0; i < cond -> len; i++ ) {
+
+        const T64BreakCondInstr *ci     = &cond -> code[ i ];
+        int                     takes   = 0;
+        int                     leaves  = condStackEffect( ci -> op, &takes );
+
+        if ( leaves < 0 ) return( false );
+        if (( ci -> op == T64_BC_GREG ) && ( ci -> reg >= T64_MAX_GREGS )) return( false );
+        if (( ci -> op == T64_BC_CREG ) && ( ci -> reg >= T64_MAX_CREGS )) return( false );
+        if ( depth < takes ) return( false );
+
+        depth = depth - takes + leaves;
+        if ( depth > T64_BREAK_COND_STACK_SIZE ) return( false );
+    }
+
+    return( depth == 1 );
+}
+
+//----------------------------------------------------------------------------------------
+// Set a break entry. An instruction breakpoint needs an aligned instruction
+// address, a watchpoint covers "len" bytes starting at the address. The entry
+// index is returned, or -1 when the table is full or the entry is not valid.
+//
+//----------------------------------------------------------------------------------------
+int T64BreakTable::setBreak( T64BreakKind         kind,
+                             T64Word              adr,
+                             T64Word              len,
+                             const T64BreakCond   *cond ) {
+
+    if (( kind < T64_BK_INSTR ) || ( kind > T64_BK_ACCESS )) return( -1 );
+    if ( ! validCond( cond )) return( -1 );
+
+    if ( kind == T64_BK_INSTR ) {
+
+        if ( ! isAlignedAdr( adr, sizeof( T64Instr ))) return( -1 );
+        len = sizeof( T64Instr );
+    }
+    else if (( len <= 0 ) || ( adr + len < adr )) return( -1 );
+
+    for ( int i = 0; i < T64_MAX_BREAKS; i++ ) {
+
+        T64BreakEntry *e = &entries[ i ];
+
+        if ( e -> kind != T64_BK_NIL ) continue;
+
+        e -> kind       = kind;
+        e -> adr        = adr;
+        e -> len        = len;
+        e -> hits       = 0;
+        e -> cond.len   = 0;
+
+        if ( cond != nullptr ) e -> cond = *cond;
+
+        setFilterBits( );
+        return( i );
+    }
+
+    return( -1 );
+}
+
+//----------------------------------------------------------------------------------------
+// Remove a break entry, or all of them.
+//
+//----------------------------------------------------------------------------------------
+bool T64BreakTable::removeBreak( int index ) {
+
+    if (( index < 0 ) || ( index >= T64_MAX_BREAKS )) return( false );
+    if ( entries[ index ].kind == T64_BK_NIL ) return( false );
+
+    entries[ index ].kind = T64_BK_NIL;
+    setFilterBits( );
+    return( true );
+}
+
+void T64BreakTable::removeAll( ) {
+
+    for ( int i = 0; i < T64_MAX_BREAKS; i++ ) entries[ i ].kind = T64_BK_NIL;
+    setFilterBits( );
+}
+
+//----------------------------------------------------------------------------------------
+// Getters. An unused entry returns a null pointer. The last hit is valid from
+// the first break until the hit is cleared.
+//
+//----------------------------------------------------------------------------------------
+T64BreakEntry *T64BreakTable::getBreak( int index ) {
+
+    if (( index < 0 ) || ( index >= T64_MAX_BREAKS )) return( nullptr );
+    if ( entries[ index ].kind == T64_BK_NIL ) return( nullptr );
+
+    return( &entries[ index ] );
+}
+
+bool T64BreakTable::getLastHit( T64BreakHit *hit ) {
+
+    if ( hitValid ) *hit = lastHit;
+    return( hitValid );
+}
+
+bool T64BreakTable::isActive( ) {
+
+    return(( instrBreaks > 0 ) || ( watchPoints > 0 ));
+}
+
+//----------------------------------------------------------------------------------------
+// Compute the entry counts and the page filter bits. A range of as many pages
+// as there are filter bits sets all of them. The data filter bits are kept in
+// the CPU, which tests them on each data access.
+//
+//----------------------------------------------------------------------------------------
+void T64BreakTable::setFilterBits( ) {
+
+    uint64_t dataPageBits = 0;
+
+    instrBreaks     = 0;
+    watchPoints     = 0;
+    instrPageBits   = 0;
+
+    for ( int i = 0; i < T64_MAX_BREAKS; i++ ) {
+
+        T64BreakEntry *e = &entries[ i ];
+
+        if ( e -> kind == T64_BK_NIL ) continue;
+
+        if ( e -> kind == T64_BK_INSTR ) {
+
+            instrBreaks ++;
+            instrPageBits |= breakPageBit( e -> adr );
+        }
+        else {
+
+            T64Word firstPage = e -> adr / T64_PAGE_SIZE_BYTES;
+            T64Word lastPage  = ( e -> adr + e -> len - 1 ) / T64_PAGE_SIZE_BYTES;
+
+            watchPoints ++;
+
+            if ( lastPage - firstPage >= T64_BREAK_PAGE_BITS - 1 ) dataPageBits = ~0ULL;
+            else {
+
+                for ( T64Word p = firstPage; p <= lastPage; p++ ) {
+
+                    dataPageBits |= breakPageBit( p * T64_PAGE_SIZE_BYTES );
+                }
+            }
+        }
+    }
+
+    proc -> cpu -> watchPageBits = dataPageBits;
+}
+
+//----------------------------------------------------------------------------------------
+// Evaluate a condition. The code was checked when the entry was set. Division
+// by zero yields zero. The logical and comparison operations yield one or zero.
+//
+//----------------------------------------------------------------------------------------
+bool T64BreakTable::evalCond( const T64BreakCond *cond ) {
+
+    T64Word stack[ T64_BREAK_COND_STACK_SIZE ];
+    int     sp  = 0;
+    T64Cpu  *cpu = proc -> cpu;
+
+    for ( int i = 0; i < cond -> len; i++ ) {
+
+        const T64BreakCondInstr *ci = &cond -> code[ i ];
+
+        switch ( ci -> op ) {
+
+            case T64_BC_NUM:  stack[ sp++ ] = ci -> val; break;
+            case T64_BC_GREG: stack[ sp++ ] = cpu -> getGeneralReg( ci -> reg ); break;
+            case T64_BC_CREG: stack[ sp++ ] = cpu -> getControlReg( ci -> reg ); break;
+
+            case T64_BC_IA: {
+
+                stack[ sp++ ] = extractField64( cpu -> getPsrReg( ), 0, 52 );
+
+            } break;
+
+            case T64_BC_ST: {
+
+                stack[ sp++ ] = extractField64( cpu -> getPsrReg( ), 52, 12 );
+
+            } break;
+
+            case T64_BC_NEG:  stack[ sp - 1 ] = - stack[ sp - 1 ]; break;
+            case T64_BC_LNOT: stack[ sp - 1 ] = ( stack[ sp - 1 ] == 0 ); break;
+
+            default: {
+
+                T64Word b = stack[ --sp ];
+                T64Word a = stack[ sp - 1 ];
+                T64Word r = 0;
+
+                switch ( ci -> op ) {
+
+                    case T64_BC_ADD:  r = (T64Word) ((uint64_t) a + (uint64_t) b ); break;
+                    case T64_BC_SUB:  r = (T64Word) ((uint64_t) a - (uint64_t) b ); break;
+                    case T64_BC_MUL:  r = (T64Word) ((uint64_t) a * (uint64_t) b ); break;
+                    case T64_BC_DIV:  r = (( b == 0 ) || (( a == INT64_MIN ) && ( b == -1 ))) ?
+                                          0 : a / b; break;
+                    case T64_BC_MOD:  r = (( b == 0 ) || ( b == -1 )) ? 0 : a % b; break;
+                    case T64_BC_AND:  r = a & b; break;
+                    case T64_BC_OR:   r = a | b; break;
+                    case T64_BC_XOR:  r = a ^ b; break;
+                    case T64_BC_LAND: r = (( a != 0 ) && ( b != 0 )); break;
+                    case T64_BC_LOR:  r = (( a != 0 ) || ( b != 0 )); break;
+                    case T64_BC_EQ:   r = ( a == b ); break;
+                    case T64_BC_NE:   r = ( a != b ); break;
+                    case T64_BC_LT:   r = ( a < b ); break;
+                    case T64_BC_LE:   r = ( a <= b ); break;
+                    case T64_BC_GT:   r = ( a > b ); break;
+                    case T64_BC_GE:   r = ( a >= b ); break;
+                    default: ;
+                }
+
+                stack[ sp - 1 ] = r;
+            }
+        }
+    }
+
+    return( stack[ 0 ] != 0 );
+}
+
+//----------------------------------------------------------------------------------------
+// Remember the hit and count it.
+//
+//----------------------------------------------------------------------------------------
+void T64BreakTable::enterHit( int index, T64Word instrAdr, T64Word dataAdr ) {
+
+    entries[ index ].hits ++;
+
+    lastHit.index       = index;
+    lastHit.kind        = entries[ index ].kind;
+    lastHit.instrAdr    = instrAdr;
+    lastHit.dataAdr     = dataAdr;
+    hitValid            = true;
+}
+
+//----------------------------------------------------------------------------------------
+// Check the instruction address before the instruction executes. The address we
+// resume at after a breakpoint is skipped once, whatever instruction comes next
+// forgets it. The result is true when a breakpoint fires.
+//
+//----------------------------------------------------------------------------------------
+bool T64BreakTable::checkInstr( T64Word vAdr ) {
+
+    if ( vAdr == resumeAdr ) {
+
+        resumeAdr = -1;
+        return( false );
+    }
+
+    resumeAdr = -1;
+
+    if (( instrPageBits & breakPageBit( vAdr )) == 0 ) return( false );
+
+    for ( int i = 0; i < T64_MAX_BREAKS; i++ ) {
+
+        T64BreakEntry *e = &entries[ i ];
+
+        if (( e -> kind != T64_BK_INSTR ) || ( e -> adr != vAdr )) continue;
+        if (( e -> cond.len > 0 ) && ( ! evalCond( &e -> cond ))) continue;
+
+        enterHit( i, vAdr, vAdr );
+        resumeAdr = vAdr;
+        return( true );
+    }
+
+    return( false );
+}
+
+//----------------------------------------------------------------------------------------
+// Check a data access. The CPU calls this routine when the filter bit of the
+// page is set. A watchpoint that fires is remembered until the instruction is
+// done, only the first one of an instruction is reported.
+//
+//----------------------------------------------------------------------------------------
+void T64BreakTable::checkData( T64Word vAdr, int len, bool wMode ) {
+
+    if ( dataHit ) return;
+
+    for ( int i = 0; i < T64_MAX_BREAKS; i++ ) {
+
+        T64BreakEntry *e = &entries[ i ];
+
+        if (( e -> kind == T64_BK_NIL ) || ( e -> kind == T64_BK_INSTR )) continue;
+        if (( e -> kind == T64_BK_READ ) && ( wMode )) continue;
+        if (( e -> kind == T64_BK_WRITE ) && ( ! wMode )) continue;
+        if (( vAdr >= e -> adr + e -> len ) || ( vAdr + len <= e -> adr )) continue;
+        if (( e -> cond.len > 0 ) && ( ! evalCond( &e -> cond ))) continue;
+
+        enterHit( i, extractField64( proc -> cpu -> getPsrReg( ), 0, 52 ), vAdr );
+        dataHit = true;
+        return;
+    }
+}
+
+bool T64BreakTable::takeDataHit( ) {
+
+    if ( ! dataHit ) return( false );
+
+    dataHit = false;
+    return( true );
+}
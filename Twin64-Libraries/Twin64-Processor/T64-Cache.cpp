@@ -0,0 +1,626 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Cache
+//
+//----------------------------------------------------------------------------------------
+// The Twin-64 processor has a cache subsystem. Since there can be more than
+// one processor, the caches need to maintain cache coherence. We implement
+// this in a simple protocol where each operation in a processor will trigger
+// the cache coherence action immediately. For example, if there is a write
+// operation to a cache line not available so far, a read private operation
+// will be communicated to the T64 system. The T64 system in turn will tell
+// all modules that they need to flush and or purge their cache line. This
+// is perhaps not the most efficient way, but coherence is maintained. Then
+// the data is read and the processor is the exclusive owner of this cache
+// line. In other words, all actions with respect to the cache line are done
+// right away transparently to the processor.
+//
+// The caches themselves are set associative caches. There are defined cache
+// types to experiment with ways and set sizes.
+//
+// NOTE: The cache does not raise traps. A failing bus operation is reported
+// to the CPU, which raises the machine check trap.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Cache
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License along with
+// this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-System.h"
+#include "T64-Processor.h"
+
+//----------------------------------------------------------------------------------------
+//
+// Our processor:               All others:
+//
+//                              INV     SHARED      MODIFIED
+//
+// READ HIT:    (shared)        -       -           -
+//
+// READ MISS:   (shared)        -       OK          flush, shared
+//
+// WRITE HIT:   (modified)      -       -           -
+//
+// WRITE SHARED:(modified)      -       purge       -
+//
+// WRITE MISS:  (modified)      -       purge       flush, purge
+//
+// A line held modified by our processor cannot be held by any other cache. A
+// write to a shared line is therefore handled like a write miss.
+//
+//----------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------
+// Local name space.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// PLRU utilities. Each set has a binary tree of bits over its ways, which is
+// 1 bit for a 2-way, 3 bits for a 4-way and 7 bits for an 8-way cache. The
+// nodes are numbered heap style, node 1 is the root and node "n" has the
+// children "2n" and "2n+1". The ways are the leaves "ways" to "2*ways-1".
+// Node "n" is stored in bit "n-1".
+//
+//  Convention: bit == 0  => left subtree was used recently, victim is right
+//              bit == 1  => right subtree was used recently, victim is left
+//
+// Victim selection follows the not recently used direction from the root. An
+// access sets all bits on the path from the leaf to the root to point to the
+// accessed side.
+//
+//----------------------------------------------------------------------------------------
+int plruTreeVictim( uint8_t state, int ways ) {
+
+    int node = 1;
+
+    while ( node < ways ) {
+
+        int bit = ( state >> ( node - 1 )) & 1;
+        node = ( node * 2 ) + ( bit ? 0 : 1 );
+    }
+
+    return( node - ways );
+}
+
+uint8_t plruTreeUpdate( uint8_t state, int ways, int way ) {
+
+    int node = way + ways;
+
+    while ( node > 1 ) {
+
+        int parent = node / 2;
+
+        if ( node & 1 ) state |= ( 1 << ( parent - 1 ));
+        else            state &= ~( 1 << ( parent - 1 ));
+
+        node = parent;
+    }
+
+    return( state );
+}
+
+} // namespace
+
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Cache
+//
+//----------------------------------------------------------------------------------------
+// "T64Cache" is the object constructor. We decode the valid cache type options
+// and precompute bit offsets, masks, and so on. The default is T64_CT_2W_128S_4L.
+// The cache registers with the system, which from then on sends the coherence
+// requests for memory accesses.
+//
+//----------------------------------------------------------------------------------------
+T64Cache::T64Cache( T64Processor    *proc,
+                    T64CacheKind    cKind,
+                    T64CacheType    cType ) {
+
+    this -> cacheKind   = cKind;
+    this -> cacheType   = cType;
+    this -> proc        = proc;
+    this -> perf        = proc -> getPerfBlock( );
+    this -> perfBase    = ( cKind == T64_CK_DATA_CACHE ) ? T64_PC_DCACHE_HITS : T64_PC_ICACHE_HITS;
+
+    switch ( cType ) {
+
+        case T64_CT_2W_64S_8L:
+        case T64_CT_2W_128S_4L:     ways = 2;   break;
+
+        case T64_CT_4W_64S_8L:
+        case T64_CT_4W_128S_4L:     ways = 4;   break;
+
+        case T64_CT_8W_64S_8L:
+        case T64_CT_8W_128S_4L:     ways = 8;   break;
+
+        default:                    ways = 2;
+    }
+
+    switch ( cType ) {
+
+        case T64_CT_2W_128S_4L:
+        case T64_CT_4W_128S_4L:
+        case T64_CT_8W_128S_4L: {
+
+            sets        = 128;
+            lineSize    = 32;
+            offsetBits  = 5;
+            indexBits   = 7;
+
+        } break;
+
+        case T64_CT_2W_64S_8L:
+        case T64_CT_4W_64S_8L:
+        case T64_CT_8W_64S_8L: {
+
+            sets        = 64;
+            lineSize    = 64;
+            offsetBits  = 6;
+            indexBits   = 6;
+
+         } break;
+
+        default: {
+
+            sets        = 128;
+            lineSize    = 32;
+            offsetBits  = 5;
+            indexBits   = 7;
+
+         }
+    }
+
+    offsetBitmask   = ( 1ULL << offsetBits ) - 1;
+    indexBitmask    = ( 1ULL << indexBits ) - 1;
+
+    cacheInfo   = new T64CacheLineInfo[ ways * sets ];
+    cacheData   = new uint8_t[ ways * sets * lineSize ];
+    plruState   = new uint8_t[ sets ];
+
+    reset( );
+    proc -> sys -> registerCache( );
+}
+
+//----------------------------------------------------------------------------------------
+// Destructor. Modified lines are written back before the cache goes away.
+//
+//----------------------------------------------------------------------------------------
+T64Cache:: ~T64Cache( ) {
+
+    flushAll( );
+    proc -> sys -> unregisterCache( );
+
+    delete[ ] cacheInfo;
+    delete[ ] cacheData;
+    delete[ ] plruState;
+}
+
+//----------------------------------------------------------------------------------------
+// Reset. Clear all data structures. Modified lines are lost, the caller will
+// use "flushAll" first when they need to be preserved.
+//
+//----------------------------------------------------------------------------------------
+void T64Cache::reset( ) {
+
+    lockCache( );
+
+    perf -> set( perfBase, 0 );
+    perf -> set( perfBase + 1, 0 );
+    perf -> set( perfBase + 2, 0 );
+
+    for ( int i = 0; i < ( ways * sets ); i++ ) {
+
+        cacheInfo[ i ].valid    = false;
+        cacheInfo[ i ].modified = false;
+        cacheInfo[ i ].tag      = 0;
+    }
+
+    memset( cacheData, 0, ways * sets * lineSize );
+    memset( plruState, 0, sets );
+    unlockCache( );
+}
+
+//----------------------------------------------------------------------------------------
+// Helper functions. The line info and data of a way in a set are found at index
+// "way * sets + set".
+//
+//----------------------------------------------------------------------------------------
+T64Word T64Cache::getTag( T64Word pAdr ) {
+
+    return( pAdr >> ( offsetBits + indexBits ));
+}
+
+int T64Cache::getSetIndex( T64Word pAdr ) {
+
+    return((int) (( pAdr >> offsetBits ) & indexBitmask ));
+}
+
+int T64Cache::getLineOfs( T64Word pAdr ) {
+
+    return((int) ( pAdr & offsetBitmask ));
+}
+
+int T64Cache::getSets( ) {
+
+    return( sets );
+}
+
+int T64Cache::getWays( ) {
+
+    return( ways );
+}
+
+int T64Cache::getLineSize( ) {
+
+    return( lineSize );
+}
+
+T64CacheKind T64Cache::getCacheKind( ) {
+
+    return( cacheKind );
+}
+
+T64CacheType T64Cache::getCacheType( ) {
+
+    return( cacheType );
+}
+
+T64Word T64Cache::getHits( ) {
+
+    return( perf -> get( perfBase ));
+}
+
+T64Word T64Cache::getMisses( ) {
+
+    return( perf -> get( perfBase + 1 ));
+}
+
+T64Word T64Cache::getWriteBacks( ) {
+
+    return( perf -> get( perfBase + 2 ));
+}
+
+char *T64Cache::getCacheTypeString( ) {
+
+    switch ( cacheType ) {
+
+        case T64_CT_2W_64S_8L:      return( (char *) "2W_64S_8L" );
+        case T64_CT_2W_128S_4L:     return( (char *) "2W_128S_4L" );
+        case T64_CT_4W_64S_8L:      return( (char *) "4W_64S_8L" );
+        case T64_CT_4W_128S_4L:     return( (char *) "4W_128S_4L" );
+        case T64_CT_8W_64S_8L:      return( (char *) "8W_64S_8L" );
+        case T64_CT_8W_128S_4L:     return( (char *) "8W_128S_4L" );
+        default:                    return( (char *) "Unknown Cache Type" );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// The cache lock. Most of the time only the owning CPU thread uses the cache, 
+// and the lock is held for a single line access. A simple spin lock is all we
+// need, just as for the memory line locks.
+//
+//----------------------------------------------------------------------------------------
+void T64Cache::lockCache( ) {
+
+    while ( cLock.exchange( true, std::memory_order_acquire )) { /* spin */ };
+}
+
+void T64Cache::unlockCache( ) {
+
+    cLock.store( false, std::memory_order_release );
+}
+
+//----------------------------------------------------------------------------------------
+// The set associative cache uses a pseudo LRU scheme. There are two local
+// routines, select a victim and update the state. An invalid way in the set is
+// always used first.
+//
+//----------------------------------------------------------------------------------------
+int T64Cache::plruVictim( int set ) {
+
+    for ( int w = 0; w < ways; w++ ) {
+
+        if ( ! cacheInfo[ ( w * sets ) + set ].valid ) return( w );
+    }
+
+    return( plruTreeVictim( plruState[ set ], ways ));
+}
+
+void T64Cache::plruUpdate( int set, int way ) {
+
+    plruState[ set ] = plruTreeUpdate( plruState[ set ], ways, way );
+}
+
+//----------------------------------------------------------------------------------------
+// "lookupWay" searches the ways of the set for the address. If we find a valid
+// cache line with the matching tag, we return the way, otherwise -1.
+//
+//----------------------------------------------------------------------------------------
+int T64Cache::lookupWay( T64Word pAdr ) {
+
+    T64Word tag = getTag( pAdr );
+    int     set = getSetIndex( pAdr );
+
+    for ( int w = 0; w < ways; w++ ) {
+
+        T64CacheLineInfo *l = &cacheInfo[ ( w * sets ) + set ];
+
+        if (( l -> valid ) && ( l -> tag == tag )) return( w );
+    }
+
+    return( -1 );
+}
+
+//----------------------------------------------------------------------------------------
+// "getCacheLineByIndex" will return the slot based on way an set index
+// regardless if the slot is valid. This is used by the simulator for display.
+//
+//----------------------------------------------------------------------------------------
+bool T64Cache::getCacheLineByIndex( int              way,
+                                    int              set,
+                                    T64CacheLineInfo **info,
+                                    uint8_t          **data ) {
+
+    if (( way < 0 ) || ( way >= ways ) || ( set < 0 ) || ( set >= sets )) {
+
+        return ( false );
+    }
+
+    *info = &cacheInfo[ ( way * sets ) + set ];
+    *data = &cacheData[ (( way * sets ) + set ) * lineSize ];
+    return ( true );
+}
+
+//----------------------------------------------------------------------------------------
+// "writeBackLine" writes a modified line back to memory. The line stays valid.
+//
+//----------------------------------------------------------------------------------------
+bool T64Cache::writeBackLine( int way, int set ) {
+
+    T64CacheLineInfo *cInfo = &cacheInfo[ ( way * sets ) + set ];
+    uint8_t          *cData = &cacheData[ (( way * sets ) + set ) * lineSize ];
+    T64Word          lAdr   = ( cInfo -> tag << ( offsetBits + indexBits )) |
+                              ((T64Word) set << offsetBits );
+
+    if ( ! proc -> busOpWriteBlock( lAdr, cData, lineSize )) return( false );
+
+    cInfo -> modified = false;
+    perf -> inc( perfBase + 2 );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// "fillLine" is the miss handling. We are called with the coherence lock held,
+// no other thread will send us requests during the miss. First select a victim
+// line in the set. A line that is held shared for a write is just replaced by
+// the private copy. If the victim was modified, it is written back first. Then
+// we READ SHARED, or READ PRIVATE for a write, the new cache line into this
+// slot. The way of the line is returned.
+//
+//----------------------------------------------------------------------------------------
+bool T64Cache::fillLine( T64Word pAdr, bool wMode, int *way ) {
+
+    int set = getSetIndex( pAdr );
+    int w   = lookupWay( pAdr );
+
+    if ( w < 0 ) w = plruVictim( set );
+
+    T64CacheLineInfo *cInfo = &cacheInfo[ ( w * sets ) + set ];
+    uint8_t          *cData = &cacheData[ (( w * sets ) + set ) * lineSize ];
+    T64Word          lAdr   = pAdr & ~offsetBitmask;
+
+    perf -> inc( perfBase + 1 );
+
+    if (( cInfo -> valid ) && ( cInfo -> modified )) {
+
+        if ( ! writeBackLine( w, set )) return( false );
+    }
+
+    cInfo -> valid = false;
+
+    bool rStat = ( wMode ) ?
+        proc -> busOpReadPrivateBlock( lAdr, cData, lineSize ) :
+        proc -> busOpReadSharedBlock( lAdr, cData, lineSize );
+
+    if ( ! rStat ) return( false );
+
+    cInfo -> valid      = true;
+    cInfo -> modified   = wMode;
+    cInfo -> tag        = getTag( pAdr );
+
+    *way = w;
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// A cache read operation. This is the entry point for the CPU. The data item
+// is aligned to its length, it never crosses a line. A hit is served under the
+// cache lock. A miss fills the line and then returns the data.
+//
+//----------------------------------------------------------------------------------------
+bool T64Cache::read( T64Word pAdr, uint8_t *data, int len ) {
+
+    int set = getSetIndex( pAdr );
+    int ofs = getLineOfs( pAdr );
+
+    lockCache( );
+
+    int w = lookupWay( pAdr );
+
+    if ( w >= 0 ) {
+
+        perf -> inc( perfBase );
+        plruUpdate( set, w );
+        memcpy( data, &cacheData[ (( w * sets ) + set ) * lineSize + ofs ], len );
+        unlockCache( );
+        return( true );
+    }
+
+    unlockCache( );
+
+    bool rStat  = false;
+
+    proc -> sys -> lockCoherence( );
+
+    if ( fillLine( pAdr, false, &w )) {
+
+        plruUpdate( set, w );
+        memcpy( data, &cacheData[ (( w * sets ) + set ) * lineSize + ofs ], len );
+        rStat = true;
+    }
+
+    proc -> sys -> unlockCoherence( );
+    return( rStat );
+}
+
+//----------------------------------------------------------------------------------------
+// A cache write operation. This is the entry point for the CPU. A write to a
+// line we hold modified is served under the cache lock. Otherwise, the line is
+// obtained privately first. The write is not reported to the system, the CPU
+// does the store notification.
+//
+//----------------------------------------------------------------------------------------
+bool T64Cache::write( T64Word pAdr, uint8_t *data, int len ) {
+
+    int set = getSetIndex( pAdr );
+    int ofs = getLineOfs( pAdr );
+
+    lockCache( );
+
+    int w = lookupWay( pAdr );
+
+    if (( w >= 0 ) && ( cacheInfo[ ( w * sets ) + set ].modified )) {
+
+        perf -> inc( perfBase );
+        plruUpdate( set, w );
+        memcpy( &cacheData[ (( w * sets ) + set ) * lineSize + ofs ], data, len );
+        unlockCache( );
+        return( true );
+    }
+
+    unlockCache( );
+
+    bool rStat  = false;
+
+    proc -> sys -> lockCoherence( );
+
+    if ( fillLine( pAdr, true, &w )) {
+
+        plruUpdate( set, w );
+        memcpy( &cacheData[ (( w * sets ) + set ) * lineSize + ofs ], data, len );
+        rStat = true;
+    }
+
+    proc -> sys -> unlockCoherence( );
+    return( rStat );
+}
+
+//----------------------------------------------------------------------------------------
+// A cache flush operation. All lines in the address range that are held here
+// modified are written back and remain as shared lines. The request comes from
+// the system on behalf of another access and could be sent by any thread. A 
+// range larger than the cache, as sent for a DMA transfer, is handled by one
+// pass over all cache lines instead of a lookup for each line in the range.
+//
+//----------------------------------------------------------------------------------------
+void T64Cache::flush( T64Word pAdr, int len ) {
+
+    releaseRange( pAdr, len, false );
+}
+
+//----------------------------------------------------------------------------------------
+// A cache purge operation. All lines in the address range are removed. A line
+// that was modified is written back first.
+//
+//----------------------------------------------------------------------------------------
+void T64Cache::purge( T64Word pAdr, int len ) {
+
+    releaseRange( pAdr, len, true );
+}
+
+void T64Cache::releaseLine( int way, int set, bool remove ) {
+
+    T64CacheLineInfo *cInfo = &cacheInfo[ ( way * sets ) + set ];
+
+    if ( cInfo -> modified ) writeBackLine( way, set );
+
+    if ( remove ) {
+
+        cInfo -> valid  = false;
+        cInfo -> tag    = 0;
+    }
+}
+
+void T64Cache::releaseRange( T64Word pAdr, int len, bool remove ) {
+
+    lockCache( );
+
+    if ( len / lineSize > ways * sets ) {
+
+        for ( int w = 0; w < ways; w++ ) {
+
+            for ( int s = 0; s < sets; s++ ) {
+
+                T64CacheLineInfo *cInfo = &cacheInfo[ ( w * sets ) + s ];
+                T64Word          lAdr   = ( cInfo -> tag << ( offsetBits + indexBits )) |
+                                          ((T64Word) s << offsetBits );
+
+                if (( cInfo -> valid ) && ( lAdr + lineSize > pAdr ) && ( lAdr < pAdr + len )) {
+                    
+                    releaseLine( w, s, remove );
+                }
+            }
+        }
+    }
+    else {
+
+        for ( T64Word lAdr = pAdr & ~offsetBitmask; lAdr < pAdr + len; lAdr += lineSize ) {
+
+            int w = lookupWay( lAdr );
+            if ( w >= 0 ) releaseLine( w, getSetIndex( lAdr ), remove );
+        }
+    }
+
+    unlockCache( );
+}
+
+//----------------------------------------------------------------------------------------
+// Write back all modified lines. This is done before a reset or when the cache
+// is deleted, so that the stores are not lost.
+//
+//----------------------------------------------------------------------------------------
+void T64Cache::flushAll( ) {
+
+    proc -> sys -> lockCoherence( );
+    lockCache( );
+
+    for ( int w = 0; w < ways; w++ ) {
+
+        for ( int s = 0; s < sets; s++ ) {
+
+            T64CacheLineInfo *cInfo = &cacheInfo[ ( w * sets ) + s ];
+
+            if (( cInfo -> valid ) && ( cInfo -> modified )) writeBackLine( w, s );
+        }
+    }
+
+    unlockCache( );
+    proc -> sys -> unlockCoherence( );
+}
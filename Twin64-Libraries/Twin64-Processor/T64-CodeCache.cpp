@@ -0,0 +1,356 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Predecoded instruction cache
+//
+//----------------------------------------------------------------------------------------
+// The predecoded instruction cache holds decoded instructions organized by
+// physical page. An instruction slot contains the instruction word and the
+// handler routine for the instruction. The CPU consults the cache before going
+// through the regular fetch and decode path. Slots are filled a basic block at
+// a time. The regular path of fetching and decoding each instruction remains
+// the reference implementation, the cache is just a faster way to the same
+// instruction handlers.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Predecoded instruction cache
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License along with
+// this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-System.h"
+#include "T64-Processor.h"
+
+//----------------------------------------------------------------------------------------
+// Local name space.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// Address helpers. The page entry of a physical page is found by hashing the
+// page number into the page array.
+//
+//----------------------------------------------------------------------------------------
+T64Word pageAdr( T64Word adr ) {
+
+    return( adr & ~((T64Word) T64_PAGE_SIZE_BYTES - 1 ));
+}
+
+int pageIndex( T64Word pAdr ) {
+
+    return((int) (( pAdr / T64_PAGE_SIZE_BYTES ) % T64_CODE_CACHE_PAGES ));
+}
+
+int slotIndex( T64Word adr ) {
+
+    return((int) (( adr % T64_PAGE_SIZE_BYTES ) / sizeof( T64Instr )));
+}
+
+//----------------------------------------------------------------------------------------
+// A basic block ends with any branch or system instruction. These are the
+// instructions that change the instruction address other than moving to the
+// next instruction or that change the processor state.
+//
+//----------------------------------------------------------------------------------------
+bool isBlockEnd( T64Instr instr ) {
+
+    int opGroup = extractInstrOpGroup( instr );
+
+    return(( opGroup == OPC_GRP_BR ) || ( opGroup == OPC_GRP_SYS ));
+}
+
+//----------------------------------------------------------------------------------------
+// Clear all slots of a page.
+//
+//----------------------------------------------------------------------------------------
+void clearPage( T64CodePage *page ) {
+
+    for ( int i = 0; i < T64_CODE_CACHE_SLOTS; i++ ) {
+
+        page -> slot[ i ].handler  = nullptr;
+        page -> slot[ i ].instr    = 0;
+        page -> slot[ i ].blockEnd = false;
+        page -> slot[ i ].jitCount = 0;
+        page -> slot[ i ].jitLen   = 0;
+        page -> slot[ i ].jitCode  = nullptr;
+    }
+}
+
+} // namespace
+
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Code Cache
+//
+//----------------------------------------------------------------------------------------
+// Object creator. We allocate the page array and start with an empty cache.
+//
+//----------------------------------------------------------------------------------------
+T64CodeCache::T64CodeCache( T64Processor *proc ) {
+
+    this -> proc  = proc;
+    this -> perf  = proc -> getPerfBlock( );
+    this -> pages = new T64CodePage[ T64_CODE_CACHE_PAGES ];
+
+    reset( );
+}
+
+//----------------------------------------------------------------------------------------
+// Destructor.
+//
+//----------------------------------------------------------------------------------------
+T64CodeCache::~T64CodeCache( ) {
+
+    reset( );
+    delete [ ] pages;
+}
+
+//----------------------------------------------------------------------------------------
+// Reset the code cache. All pages and the current translation are invalidated,
+// the pages are unmarked in the code page directory and the statistics are
+// cleared.
+//
+//----------------------------------------------------------------------------------------
+void T64CodeCache::reset( ) {
+
+    purgeAll( );
+
+    for ( int i = 0; i < T64_CODE_CACHE_PAGES; i++ ) {
+
+        T64Word adr = pages[ i ].pAdr.load( std::memory_order_relaxed );
+
+        if ( pages[ i ].marked ) proc -> sys -> unmarkCodePage( adr );
+        pages[ i ].marked = false;
+    }
+
+    perf -> set( T64_PC_CCACHE_HITS, 0 );
+    perf -> set( T64_PC_CCACHE_MISSES, 0 );
+    perf -> set( T64_PC_CCACHE_PURGES, 0 );
+    perf -> set( T64_PC_BLOCKS, 0 );
+    perf -> set( T64_PC_BLOCK_INSTRS, 0 );
+    perf -> set( T64_PC_BLOCK_MISMATCHES, 0 );
+}
+
+//----------------------------------------------------------------------------------------
+// Lookup a decoded instruction for the virtual address. We have a hit when the
+// address is in the virtual page we currently execute from, the privilege mode
+// is still the same, the page was not purged and the slot is decoded. In this
+// case, the TLB info of the page is returned as well. Any other case returns a
+// null pointer and the CPU will go through the regular translation path and
+// then fill the cache. This includes a misaligned instruction address, which
+// will then raise the alignment trap on the regular path.
+//
+//----------------------------------------------------------------------------------------
+T64DecodedInstr *T64CodeCache::lookup( T64Word   vAdr,
+                                       uint8_t   privMode,
+                                       uint16_t  *tlbInfo ) {
+
+    if (( ! curValid.load( std::memory_order_acquire )) ||
+        ( pageAdr( vAdr ) != curVPage ) ||
+        ( privMode != curPrivMode ) ||
+        ( ! isAlignedInstrAdr( vAdr )) ||
+        ( ! curPage -> valid.load( std::memory_order_acquire ))) {
+
+        return( nullptr );
+    }
+
+    T64DecodedInstr *dInstr = &curPage -> slot[ slotIndex( vAdr ) ];
+    if ( dInstr -> handler == nullptr ) return( nullptr );
+
+    *tlbInfo = curTlbInfo;
+    perf -> inc( T64_PC_CCACHE_HITS );
+    return( dInstr );
+}
+
+//----------------------------------------------------------------------------------------
+// Fill the cache for a translated instruction address. The CPU has done all the
+// checks for the virtual address. We remember the translation as the current
+// one, locate the page entry for the physical page and allocate it if needed.
+// A newly allocated page is marked in the code page directory before any 
+// instruction is read from it.
+// If the slot is not decoded yet, the basic block starting at this slot is
+// decoded. If the instruction word cannot be read, a null pointer is returned
+// and the CPU raises a machine check.
+//
+//----------------------------------------------------------------------------------------
+T64DecodedInstr *T64CodeCache::fill( T64Word    vAdr,
+                                     T64Word    pAdr,
+                                     uint8_t    privMode,
+                                     uint16_t   tlbInfo ) {
+
+    T64CodePage *page  = &pages[ pageIndex( pAdr ) ];
+    int         index  = slotIndex( pAdr );
+    T64Word     oldAdr = page -> pAdr.load( std::memory_order_relaxed );
+
+    if (( ! page -> valid.load( std::memory_order_acquire )) ||
+        ( oldAdr != pageAdr( pAdr ))) {
+
+        if ( page -> marked ) proc -> sys -> unmarkCodePage( oldAdr );
+
+        clearPage( page );
+        page -> pAdr.store( pageAdr( pAdr ), std::memory_order_relaxed );
+        page -> marked = true;
+        proc -> sys -> markCodePage( pageAdr( pAdr ));
+        page -> valid.store( true, std::memory_order_release );
+    }
+
+    curVPage    = pageAdr( vAdr );
+    curPrivMode = privMode;
+    curTlbInfo  = tlbInfo;
+    curPage     = page;
+    curValid.store( true, std::memory_order_release );
+
+    if ( page -> slot[ index ].handler == nullptr ) {
+
+        perf -> inc( T64_PC_CCACHE_MISSES );
+        if ( ! decodeBlock( page, index )) return( nullptr );
+    }
+    else perf -> inc( T64_PC_CCACHE_HITS );
+
+    return( &page -> slot[ index ] );
+}
+
+//----------------------------------------------------------------------------------------
+// The next decoded instruction within a basic block. The instruction passed is
+// one returned by a lookup, a fill or a previous call and is thus in the page 
+// we currently execute from. We return the following slot when the instruction
+// does not end a block, is not the last in the page, the page and translation
+// are still valid and the following slot is decoded. Otherwise a null pointer
+// is returned and the CPU goes through a lookup again. The instructions found
+// this way are not counted as cache hits, the CPU counts them as block 
+// instructions.
+//
+//----------------------------------------------------------------------------------------
+T64DecodedInstr *T64CodeCache::next( T64DecodedInstr *dInstr ) {
+
+    if (( dInstr -> blockEnd ) ||
+        ( dInstr >= &curPage -> slot[ T64_CODE_CACHE_SLOTS - 1 ] ) ||
+        ( ! curValid.load( std::memory_order_acquire )) ||
+        ( ! curPage -> valid.load( std::memory_order_acquire ))) {
+
+        return( nullptr );
+    }
+
+    dInstr++;
+    if ( dInstr -> handler == nullptr ) return( nullptr );
+
+    return( dInstr );
+}
+
+//----------------------------------------------------------------------------------------
+// The page and translation we currently execute from are still valid. The host
+// code of a translated block checks this after each store, a store into the
+// running block drops the page.
+//
+//----------------------------------------------------------------------------------------
+bool T64CodeCache::isCurPageValid( ) {
+
+    return(( curValid.load( std::memory_order_acquire )) &&
+           ( curPage -> valid.load( std::memory_order_acquire )));
+}
+
+//----------------------------------------------------------------------------------------
+// Decode a basic block. Starting with the slot index, we read and decode the
+// instruction words until we decoded a block ending instruction, reach the end
+// of the page or reach an already decoded slot. We return false when the very
+// first instruction word could not be read. A read failure further down just
+// ends the block, the CPU will deal with it when it gets there.
+//
+//----------------------------------------------------------------------------------------
+bool T64CodeCache::decodeBlock( T64CodePage *page, int index ) {
+
+    T64Word base = page -> pAdr.load( std::memory_order_relaxed );
+
+    for ( int i = index; i < T64_CODE_CACHE_SLOTS; i++ ) {
+
+        T64DecodedInstr *dInstr = &page -> slot[ i ];
+        T64Instr        instr   = 0;
+
+        if ( dInstr -> handler != nullptr ) break;
+
+        if ( ! proc -> busOpRead( base + i * sizeof( T64Instr ),
+                                  (uint8_t *) &instr,
+                                  sizeof( T64Instr ))) {
+
+            return( i > index );
+        }
+
+        instr = (T64Instr) loadBigEndian<sizeof( T64Instr )>((uint8_t *) &instr );
+
+        dInstr -> instr     = instr;
+        dInstr -> handler   = proc -> cpu -> decodeInstr( instr );
+        dInstr -> blockEnd  = isBlockEnd( instr );
+
+        if ( dInstr -> blockEnd ) break;
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Purge routines. A store to a physical page we have decoded instructions for
+// invalidates the page. A TLB purge invalidates the current translation and a
+// module purge invalidates everything. These routines can be called from other
+// threads and therefore only set the valid flags. The page content is cleared
+// by the owning CPU thread when the page entry is used again.
+//
+//----------------------------------------------------------------------------------------
+void T64CodeCache::purgePage( T64Word pAdr ) {
+
+    T64CodePage *page = &pages[ pageIndex( pAdr ) ];
+
+    if (( page -> pAdr.load( std::memory_order_relaxed ) == pageAdr( pAdr )) &&
+        ( page -> valid.load( std::memory_order_acquire ))) {
+
+        page -> valid.store( false, std::memory_order_release );
+        perf -> incShared( T64_PC_CCACHE_PURGES );
+    }
+}
+
+void T64CodeCache::purgeTranslation( ) {
+
+    curValid.store( false, std::memory_order_release );
+}
+
+void T64CodeCache::purgeAll( ) {
+
+    for ( int i = 0; i < T64_CODE_CACHE_PAGES; i++ ) {
+
+        pages[ i ].valid.store( false, std::memory_order_release );
+    }
+
+    purgeTranslation( );
+}
+
+//----------------------------------------------------------------------------------------
+// Statistics.
+//
+//----------------------------------------------------------------------------------------
+T64Word T64CodeCache::getHits( ) {
+
+    return( perf -> get( T64_PC_CCACHE_HITS ));
+}
+
+T64Word T64CodeCache::getMisses( ) {
+
+    return( perf -> get( T64_PC_CCACHE_MISSES ));
+}
+
+T64Word T64CodeCache::getPurges( ) {
+
+    return( perf -> get( T64_PC_CCACHE_PURGES ));
+}
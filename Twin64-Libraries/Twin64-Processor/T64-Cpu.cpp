@@ -24,6 +24,8 @@
 //
 //----------------------------------------------------------------------------------------
 #include "T64-Processor.h"
+#include <bit>
+#include <cstring>
 
 //----------------------------------------------------------------------------------------
 // Name space for local routines.
@@ -31,6 +33,24 @@
 //----------------------------------------------------------------------------------------
 namespace {
 
+//----------------------------------------------------------------------------------------
+// Compare and conditional branch condition evaluation for a condition known at
+// compile time. The conditions are the same as for the "evalCond" routine.
+//
+//----------------------------------------------------------------------------------------
+template <int COND>
+inline int evalCondT( T64Word val1, T64Word val2 ) {
+
+    if constexpr ( COND == 0 )      return( val1 == val2 );
+    else if constexpr ( COND == 1 ) return( val1 <  val2 );
+    else if constexpr ( COND == 2 ) return( val1 >  val2 );
+    else if constexpr ( COND == 3 ) return(( val1 & 0x1 ) == 0 );
+    else if constexpr ( COND == 4 ) return( val1 != val2 );
+    else if constexpr ( COND == 5 ) return( val1 <= val2 );
+    else if constexpr ( COND == 6 ) return( val1 >= val2 );
+    else                            return(( val1 & 0x1 ) != 1 );
+}
+
 };
 
 //****************************************************************************************
@@ -40,7 +60,9 @@ namespace {
 //
 //----------------------------------------------------------------------------------------
 // CPU object constructor. We keep a reference to the processor object for access
-// the processor components and via the processor to the system.
+// the processor components and via the processor to the system. With a data 
+// cache, the direct memory map is not used, memory could be older than the 
+// cached data.
 //
 // ??? need to set physical memory boundaries... we should get them from the 
 // processor.
@@ -48,8 +70,10 @@ namespace {
 //----------------------------------------------------------------------------------------
 T64Cpu::T64Cpu( T64Processor *proc, T64CpuType cpuType ) {
 
-    this -> proc    = proc;
-    this -> cpuType = cpuType;
+    this -> proc                = proc;
+    this -> cpuType             = cpuType;
+    this -> directMemEnabled    = (( proc -> options & T64_PO_DIRECT_MEM ) &&
+                                   ( proc -> dCache == nullptr ));
     
     switch ( cpuType ) {
 
@@ -77,6 +101,10 @@ void T64Cpu::reset( ) {
     psrReg          = 0;
     instrReg        = 0;
     physMemSize     = T64_MAX_PHYS_MEM_LIMIT;
+    pendingTrap     = T64Trap( NO_TRAP );
+    instrCycles     = 0;
+
+    purgeDirectMem( );
 }
 
 //----------------------------------------------------------------------------------------
@@ -115,6 +143,36 @@ void T64Cpu::setPsrReg( T64Word val ) {
     psrReg = val;
 }
 
+//----------------------------------------------------------------------------------------
+// Snapshot support. The architected state of the CPU is the register files and
+// the processor status word. A snapshot is taken between instructions, there is
+// no pending trap or instruction in flight.
+//
+//----------------------------------------------------------------------------------------
+void T64Cpu::saveState( T64Snapshot *snap ) {
+
+    snap -> put( cRegFile, sizeof( cRegFile ));
+    snap -> put( gRegFile, sizeof( gRegFile ));
+    snap -> put( &psrReg, sizeof( psrReg ));
+    snap -> put( &physMemSize, sizeof( physMemSize ));
+}
+
+bool T64Cpu::restoreState( T64Snapshot *snap ) {
+
+    if (( ! snap -> get( cRegFile, sizeof( cRegFile )))   ||
+        ( ! snap -> get( gRegFile, sizeof( gRegFile )))   ||
+        ( ! snap -> get( &psrReg, sizeof( psrReg )))      ||
+        ( ! snap -> get( &physMemSize, sizeof( physMemSize )))) {
+
+        return( false );
+    }
+
+    instrReg    = 0;
+    pendingTrap = T64Trap( NO_TRAP );
+    purgeDirectMem( );
+    return( true );
+}
+
 //----------------------------------------------------------------------------------------
 // Get/Set the general register values. The register Id is obtained from the 
 // register field position in the instruction word.
@@ -137,13 +195,38 @@ T64Word T64Cpu::getRegA( uint32_t instr ) {
 
 void T64Cpu::setRegR( uint32_t instr, T64Word val ) {
     
+    if (( proc -> tracer != nullptr ) && ( extractInstrRegR( instr ) != 0 )) {
+        
+        proc -> tracer -> record( T64_TR_REG_WRITE, extractInstrRegR( instr ), 0, val );
+    }
+
     setGeneralReg( extractInstrRegR( instr ), val );
 }
 
 //----------------------------------------------------------------------------------------
 // Trap code helpers. Each routine fills in the trap data and raises an exception.
+// The frequent traps, i.e. the TLB miss traps, the recovery counter trap, the 
+// overflow and illegal instruction traps and the user trap, do not throw an 
+// exception. They record the trap as the pending trap and return. The caller is
+// expected to return right away without changing any state and the instruction
+// execution routine delivers the trap. An instruction handler just leaves with
+// "return( illegalInstrTrap( ))". Raising a trap while another is pending keeps
+// the first one.
 //
 //----------------------------------------------------------------------------------------
+void T64Cpu::raiseTrap( T64TrapCode code, T64Word arg0, T64Word arg1 ) {
+
+    if ( pendingTrap.trapCode == NO_TRAP ) {
+        
+        pendingTrap = T64Trap( code, psrReg, arg0, arg1 );
+    }
+}
+
+bool T64Cpu::trapPending( ) {
+
+    return( pendingTrap.trapCode != NO_TRAP );
+}
+
 void T64Cpu::machineCheckTrap( T64Word adr ) {
 
     throw( T64Trap( MACHINE_CHECK, psrReg, instrReg, adr ));
@@ -151,7 +234,7 @@ void T64Cpu::machineCheckTrap( T64Word adr ) {
 
 void T64Cpu::dataMemTlbMissTrap( T64Word adr ) {
 
-    throw( T64Trap( DATA_TLB_MISS_TRAP, psrReg, instrReg, adr ));
+    raiseTrap( DATA_TLB_MISS_TRAP, instrReg, adr );
 }
 
 void T64Cpu::dataMemNonAccessTlbMissTrap( T64Word adr ) {
@@ -161,7 +244,7 @@ void T64Cpu::dataMemNonAccessTlbMissTrap( T64Word adr ) {
 
 void T64Cpu::instrTlbMissTrap( T64Word adr ) {
 
-    throw( T64Trap( INSTR_TLB_MISS_TRAP, psrReg, instrReg, adr ));
+    raiseTrap( INSTR_TLB_MISS_TRAP, instrReg, adr );
 }
 
 void T64Cpu::instrMemAccRightsTrap( T64Word adr ) {
@@ -201,17 +284,17 @@ void T64Cpu::privModeOperationTrap( ) {
 
 void T64Cpu::overFlowTrap( ) {
 
-    throw( T64Trap( OVERFLOW_TRAP, psrReg, instrReg, 0 ));
+    raiseTrap( OVERFLOW_TRAP, instrReg, 0 );
 }
 
 void T64Cpu::illegalInstrTrap( ) {
 
-    throw( T64Trap( ILLEGAL_INSTR_TRAP, psrReg, instrReg, 0 ));
+    raiseTrap( ILLEGAL_INSTR_TRAP, instrReg, 0 );
 }
 
 void T64Cpu::recoveryCounterTrap( ) {
 
-    throw( T64Trap( RECOVERY_COUNTER_TRAP, psrReg, instrReg, 0 ));
+    raiseTrap( RECOVERY_COUNTER_TRAP, instrReg, 0 );
 }
 
 //----------------------------------------------------------------------------------------
@@ -362,24 +445,28 @@ int T64Cpu::evalCond( int cond, T64Word val1, T64Word val2 ) {
 
 //----------------------------------------------------------------------------------------
 // Diagnostic operations. This routine is called by the DIAG instruction to 
-// dispatch to the respective handler. None so far.
+// dispatch to the respective handler. The sample trigger option ends the fast
+// forward phase of a sampling simulation. The wait option is an idle hint.
 //
 //----------------------------------------------------------------------------------------
 T64Word T64Cpu::diagOpHandler( int opt, T64Word arg1, T64Word arg2 ) {
 
+    if      ( opt == T64_DIAG_SAMPLE_TRIGGER ) proc -> diagTrigger = true;
+    else if ( opt == T64_DIAG_WAIT )           proc -> requestIdle( arg1 );
+
     return ( 0 );
 }
 
 //----------------------------------------------------------------------------------------
-// Instruction memory read. This is the central routine that fetches an instruction
-// word. We first check the address range. For a physical address we must be in 
-// priv mode. For a virtual address, the TLB is consulted for address translation
-// and access control data.
+// Instruction address translation. We first check the address range. For a 
+// physical address we must be in priv mode. For a virtual address, the TLB is 
+// consulted for address translation and access control data. The resulting
+// physical address is returned. A TLB miss is a pending trap, the returned
+// address is then not valid. 
 //
 //----------------------------------------------------------------------------------------
-T64Word T64Cpu::instrRead( T64Word vAdr ) {
+T64Word T64Cpu::instrTranslate( T64Word vAdr ) {
 
-    uint32_t instr = 0;
     T64Word  pAdr  = vAdr;
 
     instrAlignmentCheck( vAdr );
@@ -399,18 +486,137 @@ T64Word T64Cpu::instrRead( T64Word vAdr ) {
             }
 
             instrTlbMissTrap( vAdr );
+            return( 0 );
         }
 
         instrAccCheck( vAdr, instrTlbInfo );      
     }
 
-    if ( ! proc -> busOpRead( pAdr, (uint8_t *) &instr, 4 )) {
+    return( pAdr );
+}
+
+//----------------------------------------------------------------------------------------
+// Instruction memory read. This is the central routine that fetches an instruction
+// word. The address is translated and the instruction word read from memory, or
+// from the instruction cache when the processor has one.
+//
+//----------------------------------------------------------------------------------------
+T64Word T64Cpu::instrRead( T64Word vAdr ) {
+
+    uint32_t instr = 0;
+    T64Word  pAdr  = instrTranslate( vAdr );
+
+    if ( trapPending( )) return( 0 );
+
+    if (( proc -> iCache != nullptr ) && ( ! isInIoAdrRange( pAdr ))) {
+
+        if ( ! proc -> iCache -> read( pAdr, (uint8_t *) &instr, 4 )) {
+
+            machineCheckTrap( vAdr );
+        }
+    }
+    else if ( ! proc -> busOpRead( pAdr, (uint8_t *) &instr, 4 )) {
 
             machineCheckTrap( vAdr );
     }  
 
-    copyEndianAware( ((uint8_t *) &instr ), ((uint8_t *) &instr ), 4 );
-    return( instr );
+    return( loadBigEndian<4>((uint8_t *) &instr ));
+}
+
+//----------------------------------------------------------------------------------------
+// Predecoded instruction read. When the processor has a code cache, we first 
+// ask the cache for the decoded instruction. On a miss, the address is 
+// translated with all checks done and the cache filled for this address. Note
+// that a hit also restores the TLB info of the instruction page, which is used
+// by the gateway branch. On a pending trap a null pointer is returned.
+//
+//----------------------------------------------------------------------------------------
+T64DecodedInstr *T64Cpu::instrReadDecoded( T64Word vAdr ) {
+
+    T64CodeCache    *codeCache  = proc -> codeCache;
+    uint8_t         privMode    = extractPsrXbit( psrReg );
+    T64DecodedInstr *dInstr     = codeCache -> lookup( vAdr, privMode, &instrTlbInfo );
+
+    if ( dInstr == nullptr ) {
+
+        T64Word pAdr = instrTranslate( vAdr );
+
+        if ( trapPending( )) return( nullptr );
+
+        dInstr = codeCache -> fill( vAdr, pAdr, privMode, instrTlbInfo );
+        if ( dInstr == nullptr ) machineCheckTrap( vAdr );
+    }
+
+    return( dInstr );
+}
+
+//----------------------------------------------------------------------------------------
+// Direct memory map. For a physical address we return the host address when the
+// page is in host memory, otherwise a null pointer. On a map miss, the system 
+// is asked for the host page address. An entry made for a load is not writable,
+// the first store to the page asks the system again with the store intent, so 
+// that the memory marks the page dirty. A page that is not writable directly 
+// returns a null pointer for a store. A pending purge request is handled first.
+//
+//----------------------------------------------------------------------------------------
+uint8_t *T64Cpu::directMemPtr( T64Word pAdr, bool wMode ) {
+
+    if ( ! directMemEnabled ) return( nullptr );
+
+    if ( directMemPurged.load( std::memory_order_acquire )) {
+
+        for ( int i = 0; i < T64_DIRECT_MEM_MAP_ENTRIES; i++ ) {
+
+            directMem[ i ].pAdr     = -1;
+            directMem[ i ].hostPtr  = nullptr;
+            directMem[ i ].writable = false;
+        }
+
+        directMemPurged.store( false, std::memory_order_release );
+    }
+
+    T64Word           pageAdr = pAdr & ~((T64Word) T64_PAGE_SIZE_BYTES - 1 );
+    T64DirectMemEntry *e      = &directMem[ ( pageAdr / T64_PAGE_SIZE_BYTES ) % 
+                                            T64_DIRECT_MEM_MAP_ENTRIES ];
+
+    if (( e -> pAdr != pageAdr ) || (( wMode ) && ( ! e -> writable ))) {
+
+        bool    writable = false;
+        uint8_t *hostPtr = proc -> sys -> getHostPagePtr( pageAdr, wMode, &writable );
+
+        if ( hostPtr == nullptr ) return( nullptr );
+
+        e -> pAdr       = pageAdr;
+        e -> hostPtr    = hostPtr;
+        e -> writable   = ( wMode ) && ( writable );
+    }
+
+    if (( wMode ) && ( ! e -> writable )) return( nullptr );
+
+    return( e -> hostPtr + ( pAdr - pageAdr ));
+}
+
+void T64Cpu::purgeDirectMem( ) {
+
+    directMemPurged.store( true, std::memory_order_release );
+}
+
+//----------------------------------------------------------------------------------------
+// Timing model. The CPU adds up the cycles of the instruction groups, the
+// processor adds the cycles for the TLB and cache events. A null configuration
+// turns the counting off.
+//
+//----------------------------------------------------------------------------------------
+void T64Cpu::setTiming( const T64TimingConfig *cfg ) {
+
+    timingEnabled = ( cfg != nullptr );
+
+    for ( int i = 0; i < 4; i++ ) groupCycles[ i ] = ( timingEnabled ) ? cfg -> groupCycles[ i ] : 0;
+}
+
+T64Word T64Cpu::getInstrCycles( ) {
+
+    return( instrCycles );
 }
 
 //----------------------------------------------------------------------------------------
@@ -419,15 +625,38 @@ T64Word T64Cpu::instrRead( T64Word vAdr ) {
 // and stored right justified and sign extended in the return argument. We first
 // check the address range. For a physical address we must be in priv mode. For
 // a virtual address, the TLB is consulted for the translation and security 
-// checking. 
+// checking. A RAM page in the direct memory map is read right from host memory.
+// With a data cache, all but the IO address range is read through the cache. 
+// A TLB miss is a pending trap and the data returned is not valid. A read from
+// a page with a watchpoint filter bit set is checked against the watchpoints.
+//
+// The read routine is a template for the data length, so that the byte order 
+// conversion and the sign extension are compiled for each length. The entry 
+// point just selects the instance. The length is always computed from the 
+// instruction data width field, there are no other lengths.
 //
 //----------------------------------------------------------------------------------------
 T64Word T64Cpu::dataRead( T64Word vAdr, int len, bool sExt, bool rsv ) {
 
+    switch ( len ) {
+
+        case 1:     return( dataReadT<1>( vAdr, sExt, rsv ));
+        case 2:     return( dataReadT<2>( vAdr, sExt, rsv ));
+        case 4:     return( dataReadT<4>( vAdr, sExt, rsv ));
+        default:    return( dataReadT<8>( vAdr, sExt, rsv ));
+    }
+}
+
+template <int LEN>
+T64Word T64Cpu::dataReadT( T64Word vAdr, bool sExt, bool rsv ) {
+
     T64Word pAdr    = 0;
     T64Word data    = 0;
+    uint8_t buf[ LEN ];
  
-    dataAlignmentCheck( vAdr, len );
+    dataAlignmentCheck( vAdr, LEN );
+
+    if ( proc -> tracer != nullptr ) proc -> tracer -> record( T64_TR_MEM_READ, LEN, 0, vAdr );
            
     if ( vAdr < physMemSize ) { 
         
@@ -446,38 +675,42 @@ T64Word T64Cpu::dataRead( T64Word vAdr, int len, bool sExt, bool rsv ) {
             } 
         
             dataMemTlbMissTrap( vAdr );
+            return( 0 );
         }
 
         dataReadAccCheck( vAdr, tlbInfo );      
     }
 
+    if ( watchPageBits & breakPageBit( vAdr )) proc -> breaks -> checkData( vAdr, LEN, false );
+
     if ( rsv ) {
 
-        if ( ! proc -> busOpReadRsv( pAdr, ((uint8_t *) &data ), len )) {
+        if ( ! proc -> busOpReadRsv( pAdr, buf, LEN )) machineCheckTrap( pAdr );
+        data = loadBigEndian<LEN>( buf );
+    }
+    else if (( proc -> dCache != nullptr ) && ( ! isInIoAdrRange( pAdr ))) {
 
-            machineCheckTrap( pAdr );
-        }
+        if ( ! proc -> dCache -> read( pAdr, buf, LEN )) machineCheckTrap( pAdr );
+        data = loadBigEndian<LEN>( buf );
     }
     else {
-           
-        if ( ! proc -> busOpRead( pAdr, ((uint8_t *) &data ), len )) {
 
-            machineCheckTrap( pAdr );
-        }
+        uint8_t *hostPtr = directMemPtr( pAdr, false );
 
+        if ( hostPtr != nullptr ) {
+            
+            data = loadSharedBigEndian<LEN>( hostPtr );
+        }
+        else {
+            
+            if ( ! proc -> busOpRead( pAdr, buf, LEN )) machineCheckTrap( pAdr );
+            data = loadBigEndian<LEN>( buf );
+        }
     }
 
-    copyEndianAware(((uint8_t *) &data ), ((uint8_t *) &data ), len );
-
-    if ( sExt ) {
-
-        switch ( len ) {
+    if constexpr ( LEN < 8 ) {
 
-            case 1: data = extractSignedField64( data, 0, 8  ); break;
-            case 2: data = extractSignedField64( data, 0, 16 ); break;
-            case 4: data = extractSignedField64( data, 0, 32 ); break;
-            default: ;
-        }
+        if ( sExt ) data = extractSignedField64( data, 0, LEN * 8 );
     }
 
     return( data );
@@ -488,16 +721,35 @@ T64Word T64Cpu::dataRead( T64Word vAdr, int len, bool sExt, bool rsv ) {
 // 4 and 8, aligned accordingly. The data is stored in memory in the length 
 // given. We first check the address range. For a physical address we must be 
 // in priv mode. For a virtual address, the TLB is consulted for the translation
-// and security checking. 
+// and security checking. A store to a writable RAM page in the direct memory 
+// map goes right to host memory. The other processors are still informed about
+// the store, just as the bus write operation would do. The same is done for a
+// store into the data cache. For a conditional store, the result tells whether
+// the store was done. A TLB miss is a pending trap and nothing is stored. The
+// watchpoints are checked just as for a read. Just like the read routine, the
+// routine is a template for the data length.
 //
 //----------------------------------------------------------------------------------------
 bool T64Cpu::dataWrite( T64Word vAdr, T64Word data, int len, bool cond ) {
 
+    switch ( len ) {
+
+        case 1:     return( dataWriteT<1>( vAdr, data, cond ));
+        case 2:     return( dataWriteT<2>( vAdr, data, cond ));
+        case 4:     return( dataWriteT<4>( vAdr, data, cond ));
+        default:    return( dataWriteT<8>( vAdr, data, cond ));
+    }
+}
+
+template <int LEN>
+bool T64Cpu::dataWriteT( T64Word vAdr, T64Word data, bool cond ) {
+
     T64Word pAdr = 0;
+    uint8_t buf[ LEN ];
 
-    dataAlignmentCheck( vAdr, len );
+    dataAlignmentCheck( vAdr, LEN );
 
-    copyEndianAware(((uint8_t *) &data ), ((uint8_t *) &data ), len );
+    if ( proc -> tracer != nullptr ) proc -> tracer -> record( T64_TR_MEM_WRITE, LEN, 0, vAdr );
   
     if ( vAdr < physMemSize ) {
         
@@ -516,23 +768,39 @@ bool T64Cpu::dataWrite( T64Word vAdr, T64Word data, int len, bool cond ) {
             }
 
             dataMemTlbMissTrap( vAdr );
+            return( false );
         }
         
         dataWriteAccCheck( vAdr, tlbInfo ); 
     }
 
+    if ( watchPageBits & breakPageBit( vAdr )) proc -> breaks -> checkData( vAdr, LEN, true );
+
     if ( cond ) {
 
-        if ( ! proc -> busOpWriteCond( pAdr, ((uint8_t *) &data ), len )) {
+        storeBigEndian<LEN>( buf, data );
+        return( proc -> busOpWriteCond( pAdr, buf, LEN ));
+    }
+    else if (( proc -> dCache != nullptr ) && ( ! isInIoAdrRange( pAdr ))) {
 
-            machineCheckTrap( pAdr );
-        }
+        storeBigEndian<LEN>( buf, data );
+        if ( ! proc -> dCache -> write( pAdr, buf, LEN )) machineCheckTrap( pAdr );
+
+        proc -> sys -> busOpStoreNotify( proc, pAdr, LEN );
     }
     else {
 
-        if ( ! proc -> busOpWrite( pAdr, ((uint8_t *) &data ), len )) {
+        uint8_t *hostPtr = directMemPtr( pAdr, true );
+
+        if ( hostPtr != nullptr ) {
 
-            machineCheckTrap( pAdr );
+            storeSharedBigEndian<LEN>( hostPtr, data );
+            proc -> sys -> busOpStoreNotify( proc, pAdr, LEN );
+        }
+        else {
+            
+            storeBigEndian<LEN>( buf, data );
+            if ( ! proc -> busOpWrite( pAdr, buf, LEN )) machineCheckTrap( pAdr );
         }
     }
 
@@ -601,45 +869,42 @@ bool T64Cpu:: dataWriteRegBOfsRegX( uint32_t instr ) {
     return( dataWrite( targetAdr, val, len ));
 }
 
+//----------------------------------------------------------------------------------------
+// Illegal opcode. This is the handler for all opcodes not assigned.
+//
+//----------------------------------------------------------------------------------------
+void T64Cpu::instrIllegalOp( T64Instr instr ) {
+
+    illegalInstrTrap( );
+}
+
 //----------------------------------------------------------------------------------------
 // ALU:NOP operation.
 //
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrAluNopOp( T64Instr instr ) {
 
-    if ( instr != 0 ) illegalInstrTrap( );
+    if ( instr != 0 ) return( illegalInstrTrap( ));
     nextInstr( );
 }
 
 //----------------------------------------------------------------------------------------
-// ALU:ADD operation.
+// ALU:ADD operation. The handler is a template for the register or immediate 
+// operand form. The decoder already checked the unused fields of the register
+// form.
 //
 //----------------------------------------------------------------------------------------
+template <bool IMM>
 void T64Cpu::instrAluAddOp( T64Instr instr ) {
 
     T64Word val1 = getRegB( instr );
     T64Word val2 = 0;
 
-    switch ( extractInstrFieldU( instr, 19, 3 )) {
-                        
-        case 0: { 
-            
-            if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) illegalInstrTrap( );
-            if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
-            val2 = getRegA( instr ); 
-
-        } break;       
-        
-        case 1: { 
-            
-            val2 = extractInstrSignedImm15( instr ); 
-            
-        } break;
-
-        default: illegalInstrTrap( );
-    }
+    if constexpr ( IMM ) val2 = extractInstrSignedImm15( instr );
+    else                 val2 = getRegA( instr ); 
 
     addOverFlowCheck( val1, val2 );
+    if ( trapPending( )) return;
     setRegR( instr, val1 + val2 );            
     nextInstr( );
 }
@@ -663,48 +928,38 @@ void T64Cpu::instrMemAddOp( T64Instr instr ) {
 
         case 1: { 
 
-            if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+            if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
             val2 = dataReadRegBOfsRegX( instr, true );
         
         } break;
 
-        default: illegalInstrTrap( );
+        default: return( illegalInstrTrap( ));
     }
 
+    if ( trapPending( )) return;
+
     addOverFlowCheck( val1, val2 );
+    if ( trapPending( )) return;
     setRegR( instr, val1 + val2 );
     nextInstr( );
 }
 
 //----------------------------------------------------------------------------------------
-// ALU_SUB operation.
+// ALU_SUB operation. Just like the ADD operation, a template for the operand 
+// form.
 //
 //----------------------------------------------------------------------------------------
+template <bool IMM>
 void T64Cpu::instrAluSubOp( T64Instr instr ) {
 
     T64Word val1 = getRegB( instr );
     T64Word val2 = 0;
     
-    switch ( extractInstrFieldU( instr, 19, 3 )) {
-                        
-        case 0: { 
-            
-            if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) illegalInstrTrap( );
-            if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
-            val2 = getRegA( instr ); 
-
-        } break;       
-        
-        case 1: { 
-            
-            val2 = extractInstrSignedImm15( instr ); 
-            
-        } break;
-
-        default: illegalInstrTrap( );
-    }
+    if constexpr ( IMM ) val2 = extractInstrSignedImm15( instr );
+    else                 val2 = getRegA( instr ); 
             
     subUnderFlowCheck( val1, val2 );
+    if ( trapPending( )) return;
     setRegR( instr, val1 - val2 );
     nextInstr( );
 }
@@ -728,15 +983,18 @@ void T64Cpu::instrMemSubOp( T64Instr instr ) {
 
         case 1: { 
 
-            if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+            if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
             val2 = dataReadRegBOfsRegX( instr, true );
         
         } break;
 
-        default: illegalInstrTrap( );
+        default: return( illegalInstrTrap( ));
     }
 
+    if ( trapPending( )) return;
+
     subUnderFlowCheck( val1, val2 );
+    if ( trapPending( )) return;
     setRegR( instr, val1 - val2 );
     nextInstr( );
 }
@@ -756,8 +1014,8 @@ void T64Cpu::instrAluAndOp( T64Instr instr ) {
     }
     else {
 
-        if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) illegalInstrTrap( );
-        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+        if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) return( illegalInstrTrap( ));
+        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
         val2 = getRegA( instr );
     }
     
@@ -779,11 +1037,13 @@ void T64Cpu::instrMemAndOp( T64Instr instr ) {
 
     if ( extractInstrBit( instr, 19 )) {
         
-        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
         val2 = dataReadRegBOfsRegX( instr, true );
     }
     else val2 = dataReadRegBOfsImm13( instr, true );
     
+    if ( trapPending( )) return;
+
     if ( extractInstrBit( instr, 20 )) val1 = ~ val1;
     T64Word res = val1 & val2;
     if ( extractInstrBit( instr, 21 )) res = ~ res;
@@ -806,8 +1066,8 @@ void T64Cpu::instrAluOrOp( T64Instr instr ) {
     }
     else {
 
-        if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) illegalInstrTrap( );
-        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+        if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) return( illegalInstrTrap( ));
+        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
         val2 = getRegA( instr );
     }
     
@@ -829,11 +1089,13 @@ void T64Cpu::instrMemOrOp( T64Instr instr ) {
 
     if ( extractInstrBit( instr, 19 )) {
         
-        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
         val2 = dataReadRegBOfsRegX( instr, true );
     }
     else val2 = dataReadRegBOfsImm13( instr, true );
     
+    if ( trapPending( )) return;
+
     if ( extractInstrBit( instr, 20 )) val1 = ~ val1;
     T64Word res = val1 | val2;
     if ( extractInstrBit( instr, 21 )) res = ~ res;
@@ -850,7 +1112,7 @@ void T64Cpu::instrAluXorOp( T64Instr instr ) {
     T64Word val1 = getRegB( instr );
     T64Word val2 = 0;
 
-    if ( extractInstrBit( instr, 20 )) illegalInstrTrap( );
+    if ( extractInstrBit( instr, 20 )) return( illegalInstrTrap( ));
 
     if ( extractInstrBit( instr, 19 )) {
         
@@ -858,7 +1120,7 @@ void T64Cpu::instrAluXorOp( T64Instr instr ) {
     } 
     else {
 
-        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
         val2 = getRegA( instr );
     }                      
     
@@ -877,15 +1139,17 @@ void T64Cpu::instrMemXorOp( T64Instr instr ) {
     T64Word val1 = getRegB( instr );
     T64Word val2 = 0;
 
-    if ( extractInstrBit( instr, 20 )) illegalInstrTrap( );
+    if ( extractInstrBit( instr, 20 )) return( illegalInstrTrap( ));
     
     if ( extractInstrBit( instr, 19 )) {
         
-        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
         val2 = dataReadRegBOfsRegX( instr, true );
     }
     else val2 = dataReadRegBOfsImm13( instr, true );
     
+    if ( trapPending( )) return;
+
     T64Word res = val1 ^ val2;
     if ( extractInstrBit( instr, 21 )) res = ~ res;
     setRegR( instr, res );
@@ -893,25 +1157,21 @@ void T64Cpu::instrMemXorOp( T64Instr instr ) {
 }
 
 //----------------------------------------------------------------------------------------
-// ALU:CMP operation.
+// ALU:CMP operation. The handler is a template for the compare condition and
+// the operand form. The CMP_A opcode is the register form, the CMP_B opcode the
+// immediate form.
 //
 //----------------------------------------------------------------------------------------
+template <int COND, bool IMM>
 void T64Cpu::instrAluCmpOp( T64Instr instr ) {
 
     T64Word val1   = getRegB( instr );
     T64Word val2   = 0;
-    int     opCode = extractInstrOpNum( instr );
-    
-    if ( opCode == OPC_CMP_A ) {
-        
-        if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) illegalInstrTrap( );
-        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
-        val2 = getRegA( instr );
-    }
-    else if ( opCode == OPC_CMP_B ) val2 = extractInstrSignedImm15( instr );
-    else illegalInstrTrap( );
+
+    if constexpr ( IMM ) val2 = extractInstrSignedImm15( instr );
+    else                 val2 = getRegA( instr );
     
-    setRegR( instr, evalCond( extractInstrFieldU( instr, 19, 3 ), val1, val2 ));
+    setRegR( instr, evalCondT<COND>( val1, val2 ));
     nextInstr( );
 }
 
@@ -931,11 +1191,13 @@ void T64Cpu::instrMemCmpOp( T64Instr instr ) {
     }
     else if ( opCode == OPC_CMP_B ) {
         
-        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
         val2 = dataReadRegBOfsRegX( instr, true );
     }
-    else illegalInstrTrap( );
+    else return( illegalInstrTrap( ));
     
+    if ( trapPending( )) return;
+
     setRegR( instr, evalCond( extractInstrFieldU( instr, 19, 3 ), val1, val2 ));
     nextInstr( );
 }
@@ -959,7 +1221,7 @@ void T64Cpu::instrAluBitOp( T64Instr instr ) {
             int     pos  = 0;
             int     len  = extractInstrFieldU( instr, 0, 6 );
 
-            if ( extractInstrBit( instr, 14 )) illegalInstrTrap( );
+            if ( extractInstrBit( instr, 14 )) return( illegalInstrTrap( ));
             
             if ( extractInstrBit( instr, 13 ))   
                 pos = (int) cRegFile[ CTL_REG_SHAMT ] & 0x3F;
@@ -1007,8 +1269,8 @@ void T64Cpu::instrAluBitOp( T64Instr instr ) {
             int     shamt   = 0;
             T64Word res     = 0;
 
-            if ( extractInstrBit( instr, 14 )) illegalInstrTrap( );
-            if ( extractInstrFieldU( instr, 6, 3 )) illegalInstrTrap( );
+            if ( extractInstrBit( instr, 14 )) return( illegalInstrTrap( ));
+            if ( extractInstrFieldU( instr, 6, 3 )) return( illegalInstrTrap( ));
             
             if ( extractInstrBit( instr, 13 ))    
                 shamt = (int) cRegFile[ CTL_REG_SHAMT ] & 0x3F;
@@ -1020,7 +1282,7 @@ void T64Cpu::instrAluBitOp( T64Instr instr ) {
             
         } break;
             
-        default: illegalInstrTrap( );
+        default: return( illegalInstrTrap( ));
     }
 
     nextInstr( );
@@ -1038,7 +1300,7 @@ void T64Cpu::instrAluShaOP( T64Instr instr ) {
     int     shamt = extractInstrFieldU( instr, 13, 2 );
     int     opt   = extractInstrFieldU( instr, 19, 3 );
 
-    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
     
     switch (  opt ) {
 
@@ -1048,7 +1310,7 @@ void T64Cpu::instrAluShaOP( T64Instr instr ) {
         case 1: 
         case 3: val2 = extractInstrSignedImm13( instr ); break;
 
-        default: illegalInstrTrap( );
+        default: return( illegalInstrTrap( ));
     }
 
     switch ( opt ) {
@@ -1056,7 +1318,7 @@ void T64Cpu::instrAluShaOP( T64Instr instr ) {
         case 0:
         case 1: {
 
-            if ( willShiftLeftOverflow( val1, shamt )) overFlowTrap( );
+            if ( willShiftLeftOverflow( val1, shamt )) return( overFlowTrap( ));
             res = val1 << shamt;
 
         } break;
@@ -1068,10 +1330,11 @@ void T64Cpu::instrAluShaOP( T64Instr instr ) {
 
         } break;
 
-        default: illegalInstrTrap( );
+        default: return( illegalInstrTrap( ));
     }
 
     addOverFlowCheck( res, val2 );
+    if ( trapPending( )) return;
     setRegR( instrReg, res + val2 );
     nextInstr( );
 }
@@ -1117,12 +1380,12 @@ void T64Cpu::instrAluLdoOp( T64Instr instr ) {
         case 0: ofs = extractInstrSignedScaledImm13( instr ); break;
         case 1: {
             
-            if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+            if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
             ofs = getRegA( instr ); 
 
         } break;
 
-        default: illegalInstrTrap( );
+        default: return( illegalInstrTrap( ));
     }
     
     setRegR( instr, addAdrOfs32( base, ofs ));
@@ -1130,22 +1393,24 @@ void T64Cpu::instrAluLdoOp( T64Instr instr ) {
 }
 
 //----------------------------------------------------------------------------------------
-// MEM:LD operation.
+// MEM:LD operation. The handler is a template for the data width, the index or
+// offset address form and the sign extension. The decoder already checked the
+// reserved field bits.
 //
 //----------------------------------------------------------------------------------------
+template <int DW, bool INDEX, bool SEXT>
 void T64Cpu::instrMemLdOp( T64Instr instr ) {
 
-    if ( extractInstrBit( instr, 21 )) illegalInstrTrap( );
+    T64Word ofs = 0;
 
-    bool sExt = ! extractInstrBit( instr, 20 );
+    if constexpr ( INDEX ) ofs = getRegA( instr ) << DW;
+    else                   ofs = extractInstrSignedImm13( instr ) << DW;
 
-    if( extractInstrBit( instr, 19 )) {
+    T64Word val = dataReadT<( 1 << DW )>( addAdrOfs32( getRegB( instr ), ofs ), SEXT, false );
 
-        if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
-        setRegR( instr, dataReadRegBOfsRegX( instr, sExt ));
-    }
-    else setRegR( instr, dataReadRegBOfsImm13( instr, sExt ));
+    if ( trapPending( )) return;
    
+    setRegR( instr, val );
     nextInstr( );
 }
 
@@ -1160,13 +1425,16 @@ void T64Cpu::instrMemLdOp( T64Instr instr ) {
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrMemLdrOp( T64Instr instr ) {
 
-    if ( extractInstrBit( instr, 19 )) illegalInstrTrap( );
-    if ( extractInstrBit( instr, 21 )) illegalInstrTrap( );
-    if ( extractInstrDwField( instr ) != 3 ) illegalInstrTrap( );
+    if ( extractInstrBit( instr, 19 )) return( illegalInstrTrap( ));
+    if ( extractInstrBit( instr, 21 )) return( illegalInstrTrap( ));
+    if ( extractInstrDwField( instr ) != 3 ) return( illegalInstrTrap( ));
+
+    bool    sExt = ( extractInstrBit( instr, 20 ) == 0 );
+    T64Word val  = dataReadRegBOfsImm13( instr, sExt, true );
 
-    bool sExt = ( extractInstrBit( instr, 20 ) == 0 );
+    if ( trapPending( )) return;
           
-    setRegR( instr, dataReadRegBOfsImm13( instr, sExt, true ));
+    setRegR( instr, val );
     nextInstr( );
 }
 
@@ -1175,23 +1443,21 @@ void T64Cpu::instrMemLdrOp( T64Instr instr ) {
 //
 // The ST instruction stores a data item to memory. In addition, the reservation
 // is cleared if the address matches. In addition, we need to broadcast this
-// event to all processors.
+// event to all processors. Just like the LD operation, the handler is a 
+// template for the data width and the address form.
 //
 //----------------------------------------------------------------------------------------
+template <int DW, bool INDEX>
 void T64Cpu::instrMemStOp( T64Instr instr ) {
 
-    switch ( extractInstrFieldU( instr, 19, 3 )) {
+    T64Word ofs = 0;
 
-        case 0: dataWriteRegBOfsImm13( instr ); break;
-        case 1: {
-            
-            if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
-            dataWriteRegBOfsRegX( instr );
-        
-        } break;
+    if constexpr ( INDEX ) ofs = getRegA( instr ) << DW;
+    else                   ofs = extractInstrSignedImm13( instr ) << DW;
 
-        default: illegalInstrTrap( );
-    }
+    dataWriteT<( 1 << DW )>( addAdrOfs32( getRegB( instr ), ofs ), getRegR( instr ), false );
+
+    if ( trapPending( )) return;
 
     nextInstr( );
 }
@@ -1207,20 +1473,21 @@ void T64Cpu::instrMemStOp( T64Instr instr ) {
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrMemStcOp( T64Instr instr ) {
 
-    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) illegalInstrTrap( );
-    if ( extractInstrDwField( instr ) != 3 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) return( illegalInstrTrap( ));
+    if ( extractInstrDwField( instr ) != 3 ) return( illegalInstrTrap( ));
 
-    if ( dataWriteRegBOfsImm13( instr, true )) {
+    bool stored = dataWriteRegBOfsImm13( instr, true );
 
-        setRegR( instr, 1 );
-    }
-    else setRegR( instr, 0 );
+    if ( trapPending( )) return;
+
+    setRegR( instr, stored ? 1 : 0 );
 
     nextInstr( );
 }
 
 //----------------------------------------------------------------------------------------
-// BR:B_OP operation.
+// BR:B_OP operation. A branch to itself is an idle loop, the processor is asked
+// to idle.
 //
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrBrBOp( T64Instr instr ) {
@@ -1229,7 +1496,7 @@ void T64Cpu::instrBrBOp( T64Instr instr ) {
     T64Word rl      = addAdrOfs32( psrReg, 4 );
     T64Word newIA   = addAdrOfs32( psrReg, ofs );
 
-    if ( extractInstrFieldU( instr, 20, 2 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 20, 2 ) != 0 ) return( illegalInstrTrap( ));
     
     if ( extractInstrBit( instr, 19 )) { 
 
@@ -1239,6 +1506,8 @@ void T64Cpu::instrBrBOp( T64Instr instr ) {
         }
     }
    
+    if ( ofs == 0 ) proc -> requestIdle( 0 );
+   
     psrReg = newIA;
     setRegR( instr, rl );
 }
@@ -1255,7 +1524,7 @@ void T64Cpu::instrBrBeOp( T64Instr instr ) {
     T64Word newIA     = addAdrOfs32( newIABase, ofs );
     T64Word rl        = addAdrOfs32( psrReg, 4 );
 
-    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) illegalInstrTrap( ); 
+    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) return( illegalInstrTrap( )); 
     
     psrReg = newIA;
     setRegR( instr, rl );
@@ -1271,8 +1540,8 @@ void T64Cpu::instrBrBrOp( T64Instr instr ) {
     T64Word newIA = addAdrOfs32( psrReg, getRegB( instr ) << scale );
     T64Word rl    = addAdrOfs32( psrReg, 4 );
 
-    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) illegalInstrTrap( );
-    if ( extractInstrFieldU( instr, 0, 13 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) return( illegalInstrTrap( ));
+    if ( extractInstrFieldU( instr, 0, 13 ) != 0 ) return( illegalInstrTrap( ));
 
     instrAlignmentCheck( newIA );
     psrReg = newIA;
@@ -1290,8 +1559,8 @@ void T64Cpu::instrBrBvOp( T64Instr instr ) {
     T64Word rl      = addAdrOfs32( psrReg, 4 );
     T64Word newIA   = addAdrOfs32( base, getRegA( instr ) << scale );
 
-    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) illegalInstrTrap( );
-    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) return( illegalInstrTrap( ));
+    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
 
     instrAlignmentCheck( newIA );
 
@@ -1303,7 +1572,8 @@ void T64Cpu::instrBrBvOp( T64Instr instr ) {
 }
 
 //----------------------------------------------------------------------------------------
-// BR:BB_OP operation.
+// BR:BB_OP operation. The branch is taken when the tested bit matches the test
+// value, i.e. "BB.T" branches on a set bit and "BB.F" on a cleared bit.
 //
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrBrBbOp( T64Instr instr ) {
@@ -1312,7 +1582,7 @@ void T64Cpu::instrBrBbOp( T64Instr instr ) {
     bool    testBit = 0;
     int     pos     = 0;
     
-    if ( extractInstrBit( instr, 21 )) illegalInstrTrap( );
+    if ( extractInstrBit( instr, 21 )) return( illegalInstrTrap( ));
 
     if ( extractInstrBit( instr, 20 )) {
 
@@ -1322,7 +1592,7 @@ void T64Cpu::instrBrBbOp( T64Instr instr ) {
     
     testBit = extractInstrBit( getRegR( instr ), pos );
     
-    if ( testVal ^ testBit ) { 
+    if ( testVal == testBit ) { 
         
         psrReg = addAdrOfs32( psrReg, extractInstrSignedImm13( instr ) << 2 );
     }
@@ -1330,9 +1600,10 @@ void T64Cpu::instrBrBbOp( T64Instr instr ) {
 }
 
 //----------------------------------------------------------------------------------------
-// BR:ABR_OP operation.
+// BR:ABR_OP operation. The branch handlers are templates for the condition.
 //
 //----------------------------------------------------------------------------------------
+template <int COND>
 void T64Cpu::instrBrAbrOp( T64Instr instr ) {
 
     T64Word val1    = getRegR( instr );
@@ -1340,12 +1611,13 @@ void T64Cpu::instrBrAbrOp( T64Instr instr ) {
     T64Word sum     = 0;
 
     addOverFlowCheck( val1, val2 );
+    if ( trapPending( )) return;
     sum = val1 + val2;
     setRegR( instr, sum );
 
-    if ( evalCond( extractInstrFieldU( instr, 19, 3 ), sum, 0 )) {
+    if ( evalCondT<COND>( sum, 0 )) {
 
-        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ));
+        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ) << 2 );
     } 
     else nextInstr( );
 }
@@ -1354,14 +1626,15 @@ void T64Cpu::instrBrAbrOp( T64Instr instr ) {
 // BR:CBR_OP operation.
 //
 //----------------------------------------------------------------------------------------
+template <int COND>
 void T64Cpu::instrBrCbrOp( T64Instr instr ) {
 
     T64Word val1    = getRegR( instr );
     T64Word val2    = getRegB( instr );
 
-    if ( evalCond( extractInstrFieldU( instr, 19, 3 ), val1, val2 )) {
+    if ( evalCondT<COND>( val1, val2 )) {
 
-        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ));
+        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ) << 2 );
     } 
     else nextInstr( );
 }
@@ -1370,15 +1643,16 @@ void T64Cpu::instrBrCbrOp( T64Instr instr ) {
 // BR:MBR_OP operation.
 //
 //----------------------------------------------------------------------------------------
+template <int COND>
 void T64Cpu::instrBrMbrOp( T64Instr instr ) {
 
     T64Word val = getRegB( instr );
         
     setRegR( instr, val );
     
-    if ( evalCond( extractInstrFieldU( instr, 19, 3 ), val, 0 )) {
+    if ( evalCondT<COND>( val, 0 )) {
 
-        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ));
+        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ) << 2 );
     }
     else nextInstr( );
 }
@@ -1394,6 +1668,9 @@ void T64Cpu::instrBrMbrOp( T64Instr instr ) {
 //  6       -> MFIA: psrReg.[ 51..32 ] 
 //  7       -> MFIA: psrReg.[ 63..52 ] 
 //
+// With the timing model, the cycles control register is brought up to date 
+// before it is read.
+//
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrSysMrOp( T64Instr instr ) {
 
@@ -1401,17 +1678,19 @@ void T64Cpu::instrSysMrOp( T64Instr instr ) {
                         
         case 0: {
 
-            if ( extractInstrFieldU( instr, 4, 15 ) != 0 ) illegalInstrTrap( );
+            if ( extractInstrFieldU( instr, 4, 15 ) != 0 ) return( illegalInstrTrap( ));
             
             int cReg = extractInstrFieldU( instr, 0, 4 );
+            if (( cReg == CTL_REG_CYCLES ) && ( timingEnabled )) proc -> updateCycles( );
             setRegR( instr, cRegFile[ cReg ] ); 
             
         } break;
 
         case 1: {
 
-            if ( extractInstrFieldU( instr, 4, 15 ) != 0 ) illegalInstrTrap( );
+            if ( extractInstrFieldU( instr, 4, 15 ) != 0 ) return( illegalInstrTrap( ));
             int cReg = extractInstrFieldU( instr, 0, 4 );
+            if (( cReg == CTL_REG_CYCLES ) && ( timingEnabled )) proc -> updateCycles( );
             setRegR( instr, cRegFile[ cReg ] );
             cRegFile[ cReg ] = getRegB( instr );
 
@@ -1419,33 +1698,33 @@ void T64Cpu::instrSysMrOp( T64Instr instr ) {
 
         case 4: { 
             
-            if ( extractInstrFieldU( instr, 0, 19 ) != 0 ) illegalInstrTrap( );
+            if ( extractInstrFieldU( instr, 0, 19 ) != 0 ) return( illegalInstrTrap( ));
             setRegR( instr, psrReg ); 
             
         } break;
         
         case 5: {
             
-            if ( extractInstrFieldU( instr, 0, 19 ) != 0 ) illegalInstrTrap( );
+            if ( extractInstrFieldU( instr, 0, 19 ) != 0 ) return( illegalInstrTrap( ));
             setRegR( instr, extractField64( psrReg, 12, 20 )); 
             
         } break;
         
         case 6: { 
             
-            if ( extractInstrFieldU( instr, 0, 19 ) != 0 ) illegalInstrTrap( );
+            if ( extractInstrFieldU( instr, 0, 19 ) != 0 ) return( illegalInstrTrap( ));
             setRegR( instr, extractField64( psrReg, 32, 20 )); 
         
         } break;
 
         case 7: { 
             
-            if ( extractInstrFieldU( instr, 0, 19 ) != 0 ) illegalInstrTrap( );
+            if ( extractInstrFieldU( instr, 0, 19 ) != 0 ) return( illegalInstrTrap( ));
             setRegR( instr, extractField64( psrReg, 52, 12 )); 
             
         } break;
 
-        default: illegalInstrTrap( );
+        default: return( illegalInstrTrap( ));
     }
     
     nextInstr( );
@@ -1463,9 +1742,9 @@ void T64Cpu::instrSysLpaOp( T64Instr instr ) {
     T64Word ofs  = getRegA( instr );
     T64Word vAdr = addAdrOfs32( base, ofs );
 
-    if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) illegalInstrTrap( );
-    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) illegalInstrTrap( );
-    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) return( illegalInstrTrap( ));
+    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) return( illegalInstrTrap( ));
+    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
 
     T64Word     pAdr    = 0;
     uint16_t    tlbInfo = 0;
@@ -1493,8 +1772,8 @@ void T64Cpu::instrSysPrbOp( T64Instr instr ) {
     int     mode        = extractInstrFieldU( instr, 13, 2 );
     int     privLevel   = extractPsrXbit( psrReg );
     
-    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) illegalInstrTrap( );
-    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) return( illegalInstrTrap( ));
+    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
 
     if ( mode == 3 ) mode = extractField64( getRegA( instr ), 0, 2 );
 
@@ -1544,8 +1823,8 @@ void T64Cpu::instrSysPrbOp( T64Instr instr ) {
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrSysTlbOp( T64Instr instr ) {
 
-    if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) illegalInstrTrap( );
-    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) return( illegalInstrTrap( ));
+    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
 
     switch ( extractInstrFieldU( instr, 19, 3 )) {
 
@@ -1569,7 +1848,7 @@ void T64Cpu::instrSysTlbOp( T64Instr instr ) {
 
         } break;
 
-        default: illegalInstrTrap( );
+        default: return( illegalInstrTrap( ));
     }
     
     nextInstr( );
@@ -1590,8 +1869,8 @@ void T64Cpu::instrSysTlbOp( T64Instr instr ) {
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrSysCaOp( T64Instr instr ) {
 
-    if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) illegalInstrTrap( );
-    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 13, 2 ) != 0 ) return( illegalInstrTrap( ));
+    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
 
     switch ( extractInstrFieldU( instr, 19, 3 )) {
 
@@ -1604,7 +1883,7 @@ void T64Cpu::instrSysCaOp( T64Instr instr ) {
 
         } break;
 
-        default: illegalInstrTrap( );
+        default: return( illegalInstrTrap( ));
     }
     
     nextInstr( );
@@ -1619,7 +1898,7 @@ void T64Cpu::instrSysCaOp( T64Instr instr ) {
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrSysMstOp( T64Instr instr ) {
 
-    if ( extractInstrFieldU( instr, 0, 8 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 0, 8 ) != 0 ) return( illegalInstrTrap( ));
 
     switch ( extractInstrFieldU( instr, 19, 3 )) {
 
@@ -1635,7 +1914,7 @@ void T64Cpu::instrSysMstOp( T64Instr instr ) {
             
         } break;
 
-        default: illegalInstrTrap( );
+        default: return( illegalInstrTrap( ));
     }
     
     nextInstr( );
@@ -1647,7 +1926,7 @@ void T64Cpu::instrSysMstOp( T64Instr instr ) {
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrSysRfiOp( T64Instr instr ) {
 
-    if ( extractInstrFieldU( instr, 0, 22 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 0, 22 ) != 0 ) return( illegalInstrTrap( ));
 
     setRegR( instr, addAdrOfs32( psrReg, 4 ));
     psrReg = cRegFile[ CTL_REG_IPSR ];
@@ -1659,7 +1938,7 @@ void T64Cpu::instrSysRfiOp( T64Instr instr ) {
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrSysDiagOp( T64Instr instr ) {
 
-    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
 
     int diagOpt = ( extractInstrFieldU( instr, 19, 3 ) * 4 ) + 
                     extractInstrFieldU( instr, 13, 2 );
@@ -1675,91 +1954,572 @@ void T64Cpu::instrSysDiagOp( T64Instr instr ) {
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrSysTrapOp( T64Instr instr ) {
 
-    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) illegalInstrTrap( );
+    if ( extractInstrFieldU( instr, 0, 9 ) != 0 ) return( illegalInstrTrap( ));
 
     int trapOpt = ( extractInstrFieldU( instr, 19, 3 ) * 4 ) + 
                     extractInstrFieldU( instr, 13, 2 );
 
-    throw( T64Trap( USER_DEFINED_TRAP, psrReg, instrReg, trapOpt ));
+    raiseTrap( USER_DEFINED_TRAP, instrReg, trapOpt );
+}
+
+//----------------------------------------------------------------------------------------
+// Instruction decode. Each instruction is encoded based on the instruction group
+// and the opcode family. Essentially a big case statement, which returns the
+// handler routine for the instruction. 
+//
+// For the frequent instructions with options, there is a handler instance for
+// each variant, such as the operand form, the data width or the condition. The
+// variants are listed in constant tables, indexed by the option fields. The 
+// reserved fields of these instructions are checked here, an invalid encoding
+// decodes to the illegal instruction handler. With the code cache, all this is
+// done once, when the instruction is entered into the cache.
+//
+//----------------------------------------------------------------------------------------
+T64InstrHandler T64Cpu::decodeInstr( T64Instr instr ) {
+
+    static constexpr T64InstrHandler addTab[ 2 ] = {
+
+        &T64Cpu::instrAluAddOp<false>,  &T64Cpu::instrAluAddOp<true>
+    };
+
+    static constexpr T64InstrHandler subTab[ 2 ] = {
+
+        &T64Cpu::instrAluSubOp<false>,  &T64Cpu::instrAluSubOp<true>
+    };
+
+    static constexpr T64InstrHandler cmpTab[ 16 ] = {
+
+        &T64Cpu::instrAluCmpOp<0, false>, &T64Cpu::instrAluCmpOp<1, false>,
+        &T64Cpu::instrAluCmpOp<2, false>, &T64Cpu::instrAluCmpOp<3, false>,
+        &T64Cpu::instrAluCmpOp<4, false>, &T64Cpu::instrAluCmpOp<5, false>,
+        &T64Cpu::instrAluCmpOp<6, false>, &T64Cpu::instrAluCmpOp<7, false>,
+        &T64Cpu::instrAluCmpOp<0, true>,  &T64Cpu::instrAluCmpOp<1, true>,
+        &T64Cpu::instrAluCmpOp<2, true>,  &T64Cpu::instrAluCmpOp<3, true>,
+        &T64Cpu::instrAluCmpOp<4, true>,  &T64Cpu::instrAluCmpOp<5, true>,
+        &T64Cpu::instrAluCmpOp<6, true>,  &T64Cpu::instrAluCmpOp<7, true>
+    };
+
+    static constexpr T64InstrHandler ldTab[ 16 ] = {
+
+        &T64Cpu::instrMemLdOp<0, false, true>,  &T64Cpu::instrMemLdOp<1, false, true>,
+        &T64Cpu::instrMemLdOp<2, false, true>,  &T64Cpu::instrMemLdOp<3, false, true>,
+        &T64Cpu::instrMemLdOp<0, true, true>,   &T64Cpu::instrMemLdOp<1, true, true>,
+        &T64Cpu::instrMemLdOp<2, true, true>,   &T64Cpu::instrMemLdOp<3, true, true>,
+        &T64Cpu::instrMemLdOp<0, false, false>, &T64Cpu::instrMemLdOp<1, false, false>,
+        &T64Cpu::instrMemLdOp<2, false, false>, &T64Cpu::instrMemLdOp<3, false, false>,
+        &T64Cpu::instrMemLdOp<0, true, false>,  &T64Cpu::instrMemLdOp<1, true, false>,
+        &T64Cpu::instrMemLdOp<2, true, false>,  &T64Cpu::instrMemLdOp<3, true, false>
+    };
+
+    static constexpr T64InstrHandler stTab[ 8 ] = {
+
+        &T64Cpu::instrMemStOp<0, false>,    &T64Cpu::instrMemStOp<1, false>,
+        &T64Cpu::instrMemStOp<2, false>,    &T64Cpu::instrMemStOp<3, false>,
+        &T64Cpu::instrMemStOp<0, true>,     &T64Cpu::instrMemStOp<1, true>,
+        &T64Cpu::instrMemStOp<2, true>,     &T64Cpu::instrMemStOp<3, true>
+    };
+
+    static constexpr T64InstrHandler abrTab[ 8 ] = {
+
+        &T64Cpu::instrBrAbrOp<0>, &T64Cpu::instrBrAbrOp<1>, 
+        &T64Cpu::instrBrAbrOp<2>, &T64Cpu::instrBrAbrOp<3>,
+        &T64Cpu::instrBrAbrOp<4>, &T64Cpu::instrBrAbrOp<5>, 
+        &T64Cpu::instrBrAbrOp<6>, &T64Cpu::instrBrAbrOp<7>
+    };
+
+    static constexpr T64InstrHandler cbrTab[ 8 ] = {
+
+        &T64Cpu::instrBrCbrOp<0>, &T64Cpu::instrBrCbrOp<1>, 
+        &T64Cpu::instrBrCbrOp<2>, &T64Cpu::instrBrCbrOp<3>,
+        &T64Cpu::instrBrCbrOp<4>, &T64Cpu::instrBrCbrOp<5>, 
+        &T64Cpu::instrBrCbrOp<6>, &T64Cpu::instrBrCbrOp<7>
+    };
+
+    static constexpr T64InstrHandler mbrTab[ 8 ] = {
+
+        &T64Cpu::instrBrMbrOp<0>, &T64Cpu::instrBrMbrOp<1>, 
+        &T64Cpu::instrBrMbrOp<2>, &T64Cpu::instrBrMbrOp<3>,
+        &T64Cpu::instrBrMbrOp<4>, &T64Cpu::instrBrMbrOp<5>, 
+        &T64Cpu::instrBrMbrOp<6>, &T64Cpu::instrBrMbrOp<7>
+    };
+
+    int     opt         = extractInstrFieldU( instr, 19, 3 );
+    bool    regFormOk   = (( extractInstrFieldU( instr, 13, 2 ) == 0 ) &&
+                           ( extractInstrFieldU( instr, 0, 9 ) == 0 ));
+    bool    indexOk     = ( extractInstrFieldU( instr, 0, 9 ) == 0 );
+
+    switch ( extractInstrOpCode( instr ) ) {
+            
+        case ( OPC_GRP_ALU * 16 + OPC_NOP ):    return( &T64Cpu::instrAluNopOp );
+
+        case ( OPC_GRP_ALU * 16 + OPC_ADD ): {
+            
+            if ( opt == 1 )                     return( addTab[ 1 ] );
+            if (( opt == 0 ) && ( regFormOk ))  return( addTab[ 0 ] );
+            return( &T64Cpu::instrIllegalOp );
+        }
+        
+        case ( OPC_GRP_MEM * 16 + OPC_ADD ):    return( &T64Cpu::instrMemAddOp );
+
+        case ( OPC_GRP_ALU * 16 + OPC_SUB ): {
+            
+            if ( opt == 1 )                     return( subTab[ 1 ] );
+            if (( opt == 0 ) && ( regFormOk ))  return( subTab[ 0 ] );
+            return( &T64Cpu::instrIllegalOp );
+        }
+
+        case ( OPC_GRP_MEM * 16 + OPC_SUB ):    return( &T64Cpu::instrMemSubOp );
+        case ( OPC_GRP_ALU * 16 + OPC_AND ):    return( &T64Cpu::instrAluAndOp );
+        case ( OPC_GRP_MEM * 16 + OPC_AND ):    return( &T64Cpu::instrMemAndOp );
+        case ( OPC_GRP_ALU * 16 + OPC_OR ):     return( &T64Cpu::instrAluOrOp );
+        case ( OPC_GRP_MEM * 16 + OPC_OR ):     return( &T64Cpu::instrMemOrOp );
+        case ( OPC_GRP_ALU * 16 + OPC_XOR ):    return( &T64Cpu::instrAluXorOp );
+        case ( OPC_GRP_MEM * 16 + OPC_XOR ):    return( &T64Cpu::instrMemXorOp );
+        case ( OPC_GRP_ALU * 16 + OPC_CMP_A ): {
+            
+            if ( regFormOk ) return( cmpTab[ opt ] );
+            return( &T64Cpu::instrIllegalOp );
+        }
+
+        case ( OPC_GRP_ALU * 16 + OPC_CMP_B ):  return( cmpTab[ 8 + opt ] );
+        case ( OPC_GRP_MEM * 16 + OPC_CMP_A ):  return( &T64Cpu::instrMemCmpOp );
+        case ( OPC_GRP_MEM * 16 + OPC_CMP_B ):  return( &T64Cpu::instrMemCmpOp );
+        case ( OPC_GRP_ALU * 16 + OPC_BITOP ):  return( &T64Cpu::instrAluBitOp );
+        case ( OPC_GRP_ALU * 16 + OPC_SHAOP ):  return( &T64Cpu::instrAluShaOP );
+        case ( OPC_GRP_ALU * 16 + OPC_IMMOP ):  return( &T64Cpu::instrAluImmOp );
+        case ( OPC_GRP_ALU * 16 + OPC_LDO ):    return( &T64Cpu::instrAluLdoOp );
+        case ( OPC_GRP_MEM * 16 + OPC_LD ): {
+
+            if ( extractInstrBit( instr, 21 )) return( &T64Cpu::instrIllegalOp );
+            if (( extractInstrBit( instr, 19 )) && ( ! indexOk )) return( &T64Cpu::instrIllegalOp );
+
+            return( ldTab[ extractInstrDwField( instr ) + 
+                           ( extractInstrBit( instr, 19 ) * 4 ) +
+                           ( extractInstrBit( instr, 20 ) * 8 ) ] );
+        }
+
+        case ( OPC_GRP_MEM * 16 + OPC_LDR ):    return( &T64Cpu::instrMemLdrOp );
+        case ( OPC_GRP_MEM * 16 + OPC_ST ): {
+
+            if ( opt == 0 )                     return( stTab[ extractInstrDwField( instr ) ] );
+            if (( opt == 1 ) && ( indexOk ))    return( stTab[ extractInstrDwField( instr ) + 4 ] );
+            return( &T64Cpu::instrIllegalOp );
+        }
+
+        case ( OPC_GRP_MEM * 16 + OPC_STC ):    return( &T64Cpu::instrMemStcOp );
+        case ( OPC_GRP_BR * 16 + OPC_B ):       return( &T64Cpu::instrBrBOp );
+        case ( OPC_GRP_BR * 16 + OPC_BE ):      return( &T64Cpu::instrBrBeOp );
+        case ( OPC_GRP_BR * 16 + OPC_BR ):      return( &T64Cpu::instrBrBrOp );
+        case ( OPC_GRP_BR * 16 + OPC_BB ):      return( &T64Cpu::instrBrBbOp );
+        case ( OPC_GRP_BR * 16 + OPC_ABR ):     return( abrTab[ opt ] );
+        case ( OPC_GRP_BR * 16 + OPC_CBR ):     return( cbrTab[ opt ] );
+        case ( OPC_GRP_BR * 16 + OPC_MBR ):     return( mbrTab[ opt ] );
+        case ( OPC_GRP_SYS * 16 + OPC_MR ):     return( &T64Cpu::instrSysMrOp );
+        case ( OPC_GRP_SYS * 16 + OPC_LPA ):    return( &T64Cpu::instrSysLpaOp );
+        case ( OPC_GRP_SYS * 16 + OPC_PRB ):    return( &T64Cpu::instrSysPrbOp );
+        case ( OPC_GRP_SYS * 16 + OPC_TLB ):    return( &T64Cpu::instrSysTlbOp );
+        case ( OPC_GRP_SYS * 16 + OPC_CA ):     return( &T64Cpu::instrSysCaOp );
+        case ( OPC_GRP_SYS * 16 + OPC_MST ):    return( &T64Cpu::instrSysMstOp );
+        case ( OPC_GRP_SYS * 16 + OPC_RFI ):    return( &T64Cpu::instrSysRfiOp );
+        case ( OPC_GRP_SYS * 16 + OPC_DIAG ):   return( &T64Cpu::instrSysDiagOp );
+        case ( OPC_GRP_SYS * 16 + OPC_TRAP ):   return( &T64Cpu::instrSysTrapOp );
+        
+        default:                                return( &T64Cpu::instrIllegalOp );
+    }
 }
 
 //----------------------------------------------------------------------------------------
 // Execute an instruction at instruction address location. This is the key 
-// routine of the simulator. Essentially a big case statement. Each instruction
-// is encoded based on the instruction group and the opcode family. 
+// routine of the simulator. Without a code cache, the instruction is fetched 
+// from memory and decoded each time. This is the reference path. With a code 
+// cache, the decoded instruction is taken from the code cache. Either way, we
+// end up in the same instruction handler. The warmup and measured regions of a 
+// sampling simulation always use the reference path. With a tracer attached, 
+// each instruction is recorded before it executes.
 //
 // When traps happen, the control registers are set with the trap information 
-// and execution continuous at the IVA address slot for the respective trap.
+// and execution continuous at the IVA address slot for the respective trap. 
+// This includes the traps raised by the instruction fetch. The frequent traps
+// are pending traps, they are checked once after the fetch and once after the
+// instruction handler. All other traps are raised as an exception. Both paths 
+// end up in the same trap delivery routine.
+//
+// The routine is a template. The instance with PROFILE set also counts each 
+// instruction with the profiler, the other instance has no profiling code. The
+// plain "executeInstr" call selects the instance.
 //
 //----------------------------------------------------------------------------------------
 T64TrapCode T64Cpu::executeInstr( ) {
 
-    instrReg = instrRead( extractField64( psrReg, 0, 52 ));
+    if ( proc -> profiler != nullptr ) return( executeInstrT<true>( ));
+    else                               return( executeInstrT<false>( ));
+}
+
+template <bool PROFILE>
+T64TrapCode T64Cpu::executeInstrT( ) {
 
     try {
-        
-        switch ( extractInstrOpCode( instrReg ) ) {
-                
-            case ( OPC_GRP_ALU * 16 + OPC_NOP ):    instrAluNopOp( instrReg );   break;
-            case ( OPC_GRP_ALU * 16 + OPC_ADD ):    instrAluAddOp( instrReg );   break;
-            case ( OPC_GRP_MEM * 16 + OPC_ADD ):    instrMemAddOp( instrReg );   break;
-            case ( OPC_GRP_ALU * 16 + OPC_SUB ):    instrAluSubOp( instrReg );   break;
-            case ( OPC_GRP_MEM * 16 + OPC_SUB ):    instrMemSubOp( instrReg );   break;
-            case ( OPC_GRP_ALU * 16 + OPC_AND ):    instrAluAndOp( instrReg );   break;
-            case ( OPC_GRP_MEM * 16 + OPC_AND ):    instrMemAndOp( instrReg );   break;
-            case ( OPC_GRP_ALU * 16 + OPC_OR ):     instrAluOrOp( instrReg );    break;
-            case ( OPC_GRP_MEM * 16 + OPC_OR ):     instrMemOrOp( instrReg );    break;
-            case ( OPC_GRP_ALU * 16 + OPC_XOR ):    instrAluXorOp( instrReg );   break;
-            case ( OPC_GRP_MEM * 16 + OPC_XOR ):    instrMemXorOp( instrReg );   break;
-            case ( OPC_GRP_ALU * 16 + OPC_CMP_A ):  instrAluCmpOp( instrReg );   break;
-            case ( OPC_GRP_ALU * 16 + OPC_CMP_B ):  instrAluCmpOp( instrReg );   break;
-            case ( OPC_GRP_MEM * 16 + OPC_CMP_A ):  instrMemCmpOp( instrReg );   break;
-            case ( OPC_GRP_MEM * 16 + OPC_CMP_B ):  instrMemCmpOp( instrReg );   break;
-            case ( OPC_GRP_ALU * 16 + OPC_BITOP ):  instrAluBitOp( instrReg );   break;
-            case ( OPC_GRP_ALU * 16 + OPC_SHAOP ):  instrAluShaOP( instrReg );   break;
-            case ( OPC_GRP_ALU * 16 + OPC_IMMOP ):  instrAluImmOp( instrReg );   break;
-            case ( OPC_GRP_ALU * 16 + OPC_LDO ):    instrAluLdoOp( instrReg );   break;
-            case ( OPC_GRP_MEM * 16 + OPC_LD ):     instrMemLdOp( instrReg );    break;
-            case ( OPC_GRP_MEM * 16 + OPC_LDR ):    instrMemLdrOp( instrReg );   break;
-            case ( OPC_GRP_MEM * 16 + OPC_ST ):     instrMemStOp( instrReg );    break;
-            case ( OPC_GRP_MEM * 16 + OPC_STC ):    instrMemStcOp( instrReg );   break;
-            case ( OPC_GRP_BR * 16 + OPC_B ):       instrBrBOp( instrReg );      break;
-            case ( OPC_GRP_BR * 16 + OPC_BE ):      instrBrBeOp( instrReg );     break;
-            case ( OPC_GRP_BR * 16 + OPC_BR ):      instrBrBrOp( instrReg );     break;
-            case ( OPC_GRP_BR * 16 + OPC_BB ):      instrBrBbOp( instrReg );     break;
-            case ( OPC_GRP_BR * 16 + OPC_ABR ):     instrBrAbrOp( instrReg );    break;
-            case ( OPC_GRP_BR * 16 + OPC_CBR ):     instrBrCbrOp( instrReg );    break;
-            case ( OPC_GRP_BR * 16 + OPC_MBR ):     instrBrMbrOp( instrReg );    break;
-            case ( OPC_GRP_SYS * 16 + OPC_MR ):     instrSysMrOp( instrReg );    break;
-            case ( OPC_GRP_SYS * 16 + OPC_LPA ):    instrSysLpaOp( instrReg );   break;
-            case ( OPC_GRP_SYS * 16 + OPC_PRB ):    instrSysPrbOp( instrReg );   break;
-            case ( OPC_GRP_SYS * 16 + OPC_TLB ):    instrSysTlbOp( instrReg  );  break;
-            case ( OPC_GRP_SYS * 16 + OPC_CA ):     instrSysCaOp( instrReg );    break;
-            case ( OPC_GRP_SYS * 16 + OPC_MST ):    instrSysMstOp( instrReg );   break;
-            case ( OPC_GRP_SYS * 16 + OPC_RFI ):    instrSysRfiOp( instrReg );   break;
-            case ( OPC_GRP_SYS * 16 + OPC_DIAG ):   instrSysDiagOp( instrReg );  break;
-            case ( OPC_GRP_SYS * 16 + OPC_TRAP ):   instrSysTrapOp( instrReg );  break;
-            
-            default: illegalInstrTrap( );
+
+        T64Word instrAdr = extractField64( psrReg, 0, 52 );
+
+        if (( proc -> codeCache != nullptr ) && ( ! proc -> detailedPath )) {
+
+            T64DecodedInstr *dInstr = instrReadDecoded( instrAdr );
+
+            if ( dInstr != nullptr ) {
+
+                instrReg = dInstr -> instr;
+
+                if ( timingEnabled ) instrCycles += groupCycles[ instrReg >> 30 ];
+                if constexpr ( PROFILE ) proc -> profiler -> countInstr( instrAdr, instrReg );
+
+                if ( proc -> tracer != nullptr ) {
+                    
+                    proc -> tracer -> record( T64_TR_INSTR, 0, instrReg, instrAdr );
+                }
+
+                ( this ->* dInstr -> handler )( instrReg );
+            }
+        }
+        else {
+
+            T64Instr instr = (T64Instr) instrRead( instrAdr );
+
+            if ( ! trapPending( )) {
+
+                instrReg = instr;
+
+                if ( timingEnabled ) instrCycles += groupCycles[ instrReg >> 30 ];
+                if constexpr ( PROFILE ) proc -> profiler -> countInstr( instrAdr, instrReg );
+
+                if ( proc -> tracer != nullptr ) {
+                    
+                    proc -> tracer -> record( T64_TR_INSTR, 0, instrReg, instrAdr );
+                }
+
+                ( this ->* decodeInstr( instrReg ))( instrReg );
+            }
+        }
+
+        if ( ! trapPending( )) recoveryCounterCheck( );
+
+        if ( ! trapPending( )) return ( NO_TRAP );
+        else                   return( deliverTrap( pendingTrap ));
+    }
+    catch ( const T64Trap t ) {
+
+        return( deliverTrap( t ));
+    }
+}
+
+template T64TrapCode T64Cpu::executeInstrT<true>( );
+template T64TrapCode T64Cpu::executeInstrT<false>( );
+
+//----------------------------------------------------------------------------------------
+// Execute a basic block. With the block option, the decoded instructions of a
+// block are executed in one loop. The first instruction is found with a code
+// cache lookup, the following ones are just the next slots of the page, as long
+// as the instruction executed went on to the next address. A taken branch, the 
+// end of the block, a trap or the unit limit ends the loop. Each instruction 
+// goes through the same handler and the same trap and recovery counter checks
+// as in "executeInstr", the state at a trap is thus exactly the same. The 
+// number of instructions done is returned in "done", an instruction that traps
+// counts as done, just like a call to "executeInstr" does. The block path has
+// neither profiling nor tracing, the processor only uses it when both are off.
+// A block that was translated into host code runs the host code instead of 
+// the loop, see "executeJit".
+//
+// With the verify option, every instruction taken from the block is also read 
+// on the regular path and compared to the decoded slot. On a difference, the 
+// mismatch is counted, the code cache is purged and the instruction read is 
+// executed. This ends the block, the slots of the purged cache are no longer
+// used. A trap on the regular read is a mismatch as well and is delivered.
+//
+//----------------------------------------------------------------------------------------
+T64TrapCode T64Cpu::executeBlock( int units, int *done ) {
+
+    T64CodeCache    *codeCache  = proc -> codeCache;
+    T64PerfBlock    *perf       = proc -> getPerfBlock( );
+    bool            verify      = ( proc -> options & T64_PO_VERIFY );
+    int             n           = 1;
+
+    try {
+
+        T64Word         instrAdr    = extractField64( psrReg, 0, 52 );
+        T64DecodedInstr *dInstr     = instrReadDecoded( instrAdr );
+        T64InstrHandler handler     = nullptr;
+        bool            last        = false;
+
+        if (( dInstr != nullptr ) &&
+            (( proc -> jit == nullptr ) || ( ! executeJit( dInstr, units, &n )))) {
+
+            instrReg    = dInstr -> instr;
+            handler     = dInstr -> handler;
+        }
+
+        while ( handler != nullptr ) {
+
+            if ( timingEnabled ) instrCycles += groupCycles[ instrReg >> 30 ];
+
+            ( this ->* handler )( instrReg );
+
+            if ( ! trapPending( )) recoveryCounterCheck( );
+
+            if (( trapPending( )) ||
+                ( last ) ||
+                ( n >= units ) ||
+                ( extractField64( psrReg, 0, 52 ) != instrAdr + 4 )) break;
+
+            dInstr = codeCache -> next( dInstr );
+            if ( dInstr == nullptr ) break;
+
+            instrAdr    += 4;
+            instrReg    = dInstr -> instr;
+            handler     = dInstr -> handler;
+            n++;
+
+            if ( verify ) {
+
+                T64Instr instr = (T64Instr) instrRead( instrAdr );
+
+                if ( trapPending( )) {
+
+                    perf -> inc( T64_PC_BLOCK_MISMATCHES );
+                    break;
+                }
+
+                if (( instr != instrReg ) || ( decodeInstr( instr ) != handler )) {
+
+                    perf -> inc( T64_PC_BLOCK_MISMATCHES );
+                    codeCache -> purgeAll( );
+
+                    instrReg    = instr;
+                    handler     = decodeInstr( instr );
+                    last        = true;
+                }
+            }
+        }
+
+        perf -> inc( T64_PC_BLOCKS );
+        perf -> add( T64_PC_BLOCK_INSTRS, n );
+        *done = n;
+
+        if ( ! trapPending( )) return ( NO_TRAP );
+        else                   return( deliverTrap( pendingTrap ));
+    }
+    catch ( const T64Trap t ) {
+
+        perf -> inc( T64_PC_BLOCKS );
+        perf -> add( T64_PC_BLOCK_INSTRS, n );
+        *done = n;
+
+        return( deliverTrap( t ));
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Execute a translated block. Each entry of a block counts in the slot the block
+// starts with. When the count reaches the threshold, the block is translated. 
+// A block that cannot be translated is not tried again until the slot is 
+// decoded again. The host code only runs when the whole translation fits into
+// the units left and there is nothing the host code does not do, i.e. neither 
+// the recovery counter nor a watchpoint is active. The host code tells how many
+// instructions it did and how far the instruction address moved. When it did
+// none, we return false and the block is executed with the handlers. Otherwise
+// the block is done, even when the host code left before its end, the next 
+// block starts where it left. The timing model adds the cycles of the 
+// instructions done, just like the handler loop.
+//
+//----------------------------------------------------------------------------------------
+bool T64Cpu::executeJit( T64DecodedInstr *dInstr, int units, int *done ) {
+
+    if ( dInstr -> jitCode == nullptr ) {
+
+        if ( dInstr -> jitCount < T64_JIT_THRESHOLD ) {
+
+            dInstr -> jitCount++;
+            return( false );
         }
 
-        recoveryCounterCheck( );
+        if ( dInstr -> jitCount > T64_JIT_THRESHOLD ) return( false );
+
+        int         len     = 0;
+        T64JitCode  code    = proc -> jit -> translate( dInstr, &len );
+
+        dInstr -> jitCount++;
+        if ( code == nullptr ) return( false );
+
+        dInstr -> jitCode   = code;
+        dInstr -> jitLen    = len;
+    }
+
+    if (( dInstr -> jitLen > units ) ||
+        ( extractPsrRbit( psrReg ) != 0 ) ||
+        ( watchPageBits != 0 )) {
+
+        return( false );
+    }
+
+    if ( proc -> jit -> verify ) return( verifyJit( dInstr, done ));
+
+    uint64_t    res = dInstr -> jitCode( gRegFile, psrReg );
+    int         cnt = (int) ( res & 0xFFFFFFFF );
+
+    if ( cnt == 0 ) return( false );
+
+    psrReg      = addAdrOfs32( psrReg, (T64Word) ( res >> 32 ));
+    instrReg    = dInstr[ cnt - 1 ].instr;
+
+    if ( timingEnabled ) {
+
+        for ( int i = 0; i < cnt; i++ ) instrCycles += groupCycles[ dInstr[ i ].instr >> 30 ];
+    }
+
+    proc -> getPerfBlock( ) -> add( T64_PC_JIT_INSTRS, cnt );
+    *done = cnt;
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Verify a translated block run. The host code runs with its stores journaled.
+// We remember the registers and the memory data it produced, undo the stores
+// and restore the registers. Then the same number of instructions is fetched,
+// decoded and executed on the regular path. The registers, the instruction 
+// address and the stored memory data must be the same. On a difference or a
+// trap on the regular path, the mismatch is counted and the translations are
+// flushed. The state is the one of the regular path in any case. Undoing the 
+// stores assumes that no other processor stores to the same data meanwhile,
+// which holds when the processors run in lockstep.
+//
+//----------------------------------------------------------------------------------------
+bool T64Cpu::verifyJit( T64DecodedInstr *dInstr, int *done ) {
+
+    T64Jit      *jit        = proc -> jit;
+    T64PerfBlock *perf      = proc -> getPerfBlock( );
+    T64Word     regs[ T64_MAX_GREGS ];
+    T64Word     jitRegs[ T64_MAX_GREGS ];
+    bool        match       = true;
+
+    memcpy( regs, gRegFile, sizeof( regs ));
+    jit -> journalLen = 0;
+
+    uint64_t    res     = dInstr -> jitCode( gRegFile, psrReg );
+    int         cnt     = (int) ( res & 0xFFFFFFFF );
+    T64Word     jitPsr  = addAdrOfs32( psrReg, (T64Word) ( res >> 32 ));
 
-        return ( NO_TRAP );
+    if ( cnt == 0 ) return( false );
+
+    memcpy( jitRegs, gRegFile, sizeof( jitRegs ));
+    memcpy( gRegFile, regs, sizeof( regs ));
+
+    for ( int i = 0; i < jit -> journalLen; i++ ) {
+
+        T64JitStore *e = &jit -> journal[ i ];
+        memcpy( e -> newData, e -> hostPtr, e -> len );
+    }
+
+    for ( int i = jit -> journalLen - 1; i >= 0; i-- ) {
+
+        T64JitStore *e = &jit -> journal[ i ];
+        memcpy( e -> hostPtr, e -> oldData, e -> len );
+    }
+
+    try {
+
+        for ( int i = 0; i < cnt; i++ ) {
+
+            *done       = i + 1;
+            instrReg    = (T64Instr) instrRead( extractField64( psrReg, 0, 52 ));
+            if ( trapPending( )) break;
+
+            if ( timingEnabled ) instrCycles += groupCycles[ instrReg >> 30 ];
+
+            ( this ->* decodeInstr( instrReg ))( instrReg );
+            if ( trapPending( )) break;
+        }
     }
     catch ( const T64Trap t ) {
 
-        proc -> setRsvInfo( 0, false );
+        perf -> inc( T64_PC_BLOCK_MISMATCHES );
+        jit -> flush( );
+        throw;
+    }
+
+    if (( trapPending( )) ||
+        ( psrReg != jitPsr ) ||
+        ( memcmp( gRegFile, jitRegs, sizeof( jitRegs )) != 0 )) {
+
+        match = false;
+    }
 
-        T64TrapCode code = t.trapCode;
+    for ( int i = 0; i < jit -> journalLen; i++ ) {
 
-        cRegFile[ CTL_REG_IPSR   ] = t.instrAdr;
-        cRegFile[ CTL_REG_IARG_0 ] = t.arg0;
-        cRegFile[ CTL_REG_IARG_1 ] = t.arg1;  
+        T64JitStore *e = &jit -> journal[ i ];
+        if ( memcmp( e -> hostPtr, e -> newData, e -> len ) != 0 ) match = false;
+    }
 
-        T64Word ivaAdr  = cRegFile[ CTL_REG_IVA ];
-        psrReg          = ivaAdr + ( code * 32 );
+    if ( match ) perf -> add( T64_PC_JIT_INSTRS, cnt );
+    else {
 
-        return( code );
+        perf -> inc( T64_PC_BLOCK_MISMATCHES );
+        jit -> flush( );
     }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Trap delivery. Any reservation is cleared, the control registers are set 
+// with the trap information and execution continues at the IVA address slot 
+// for the trap. A pending trap is cleared.
+//
+//----------------------------------------------------------------------------------------
+T64TrapCode T64Cpu::deliverTrap( const T64Trap &t ) {
+
+    T64Trap trap = t;
+
+    pendingTrap = T64Trap( NO_TRAP );
+
+    if ( proc -> tracer != nullptr ) {
+        
+        proc -> tracer -> record( T64_TR_TRAP, 0, trap.trapCode, trap.instrAdr );
+    }
+
+    if ( proc -> profiler != nullptr ) proc -> profiler -> countTrap( trap.trapCode );
+
+    proc -> sys -> clearReservation( proc );
+
+    cRegFile[ CTL_REG_IPSR   ] = trap.instrAdr;
+    cRegFile[ CTL_REG_IARG_0 ] = trap.arg0;
+    cRegFile[ CTL_REG_IARG_1 ] = trap.arg1;  
+
+    T64Word ivaAdr  = cRegFile[ CTL_REG_IVA ];
+    psrReg          = ivaAdr + ( trap.trapCode * 32 );
+
+    return( trap.trapCode );
+}
+
+//----------------------------------------------------------------------------------------
+// External interrupts. The processor calls this between batches when a line is
+// pending. An interrupt is taken when the PSR I bit is set and the line is 
+// enabled in the EIEM register. The lowest line has priority. It is cleared 
+// and delivered as an external interrupt trap with the line number and the 
+// lines still pending as arguments. We return true when we took an interrupt.
+//
+//----------------------------------------------------------------------------------------
+bool T64Cpu::handleExtInterrupts( ) {
+
+    if ( ! extractPsrIbit( psrReg )) return( false );
+
+    uint64_t enabled = proc -> getPendingInterrupts( ) & (uint64_t) cRegFile[ CTL_REG_EIEM ];
+    if ( enabled == 0 ) return( false );
+
+    int line = std::countr_zero( enabled );
+
+    proc -> clearInterrupt( line );
+    deliverTrap( T64Trap( EXTERNAL_INTERRUPT, 
+                          psrReg, 
+                          (uint32_t) line, 
+                          (T64Word) proc -> getPendingInterrupts( )));
+    return( true );
 }
@@ -0,0 +1,1031 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Block translator
+//
+//----------------------------------------------------------------------------------------
+// The block translator turns a frequently executed basic block of the code cache
+// into host code. The host code does exactly what the instruction handlers do
+// for the instructions translated. Any instruction that is not translated, or
+// that would trap or needs more than the fast path, is left to the handlers.
+// The host code leaves right before such an instruction and the CPU continues
+// from there. The instruction handlers remain the reference implementation.
+//
+// The translator emits x86-64 code for the System V calling convention. The
+// generated routine is called with the general register file and the status
+// register. The most used general registers of the block are kept in callee
+// saved host registers, the others are accessed in the register file. Fields
+// of the CPU object, such as the direct memory map, are addressed relative to
+// the register file. The stack frame holds the status register passed in, the
+// physical address of the current store and a scratch slot.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Block translator
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License along with
+// this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-System.h"
+#include "T64-Processor.h"
+#include <cstddef>
+#include <cstring>
+
+#if defined( __x86_64__ ) && ! defined( _WIN32 )
+#include <sys/mman.h>
+#define T64_JIT_HOST 1
+#endif
+
+//----------------------------------------------------------------------------------------
+// Local name space.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// Host registers. The guest registers kept in host registers use the callee
+// saved registers, R15 holds the register file address. RAX, RCX and RDX are
+// the scratch registers of an instruction.
+//
+//----------------------------------------------------------------------------------------
+enum HostReg : int {
+
+    RAX = 0,    RCX = 1,    RDX = 2,    RBX = 3,
+    RSP = 4,    RBP = 5,    RSI = 6,    RDI = 7,
+    R12 = 12,   R13 = 13,   R14 = 14,   R15 = 15
+};
+
+const int HOST_REG_CNT = 5;
+const int hostRegs[ HOST_REG_CNT ] = { RBX, RBP, R12, R13, R14 };
+
+//----------------------------------------------------------------------------------------
+// Condition codes for the conditional jump and set instructions. The T64
+// conditions are mapped to the signed compare results. The EV and OD conditions
+// test the low bit of the first operand, the two are the same in the handlers.
+//
+//----------------------------------------------------------------------------------------
+enum HostCond : int {
+
+    CC_O    = 0x0,  CC_B    = 0x2,  CC_AE   = 0x3,  CC_E    = 0x4,
+    CC_NE   = 0x5,  CC_L    = 0xC,  CC_GE   = 0xD,  CC_LE   = 0xE,
+    CC_G    = 0xF,  CC_ALWAYS = -1
+};
+
+const int condTab[ 8 ] = { CC_E, CC_L, CC_G, CC_E, CC_NE, CC_LE, CC_GE, CC_E };
+
+bool isLowBitCond( int cond ) {
+
+    return(( cond == 3 ) || ( cond == 7 ));
+}
+
+//----------------------------------------------------------------------------------------
+// Operation codes and extensions used. The register forms are the "r/m, reg"
+// forms, the immediate forms use the "81" group with the extension.
+//
+//----------------------------------------------------------------------------------------
+const uint8_t OP_ADD    = 0x01;
+const uint8_t OP_OR     = 0x09;
+const uint8_t OP_AND    = 0x21;
+const uint8_t OP_SUB    = 0x29;
+const uint8_t OP_XOR    = 0x31;
+const uint8_t OP_CMP    = 0x39;
+const uint8_t OP_CMP_RM = 0x3B;
+const uint8_t OP_TEST   = 0x85;
+const uint8_t OP_MOV    = 0x89;
+const uint8_t OP_MOV_RM = 0x8B;
+
+const uint8_t EXT_ADD   = 0;
+const uint8_t EXT_OR    = 1;
+const uint8_t EXT_AND   = 4;
+const uint8_t EXT_SUB   = 5;
+const uint8_t EXT_XOR   = 6;
+const uint8_t EXT_SHL   = 4;
+const uint8_t EXT_SHR   = 5;
+
+//----------------------------------------------------------------------------------------
+// The stack frame. After pushing six registers, the frame keeps the stack
+// aligned to 16 bytes for the helper calls.
+//
+//----------------------------------------------------------------------------------------
+const int FRAME_SIZE    = 24;
+const int FRAME_PSR     = 0;
+const int FRAME_PADR    = 8;
+const int FRAME_TEMP    = 16;
+
+//----------------------------------------------------------------------------------------
+// The largest code a single instruction translates to, with some extra for the
+// prologue, the exits and the epilogue.
+//
+//----------------------------------------------------------------------------------------
+const int MAX_INSTR_CODE    = 256;
+const int MAX_EXTRA_CODE    = 1024;
+
+uint64_t exitValue( int count, uint32_t delta ) {
+
+    return(( (uint64_t) delta << 32 ) | (uint32_t) count );
+}
+
+} // namespace
+
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Block translator
+//
+//----------------------------------------------------------------------------------------
+// Object creator. The code buffer is allocated right away. When the host is not
+// supported or the buffer cannot be allocated, there is no buffer and no block
+// is ever translated.
+//
+//----------------------------------------------------------------------------------------
+T64Jit::T64Jit( T64Processor *proc ) {
+
+    this -> proc    = proc;
+    this -> cpu     = proc -> cpu;
+    this -> perf    = proc -> getPerfBlock( );
+    this -> verify  = ( proc -> options & T64_PO_VERIFY );
+
+#if defined( T64_JIT_HOST )
+    void *buf = mmap( nullptr,
+                      T64_JIT_CODE_BUF_SIZE,
+                      PROT_READ | PROT_WRITE | PROT_EXEC,
+                      MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1,
+                      0 );
+
+    if ( buf != MAP_FAILED ) {
+
+        codeBuf     = (uint8_t *) buf;
+        codeLimit   = T64_JIT_CODE_BUF_SIZE;
+    }
+#endif
+
+    reset( );
+}
+
+//----------------------------------------------------------------------------------------
+// Destructor.
+//
+//----------------------------------------------------------------------------------------
+T64Jit::~T64Jit( ) {
+
+#if defined( T64_JIT_HOST )
+    if ( codeBuf != nullptr ) munmap( codeBuf, T64_JIT_CODE_BUF_SIZE );
+#endif
+}
+
+//----------------------------------------------------------------------------------------
+// Reset the translator. The code buffer is used from the start again and the
+// statistics are cleared. The caller has reset the code cache, no slot refers
+// to the old code. A flush purges the code cache first, this is done when the
+// buffer is full and when a verify run found a difference.
+//
+//----------------------------------------------------------------------------------------
+void T64Jit::reset( ) {
+
+    codePos     = 0;
+    exitCount   = 0;
+    journalLen  = 0;
+
+    perf -> set( T64_PC_JIT_BLOCKS, 0 );
+    perf -> set( T64_PC_JIT_INSTRS, 0 );
+}
+
+void T64Jit::flush( ) {
+
+    proc -> codeCache -> purgeAll( );
+
+    codePos     = 0;
+    exitCount   = 0;
+}
+
+//----------------------------------------------------------------------------------------
+// Translate the block starting with the decoded instruction. The slots of the
+// block are found just like the block execution does, using the code cache
+// "next" routine. We translate instructions until the first one we cannot
+// translate. When not even the first can be translated, there is no host code.
+// Otherwise the number translated is returned in "len".
+//
+// The routine starts with the prologue, which saves the callee saved registers
+// and loads the guest registers kept in host registers. Each instruction is
+// then translated. After the last one, the routine leaves with all of them done.
+// The exits for the jumps out of the block are placed after the epilogue, they
+// set the result and jump to the epilogue, which stores the host registers
+// back to the register file.
+//
+//----------------------------------------------------------------------------------------
+T64JitCode T64Jit::translate( T64DecodedInstr *dInstr, int *len ) {
+
+    if ( codeBuf == nullptr ) return( nullptr );
+
+    if ( codeLimit - codePos < T64_JIT_MAX_INSTRS * MAX_INSTR_CODE + MAX_EXTRA_CODE ) {
+
+        flush( );
+        return( nullptr );
+    }
+
+    T64DecodedInstr *blk    = dInstr;
+    int             blkLen  = 0;
+
+    while (( blk != nullptr ) && ( blkLen < T64_JIT_MAX_INSTRS )) {
+
+        blkLen++;
+        blk = proc -> codeCache -> next( blk );
+    }
+
+    int         start   = codePos;
+    int         count   = 0;
+
+    exitCount = 0;
+    selectHostRegs( dInstr, blkLen );
+
+    emitByte( 0x53 );                                   // push rbx
+    emitByte( 0x55 );                                   // push rbp
+    emitByte( 0x41 ); emitByte( 0x54 );                 // push r12
+    emitByte( 0x41 ); emitByte( 0x55 );                 // push r13
+    emitByte( 0x41 ); emitByte( 0x56 );                 // push r14
+    emitByte( 0x41 ); emitByte( 0x57 );                 // push r15
+    emitByte( 0x48 ); emitByte( 0x83 ); emitByte( 0xEC ); emitByte( FRAME_SIZE );
+    emitRegReg( OP_MOV, R15, RDI );
+    emitMem( OP_MOV, true, RSI, RSP, FRAME_PSR );
+
+    for ( int i = 1; i < T64_MAX_GREGS; i++ ) {
+
+        if ( regMap[ i ] >= 0 ) emitMem( OP_MOV_RM, true, regMap[ i ], R15, i * 8 );
+    }
+
+    while ( count < blkLen ) {
+
+        T64DecodedInstr *d = dInstr + count;
+
+        if ( d -> handler == &T64Cpu::instrIllegalOp ) break;
+        if ( ! translateInstr( d -> instr, count )) break;
+        count++;
+    }
+
+    if ( count == 0 ) {
+
+        codePos = start;
+        return( nullptr );
+    }
+
+    emitLoadImm( RAX, (T64Word) exitValue( count, count * 4 ));
+
+    int epilogue = codePos;
+
+    for ( int i = 1; i < T64_MAX_GREGS; i++ ) {
+
+        if ( regMap[ i ] >= 0 ) emitMem( OP_MOV, true, regMap[ i ], R15, i * 8 );
+    }
+
+    emitByte( 0x48 ); emitByte( 0x83 ); emitByte( 0xC4 ); emitByte( FRAME_SIZE );
+    emitByte( 0x41 ); emitByte( 0x5F );                 // pop r15
+    emitByte( 0x41 ); emitByte( 0x5E );                 // pop r14
+    emitByte( 0x41 ); emitByte( 0x5D );                 // pop r13
+    emitByte( 0x41 ); emitByte( 0x5C );                 // pop r12
+    emitByte( 0x5D );                                   // pop rbp
+    emitByte( 0x5B );                                   // pop rbx
+    emitByte( 0xC3 );                                   // ret
+
+    for ( int i = 0; i < exitCount; i++ ) {
+
+        int32_t rel = codePos - ( exitPos[ i ] + 4 );
+        memcpy( codeBuf + exitPos[ i ], &rel, sizeof( rel ));
+
+        emitLoadImm( RAX, (T64Word) exitVal[ i ] );
+        emitByte( 0xE9 );
+        emitWord((uint32_t) ( epilogue - ( codePos + 4 )));
+    }
+
+    perf -> inc( T64_PC_JIT_BLOCKS );
+    *len = count;
+    return((T64JitCode) ( codeBuf + start ));
+}
+
+//----------------------------------------------------------------------------------------
+// Translate one instruction at position "k" of the block. We return false for
+// an instruction not translated, nothing is emitted for it then. The handler
+// of the instruction is not the illegal instruction handler, the decoder has
+// thus checked the reserved fields it checks. The checks the handlers do
+// themselves are done here, the instruction is not translated when they fail.
+//
+// An instruction that could trap first checks for it and leaves the block with
+// the instructions before it done. A branch taken leaves with the instruction
+// done and the branch offset added to the instruction address. Just as in the
+// BB handler, a bit position above 31 tests a zero bit.
+//
+//----------------------------------------------------------------------------------------
+bool T64Jit::translateInstr( T64Instr instr, int k ) {
+
+    int         regR    = extractInstrRegR( instr );
+    int         regB    = extractInstrRegB( instr );
+    int         regA    = extractInstrRegA( instr );
+    int         opt     = extractInstrFieldU( instr, 19, 3 );
+    uint32_t    here    = (uint32_t) k * 4;
+    int         pos     = codePos;
+    int         exits   = exitCount;
+    bool        ok      = true;
+
+    switch ( extractInstrOpCode( instr )) {
+
+        case ( OPC_GRP_ALU * 16 + OPC_NOP ): {
+
+            ok = ( instr == 0 );
+
+        } break;
+
+        case ( OPC_GRP_ALU * 16 + OPC_ADD ):
+        case ( OPC_GRP_ALU * 16 + OPC_SUB ): {
+
+            bool add = ( extractInstrOpCode( instr ) == ( OPC_GRP_ALU * 16 + OPC_ADD ));
+
+            emitGetReg( RAX, regB );
+
+            if ( opt == 1 ) {
+
+                emitRegImm(( add ) ? EXT_ADD : EXT_SUB, RAX, extractInstrSignedImm15( instr ));
+            }
+            else {
+
+                emitGetReg( RCX, regA );
+                emitRegReg(( add ) ? OP_ADD : OP_SUB, RAX, RCX );
+            }
+
+            emitExit( CC_O, k, here );
+            emitSetReg( regR, RAX );
+
+        } break;
+
+        case ( OPC_GRP_ALU * 16 + OPC_AND ):
+        case ( OPC_GRP_ALU * 16 + OPC_OR ):
+        case ( OPC_GRP_ALU * 16 + OPC_XOR ): {
+
+            int     opc     = extractInstrOpCode( instr );
+            bool    isXor   = ( opc == ( OPC_GRP_ALU * 16 + OPC_XOR ));
+            bool    isAnd   = ( opc == ( OPC_GRP_ALU * 16 + OPC_AND ));
+            bool    imm     = extractInstrBit( instr, 19 );
+
+            if (( isXor ) && ( extractInstrBit( instr, 20 ))) {
+
+                ok = false;
+                break;
+            }
+
+            if (( ! imm ) &&
+                (( extractInstrFieldU( instr, 0, 9 ) != 0 ) ||
+                 (( ! isXor ) && ( extractInstrFieldU( instr, 13, 2 ) != 0 )))) {
+
+                ok = false;
+                break;
+            }
+
+            emitGetReg( RAX, regB );
+
+            if ( extractInstrBit( instr, 20 )) {
+
+                emitRex( true, 0, RAX ); emitByte( 0xF7 ); emitByte( 0xD0 ); // not rax
+            }
+
+            if ( imm ) {
+
+                emitRegImm(( isXor ) ? EXT_XOR : (( isAnd ) ? EXT_AND : EXT_OR ),
+                            RAX,
+                            extractInstrSignedImm15( instr ));
+            }
+            else {
+
+                emitGetReg( RCX, regA );
+                emitRegReg(( isXor ) ? OP_XOR : (( isAnd ) ? OP_AND : OP_OR ), RAX, RCX );
+            }
+
+            if ( extractInstrBit( instr, 21 )) {
+
+                emitRex( true, 0, RAX ); emitByte( 0xF7 ); emitByte( 0xD0 ); // not rax
+            }
+
+            emitSetReg( regR, RAX );
+
+        } break;
+
+        case ( OPC_GRP_ALU * 16 + OPC_CMP_A ):
+        case ( OPC_GRP_ALU * 16 + OPC_CMP_B ): {
+
+            emitGetReg( RAX, regB );
+
+            if ( extractInstrOpCode( instr ) == ( OPC_GRP_ALU * 16 + OPC_CMP_B )) {
+
+                emitLoadImm( RCX, extractInstrSignedImm15( instr ));
+            }
+            else emitGetReg( RCX, regA );
+
+            int cc = emitCompare( opt, true );
+
+            emitByte( 0x0F ); emitByte( 0x90 + cc ); emitByte( 0xC0 );  // setcc al
+            emitByte( 0x0F ); emitByte( 0xB6 ); emitByte( 0xC0 );       // movzx eax, al
+            emitSetReg( regR, RAX );
+
+        } break;
+
+        case ( OPC_GRP_ALU * 16 + OPC_LDO ): {
+
+            emitGetReg( RAX, regB );
+
+            if ( opt == 0 ) {
+
+                emitLoadImm( RCX, (uint32_t) extractInstrSignedScaledImm13( instr ));
+            }
+            else if (( opt == 1 ) && ( extractInstrFieldU( instr, 0, 9 ) == 0 )) {
+
+                emitGetReg( RCX, regA );
+            }
+            else {
+
+                ok = false;
+                break;
+            }
+
+            emitAdrOfs( );
+            emitSetReg( regR, RAX );
+
+        } break;
+
+        case ( OPC_GRP_ALU * 16 + OPC_IMMOP ): {
+
+            T64Word val = extractInstrImm20( instr );
+
+            switch ( extractInstrFieldU( instr, 20, 2 )) {
+
+                case 0: {
+
+                    emitGetReg( RAX, regR );
+                    emitLoadImm( RCX, val );
+                    emitAdrOfs( );
+
+                } break;
+
+                case 1: {
+
+                    emitLoadImm( RAX, val << 12 );
+
+                } break;
+
+                case 2:
+                case 3: {
+
+                    int     bitPos  = ( extractInstrFieldU( instr, 20, 2 ) == 2 ) ? 32 : 52;
+                    int     bitLen  = ( bitPos == 32 ) ? 20 : 12;
+                    T64Word mask    = depositField64( 0, bitPos, bitLen, -1 );
+
+                    emitGetReg( RAX, regR );
+                    emitLoadImm( RCX, ~ mask );
+                    emitRegReg( OP_AND, RAX, RCX );
+                    emitLoadImm( RCX, depositField64( 0, bitPos, bitLen, val ));
+                    emitRegReg( OP_OR, RAX, RCX );
+
+                } break;
+            }
+
+            emitSetReg( regR, RAX );
+
+        } break;
+
+        case ( OPC_GRP_MEM * 16 + OPC_LD ): {
+
+            int len = 1 << extractInstrDwField( instr );
+
+            if ( ! cpu -> directMemEnabled ) {
+
+                ok = false;
+                break;
+            }
+
+            emitMemAdr( instr, k, len, false );
+
+            switch ( len ) {
+
+                case 1: {
+
+                    emitByte( 0x0F ); emitByte( 0xB6 ); emitByte( 0x02 );   // movzx eax, [rdx]
+
+                } break;
+
+                case 2: {
+
+                    emitByte( 0x0F ); emitByte( 0xB7 ); emitByte( 0x02 );   // movzx eax, [rdx]
+                    emitByte( 0x66 ); emitByte( 0xC1 ); emitByte( 0xC0 );   // rol ax, 8
+                    emitByte( 0x08 );
+
+                } break;
+
+                case 4: {
+
+                    emitByte( 0x8B ); emitByte( 0x02 );                     // mov eax, [rdx]
+                    emitByte( 0x0F ); emitByte( 0xC8 );                     // bswap eax
+
+                } break;
+
+                default: {
+
+                    emitByte( 0x48 ); emitByte( 0x8B ); emitByte( 0x02 );   // mov rax, [rdx]
+                    emitByte( 0x48 ); emitByte( 0x0F ); emitByte( 0xC8 );   // bswap rax
+                }
+            }
+
+            if (( len < 8 ) && ( ! extractInstrBit( instr, 20 ))) {
+
+                emitByte( 0x48 );
+
+                if ( len == 1 )      { emitByte( 0x0F ); emitByte( 0xBE ); }  // movsx rax, al
+                else if ( len == 2 ) { emitByte( 0x0F ); emitByte( 0xBF ); }  // movsx rax, ax
+                else                 { emitByte( 0x63 ); }                    // movsxd rax, eax
+
+                emitByte( 0xC0 );
+            }
+
+            emitSetReg( regR, RAX );
+
+        } break;
+
+        case ( OPC_GRP_MEM * 16 + OPC_ST ): {
+
+            int len = 1 << extractInstrDwField( instr );
+
+            if ( ! cpu -> directMemEnabled ) {
+
+                ok = false;
+                break;
+            }
+
+            emitMemAdr( instr, k, len, true );
+
+            if ( verify ) {
+
+                emitMem( OP_MOV, true, RDX, RSP, FRAME_TEMP );
+                emitLoadImm( RDI, (T64Word) this );
+                emitRegReg( OP_MOV, RSI, RDX );
+                emitLoadImm( RDX, len );
+                emitCall((uintptr_t) &T64Jit::journalStore );
+                emitMem( OP_MOV_RM, true, RDX, RSP, FRAME_TEMP );
+            }
+
+            emitGetReg( RCX, regR );
+
+            switch ( len ) {
+
+                case 1: {
+
+                    emitByte( 0x88 ); emitByte( 0x0A );                     // mov [rdx], cl
+
+                } break;
+
+                case 2: {
+
+                    emitByte( 0x66 ); emitByte( 0xC1 ); emitByte( 0xC1 );   // rol cx, 8
+                    emitByte( 0x08 );
+                    emitByte( 0x66 ); emitByte( 0x89 ); emitByte( 0x0A );   // mov [rdx], cx
+
+                } break;
+
+                case 4: {
+
+                    emitByte( 0x0F ); emitByte( 0xC9 );                     // bswap ecx
+                    emitByte( 0x89 ); emitByte( 0x0A );                     // mov [rdx], ecx
+
+                } break;
+
+                default: {
+
+                    emitByte( 0x48 ); emitByte( 0x0F ); emitByte( 0xC9 );   // bswap rcx
+                    emitByte( 0x48 ); emitByte( 0x89 ); emitByte( 0x0A );   // mov [rdx], rcx
+                }
+            }
+
+            emitLoadImm( RDI, (T64Word) this );
+            emitMem( OP_MOV_RM, true, RSI, RSP, FRAME_PADR );
+            emitLoadImm( RDX, len );
+            emitCall((uintptr_t) &T64Jit::storeNotify );
+            emitByte( 0x84 ); emitByte( 0xC0 );                             // test al, al
+            emitExit( CC_E, k + 1, here + 4 );
+
+        } break;
+
+        case ( OPC_GRP_BR * 16 + OPC_B ): {
+
+            T64Word ofs = extractInstrSignedImm19( instr ) << 2;
+
+            if (( extractInstrFieldU( instr, 19, 3 ) != 0 ) || ( ofs == 0 )) {
+
+                ok = false;
+                break;
+            }
+
+            if ( regR != 0 ) {
+
+                emitMem( OP_MOV_RM, true, RAX, RSP, FRAME_PSR );
+                emitLoadImm( RCX, here + 4 );
+                emitAdrOfs( );
+                emitSetReg( regR, RAX );
+            }
+
+            emitExit( CC_ALWAYS, k + 1, here + (uint32_t) ofs );
+
+        } break;
+
+        case ( OPC_GRP_BR * 16 + OPC_CBR ): {
+
+            emitGetReg( RAX, regR );
+            emitGetReg( RCX, regB );
+            emitExit( emitCompare( opt, true ),
+                      k + 1,
+                      here + ((uint32_t) extractInstrSignedImm15( instr ) << 2 ));
+
+        } break;
+
+        case ( OPC_GRP_BR * 16 + OPC_MBR ): {
+
+            emitGetReg( RAX, regB );
+            emitSetReg( regR, RAX );
+            emitExit( emitCompare( opt, false ),
+                      k + 1,
+                      here + ((uint32_t) extractInstrSignedImm15( instr ) << 2 ));
+
+        } break;
+
+        case ( OPC_GRP_BR * 16 + OPC_ABR ): {
+
+            emitGetReg( RAX, regR );
+            emitGetReg( RCX, regB );
+            emitRegReg( OP_ADD, RAX, RCX );
+            emitExit( CC_O, k, here );
+            emitSetReg( regR, RAX );
+            emitExit( emitCompare( opt, false ),
+                      k + 1,
+                      here + ((uint32_t) extractInstrSignedImm15( instr ) << 2 ));
+
+        } break;
+
+        case ( OPC_GRP_BR * 16 + OPC_BB ): {
+
+            if (( extractInstrBit( instr, 21 )) || ( extractInstrBit( instr, 20 ))) {
+
+                ok = false;
+                break;
+            }
+
+            int         bitPos  = extractInstrFieldU( instr, 13, 6 );
+            uint32_t    target  = here + ((uint32_t) extractInstrSignedImm13( instr ) << 2 );
+
+            if ( bitPos > 31 ) {
+
+                if ( ! extractInstrBit( instr, 19 )) emitExit( CC_ALWAYS, k + 1, target );
+                break;
+            }
+
+            emitGetReg( RAX, regR );
+            emitByte( 0x48 ); emitByte( 0x0F ); emitByte( 0xBA );          // bt rax, pos
+            emitByte( 0xE0 ); emitByte((uint8_t) bitPos );
+            emitExit(( extractInstrBit( instr, 19 )) ? CC_B : CC_AE, k + 1, target );
+
+        } break;
+
+        default: ok = false;
+    }
+
+    if ( ! ok ) {
+
+        codePos     = pos;
+        exitCount   = exits;
+    }
+
+    return( ok );
+}
+
+//----------------------------------------------------------------------------------------
+// The memory address of a load or store. The address is formed just like the
+// handlers do and the host code checks that the access can use the direct
+// memory map right away. We must be in privileged mode, there is no pending
+// purge of the map, the address is a physical address and aligned, and the map
+// entry for the page is present, and writable for a store. Otherwise the block
+// is left before the instruction and the handler does the access. Finally, the
+// physical address is saved in the frame and RDX holds the host address.
+//
+//----------------------------------------------------------------------------------------
+void T64Jit::emitMemAdr( T64Instr instr, int k, int len, bool store ) {
+
+    int         dw          = extractInstrDwField( instr );
+    uint32_t    here        = (uint32_t) k * 4;
+    int32_t     ofsPurged   = (int32_t) ((uint8_t *) &cpu -> directMemPurged -
+                                         (uint8_t *) cpu -> gRegFile );
+    int32_t     ofsMemSize  = (int32_t) ((uint8_t *) &cpu -> physMemSize -
+                                         (uint8_t *) cpu -> gRegFile );
+    int32_t     ofsMap      = (int32_t) ((uint8_t *) cpu -> directMem -
+                                         (uint8_t *) cpu -> gRegFile );
+
+    static_assert( sizeof( T64DirectMemEntry ) < 128 );
+    static_assert(( T64_DIRECT_MEM_MAP_ENTRIES & ( T64_DIRECT_MEM_MAP_ENTRIES - 1 )) == 0 );
+
+    emitGetReg( RAX, extractInstrRegB( instr ));
+
+    if ( extractInstrBit( instr, 19 )) {
+
+        emitGetReg( RCX, extractInstrRegA( instr ));
+        if ( dw > 0 ) emitShift( EXT_SHL, RCX, dw );
+    }
+    else emitLoadImm( RCX, (uint32_t) ( extractInstrSignedImm13( instr ) << dw ));
+
+    emitAdrOfs( );
+
+    emitMem( OP_MOV_RM, true, RCX, RSP, FRAME_PSR );
+    emitByte( 0x48 ); emitByte( 0x0F ); emitByte( 0xBA );                  // bt rcx, 61
+    emitByte( 0xE1 ); emitByte( 61 );
+    emitExit( CC_B, k, here );
+
+    emitRex( false, 0, R15 ); emitByte( 0x80 ); emitByte( 0xBF );          // cmp byte [r15+ofs], 0
+    emitWord((uint32_t) ofsPurged ); emitByte( 0 );
+    emitExit( CC_NE, k, here );
+
+    emitMem( OP_CMP_RM, true, RAX, R15, ofsMemSize );
+    emitExit( CC_AE, k, here );
+
+    if ( len > 1 ) {
+
+        emitByte( 0xA8 ); emitByte((uint8_t) ( len - 1 ));                 // test al, len - 1
+        emitExit( CC_NE, k, here );
+    }
+
+    emitRegReg( OP_MOV, RCX, RAX );
+    emitShift( EXT_SHR, RCX, 12 );
+    emitByte( 0x83 ); emitByte( 0xE1 );                                     // and ecx, entries - 1
+    emitByte( T64_DIRECT_MEM_MAP_ENTRIES - 1 );
+    emitByte( 0x48 ); emitByte( 0x6B ); emitByte( 0xC9 );                  // imul rcx, rcx, size
+    emitByte( sizeof( T64DirectMemEntry ));
+    emitByte( 0x49 ); emitByte( 0x8D ); emitByte( 0x8C ); emitByte( 0x0F );// lea rcx, [r15+rcx+ofs]
+    emitWord((uint32_t) ofsMap );
+
+    emitRegReg( OP_MOV, RDX, RAX );
+    emitRegImm( EXT_AND, RDX, - T64_PAGE_SIZE_BYTES );
+    emitMem( OP_CMP_RM, true, RDX, RCX, offsetof( T64DirectMemEntry, pAdr ));
+    emitExit( CC_NE, k, here );
+
+    if ( store ) {
+
+        emitByte( 0x80 ); emitByte( 0xB9 );                                 // cmp byte [rcx+ofs], 0
+        emitWord( offsetof( T64DirectMemEntry, writable )); emitByte( 0 );
+        emitExit( CC_E, k, here );
+    }
+
+    emitMem( OP_MOV, true, RAX, RSP, FRAME_PADR );
+    emitMem( OP_MOV_RM, true, RDX, RCX, offsetof( T64DirectMemEntry, hostPtr ));
+    emitByte( 0x25 ); emitWord( T64_PAGE_SIZE_BYTES - 1 );                  // and eax, ofs mask
+    emitRegReg( OP_ADD, RDX, RAX );
+}
+
+//----------------------------------------------------------------------------------------
+// Compare for a condition. The first operand is in RAX, the second in RCX or,
+// for the compares against zero, none. We return the condition code that is
+// true when the T64 condition is met.
+//
+//----------------------------------------------------------------------------------------
+int T64Jit::emitCompare( int cond, bool cmpVal2 ) {
+
+    if ( isLowBitCond( cond )) {
+
+        emitByte( 0xA8 ); emitByte( 0x01 );                                 // test al, 1
+    }
+    else if ( cmpVal2 ) emitRegReg( OP_CMP, RAX, RCX );
+    else                emitRegReg( OP_TEST, RAX, RAX );
+
+    return( condTab[ cond & 7 ] );
+}
+
+//----------------------------------------------------------------------------------------
+// Select the guest registers kept in host registers. We count the register
+// fields of the block instructions and take the most used registers. R0 is
+// never kept, it reads as zero and writes to it are dropped.
+//
+//----------------------------------------------------------------------------------------
+void T64Jit::selectHostRegs( T64DecodedInstr *dInstr, int len ) {
+
+    int uses[ T64_MAX_GREGS ] = { 0 };
+
+    for ( int i = 0; i < len; i++ ) {
+
+        uses[ extractInstrRegR( dInstr[ i ].instr ) ]++;
+        uses[ extractInstrRegB( dInstr[ i ].instr ) ]++;
+    }
+
+    uses[ 0 ] = 0;
+
+    for ( int i = 0; i < T64_MAX_GREGS; i++ ) regMap[ i ] = -1;
+
+    for ( int h = 0; h < HOST_REG_CNT; h++ ) {
+
+        int best = 0;
+
+        for ( int i = 1; i < T64_MAX_GREGS; i++ ) {
+
+            if (( regMap[ i ] < 0 ) && ( uses[ i ] > uses[ best ] )) best = i;
+        }
+
+        if ( best == 0 ) break;
+
+        regMap[ best ]  = hostRegs[ h ];
+        uses[ best ]    = 0;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Helpers called from the host code. A store is reported to the system just as
+// the store handler does. We then tell whether the block can go on, which is
+// not the case when the store dropped the code page we run from. With the
+// verify option, the data at the store address is journaled before the store.
+//
+//----------------------------------------------------------------------------------------
+bool T64Jit::storeNotify( T64Jit *jit, T64Word pAdr, int len ) {
+
+    jit -> proc -> sys -> busOpStoreNotify( jit -> proc, pAdr, len );
+
+    return( jit -> proc -> codeCache -> isCurPageValid( ));
+}
+
+void T64Jit::journalStore( T64Jit *jit, uint8_t *hostPtr, int len ) {
+
+    if ( jit -> journalLen < T64_JIT_MAX_INSTRS ) {
+
+        T64JitStore *e = &jit -> journal[ jit -> journalLen++ ];
+
+        e -> hostPtr = hostPtr;
+        e -> len     = len;
+        memcpy( e -> oldData, hostPtr, len );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// The instruction encoders. Only the few forms needed are encoded. The register
+// numbers are the host register numbers, a REX prefix is added when needed.
+//
+//----------------------------------------------------------------------------------------
+void T64Jit::emitByte( uint8_t val ) {
+
+    codeBuf[ codePos++ ] = val;
+}
+
+void T64Jit::emitWord( uint32_t val ) {
+
+    memcpy( codeBuf + codePos, &val, sizeof( val ));
+    codePos += sizeof( val );
+}
+
+void T64Jit::emitLong( uint64_t val ) {
+
+    memcpy( codeBuf + codePos, &val, sizeof( val ));
+    codePos += sizeof( val );
+}
+
+void T64Jit::emitRex( bool w, int reg, int base ) {
+
+    uint8_t rex = 0x40 | (( w ) ? 0x08 : 0 ) | (( reg & 8 ) ? 0x04 : 0 ) | (( base & 8 ) ? 0x01 : 0 );
+
+    if ( rex != 0x40 ) emitByte( rex );
+}
+
+void T64Jit::emitRegReg( uint8_t op, int dst, int src ) {
+
+    emitRex( true, src, dst );
+    emitByte( op );
+    emitByte( 0xC0 | (( src & 7 ) << 3 ) | ( dst & 7 ));
+}
+
+void T64Jit::emitRegImm( uint8_t ext, int dst, int32_t imm ) {
+
+    emitRex( true, 0, dst );
+    emitByte( 0x81 );
+    emitByte( 0xC0 | ( ext << 3 ) | ( dst & 7 ));
+    emitWord((uint32_t) imm );
+}
+
+void T64Jit::emitShift( uint8_t ext, int dst, int amt ) {
+
+    emitRex( true, 0, dst );
+    emitByte( 0xC1 );
+    emitByte( 0xC0 | ( ext << 3 ) | ( dst & 7 ));
+    emitByte((uint8_t) amt );
+}
+
+void T64Jit::emitMem( uint8_t op, bool w, int reg, int base, int32_t disp ) {
+
+    emitRex( w, reg, base );
+    emitByte( op );
+    emitByte( 0x80 | (( reg & 7 ) << 3 ) | ( base & 7 ));
+    if (( base & 7 ) == RSP ) emitByte( 0x24 );
+    emitWord((uint32_t) disp );
+}
+
+void T64Jit::emitLoadImm( int dst, T64Word val ) {
+
+    if ( val == 0 ) {
+
+        emitRex( false, dst, dst );
+        emitByte( OP_XOR );
+        emitByte( 0xC0 | (( dst & 7 ) << 3 ) | ( dst & 7 ));
+    }
+    else if (( val > 0 ) && ( val <= UINT32_MAX )) {
+
+        emitRex( false, 0, dst );
+        emitByte( 0xB8 + ( dst & 7 ));
+        emitWord((uint32_t) val );
+    }
+    else if (( val >= INT32_MIN ) && ( val <= INT32_MAX )) {
+
+        emitRex( true, 0, dst );
+        emitByte( 0xC7 );
+        emitByte( 0xC0 | ( dst & 7 ));
+        emitWord((uint32_t) val );
+    }
+    else {
+
+        emitRex( true, 0, dst );
+        emitByte( 0xB8 + ( dst & 7 ));
+        emitLong((uint64_t) val );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Guest register access. A register kept in a host register is just moved, the
+// others are in the register file. R0 reads as zero and is never written.
+//
+//----------------------------------------------------------------------------------------
+void T64Jit::emitGetReg( int dst, int gReg ) {
+
+    if ( gReg == 0 )                emitLoadImm( dst, 0 );
+    else if ( regMap[ gReg ] >= 0 ) emitRegReg( OP_MOV, dst, regMap[ gReg ] );
+    else                            emitMem( OP_MOV_RM, true, dst, R15, gReg * 8 );
+}
+
+void T64Jit::emitSetReg( int gReg, int src ) {
+
+    if ( gReg == 0 )                return;
+    else if ( regMap[ gReg ] >= 0 ) emitRegReg( OP_MOV, regMap[ gReg ], src );
+    else                            emitMem( OP_MOV, true, src, R15, gReg * 8 );
+}
+
+//----------------------------------------------------------------------------------------
+// The address arithmetic. RAX is the address, RCX the offset. Just like the
+// "addAdrOfs32" routine, the offset is added to the lower half of the address
+// only. The result is in RAX, RDX is used.
+//
+//----------------------------------------------------------------------------------------
+void T64Jit::emitAdrOfs( ) {
+
+    emitByte( 0x89 ); emitByte( 0xC2 );                                     // mov edx, eax
+    emitByte( 0x01 ); emitByte( 0xCA );                                     // add edx, ecx
+    emitShift( EXT_SHR, RAX, 32 );
+    emitShift( EXT_SHL, RAX, 32 );
+    emitRegReg( OP_OR, RAX, RDX );
+}
+
+//----------------------------------------------------------------------------------------
+// A helper call. The arguments are set already.
+//
+//----------------------------------------------------------------------------------------
+void T64Jit::emitCall( uintptr_t fn ) {
+
+    emitLoadImm( RAX, (T64Word) fn );
+    emitByte( 0xFF ); emitByte( 0xD0 );                                     // call rax
+}
+
+//----------------------------------------------------------------------------------------
+// A jump out of the block, conditional or always. The jump target is the exit
+// placed after the epilogue, which sets the result value. The jump offset is
+// filled in when the exits are placed.
+//
+//----------------------------------------------------------------------------------------
+void T64Jit::emitExit( int cc, int count, uint32_t delta ) {
+
+    if ( cc == CC_ALWAYS ) {
+
+        emitByte( 0xE9 );
+    }
+    else {
+
+        emitByte( 0x0F );
+        emitByte( 0x80 + cc );
+    }
+
+    exitPos[ exitCount ] = codePos;
+    exitVal[ exitCount ] = exitValue( count, delta );
+    exitCount++;
+
+    emitWord( 0 );
+}
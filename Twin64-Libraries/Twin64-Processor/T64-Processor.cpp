@@ -39,6 +39,39 @@
 //----------------------------------------------------------------------------------------
 namespace {
 
+//----------------------------------------------------------------------------------------
+// The names of the processor performance counters, in counter order.
+//
+//----------------------------------------------------------------------------------------
+const char *const procPerfCounterNames[ T64_PC_MAX ] = {
+
+    "instrs",       "traps",
+    "iTlbHits",     "iTlbMisses",   "iTlbGTlbHits", "iTlbGTlbMisses",
+    "dTlbHits",     "dTlbMisses",   "dTlbGTlbHits", "dTlbGTlbMisses",
+    "icHits",       "icMisses",     "icWriteBacks",
+    "dcHits",       "dcMisses",     "dcWriteBacks",
+    "ccHits",       "ccMisses",     "ccPurges",
+    "idleReqs",     "interrupts",   "events",
+    "blocks",       "blockInstrs",  "blockMismatches",
+    "cycles",
+    "jitBlocks",    "jitInstrs"
+};
+
+//----------------------------------------------------------------------------------------
+// The increment of a counter since the last timing update. The base remembers
+// the value seen last. A counter below its base was cleared in the meantime, 
+// all it counted since is the increment.
+//
+//----------------------------------------------------------------------------------------
+T64Word counterDelta( T64PerfBlock *perf, T64Word *base, int index ) {
+
+    T64Word val     = perf -> get( index );
+    T64Word delta   = ( val >= base[ index ] ) ? val - base[ index ] : val;
+
+    base[ index ] = val;
+    return( delta );
+}
+
 };
 
 //****************************************************************************************
@@ -47,10 +80,13 @@ namespace {
 // Processor. 
 //
 //----------------------------------------------------------------------------------------
-// A processor is a module with one CPU, TLBs and one day also Caches. We create
+// A processor is a module with one CPU, TLBs and optional caches. We create
 // the component objects right here and pass them our instance, such that they 
 // have access to these components. Typically, they keep local copies of the 
-// references they need.
+// references they need. The performance counters are defined first, all the
+// components count into the processor counter block. A cache type other than 
+// T64_CT_NIL gives the processor an instruction and a data cache of that type.
+// The caches are created first, the CPU checks for them.
 //
 // The processor runs its own thread. The thread logic is inherited from the 
 // T64ThreadModule class. We need to implement the abstract methods of a module
@@ -75,11 +111,26 @@ T64Processor::T64Processor( T64System           *sys,
                                                 0,
                                                 0 ) {
 
-    this -> sys = sys;
+    this -> sys     = sys;
+    this -> options = options;
+
+    definePerfCounters( procPerfCounterNames, T64_PC_MAX );
+
+    if ( cacheType != T64_CT_NIL ) {
+
+        iCache = new T64Cache( this, T64_CK_INSTR_CACHE, cacheType );
+        dCache = new T64Cache( this, T64_CK_DATA_CACHE, cacheType );
+    }
 
     cpu       = new T64Cpu( this, cpuType );
+    breaks    = new T64BreakTable( this );
     localTlb  = new T64LocalTlb( this, T64_TK_UNIFIED_TLB, tlbType );
+    events    = sys -> getEventQueue( modNum );
     globalTlb = dynamic_cast<T64GlobalTlb*>( sys -> lookupByModuleType( MT_GTLB ));
+
+    if ( options & T64_PO_PREDECODE ) codeCache = new T64CodeCache( this );
+    if (( options & T64_PO_BLOCKS ) && ( codeCache != nullptr )) jit = new T64Jit( this );
+    if ( options & T64_PO_TIMING ) cpu -> setTiming( &timingCfg );
     
     cpu -> reset( );
     localTlb -> reset( );
@@ -92,7 +143,12 @@ T64Processor::T64Processor( T64System           *sys,
 T64Processor:: ~T64Processor( ) {
 
     delete cpu;
+    delete breaks;
     delete localTlb;
+    delete jit;
+    delete codeCache;
+    delete iCache;
+    delete dCache;
 }
 
 //----------------------------------------------------------------------------------------
@@ -103,6 +159,21 @@ void T64Processor::initModule( ) {
 
     cpu -> reset( );
     localTlb -> reset( );
+    if ( codeCache != nullptr ) codeCache -> reset( );
+    if ( jit != nullptr ) jit -> reset( );
+    if ( iCache != nullptr ) iCache -> reset( );
+    if ( dCache != nullptr ) dCache -> reset( );
+    breaks -> clearHit( );
+    sys -> clearReservation( this );
+    perf -> set( T64_PC_INSTRS, 0 );
+    perf -> set( T64_PC_TRAPS, 0 );
+    perf -> set( T64_PC_IDLE_REQS, 0 );
+    perf -> set( T64_PC_INTERRUPTS, 0 );
+    perf -> set( T64_PC_EVENTS, 0 );
+    resetCycles( );
+    events -> reset( );
+    idleReq = false;
+    startSampling( );
     
     T64ProcThreadModule::initModule( );
 }
@@ -111,10 +182,79 @@ void T64Processor::resetModule( ) {
 
     cpu -> reset( );
     localTlb -> reset( );
+    if ( codeCache != nullptr ) codeCache -> reset( );
+    if ( jit != nullptr ) jit -> reset( );
+    if ( iCache != nullptr ) iCache -> reset( );
+    
+    if ( dCache != nullptr ) {
+        
+        dCache -> flushAll( );
+        dCache -> reset( );
+    }
+
+    breaks -> clearHit( );
+    sys -> clearReservation( this );
+    perf -> set( T64_PC_INSTRS, 0 );
+    perf -> set( T64_PC_TRAPS, 0 );
+    perf -> set( T64_PC_IDLE_REQS, 0 );
+    perf -> set( T64_PC_INTERRUPTS, 0 );
+    perf -> set( T64_PC_EVENTS, 0 );
+    resetCycles( );
+    events -> reset( );
+    idleReq = false;
+    startSampling( );
 
     T64ProcThreadModule::resetModule( );
 }
 
+//----------------------------------------------------------------------------------------
+// Snapshot support. The processor record contains the CPU registers, the local
+// TLB and the reservation. The data cache writes back its modified lines first,
+// so that the memory saved after the processors is current. The caches and the
+// code cache are not saved, they are discarded on restore and just warm up 
+// again. The processor must be halted.
+//
+//----------------------------------------------------------------------------------------
+bool T64Processor::saveState( T64Snapshot *snap ) {
+
+    if ( dCache != nullptr ) dCache -> flushAll( );
+
+    T64Word rsvAdr  = getRsvAdr( );
+    T64Word rsvData = getRsvData( );
+
+    snap -> beginModule( this );
+    cpu -> saveState( snap );
+    localTlb -> saveState( snap );
+    snap -> put( &rsvAdr, sizeof( rsvAdr ));
+    snap -> put( &rsvData, sizeof( rsvData ));
+    return( true );
+}
+
+bool T64Processor::restoreState( T64Snapshot *snap ) {
+
+    T64Word rsvAdr  = T64_RSV_NONE;
+    T64Word rsvData = 0;
+
+    if (( ! snap -> findModule( this ))               ||
+        ( ! cpu -> restoreState( snap ))              ||
+        ( ! localTlb -> restoreState( snap ))         ||
+        ( ! snap -> get( &rsvAdr, sizeof( rsvAdr )))  ||
+        ( ! snap -> get( &rsvData, sizeof( rsvData )))) {
+
+        return( false );
+    }
+
+    if ( codeCache != nullptr ) codeCache -> reset( );
+    if ( jit != nullptr ) jit -> reset( );
+    if ( iCache != nullptr ) iCache -> reset( );
+    if ( dCache != nullptr ) dCache -> reset( );
+
+    if ( rsvAdr != T64_RSV_NONE ) sys -> setReservation( this, rsvAdr, rsvData );
+    else                          sys -> clearReservation( this );
+
+    return( true );
+}
+
 //----------------------------------------------------------------------------------------
 // The thread class expect to call a routine that will execute a number of units.
 // For a processor, the unit is an instruction step. The routine will also return
@@ -125,9 +265,572 @@ void T64Processor::resetModule( ) {
 //----------------------------------------------------------------------------------------
 T64TrapCode T64Processor::executeUnit( ) {
 
-    return( cpu -> executeInstr( ));
+    serviceEvents( );
+
+    T64TrapCode trapCode = cpu -> executeInstr( );
+
+    perf -> inc( T64_PC_INSTRS );
+    if ( trapCode != NO_TRAP ) perf -> inc( T64_PC_TRAPS );
+
+    int fired = events -> advance( 1 );
+    if ( fired > 0 ) perf -> add( T64_PC_EVENTS, fired );
+
+    if ( sampleActive ) sampleStep( );
+    if ( options & T64_PO_TIMING ) updateCycles( );
+    return( trapCode );
 };
 
+//----------------------------------------------------------------------------------------
+// The batched version executes up to "units" instructions in one loop without
+// going back to the thread for each instruction. We stop early on a trap when
+// asked to halt on a trap. The loop is a template, so that the check for a 
+// profiler and for breakpoints is done once per batch and not for every 
+// instruction. The instance with BREAKS set checks the instruction address 
+// before and a watchpoint hit after each instruction. A break always ends the
+// batch, the instruction at a breakpoint is not counted as done. The executed
+// instructions are added to the instruction counter once per batch. With the
+// block option, the instance without profiler and breakpoints executes a basic
+// block per CPU call instead of a single instruction.
+//
+// Timed events and interrupts are only handled between batches. A batch is cut
+// short so that it ends when the next event is due, the event then fires at the
+// exact instruction count. A pending interrupt is taken before the batch starts.
+//
+//----------------------------------------------------------------------------------------
+T64TrapCode T64Processor::executeUnits( int units, bool haltOnTrap, int *done ) {
+
+    T64TrapCode trapCode = NO_TRAP;
+
+    idleReq = false;
+
+    serviceEvents( );
+
+    T64Word toNext = events -> unitsToNext( );
+    if ( toNext < units ) units = ( toNext > 1 ) ? (int) toNext : 1;
+
+    if ( breaks -> isActive( )) {
+
+        if ( profiler != nullptr ) trapCode = executeUnitsT<true, true>( units, haltOnTrap, done );
+        else                       trapCode = executeUnitsT<false, true>( units, haltOnTrap, done );
+    }
+    else {
+
+        if ( profiler != nullptr ) trapCode = executeUnitsT<true, false>( units, haltOnTrap, done );
+        else                       trapCode = executeUnitsT<false, false>( units, haltOnTrap, done );
+    }
+
+    int fired = events -> advance( *done );
+    if ( fired > 0 ) perf -> add( T64_PC_EVENTS, fired );
+
+    if ( options & T64_PO_TIMING ) updateCycles( );
+    if ( viewActive.load( std::memory_order_relaxed )) publishState( );
+
+    return( trapCode );
+}
+
+//----------------------------------------------------------------------------------------
+// Fire the events that are due and take a pending interrupt. An event scheduled
+// by another thread may be due already, it fires right away. The CPU decides
+// whether a pending interrupt can be taken.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::serviceEvents( ) {
+
+    int fired = events -> advance( 0 );
+    if ( fired > 0 ) perf -> add( T64_PC_EVENTS, fired );
+
+    if (( getPendingInterrupts( ) != 0 ) && ( cpu -> handleExtInterrupts( ))) {
+        
+        perf -> inc( T64_PC_INTERRUPTS );
+    }
+}
+
+template <bool PROFILE, bool BREAKS>
+T64TrapCode T64Processor::executeUnitsT( int units, bool haltOnTrap, int *done ) {
+
+    T64TrapCode trapCode = NO_TRAP;
+    int         i        = 0;
+
+    if constexpr (( ! PROFILE ) && ( ! BREAKS )) {
+
+        if ( useBlocks( )) {
+
+            while ( i < units ) {
+
+                int n = 0;
+
+                trapCode = cpu -> executeBlock( units - i, &n );
+                i += n;
+
+                if ( trapCode != NO_TRAP ) {
+
+                    perf -> inc( T64_PC_TRAPS );
+                    if ( haltOnTrap ) break;
+                }
+            }
+
+            perf -> add( T64_PC_INSTRS, i );
+            *done = i;
+            return( trapCode );
+        }
+    }
+
+    while ( i < units ) {
+
+        if constexpr ( BREAKS ) {
+
+            if ( breaks -> checkInstr( extractField64( cpu -> getPsrReg( ), 0, 52 ))) {
+
+                trapCode = DEBUG_BREAK_EVENT;
+                break;
+            }
+        }
+
+        trapCode = cpu -> executeInstrT<PROFILE>( );
+        i++;
+
+        if ( sampleActive ) sampleStep( );
+
+        if constexpr ( BREAKS ) {
+
+            if ( breaks -> takeDataHit( )) {
+
+                trapCode = DEBUG_BREAK_EVENT;
+                break;
+            }
+        }
+
+        if ( trapCode != NO_TRAP ) {
+            
+            perf -> inc( T64_PC_TRAPS );
+            if ( haltOnTrap ) break;
+        }
+    }
+
+    perf -> add( T64_PC_INSTRS, i );
+    *done = i;
+    return( trapCode );
+}
+
+//----------------------------------------------------------------------------------------
+// The block path is used when the block option is set and there is a code cache
+// to execute from. Anything that needs to look at each instruction on its own, 
+// such as the tracer or a sampling simulation, selects the instruction path.
+// Profiler and breakpoints already select a loop instance without blocks.
+//
+//----------------------------------------------------------------------------------------
+bool T64Processor::useBlocks( ) {
+
+    return(( options & T64_PO_BLOCKS ) &&
+           ( codeCache != nullptr ) &&
+           ( tracer == nullptr ) &&
+           ( ! sampleActive ) &&
+           ( ! detailedPath ));
+}
+
+//----------------------------------------------------------------------------------------
+// Timing model. The configuration can be changed at any time, the cycles so far
+// are not recomputed. The estimate is the instruction group cycles of the CPU
+// plus the cycles for the events counted. Both are accumulated as we go: the 
+// CPU adds the group cycles per instruction and each update adds the events 
+// counted since the last update with the cycles configured now. The counters
+// start over on a reset, and so does the estimate.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::setTimingConfig( const T64TimingConfig &cfg ) {
+
+    timingCfg = cfg;
+    if ( options & T64_PO_TIMING ) cpu -> setTiming( &timingCfg );
+}
+
+T64Word T64Processor::getCycles( ) {
+
+    return( perf -> get( T64_PC_CYCLES ));
+}
+
+void T64Processor::updateCycles( ) {
+
+    T64Word *base = cycleBase;
+
+    eventCycles += ( counterDelta( perf, base, T64_PC_ITLB_GTLB_HITS ) + 
+                     counterDelta( perf, base, T64_PC_DTLB_GTLB_HITS )) * 
+                   timingCfg.gTlbHitCycles;
+
+    eventCycles += ( counterDelta( perf, base, T64_PC_ITLB_GTLB_MISSES ) + 
+                     counterDelta( perf, base, T64_PC_DTLB_GTLB_MISSES )) * 
+                   timingCfg.gTlbMissCycles;
+
+    eventCycles += ( counterDelta( perf, base, T64_PC_ICACHE_HITS ) + 
+                     counterDelta( perf, base, T64_PC_DCACHE_HITS )) * 
+                   timingCfg.cacheHitCycles;
+
+    eventCycles += ( counterDelta( perf, base, T64_PC_ICACHE_MISSES ) + 
+                     counterDelta( perf, base, T64_PC_DCACHE_MISSES )) * 
+                   timingCfg.cacheMissCycles;
+
+    eventCycles += ( counterDelta( perf, base, T64_PC_ICACHE_WBACKS ) + 
+                     counterDelta( perf, base, T64_PC_DCACHE_WBACKS )) * 
+                   timingCfg.cacheWBackCycles;
+
+    eventCycles += counterDelta( perf, base, T64_PC_TRAPS ) * timingCfg.trapCycles;
+
+    T64Word cycles = cpu -> getInstrCycles( ) + eventCycles;
+
+    perf -> set( T64_PC_CYCLES, cycles );
+    cpu -> setControlReg( CTL_REG_CYCLES, cycles );
+}
+
+void T64Processor::resetCycles( ) {
+
+    for ( int i = 0; i < T64_PC_MAX; i++ ) cycleBase[ i ] = 0;
+
+    eventCycles = 0;
+    perf -> set( T64_PC_CYCLES, 0 );
+}
+
+//----------------------------------------------------------------------------------------
+// Live state view. The writer side fills the buffer not published last and 
+// then publishes it. The reader takes the published buffer and checks that its
+// sequence number did not change during the copy. After a few failed attempts
+// the reader gives up, the caller then keeps the view it had. So does a caller
+// asking before the first batch was published. The first request turns on the
+// publishing.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::publishState( ) {
+
+    int         b   = 1 - viewCur.load( std::memory_order_relaxed );
+    uint32_t    seq = viewSeq[ b ].load( std::memory_order_relaxed );
+
+    viewSeq[ b ].store( seq + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    copyState( &viewBuf[ b ] );
+
+    viewSeq[ b ].store( seq + 2, std::memory_order_release );
+    viewCur.store( b, std::memory_order_release );
+}
+
+bool T64Processor::getStateView( T64ProcStateView *view ) {
+
+    if ( getModuleState( ) != T64_MOD_STATE_EXECUTE ) {
+
+        copyState( view );
+        return( true );
+    }
+
+    viewActive.store( true, std::memory_order_relaxed );
+
+    for ( int i = 0; i < 8; i++ ) {
+
+        int         b   = viewCur.load( std::memory_order_acquire );
+        uint32_t    seq = viewSeq[ b ].load( std::memory_order_acquire );
+
+        if (( seq == 0 ) || ( seq & 0x1 )) continue;
+
+        *view = viewBuf[ b ];
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if ( viewSeq[ b ].load( std::memory_order_relaxed ) == seq ) return( true );
+    }
+
+    return( false );
+}
+
+void T64Processor::copyState( T64ProcStateView *view ) {
+
+    view -> psr = cpu -> getPsrReg( );
+
+    for ( int i = 0; i < T64_MAX_GREGS; i++ ) view -> gRegs[ i ] = cpu -> getGeneralReg( i );
+    for ( int i = 0; i < T64_MAX_CREGS; i++ ) view -> cRegs[ i ] = cpu -> getControlReg( i );
+
+    view -> instrs = perf -> get( T64_PC_INSTRS );
+}
+
+//----------------------------------------------------------------------------------------
+// Idle hints. The CPU remembers the request, for several requests in a batch 
+// the last timeout is used. After the batch, the thread module takes the 
+// request and decides whether to park us. With timed events in our queue, we
+// do not park but skip the time forward to the next event.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::requestIdle( T64Word timeoutUs ) {
+
+    idleReq     = true;
+    idleTimeout = ( timeoutUs > 0 ) ? timeoutUs : 0;
+    perf -> inc( T64_PC_IDLE_REQS );
+}
+
+bool T64Processor::takeIdleRequest( T64Word *timeoutUs ) {
+
+    if ( ! idleReq ) return( false );
+
+    idleReq = false;
+
+    int fired = events -> skipToNext( );
+
+    if ( fired > 0 ) {
+        
+        perf -> add( T64_PC_EVENTS, fired );
+        return( false );
+    }
+
+    *timeoutUs = idleTimeout;
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Attach or detach a tracer. The processor must not be executing. The tracer 
+// remains owned by the caller.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::setTracer( T64Tracer *tracer ) {
+
+    this -> tracer = tracer;
+}
+
+T64Tracer *T64Processor::getTracer( ) {
+
+    return( tracer );
+}
+
+//----------------------------------------------------------------------------------------
+// Attach or detach a profiler. The processor must not be executing. The 
+// profiler remains owned by the caller.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::setProfiler( T64Profiler *profiler ) {
+
+    this -> profiler = profiler;
+}
+
+T64Profiler *T64Processor::getProfiler( ) {
+
+    return( profiler );
+}
+
+//----------------------------------------------------------------------------------------
+// The break table. It is created with the processor and only changed while the
+// processor is not executing.
+//
+//----------------------------------------------------------------------------------------
+T64BreakTable *T64Processor::getBreakTablePtr( ) {
+
+    return( breaks );
+}
+
+//----------------------------------------------------------------------------------------
+// Sampling simulation. Setting a configuration starts the sampling schedule. 
+// A configuration without a trigger and without a warmup or sample length 
+// disables sampling.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::setSampleConfig( const T64SampleConfig &cfg ) {
+
+    sampleCfg = cfg;
+    startSampling( );
+}
+
+T64SimMode T64Processor::getSimMode( ) {
+
+    return( simMode );
+}
+
+//----------------------------------------------------------------------------------------
+// Return the sample statistics. When we are in a measured region, the counters 
+// so far in the region are included.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::getSampleStats( T64SampleStats *stats ) {
+
+    *stats = sampleStats;
+
+    if ( simMode == T64_SM_DETAILED ) addSampleCounters( stats );
+}
+
+//----------------------------------------------------------------------------------------
+// Start the sampling schedule. We begin with fast forwarding when there is a 
+// trigger. For the instruction count trigger, the fast phase is shortened by 
+// the warmup phase. Without a trigger, we start with the warmup phase.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::startSampling( ) {
+
+    bool trigger = (( sampleCfg.ffInstrs > 0 ) || 
+                    ( sampleCfg.ffPc >= 0 ) || 
+                    ( sampleCfg.ffDiag ));
+
+    simMode      = T64_SM_NORMAL;
+    sampleStats  = { };
+    sampleBase   = { };
+    diagTrigger  = false;
+    sampleActive = (( trigger ) || 
+                    ( sampleCfg.warmInstrs > 0 ) || 
+                    ( sampleCfg.sampleInstrs > 0 ));
+
+    if ( ! sampleActive ) enterSimMode( T64_SM_NORMAL );
+    else if ( ! trigger ) enterSimMode( T64_SM_WARMUP );
+    else {
+
+        enterSimMode( T64_SM_FAST );
+
+        if ( sampleCfg.ffInstrs > 0 ) {
+
+            modeInstrsLeft = sampleCfg.ffInstrs - sampleCfg.warmInstrs;
+            if ( modeInstrsLeft <= 0 ) enterSimMode( T64_SM_WARMUP );
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Enter a simulation mode. The detailed path is used for the warmup and the 
+// measured region. Entering the measured region takes a snapshot of the 
+// counters, leaving it adds the counter differences to the statistics. After
+// a measured region, the next fast forward phase is the sample gap less the 
+// warmup phase. Without a sample gap, sampling is done.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::enterSimMode( T64SimMode mode ) {
+
+    if ( simMode == T64_SM_DETAILED ) addSampleCounters( &sampleStats );
+
+    simMode         = mode;
+    detailedPath    = (( mode == T64_SM_WARMUP ) || ( mode == T64_SM_DETAILED ));
+    modeInstrsLeft  = 0;
+
+    switch ( mode ) {
+        
+        case T64_SM_NORMAL: {
+
+            sampleActive = false;
+
+        } break;
+
+        case T64_SM_FAST: {
+
+            diagTrigger = false;
+
+        } break;
+
+        case T64_SM_WARMUP: {
+
+            modeInstrsLeft = sampleCfg.warmInstrs;
+            if ( modeInstrsLeft == 0 ) enterSimMode( T64_SM_DETAILED );
+
+        } break;
+
+        case T64_SM_DETAILED: {
+
+            readSampleCounters( &sampleBase );
+            sampleStats.samples ++;
+            modeInstrsLeft = sampleCfg.sampleInstrs;
+
+        } break;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Called after each instruction while sampling is active. We count the 
+// instruction for the current mode and check for the end of the mode. In the
+// fast mode without an instruction count, the instruction address and the DIAG
+// trigger end the fast forward phase.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::sampleStep( ) {
+
+    sampleStats.instrs ++;
+
+    switch ( simMode ) {
+
+        case T64_SM_FAST: {
+
+            sampleStats.fastInstrs ++;
+
+            if ( modeInstrsLeft > 0 ) {
+
+                if ( -- modeInstrsLeft == 0 ) enterSimMode( T64_SM_WARMUP );
+            }
+            else if (( diagTrigger ) || 
+                     (( sampleCfg.ffPc >= 0 ) && 
+                      ( extractField64( cpu -> getPsrReg( ), 0, 52 ) == sampleCfg.ffPc ))) {
+
+                enterSimMode( T64_SM_WARMUP );
+            }
+
+        } break;
+
+        case T64_SM_WARMUP: {
+
+            sampleStats.warmInstrs ++;
+            if ( -- modeInstrsLeft <= 0 ) enterSimMode( T64_SM_DETAILED );
+
+        } break;
+
+        case T64_SM_DETAILED: {
+
+            sampleStats.detailInstrs ++;
+
+            if (( modeInstrsLeft > 0 ) && ( -- modeInstrsLeft == 0 )) {
+
+                if ( sampleCfg.sampleGap > 0 ) {
+
+                    enterSimMode( T64_SM_FAST );
+
+                    modeInstrsLeft = sampleCfg.sampleGap - sampleCfg.warmInstrs;
+                    if ( modeInstrsLeft <= 0 ) enterSimMode( T64_SM_WARMUP );
+                } 
+                else enterSimMode( T64_SM_NORMAL );
+            }
+
+        } break;
+
+        default: ;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Sample counter helpers. We read the current TLB and cache counters, or add
+// the counters since the start of the measured region.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::readSampleCounters( T64SampleStats *stats ) {
+
+    stats -> iTlbHits   = localTlb -> getItlbHits( );
+    stats -> iTlbMisses = localTlb -> getItlbMisses( );
+    stats -> dTlbHits   = localTlb -> getDtlbHits( );
+    stats -> dTlbMisses = localTlb -> getDtlbMisses( );
+
+    if ( iCache != nullptr ) {
+
+        stats -> iCacheHits   = iCache -> getHits( );
+        stats -> iCacheMisses = iCache -> getMisses( );
+    }
+
+    if ( dCache != nullptr ) {
+
+        stats -> dCacheHits       = dCache -> getHits( );
+        stats -> dCacheMisses     = dCache -> getMisses( );
+        stats -> dCacheWriteBacks = dCache -> getWriteBacks( );
+    }
+}
+
+void T64Processor::addSampleCounters( T64SampleStats *stats ) {
+
+    T64SampleStats cur;
+
+    readSampleCounters( &cur );
+
+    stats -> iTlbHits         += cur.iTlbHits         - sampleBase.iTlbHits;
+    stats -> iTlbMisses       += cur.iTlbMisses       - sampleBase.iTlbMisses;
+    stats -> dTlbHits         += cur.dTlbHits         - sampleBase.dTlbHits;
+    stats -> dTlbMisses       += cur.dTlbMisses       - sampleBase.dTlbMisses;
+    stats -> iCacheHits       += cur.iCacheHits       - sampleBase.iCacheHits;
+    stats -> iCacheMisses     += cur.iCacheMisses     - sampleBase.iCacheMisses;
+    stats -> dCacheHits       += cur.dCacheHits       - sampleBase.dCacheHits;
+    stats -> dCacheMisses     += cur.dCacheMisses     - sampleBase.dCacheMisses;
+    stats -> dCacheWriteBacks += cur.dCacheWriteBacks - sampleBase.dCacheWriteBacks;
+}
+
 //----------------------------------------------------------------------------------------
 // Little helpers.
 //
@@ -207,6 +910,9 @@ char *T64Processor::getProcStateStr( ) {
                 case BREAK_INSTR_TRAP: 
                     return((char *) "TRAP: BREAK" );
 
+                case DEBUG_BREAK_EVENT: 
+                    return((char *) "BREAK" );
+
                 case USER_DEFINED_TRAP: 
                     return((char *) "TRAP: USER" );
 
@@ -228,6 +934,21 @@ T64LocalTlb *T64Processor::getLocalTlbPtr( ) {
     return ( localTlb );
 }
 
+T64CodeCache *T64Processor::getCodeCachePtr( ) {
+
+    return ( codeCache );
+}
+
+T64Cache *T64Processor::getICachePtr( ) {
+
+    return ( iCache );
+}
+
+T64Cache *T64Processor::getDCachePtr( ) {
+
+    return ( dCache );
+}
+
 T64GlobalTlb *T64Processor::getGlobalTlbPtr( ) {
 
     return( globalTlb );
@@ -371,6 +1092,46 @@ bool T64Processor::handleHPARead( T64Word pAdr, uint8_t *data, int len ) {
 
             } break;
 
+            case T64_IO_ICACHE_HITS_OFS: {
+
+                tmp = ( iCache != nullptr ) ? iCache -> getHits( ) : 0;
+                copyFromReg( data, tmp, wordOfs, len );
+                return( true );
+
+            } break;
+
+            case T64_IO_ICACHE_MISSES_OFS: {
+
+                tmp = ( iCache != nullptr ) ? iCache -> getMisses( ) : 0;
+                copyFromReg( data, tmp, wordOfs, len );
+                return( true );
+
+            } break;
+
+            case T64_IO_DCACHE_HITS_OFS: {
+
+                tmp = ( dCache != nullptr ) ? dCache -> getHits( ) : 0;
+                copyFromReg( data, tmp, wordOfs, len );
+                return( true );
+
+            } break;
+
+            case T64_IO_DCACHE_MISSES_OFS: {
+
+                tmp = ( dCache != nullptr ) ? dCache -> getMisses( ) : 0;
+                copyFromReg( data, tmp, wordOfs, len );
+                return( true );
+
+            } break;
+
+            case T64_IO_DCACHE_WBACKS_OFS: {
+
+                tmp = ( dCache != nullptr ) ? dCache -> getWriteBacks( ) : 0;
+                copyFromReg( data, tmp, wordOfs, len );
+                return( true );
+
+            } break;
+
             default: {
 
                 copyFromReg( data, tmp, 0, len );
@@ -405,6 +1166,13 @@ bool T64Processor::handleHPARead( T64Word pAdr, uint8_t *data, int len ) {
             return( true );
         }
     }
+    else if ( regSetIndex == T64_PERF_REG_SET ) {
+
+        if ( ! readPerfReg( wordInRegSetIndex, &tmp )) return( false );
+
+        copyFromReg( data, tmp, wordOfs, len );
+        return( true );
+    }
     else return ( false );
 }
 
@@ -426,17 +1194,24 @@ bool T64Processor::handleHPAWrite( T64Word pAdr, uint8_t *data, int len ) {
 }
 
 //----------------------------------------------------------------------------------------
-// We have a broadcast event. Note that we are called with the system bus locked.
+// We have a broadcast event. Broadcast events are taken from our event queue 
+// between two batches of instructions, or right away when we are not running.
 // 
 //  T64_CNTRL_EVENT_TLB_PURGE - an entry was purged from the global TLB, clear
-//  our local copies if any.
+//  our local copies if any. The code cache forgets its current translation.
 //
 //  T64_CNTRL_EVENT_STORE_OP - each store operation is checked for a possible
-//  match with the reserve register. If a match, we invalidate this info.
+//  match with the reserve register. If a match, we invalidate this info. A 
+//  store to a page in the code cache invalidates the decoded page.
 //
 //  T64_CNTRL_EVENT_MODULE_PURGE - a module was purged. If it is the global
 //  TLB, we clear our cached reference. A future access will lead to a machine
-//  check trap.
+//  check trap. The code cache and the direct memory map are invalidated, the 
+//  module could have been the memory they refer to.
+//
+//  T64_CNTRL_EVENT_CACHE_FLUSH, T64_CNTRL_EVENT_CACHE_PURGE - another party 
+//  accesses a memory line, our caches write back or remove their copy. These 
+//  events are sent with the system coherence lock held, not the bus lock.
 //
 //----------------------------------------------------------------------------------------
 bool T64Processor::handleControlEvent( T64BBusOpControlEvents event, 
@@ -447,20 +1222,34 @@ bool T64Processor::handleControlEvent( T64BBusOpControlEvents event,
 
         case T64_CNTRL_EVENT_TLB_PURGE: {
             
+            if ( codeCache != nullptr ) codeCache -> purgeTranslation( );
             return( localTlb -> purgeTlb( arg1 ));
 
         } break;
 
         case T64_CNTRL_EVENT_STORE_OP: {
 
-            if ( getRsvInfo( ) == arg1 ) setRsvInfo( arg1, false );
+            if ( codeCache != nullptr ) codeCache -> purgePage( arg1 );
             return( true );
 
         } break;
 
         case T64_CNTRL_EVENT_MODULE_PURGE: {
 
-            if ( arg1 == globalTlb -> getModuleNum( )) globalTlb = nullptr;  
+            if (( globalTlb != nullptr ) && ( arg1 == globalTlb -> getModuleNum( ))) {
+                
+                globalTlb = nullptr;  
+            }
+
+            if ( codeCache != nullptr ) codeCache -> purgeAll( );
+            cpu -> purgeDirectMem( );
+
+        } break;
+
+        case T64_CNTRL_EVENT_CACHE_FLUSH:
+        case T64_CNTRL_EVENT_CACHE_PURGE: {
+
+            snoopCaches( event, arg1, (int) arg2 );
 
         } break;
 
@@ -470,6 +1259,24 @@ bool T64Processor::handleControlEvent( T64BBusOpControlEvents event,
     return( true );
 }
 
+//----------------------------------------------------------------------------------------
+// Our own caches on a cache event. The instruction cache holds no modified 
+// lines, a flush does not concern it.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::snoopCaches( T64BBusOpControlEvents event, T64Word pAdr, int len ) {
+
+    if ( event == T64_CNTRL_EVENT_CACHE_FLUSH ) {
+
+        if ( dCache != nullptr ) dCache -> flush( pAdr, len );
+    }
+    else if ( event == T64_CNTRL_EVENT_CACHE_PURGE ) {
+
+        if ( iCache != nullptr ) iCache -> purge( pAdr, len );
+        if ( dCache != nullptr ) dCache -> purge( pAdr, len );
+    }
+}
+
 //----------------------------------------------------------------------------------------
 // System Bus operations interface routines. The bus operations for read and 
 // and write transactions are just passed through to the system layer. The bus
@@ -481,6 +1288,12 @@ bool T64Processor::handleControlEvent( T64BBusOpControlEvents event,
 // a broadcast event. The processor will handle TLB events, such as TLB entry
 // purge and so on.
 //
+// The block operations are used by our caches. The system informs the other
+// processors, our own caches are informed here, so that the instruction cache 
+// sees a line modified in the data cache and vice versa. A block write is a 
+// write back of a line we hold modified, no other copy exists. The requesting
+// cache does not hold its lock during a block read.
+//
 //----------------------------------------------------------------------------------------
 bool T64Processor::busOpRead( T64Word adr, uint8_t *data, int len ) {
 
@@ -509,6 +1322,23 @@ bool T64Processor::busOpControl( T64BBusOpControlEvents id,
     return( sys -> busOpControl( this, id, arg1, arg2 ));
 }
 
+bool T64Processor::busOpReadSharedBlock( T64Word adr, uint8_t *data, int len ) {
+
+    snoopCaches( T64_CNTRL_EVENT_CACHE_FLUSH, adr, len );
+    return( sys -> busOpReadSharedBlock( this, adr, data, len ));
+}
+
+bool T64Processor::busOpReadPrivateBlock( T64Word adr, uint8_t *data, int len ) {
+
+    snoopCaches( T64_CNTRL_EVENT_CACHE_PURGE, adr, len );
+    return( sys -> busOpReadPrivateBlock( this, adr, data, len ));
+}
+
+bool T64Processor::busOpWriteBlock( T64Word adr, uint8_t *data, int len ) {
+
+    return( sys -> busOpWriteBlock( this, adr, data, len ));
+}
+
 bool T64Processor::busOpReadEvent( T64Word pAdr, uint8_t *data, int len ) {
 
     return( handleHPARead( pAdr, data, len ));
@@ -525,3 +1355,24 @@ bool T64Processor::busOpControlEvent(  T64BBusOpControlEvents  event,
 
     return( handleControlEvent( event, arg1, arg2 ));
 }
+
+//----------------------------------------------------------------------------------------
+// The broadcast events we subscribe to. The store and cache events are sent to
+// the processors directly by the system and are not broadcast. When our event
+// queue overflowed, we do not know which TLB entries were purged. We purge the
+// local TLB and all decoded code pages and direct memory references. The TLB
+// statistics counters are kept.
+//
+//----------------------------------------------------------------------------------------
+uint32_t T64Processor::getControlEventMask( ) {
+
+    return( controlEventBit( T64_CNTRL_EVENT_MODULE_PURGE ) | 
+            controlEventBit( T64_CNTRL_EVENT_TLB_PURGE ));
+}
+
+void T64Processor::controlEventOverflow( ) {
+
+    localTlb -> purgeAll( );
+    if ( codeCache != nullptr ) codeCache -> purgeAll( );
+    cpu -> purgeDirectMem( );
+}
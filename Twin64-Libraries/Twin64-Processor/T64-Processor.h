@@ -32,6 +32,7 @@
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <unordered_map>
 
 //----------------------------------------------------------------------------------------
 // Forwards.
@@ -39,14 +40,45 @@
 //----------------------------------------------------------------------------------------
 struct T64System;
 struct T64Processor;
+struct T64Cpu;
+struct T64Jit;
+struct T64Cache;
+struct T64Tracer;
+struct T64Profiler;
+struct T64BreakTable;
+struct T64TimingConfig;
 
 //----------------------------------------------------------------------------------------
-// Processor Options. None defined yet. A place holder. 
+// Processor Options. The options are bits that can be combined.
+//
+//  T64_PO_PREDECODE  - execute from the predecoded instruction cache instead of 
+//                      fetching and decoding each instruction from memory.
+//
+//  T64_PO_DIRECT_MEM - data accesses to RAM pages use the host memory directly
+//                      instead of the bus operations.
+//
+//  T64_PO_BLOCKS     - execute the predecoded instructions a basic block at a
+//                      time. Requires the predecoded instruction cache. On an
+//                      x86-64 host, frequently executed blocks are translated
+//                      into host code.
+//
+//  T64_PO_VERIFY     - check each instruction of a block against the regular
+//                      fetch and decode path and each translated block run
+//                      against the instruction handlers. This is a debugging 
+//                      aid.
+//
+//  T64_PO_TIMING     - estimate the cycles a real processor would need, see 
+//                      the timing model below.
 //
 //----------------------------------------------------------------------------------------
 enum T64Options : uint32_t {
 
-    T64_PO_NIL = 0
+    T64_PO_NIL          = 0,
+    T64_PO_PREDECODE    = 1,
+    T64_PO_DIRECT_MEM   = 2,
+    T64_PO_BLOCKS       = 4,
+    T64_PO_VERIFY       = 8,
+    T64_PO_TIMING       = 16
 };
 
 //----------------------------------------------------------------------------------------
@@ -58,6 +90,10 @@ enum T64Options : uint32_t {
 // two 64-bit words. The first word contains the virtual address and the second
 // word contains the physical address and tlb information.
 //
+// The cache counters read as zero when the processor has no caches.
+//
+// Reg Set 2 contains the processor performance counters, see below.
+//
 //----------------------------------------------------------------------------------------
 enum T64ProcRegSetOfs : int {
 
@@ -72,12 +108,70 @@ enum T64ProcRegSetOfs : int {
     T64_IO_DTLB_HITS_OFS        = 16,
     T64_IO_DTLB_MISSES_OFS      = 17,
     T64_IO_DTLB_GTLB_HITS_OFS   = 18,
-    T64_IO_DTLB_GTLB_MISSES_OFS = 19
+    T64_IO_DTLB_GTLB_MISSES_OFS = 19,
+
+    T64_IO_ICACHE_HITS_OFS      = 20,
+    T64_IO_ICACHE_MISSES_OFS    = 21,
+    T64_IO_DCACHE_HITS_OFS      = 22,
+    T64_IO_DCACHE_MISSES_OFS    = 23,
+    T64_IO_DCACHE_WBACKS_OFS    = 24
+};
+
+//----------------------------------------------------------------------------------------
+// The processor performance counters. The processor defines the counter block,
+// the CPU, TLB and cache components count into it. The cache counters are the
+// same for the instruction and the data cache, the data cache counters follow
+// the instruction cache counters. The counters are also readable in register
+// set 2 of the processor HPA page. 
+//
+//----------------------------------------------------------------------------------------
+enum T64ProcPerfCounter : int {
+
+    T64_PC_INSTRS           = 0,
+    T64_PC_TRAPS            = 1,
+
+    T64_PC_ITLB_HITS        = 2,
+    T64_PC_ITLB_MISSES      = 3,
+    T64_PC_ITLB_GTLB_HITS   = 4,
+    T64_PC_ITLB_GTLB_MISSES = 5,
+
+    T64_PC_DTLB_HITS        = 6,
+    T64_PC_DTLB_MISSES      = 7,
+    T64_PC_DTLB_GTLB_HITS   = 8,
+    T64_PC_DTLB_GTLB_MISSES = 9,
+
+    T64_PC_ICACHE_HITS      = 10,
+    T64_PC_ICACHE_MISSES    = 11,
+    T64_PC_ICACHE_WBACKS    = 12,
+    T64_PC_DCACHE_HITS      = 13,
+    T64_PC_DCACHE_MISSES    = 14,
+    T64_PC_DCACHE_WBACKS    = 15,
+
+    T64_PC_CCACHE_HITS      = 16,
+    T64_PC_CCACHE_MISSES    = 17,
+    T64_PC_CCACHE_PURGES    = 18,
+
+    T64_PC_IDLE_REQS        = 19,
+    T64_PC_INTERRUPTS       = 20,
+    T64_PC_EVENTS           = 21,
+
+    T64_PC_BLOCKS           = 22,
+    T64_PC_BLOCK_INSTRS     = 23,
+    T64_PC_BLOCK_MISMATCHES = 24,
+
+    T64_PC_CYCLES           = 25,
+
+    T64_PC_JIT_BLOCKS       = 26,
+    T64_PC_JIT_INSTRS       = 27,
+
+    T64_PC_MAX              = 28
 };
 
 //----------------------------------------------------------------------------------------
 // A processor maintains a local ITLB and DTLB. These are small sets of TLB
-// entries to consult for each access.
+// entries to consult for each access. They are either fully associative or 
+// 4-way set associative. In front of each is a one entry micro TLB, which holds
+// the last translation used.
 //
 //----------------------------------------------------------------------------------------
 struct T64LocalTlb {
@@ -89,12 +183,16 @@ struct T64LocalTlb {
     virtual         ~ T64LocalTlb( );
     
     void            reset( );
+    void            purgeAll( );
 
     bool            lookupItlb( T64Word vadr, T64Word *pAdr, uint16_t *tlbInfo );
     bool            lookupDtlb( T64Word vadr, T64Word *pAdr, uint16_t *tlbInfo );
 
     bool            purgeTlb( T64Word vAdr );
 
+    void            saveState( T64Snapshot *snap );
+    bool            restoreState( T64Snapshot *snap );
+
     T64TlbEntry     *getITlbEntry( int index );
     T64TlbEntry     *getDTlbEntry( int index );
 
@@ -123,21 +221,663 @@ struct T64LocalTlb {
 
     int             iTlbEntries         = 0;
     int             dTlbEntries         = 0;
+    int             tlbSets             = 1;
+    uint32_t        iPageSizesUsed      = 0;
+    uint32_t        dPageSizesUsed      = 0;
    
     uint32_t        iTlbRoundRobin      = 0;       
+    uint32_t        dTlbRoundRobin      = 0;       
+
+    T64TlbEntry     iTlbLast            = { };
+    T64TlbEntry     dTlbLast            = { };
 
     T64Word         tlbStatus           = 0;
     T64Word         tlbConfig           = 0;
     
-    T64Word         iTlbHits            = 0;
-    T64Word         iTlbMisses          = 0;
-    T64Word         iTlbMissGTlbHits    = 0;
-    T64Word         iTlbMissGTlbMisses  = 0;
+    T64PerfBlock    *perf               = nullptr;
+};
+
+//----------------------------------------------------------------------------------------
+// The predecoded instruction cache. Instead of fetching an instruction word via
+// the TLB and the system bus and then decoding it with the big opcode switch, 
+// the CPU can execute from a cache of decoded instructions. The cache is 
+// organized by physical page. Each page has a slot for every instruction word
+// in the page, holding the instruction word and the handler routine to invoke.
+// When a slot is not yet decoded, the basic block starting at that slot is 
+// decoded, i.e. all instructions up to and including the next branch or system
+// instruction, or the end of the page.
+//
+// The cache also remembers the translation of the virtual page last executed
+// from, so that the ITLB lookup and access checks are only done when we enter 
+// a new page or the privilege level changes.
+//
+// A slot also records whether its instruction ends a basic block. With the
+// block option, the CPU moves from one slot to the next within a block without
+// another lookup, as long as the page and the translation remain valid.
+//
+// Stores to a cached code page drop that page. A TLB purge drops the remembered
+// translation and a module purge drops the entire cache. The invalidation calls
+// can come from other processor threads, they only clear the valid flags. The
+// page address is atomic, since a purge reads it while the owner refills the 
+// entry for another page. All other work is done by the CPU thread that owns 
+// the cache. A page entry in use is marked in the system code page directory, 
+// so that only stores to those pages are reported to the processors.
+//
+// A slot where a block is entered also counts the block entries and holds the
+// host code, once the block is translated. Clearing the page drops both.
+//
+//----------------------------------------------------------------------------------------
+const int T64_CODE_CACHE_PAGES  = 32;
+const int T64_CODE_CACHE_SLOTS  = T64_PAGE_SIZE_BYTES / sizeof( T64Instr );
+
+typedef void ( T64Cpu::*T64InstrHandler )( T64Instr instr );
+typedef uint64_t ( *T64JitCode )( T64Word *regs, T64Word psr );
+
+struct T64DecodedInstr {
+
+    T64InstrHandler     handler     = nullptr;
+    T64Instr            instr       = 0;
+    bool                blockEnd    = false;
+    uint16_t            jitCount    = 0;
+    uint16_t            jitLen      = 0;
+    T64JitCode          jitCode     = nullptr;
+};
+
+struct T64CodePage {
+
+    std::atomic<bool>       valid   = false;
+    bool                    marked  = false;
+    std::atomic<T64Word>    pAdr    = 0;
+    T64DecodedInstr         slot[ T64_CODE_CACHE_SLOTS ];
+};
+
+struct T64CodeCache {
+
+    public:
+
+    T64CodeCache( T64Processor *proc );
+
+    virtual         ~ T64CodeCache( );
+
+    void            reset( );
+
+    T64DecodedInstr *lookup( T64Word vAdr, uint8_t privMode, uint16_t *tlbInfo );
+    T64DecodedInstr *fill( T64Word vAdr, T64Word pAdr, uint8_t privMode, uint16_t tlbInfo );
+    T64DecodedInstr *next( T64DecodedInstr *dInstr );
+    bool            isCurPageValid( );
+
+    void            purgePage( T64Word pAdr );
+    void            purgeTranslation( );
+    void            purgeAll( );
+
+    T64Word         getHits( );
+    T64Word         getMisses( );
+    T64Word         getPurges( );
+
+    private:
+
+    bool            decodeBlock( T64CodePage *page, int index );
+
+    T64Processor        *proc           = nullptr;
+    T64CodePage         *pages          = nullptr;
+
+    std::atomic<bool>   curValid        = false;
+    T64Word             curVPage        = 0;
+    uint8_t             curPrivMode     = 0;
+    uint16_t            curTlbInfo      = 0;
+    T64CodePage         *curPage        = nullptr;
+
+    T64PerfBlock        *perf           = nullptr;
+};
+
+//----------------------------------------------------------------------------------------
+// The block translator. With the block option, a block entered often enough is 
+// translated into host code. The host code does what the instruction handlers
+// would do for the instructions of the block. The most used general registers
+// are kept in host registers while the block runs and the loads and stores to 
+// RAM pages in the direct memory map access host memory right away. Whenever
+// an instruction would trap or needs anything else, the host code leaves just 
+// before that instruction and the CPU continues with the handlers. The result
+// of a run holds the number of instructions done in the low half and the 
+// amount added to the low half of the instruction address in the upper half.
+//
+// The host code is placed in a code buffer owned by the CPU thread. The code is
+// only entered from a valid code cache slot, a code page purge therefore also 
+// drops the translations of the page. When the buffer is full, the code cache 
+// is purged and the buffer is used again from the start. The translator is for
+// x86-64 hosts, on other hosts no block is translated.
+//
+// With the verify option, the stores of a translated block run are journaled.
+// The CPU undoes them, runs the same instructions with the handlers and 
+// compares the results.
+//
+//----------------------------------------------------------------------------------------
+const int T64_JIT_THRESHOLD     = 32;
+const int T64_JIT_MAX_INSTRS    = 64;
+const int T64_JIT_CODE_BUF_SIZE = 1024 * 1024;
+
+struct T64JitStore {
+
+    uint8_t             *hostPtr    = nullptr;
+    int                 len         = 0;
+    uint8_t             oldData[ 8 ];
+    uint8_t             newData[ 8 ];
+};
+
+struct T64Jit {
+
+    public:
+
+    T64Jit( T64Processor *proc );
+
+    virtual         ~ T64Jit( );
+
+    void            reset( );
+    void            flush( );
+    T64JitCode      translate( T64DecodedInstr *dInstr, int *len );
+
+    private:
+
+    static bool     storeNotify( T64Jit *jit, T64Word pAdr, int len );
+    static void     journalStore( T64Jit *jit, uint8_t *hostPtr, int len );
+
+    bool            translateInstr( T64Instr instr, int k );
+    void            selectHostRegs( T64DecodedInstr *dInstr, int len );
+
+    void            emitByte( uint8_t val );
+    void            emitWord( uint32_t val );
+    void            emitLong( uint64_t val );
+    void            emitRex( bool w, int reg, int base );
+    void            emitRegReg( uint8_t op, int dst, int src );
+    void            emitRegImm( uint8_t ext, int dst, int32_t imm );
+    void            emitShift( uint8_t ext, int dst, int amt );
+    void            emitMem( uint8_t op, bool w, int reg, int base, int32_t disp );
+    void            emitLoadImm( int dst, T64Word val );
+    void            emitGetReg( int dst, int gReg );
+    void            emitSetReg( int gReg, int src );
+    void            emitAdrOfs( );
+    void            emitCall( uintptr_t fn );
+    void            emitExit( int cc, int count, uint32_t delta );
+    int             emitCompare( int cond, bool cmpVal2 );
+    void            emitMemAdr( T64Instr instr, int k, int len, bool store );
+
+    T64Processor        *proc           = nullptr;
+    T64Cpu              *cpu            = nullptr;
+    T64PerfBlock        *perf           = nullptr;
+    bool                verify          = false;
+
+    uint8_t             *codeBuf        = nullptr;
+    int                 codePos         = 0;
+    int                 codeLimit       = 0;
+    int                 exitCount       = 0;
+    int                 exitPos[ T64_JIT_MAX_INSTRS * 8 ];
+    uint64_t            exitVal[ T64_JIT_MAX_INSTRS * 8 ];
+    int                 regMap[ T64_MAX_GREGS ];
+
+    T64JitStore         journal[ T64_JIT_MAX_INSTRS ];
+    int                 journalLen      = 0;
+
+    friend struct   T64Cpu;
+};
+
+//----------------------------------------------------------------------------------------
+// The processor caches. A processor can have an instruction and a data cache,
+// which are set associative caches with 2, 4 or 8 ways and a pseudo LRU 
+// replacement within a set. A line is either shared, i.e. it is the same as in
+// memory and other caches may hold it too, or modified, i.e. this cache holds
+// the only valid copy. A write to a line that is not modified first obtains 
+// the line privately, which removes all other copies. Lines are written back 
+// when replaced or when the system asks for the line on behalf of another 
+// access. The IO address range is never cached.
+//
+// The owning CPU thread accesses the cache, the flush and purge requests can 
+// come from other threads. The cache lock protects the line data between the
+// two. A miss is handled with the system coherence lock held, so that no other
+// thread will send a request to this cache during the miss.
+//
+//----------------------------------------------------------------------------------------
+struct T64CacheLineInfo {
+
+    bool                valid       = false;
+    bool                modified    = false;
+    T64Word             tag         = 0;
+};
+
+struct T64Cache {
+
+    public:
+
+    T64Cache( T64Processor *proc, T64CacheKind cacheKind, T64CacheType cacheType );
+
+    virtual         ~ T64Cache( );
+
+    void            reset( );
+
+    bool            read( T64Word pAdr, uint8_t *data, int len );
+    bool            write( T64Word pAdr, uint8_t *data, int len );
+    void            flush( T64Word pAdr, int len );
+    void            purge( T64Word pAdr, int len );
+    void            flushAll( );
+
+    bool            getCacheLineByIndex( int              way,
+                                         int              set,
+                                         T64CacheLineInfo **info,
+                                         uint8_t          **data );
+
+    T64Word         getHits( );
+    T64Word         getMisses( );
+    T64Word         getWriteBacks( );
+
+    int             getWays( );
+    int             getSets( );
+    int             getLineSize( );
+    T64CacheKind    getCacheKind( );
+    T64CacheType    getCacheType( );
+    char            *getCacheTypeString( );
+
+    private:
+
+    T64Word         getTag( T64Word pAdr );
+    int             getSetIndex( T64Word pAdr );
+    int             getLineOfs( T64Word pAdr );
+    int             lookupWay( T64Word pAdr );
+    bool            fillLine( T64Word pAdr, bool wMode, int *way );
+    bool            writeBackLine( int way, int set );
+    void            releaseLine( int way, int set, bool remove );
+    void            releaseRange( T64Word pAdr, int len, bool remove );
+    int             plruVictim( int set );
+    void            plruUpdate( int set, int way );
+    void            lockCache( );
+    void            unlockCache( );
+
+    T64Processor        *proc           = nullptr;
+    T64CacheKind        cacheKind       = T64_CK_NIL;
+    T64CacheType        cacheType       = T64_CT_NIL;
+
+    T64CacheLineInfo    *cacheInfo      = nullptr;
+    uint8_t             *cacheData      = nullptr;
+    uint8_t             *plruState      = nullptr;
+
+    int                 ways            = 0;
+    int                 sets            = 0;
+    int                 lineSize        = 0;
+    int                 offsetBits      = 0;
+    int                 indexBits       = 0;
+    T64Word             offsetBitmask   = 0;
+    T64Word             indexBitmask    = 0;
+
+    T64PerfBlock        *perf           = nullptr;
+    int                 perfBase        = 0;
+
+    std::atomic<bool>   cLock           = false;
+};
+
+//----------------------------------------------------------------------------------------
+// Execution tracing. A processor can have a tracer, which records the executed 
+// instructions, register writes, data memory addresses and traps. The records
+// are kept in a ring buffer, which is written to a file by a background thread.
+// The CPU thread is the only producer and the writer thread the only consumer,
+// the ring needs no lock. When the ring is full, the CPU thread waits for the 
+// writer to make room, no record is ever dropped.
+//
+// A record is 16 bytes. The file starts with a header, followed by the records, 
+// both in host byte order. The record kinds are:
+//
+//  T64_TR_INSTR     - "val" is the instruction address, "data" the instruction.
+//  T64_TR_REG_WRITE - "aux" is the register number, "val" the register value.
+//  T64_TR_MEM_READ  - "aux" is the length, "val" the virtual address.
+//  T64_TR_MEM_WRITE - "aux" is the length, "val" the virtual address.
+//  T64_TR_TRAP      - "data" is the trap code, "val" the instruction address.
+//
+// The tracer is attached and detached while the processor is stopped. The 
+// creator owns the tracer, closing it writes the remaining records.
+//
+//----------------------------------------------------------------------------------------
+enum T64TraceKind : uint8_t {
+
+    T64_TR_NIL          = 0,
+    T64_TR_INSTR        = 1,
+    T64_TR_REG_WRITE    = 2,
+    T64_TR_MEM_READ     = 3,
+    T64_TR_MEM_WRITE    = 4,
+    T64_TR_TRAP         = 5
+};
+
+const uint32_t  T64_TRACE_VERSION       = 1;
+const int       T64_TRACE_RING_RECORDS  = 256 * 1024;
+
+struct T64TraceRecord {
+
+    uint8_t     kind;
+    uint8_t     aux;
+    uint16_t    modNum;
+    uint32_t    data;
+    T64Word     val;
+};
+
+struct T64TraceFileHeader {
+
+    char        magic[ 8 ];
+    uint32_t    version;
+    uint32_t    recordSize;
+    uint32_t    modNum;
+    uint32_t    reserved;
+};
+
+struct T64Tracer {
+
+    public:
+
+    T64Tracer( int modNum, int ringRecords = T64_TRACE_RING_RECORDS );
+
+    virtual         ~ T64Tracer( );
+
+    bool            open( const char *fileName );
+    void            close( );
+    bool            isOpen( );
+
+    void            record( T64TraceKind kind, uint8_t aux, uint32_t data, T64Word val );
+
+    T64Word         getRecords( );
+    T64Word         getWaits( );
+
+    private:
+
+    void            writerLoop( );
+    void            waitForSpace( uint64_t head );
+
+    T64TraceRecord          *ring           = nullptr;
+    uint64_t                ringMask        = 0;
+    int                     modNum          = 0;
+    FILE                    *file           = nullptr;
+
+    std::atomic<uint64_t>   head            = 0;
+    std::atomic<uint64_t>   tail            = 0;
+    std::atomic<bool>       stopWriter      = false;
+    std::thread             writer;
+
+    T64Word                 waits           = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// The producer side of the ring. This is called for each trace event by the CPU
+// thread, we keep it inline and short.
+//
+//----------------------------------------------------------------------------------------
+inline void T64Tracer::record( T64TraceKind kind, uint8_t aux, uint32_t data, T64Word val ) {
+
+    uint64_t h = head.load( std::memory_order_relaxed );
+
+    if ( h - tail.load( std::memory_order_acquire ) > ringMask ) waitForSpace( h );
 
-    T64Word         dTlbHits            = 0;
-    T64Word         dTlbMisses          = 0;
-    T64Word         dTlbMissGTlbHits    = 0;
-    T64Word         dTlbMissGTlbMisses  = 0; 
+    T64TraceRecord *r = &ring[ h & ringMask ];
+
+    r -> kind   = kind;
+    r -> aux    = aux;
+    r -> modNum = (uint16_t) modNum;
+    r -> data   = data;
+    r -> val    = val;
+
+    head.store( h + 1, std::memory_order_release );
+}
+
+//----------------------------------------------------------------------------------------
+// Execution profiling. A processor can have a profiler, which counts the
+// executed instructions by opcode, i.e. by the case of the instruction decode
+// switch, and the traps by trap code. Every "sampleRate" instructions, the 
+// instruction address is entered into a histogram, from which the hot spots 
+// are reported. 
+//
+// The CPU has a separate template instance of the instruction execution for 
+// profiling, the instance without profiling contains no profiling code at all.
+// The processor selects the instance once per batch of instructions. Like the
+// tracer, the profiler is attached while the processor is stopped and owned by
+// the creator.
+//
+//----------------------------------------------------------------------------------------
+const int T64_PROF_OPCODES      = 64;
+const int T64_PROF_TRAP_CODES   = 32;
+
+struct T64HotSpot {
+
+    T64Word             vAdr        = 0;
+    T64Instr            instr       = 0;
+    T64Word             count       = 0;
+};
+
+struct T64Profiler {
+
+    public:
+
+    T64Profiler( int sampleRate = 1 );
+
+    void            reset( );
+
+    void            countInstr( T64Word vAdr, T64Instr instr );
+    void            countTrap( T64TrapCode trapCode );
+
+    int             getSampleRate( );
+    T64Word         getInstrs( );
+    T64Word         getSamples( );
+    T64Word         getOpCodeCount( int opCode );
+    T64Instr        getOpCodeInstr( int opCode );
+    T64Word         getTrapCount( int trapCode );
+    int             getHotSpots( T64HotSpot *tab, int maxEntries );
+
+    private:
+
+    int             sampleRate                          = 1;
+    int             sampleLeft                          = 1;
+    T64Word         instrs                              = 0;
+    T64Word         samples                             = 0;
+    T64Word         opCodeCounts[ T64_PROF_OPCODES ]    = { };
+    T64Instr        opCodeInstr[ T64_PROF_OPCODES ]     = { };
+    T64Word         trapCounts[ T64_PROF_TRAP_CODES ]   = { };
+
+    std::unordered_map<T64Word, T64HotSpot> pcHistogram;
+};
+
+//----------------------------------------------------------------------------------------
+// Count an instruction. This is called for each instruction by the profiling 
+// instance of the CPU, we keep it inline and short.
+//
+//----------------------------------------------------------------------------------------
+inline void T64Profiler::countInstr( T64Word vAdr, T64Instr instr ) {
+
+    int opCode = extractInstrOpCode( instr );
+
+    instrs ++;
+    opCodeCounts[ opCode ] ++;
+    opCodeInstr[ opCode ] = instr;
+
+    if ( -- sampleLeft == 0 ) {
+
+        T64HotSpot *h = &pcHistogram[ vAdr ];
+
+        h -> vAdr   = vAdr;
+        h -> instr  = instr;
+        h -> count ++;
+
+        samples ++;
+        sampleLeft = sampleRate;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Breakpoints and watchpoints. A processor has a table of break entries. An 
+// instruction breakpoint stops the processor before the instruction at its 
+// address executes. A watchpoint stops the processor after the instruction that
+// read or wrote data in its address range. The addresses are the addresses the 
+// CPU uses, i.e. virtual addresses or physical addresses in the physical range.
+// A stop is reported as the DEBUG_BREAK_EVENT code, which halts the processor 
+// whether it halts on traps or not. When execution resumes at the address of 
+// the instruction breakpoint that stopped it, that breakpoint does not fire 
+// again for the first instruction.
+//
+// An entry can have a condition. The simulator compiles its expression once to
+// a small stack machine code, which is evaluated by the CPU thread each time the
+// entry matches. The operands are numbers, the general and control registers 
+// and the PSR fields of the processor. The result is true when the top of the 
+// stack is not zero.
+//
+// When no entry is set, breakpoints cost nothing. The processor then runs the
+// batch instance without the instruction address check, and the page filter 
+// bits for the data accesses are all clear. Each filter bit stands for every 
+// 64th page, a data access only looks at the watchpoints when the bit for its 
+// page is set. The instruction addresses are filtered the same way.
+//
+// The table is changed while the processor is stopped. A processor reset 
+// keeps the entries but forgets a pending hit.
+//
+//----------------------------------------------------------------------------------------
+enum T64BreakKind : uint8_t {
+
+    T64_BK_NIL          = 0,
+    T64_BK_INSTR        = 1,
+    T64_BK_READ         = 2,
+    T64_BK_WRITE        = 3,
+    T64_BK_ACCESS       = 4
+};
+
+enum T64BreakCondOp : uint8_t {
+
+    T64_BC_NIL          = 0,
+    T64_BC_NUM          = 1,
+    T64_BC_GREG         = 2,
+    T64_BC_CREG         = 3,
+    T64_BC_IA           = 4,
+    T64_BC_ST           = 5,
+    T64_BC_NEG          = 6,
+    T64_BC_LNOT         = 7,
+    T64_BC_ADD          = 8,
+    T64_BC_SUB          = 9,
+    T64_BC_MUL          = 10,
+    T64_BC_DIV          = 11,
+    T64_BC_MOD          = 12,
+    T64_BC_AND          = 13,
+    T64_BC_OR           = 14,
+    T64_BC_XOR          = 15,
+    T64_BC_LAND         = 16,
+    T64_BC_LOR          = 17,
+    T64_BC_EQ           = 18,
+    T64_BC_NE           = 19,
+    T64_BC_LT           = 20,
+    T64_BC_LE           = 21,
+    T64_BC_GT           = 22,
+    T64_BC_GE           = 23
+};
+
+const int T64_MAX_BREAKS            = 16;
+const int T64_BREAK_COND_CODE_LEN   = 48;
+const int T64_BREAK_COND_STACK_SIZE = 16;
+const int T64_BREAK_PAGE_BITS       = 64;
+
+struct T64BreakCondInstr {
+
+    T64BreakCondOp      op          = T64_BC_NIL;
+    uint8_t             reg         = 0;
+    T64Word             val         = 0;
+};
+
+struct T64BreakCond {
+
+    int                 len         = 0;
+    T64BreakCondInstr   code[ T64_BREAK_COND_CODE_LEN ];
+};
+
+struct T64BreakEntry {
+
+    T64BreakKind        kind        = T64_BK_NIL;
+    T64Word             adr         = 0;
+    T64Word             len         = 0;
+    T64Word             hits        = 0;
+    T64BreakCond        cond;
+};
+
+struct T64BreakHit {
+
+    int                 index       = -1;
+    T64BreakKind        kind        = T64_BK_NIL;
+    T64Word             instrAdr    = 0;
+    T64Word             dataAdr     = 0;
+};
+
+struct T64BreakTable {
+
+    public:
+
+    T64BreakTable( T64Processor *proc );
+
+    void            reset( );
+    void            clearHit( );
+
+    int             setBreak( T64BreakKind kind, 
+                              T64Word adr, 
+                              T64Word len, 
+                              const T64BreakCond *cond = nullptr );
+
+    bool            removeBreak( int index );
+    void            removeAll( );
+
+    T64BreakEntry   *getBreak( int index );
+    bool            getLastHit( T64BreakHit *hit );
+    bool            isActive( );
+
+    bool            checkInstr( T64Word vAdr );
+    void            checkData( T64Word vAdr, int len, bool wMode );
+    bool            takeDataHit( );
+
+    static bool     validCond( const T64BreakCond *cond );
+
+    private:
+
+    bool            evalCond( const T64BreakCond *cond );
+    void            setFilterBits( );
+    void            enterHit( int index, T64Word instrAdr, T64Word dataAdr );
+
+    T64Processor    *proc                       = nullptr;
+    T64BreakEntry   entries[ T64_MAX_BREAKS ];
+    int             instrBreaks                 = 0;
+    int             watchPoints                 = 0;
+    uint64_t        instrPageBits               = 0;
+    T64Word         resumeAdr                   = -1;
+    bool            dataHit                     = false;
+    bool            hitValid                    = false;
+    T64BreakHit     lastHit                     = { };
+};
+
+//----------------------------------------------------------------------------------------
+// The filter bit for the page of an address. This is called for each data access
+// by the CPU, we keep it inline and short.
+//
+//----------------------------------------------------------------------------------------
+inline uint64_t breakPageBit( T64Word adr ) {
+
+    return( 1ULL << (( adr / T64_PAGE_SIZE_BYTES ) & ( T64_BREAK_PAGE_BITS - 1 )));
+}
+
+//----------------------------------------------------------------------------------------
+// The direct memory map. For data accesses to RAM, the CPU can bypass the 
+// bus operations and access the host memory of the memory module directly. 
+// The map is a small direct mapped table, indexed by the physical page number,
+// that remembers the host address of a page and whether stores can go there 
+// directly. An entry only becomes writable with the first store to the page, 
+// which lets the memory module mark the page dirty. A page that is not covered
+// by host memory, such as the IO address range, is not entered and the access
+// goes through the bus operations. 
+//
+// The map is purged on a module purge, since the module owning the memory could
+// be gone. The purge request can come from another thread, it only sets a flag
+// and the CPU thread clears the entries on its next access.
+//
+//----------------------------------------------------------------------------------------
+const int T64_DIRECT_MEM_MAP_ENTRIES = 64;
+
+struct T64DirectMemEntry {
+
+    T64Word             pAdr        = -1;
+    uint8_t             *hostPtr    = nullptr;
+    bool                writable    = false;
 };
 
 //----------------------------------------------------------------------------------------
@@ -165,6 +905,11 @@ struct T64Cpu {
     void            reset( );
     T64TrapCode     executeInstr( );
 
+    template <bool PROFILE>
+    T64TrapCode     executeInstrT( );
+    T64TrapCode     executeBlock( int units, int *done );
+    bool            handleExtInterrupts( );
+
     T64Word         getGeneralReg( int index );
     void            setGeneralReg( int index, T64Word val );
 
@@ -174,10 +919,25 @@ struct T64Cpu {
     T64Word         getPsrReg( );
     void            setPsrReg( T64Word val );
 
+    void            purgeDirectMem( );
+
+    void            setTiming( const T64TimingConfig *cfg );
+    T64Word         getInstrCycles( );
+
+    void            saveState( T64Snapshot *snap );
+    bool            restoreState( T64Snapshot *snap );
+
     private: 
 
     int             evalCond( int cond, T64Word val1, T64Word val2 );
 
+    void            raiseTrap( T64TrapCode code, T64Word arg0, T64Word arg1 );
+    bool            trapPending( );
+    T64TrapCode     deliverTrap( const T64Trap &t );
+
+    bool            executeJit( T64DecodedInstr *dInstr, int units, int *done );
+    bool            verifyJit( T64DecodedInstr *dInstr, int *done );
+
     void            machineCheckTrap( T64Word adr );
     void            privModeOperationTrap( );
 
@@ -214,18 +974,32 @@ struct T64Cpu {
     T64Word         getRegA( uint32_t instr );
     void            setRegR( uint32_t instr, T64Word val );
    
+    T64Word         instrTranslate( T64Word vAdr );
     T64Word         instrRead( T64Word vAdr );
+    T64DecodedInstr *instrReadDecoded( T64Word vAdr );
+    T64InstrHandler decodeInstr( T64Instr instr );
     T64Word         dataRead( T64Word vAdr, int len, bool sExt, bool rsv = false );
     T64Word         dataReadRegBOfsImm13( uint32_t instr, bool sExt, bool rsv = false );
     T64Word         dataReadRegBOfsRegX( uint32_t instr, bool sExt );
 
+    template <int LEN>
+    T64Word         dataReadT( T64Word vAdr, bool sExt, bool rsv );
+
+    uint8_t         *directMemPtr( T64Word pAdr, bool wMode );
+
     bool            dataWrite( T64Word vAdr, T64Word val, int len, bool cond = false );
     bool            dataWriteRegBOfsImm13( uint32_t instr, bool cond = false );
     bool            dataWriteRegBOfsRegX( uint32_t instr );
 
+    template <int LEN>
+    bool            dataWriteT( T64Word vAdr, T64Word val, bool cond );
+
+    void            instrIllegalOp( T64Instr instr );
     void            instrAluNopOp( T64Instr instr );
+    template <bool IMM>
     void            instrAluAddOp( T64Instr instr );
     void            instrMemAddOp( T64Instr instr );
+    template <bool IMM>
     void            instrAluSubOp( T64Instr instr );
     void            instrMemSubOp( T64Instr instr );
     void            instrAluAndOp( T64Instr instr );
@@ -234,14 +1008,17 @@ struct T64Cpu {
     void            instrMemOrOp( T64Instr instr );
     void            instrAluXorOp( T64Instr instr );
     void            instrMemXorOp( T64Instr instr );
+    template <int COND, bool IMM>
     void            instrAluCmpOp( T64Instr instr );
     void            instrMemCmpOp( T64Instr instr );
     void            instrAluBitOp( T64Instr instr );
     void            instrAluShaOP( T64Instr instr );
     void            instrAluImmOp( T64Instr instr );
     void            instrAluLdoOp( T64Instr instr );
+    template <int DW, bool INDEX, bool SEXT>
     void            instrMemLdOp( T64Instr instr );
     void            instrMemLdrOp( T64Instr instr);
+    template <int DW, bool INDEX>
     void            instrMemStOp( T64Instr instr );
     void            instrMemStcOp( T64Instr instr );
     void            instrBrBOp( T64Instr instr );
@@ -249,8 +1026,11 @@ struct T64Cpu {
     void            instrBrBrOp( T64Instr instr );
     void            instrBrBvOp( T64Instr instr );
     void            instrBrBbOp( T64Instr instr );
+    template <int COND>
     void            instrBrAbrOp( T64Instr instr );
+    template <int COND>
     void            instrBrCbrOp( T64Instr instr );
+    template <int COND>
     void            instrBrMbrOp( T64Instr instr );
     void            instrSysMrOp( T64Instr instr );
     void            instrSysLpaOp( T64Instr instr );
@@ -262,9 +1042,6 @@ struct T64Cpu {
     void            instrSysDiagOp( T64Instr instr );
     void            instrSysTrapOp( T64Instr instr );
 
-   
-    void            handleExtInterrupts( );  // ??? will go out ?
-
     T64Word         diagOpHandler( int opt, T64Word arg1, T64Word arg2 );
 
     T64Word         cRegFile[ T64_MAX_CREGS ];
@@ -276,11 +1053,155 @@ struct T64Cpu {
     T64CpuType      cpuType         = T64_CPU_T_NIL;
     T64Word         physMemSize     = T64_MAX_PHYS_MEM_LIMIT;
     T64Processor    *proc           = nullptr;
+    T64Trap         pendingTrap     = T64Trap( NO_TRAP );
+
+    bool                directMemEnabled    = false;
+    bool                timingEnabled       = false;
+    T64Word             groupCycles[ 4 ]    = { 0, 0, 0, 0 };
+    T64Word             instrCycles         = 0;
+    std::atomic<bool>   directMemPurged     = false;
+    T64DirectMemEntry   directMem[ T64_DIRECT_MEM_MAP_ENTRIES ];
+
+    uint64_t            watchPageBits       = 0;
+
+    friend struct   T64CodeCache;
+    friend struct   T64BreakTable;
+    friend struct   T64Jit;
+};
+
+//----------------------------------------------------------------------------------------
+// Sampling simulation. For architecture studies a processor can fast forward 
+// through the uninteresting part of a program and then measure a region with 
+// the detailed path. The simulation modes are:
+//
+//  T64_SM_NORMAL   - the configured execution path, nothing is sampled. This is
+//                    the default and the mode after the last sample.
+//  T64_SM_FAST     - the fast functional path, i.e. predecoded instructions if
+//                    the processor has a code cache. Not measured.
+//  T64_SM_WARMUP   - the detailed path, i.e. each instruction is fetched through
+//                    the instruction cache and decoded. Not measured.
+//  T64_SM_DETAILED - the detailed path. The TLB and cache counters are measured.
+//
+// The caches and TLBs are used in all modes. They are therefore already warm 
+// when a region starts, the warmup phase brings the remaining state, such as a
+// reservation or the ITLB entries for the detailed path, into a steady state.
+//
+// Fast forwarding ends when one of the configured triggers fires: a number of 
+// instructions, reaching an instruction address, or a DIAG instruction with the
+// T64_DIAG_SAMPLE_TRIGGER option. For the instruction count trigger the warmup 
+// phase is the last "warmInstrs" instructions before the trigger, for the other
+// triggers it follows the trigger. Without any trigger, sampling starts with 
+// the warmup phase right away. A region of "sampleInstrs" instructions, zero 
+// means until the end, is measured. With a sample gap, the sequence of fast 
+// forward, warmup and measured region repeats every "sampleGap" plus 
+// "sampleInstrs" instructions, so that the counters for a full workload can be
+// estimated from the samples.
+//
+// The sample configuration is set while the processor is stopped. A reset 
+// starts the sampling schedule again.
+//
+//----------------------------------------------------------------------------------------
+enum T64SimMode : int {
+
+    T64_SM_NORMAL       = 0,
+    T64_SM_FAST         = 1,
+    T64_SM_WARMUP       = 2,
+    T64_SM_DETAILED     = 3
+};
+
+const int T64_DIAG_SAMPLE_TRIGGER = 1;
+
+//----------------------------------------------------------------------------------------
+// Idle hints. A guest that waits for something can tell with a DIAG instruction
+// with the T64_DIAG_WAIT option. The general register B value is the timeout in
+// microseconds, zero means no timeout. When the guest loaded the location it 
+// polls with a LDR instruction before, a store to that memory line ends the 
+// wait. A branch to itself is an idle loop as well, it waits without timeout.
+// The hint takes effect when the current batch of instructions is done, the
+// processor thread is then parked. To the guest, a wait can end at any time,
+// it needs to check the condition it waits for again.
+//
+//----------------------------------------------------------------------------------------
+const int T64_DIAG_WAIT = 2;
+
+struct T64SampleConfig {
+
+    T64Word     ffInstrs        = 0;
+    T64Word     ffPc            = -1;
+    bool        ffDiag          = false;
+    T64Word     warmInstrs      = 0;
+    T64Word     sampleInstrs    = 0;
+    T64Word     sampleGap       = 0;
+};
+
+struct T64SampleStats {
+
+    T64Word     instrs          = 0;
+    T64Word     fastInstrs      = 0;
+    T64Word     warmInstrs      = 0;
+    T64Word     detailInstrs    = 0;
+    T64Word     samples         = 0;
+
+    T64Word     iTlbHits        = 0;
+    T64Word     iTlbMisses      = 0;
+    T64Word     dTlbHits        = 0;
+    T64Word     dTlbMisses      = 0;
+    T64Word     iCacheHits      = 0;
+    T64Word     iCacheMisses    = 0;
+    T64Word     dCacheHits      = 0;
+    T64Word     dCacheMisses    = 0;
+    T64Word     dCacheWriteBacks = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// Timing model. The simulator is functional, an instruction and its memory
+// accesses complete in one step. With the timing option, the processor also 
+// estimates the cycles a real processor would need. Each instruction costs the
+// cycles configured for its instruction group. On top of that, each TLB and
+// cache event counted in the performance counters adds its cycles. These are
+// a local TLB miss served by the global TLB, a miss in the global TLB as well,
+// the cache hits, misses and write backs, and the traps. Since the events are
+// counted anyway, only the instruction group cycles cost time per instruction.
+//
+// The estimate is the cycles performance counter and is readable by the guest
+// in the CTL_REG_CYCLES control register. Both are brought up to date after 
+// each batch and when the guest reads the register.
+//
+//----------------------------------------------------------------------------------------
+struct T64TimingConfig {
+
+    int         groupCycles[ 4 ]    = { 1, 2, 2, 4 };
+    int         gTlbHitCycles       = 10;
+    int         gTlbMissCycles      = 40;
+    int         cacheHitCycles      = 0;
+    int         cacheMissCycles     = 20;
+    int         cacheWBackCycles    = 20;
+    int         trapCycles          = 10;
+};
+
+//----------------------------------------------------------------------------------------
+// Live state view. While a processor runs, its registers belong to the thread
+// executing it. Once somebody asked for a view, the processor publishes a copy
+// of its registers when a batch is done. There are two buffers, each with a 
+// sequence number that is odd while the buffer is written. The processor 
+// writes the buffer not published last, so a reader copying the published one
+// rarely collides with it. A reader that sees the sequence number change during
+// its copy just tries again. The view is consistent and at most one batch old, 
+// and the reader never holds up the processor. For a processor that does not
+// execute, the view is taken from the CPU directly.
+//
+//----------------------------------------------------------------------------------------
+struct T64ProcStateView {
+
+    T64Word     psr                         = 0;
+    T64Word     gRegs[ T64_MAX_GREGS ]      = { 0 };
+    T64Word     cRegs[ T64_MAX_CREGS ]      = { 0 };
+    T64Word     instrs                      = 0;
 };
 
 //----------------------------------------------------------------------------------------
 // The CPU core executes the instructions. A processor module contains the CPU 
-// core, TLBs and one day caches. The processor module connects to the system 
+// core, TLBs and optional caches. The processor module connects to the system 
 // bus for memory and IO access. The unit is a single step, i.e. one instruction. 
 //
 //----------------------------------------------------------------------------------------
@@ -300,6 +1221,7 @@ struct T64Processor : T64ProcThreadModule {
     void            initModule( ) override;
     void            resetModule( ) override;
     T64TrapCode     executeUnit( ) override;
+    T64TrapCode     executeUnits( int units, bool haltOnTrap, int *done ) override;
 
     bool            busOpRead( T64Word adr, uint8_t *data, int len );
     bool            busOpReadRsv( T64Word adr, uint8_t *data, int len );
@@ -310,6 +1232,10 @@ struct T64Processor : T64ProcThreadModule {
                                   T64Word            arg1, 
                                   T64Word            arg2 );
 
+    bool            busOpReadSharedBlock( T64Word adr, uint8_t *data, int len );
+    bool            busOpReadPrivateBlock( T64Word adr, uint8_t *data, int len );
+    bool            busOpWriteBlock( T64Word adr, uint8_t *data, int len );
+
     bool            busOpReadEvent( T64Word pAdr, 
                                     uint8_t *data, 
                                     int len ) override;
@@ -321,12 +1247,39 @@ struct T64Processor : T64ProcThreadModule {
     bool            busOpControlEvent( T64BBusOpControlEvents id, 
                                        T64Word            arg1, 
                                        T64Word            arg2 ) override;
+
+    uint32_t        getControlEventMask( ) override;
+    void            controlEventOverflow( ) override;
+    bool            takeIdleRequest( T64Word *timeoutUs ) override;
                         
     T64Cpu          *getCpuPtr( );
     T64LocalTlb     *getLocalTlbPtr( );
+    T64CodeCache    *getCodeCachePtr( );
+    T64Cache        *getICachePtr( );
+    T64Cache        *getDCachePtr( );
     char            *getProcStateStr( );
     T64GlobalTlb    *getGlobalTlbPtr( );
 
+    void            setTracer( T64Tracer *tracer );
+    T64Tracer       *getTracer( );
+
+    void            setProfiler( T64Profiler *profiler );
+    T64Profiler     *getProfiler( );
+
+    T64BreakTable   *getBreakTablePtr( );
+
+    void            setSampleConfig( const T64SampleConfig &cfg );
+    void            getSampleStats( T64SampleStats *stats );
+    T64SimMode      getSimMode( );
+
+    void            setTimingConfig( const T64TimingConfig &cfg );
+    T64Word         getCycles( );
+
+    bool            saveState( T64Snapshot *snap ) override;
+    bool            restoreState( T64Snapshot *snap ) override;
+
+    bool            getStateView( T64ProcStateView *view );
+
 private:
 
     bool            handleHPARead( T64Word pAdr, uint8_t *data, int len );
@@ -336,10 +1289,60 @@ private:
                                         T64Word             arg1, 
                                         T64Word             arg2);
 
+    void            snoopCaches( T64BBusOpControlEvents event, T64Word pAdr, int len );
+
+    template <bool PROFILE, bool BREAKS>
+    T64TrapCode     executeUnitsT( int units, bool haltOnTrap, int *done );
+    bool            useBlocks( );
+
+    void            startSampling( );
+    void            sampleStep( );
+    void            enterSimMode( T64SimMode mode );
+    void            readSampleCounters( T64SampleStats *stats );
+    void            addSampleCounters( T64SampleStats *stats );
+    void            requestIdle( T64Word timeoutUs );
+    void            serviceEvents( );
+    void            publishState( );
+    void            copyState( T64ProcStateView *view );
+    void            updateCycles( );
+    void            resetCycles( );
+
     friend struct   T64Cpu;
+    friend struct   T64CodeCache;
+    friend struct   T64Cache;
+    friend struct   T64BreakTable;
+    friend struct   T64Jit;
 
     T64System       *sys                    = nullptr;
     T64Cpu          *cpu                    = nullptr;
     T64LocalTlb     *localTlb               = nullptr;
     T64GlobalTlb    *globalTlb              = nullptr;
+    T64CodeCache    *codeCache              = nullptr;
+    T64Jit          *jit                    = nullptr;
+    T64Cache        *iCache                 = nullptr;
+    T64Cache        *dCache                 = nullptr;
+    T64Tracer       *tracer                 = nullptr;
+    T64Profiler     *profiler               = nullptr;
+    T64BreakTable   *breaks                 = nullptr;
+    T64EventQueue   *events                 = nullptr;
+    T64Options      options                 = T64_PO_NIL;
+
+    T64TimingConfig timingCfg               = { };
+    T64Word         cycleBase[ T64_PC_MAX ] = { };
+    T64Word         eventCycles             = 0;
+    T64SampleConfig sampleCfg               = { };
+    T64SampleStats  sampleStats             = { };
+    T64SampleStats  sampleBase              = { };
+    T64SimMode      simMode                 = T64_SM_NORMAL;
+    bool            sampleActive            = false;
+    bool            detailedPath            = false;
+    bool            diagTrigger             = false;
+    bool            idleReq                 = false;
+    T64Word         idleTimeout             = 0;
+    T64Word         modeInstrsLeft          = 0;
+
+    T64ProcStateView        viewBuf[ 2 ];
+    std::atomic<uint32_t>   viewSeq[ 2 ]    = { 0, 0 };
+    std::atomic<int>        viewCur         { 0 };
+    std::atomic<bool>       viewActive      { false };
 };
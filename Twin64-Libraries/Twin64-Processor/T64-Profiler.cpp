@@ -0,0 +1,134 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Execution profiler
+//
+//----------------------------------------------------------------------------------------
+// The profiler counts the executed instructions by opcode and the traps by trap
+// code. A sampled instruction address histogram shows where the time goes. The
+// counting itself is done inline, this file contains the setup and the report
+// routines.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Execution profiler
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License along with
+// this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-Processor.h"
+
+#include <algorithm>
+#include <vector>
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Profiler.
+//
+//----------------------------------------------------------------------------------------
+// The profiler object. A sample rate of one enters every instruction into the 
+// address histogram.
+//
+//----------------------------------------------------------------------------------------
+T64Profiler::T64Profiler( int sampleRate ) {
+
+    this -> sampleRate = ( sampleRate < 1 ) ? 1 : sampleRate;
+    reset( );
+}
+
+void T64Profiler::reset( ) {
+
+    instrs      = 0;
+    samples     = 0;
+    sampleLeft  = sampleRate;
+
+    memset( opCodeCounts, 0, sizeof( opCodeCounts ));
+    memset( opCodeInstr, 0, sizeof( opCodeInstr ));
+    memset( trapCounts, 0, sizeof( trapCounts ));
+    pcHistogram.clear( );
+}
+
+//----------------------------------------------------------------------------------------
+// Count a trap. Traps are rare compared to instructions, this is called by the
+// trap delivery for both CPU instances.
+//
+//----------------------------------------------------------------------------------------
+void T64Profiler::countTrap( T64TrapCode trapCode ) {
+
+    if (( trapCode >= 0 ) && ( trapCode < T64_PROF_TRAP_CODES )) trapCounts[ trapCode ] ++;
+}
+
+//----------------------------------------------------------------------------------------
+// Getters.
+//
+//----------------------------------------------------------------------------------------
+int T64Profiler::getSampleRate( ) {
+
+    return( sampleRate );
+}
+
+T64Word T64Profiler::getInstrs( ) {
+
+    return( instrs );
+}
+
+T64Word T64Profiler::getSamples( ) {
+
+    return( samples );
+}
+
+T64Word T64Profiler::getOpCodeCount( int opCode ) {
+
+    if (( opCode < 0 ) || ( opCode >= T64_PROF_OPCODES )) return( 0 );
+    return( opCodeCounts[ opCode ] );
+}
+
+T64Instr T64Profiler::getOpCodeInstr( int opCode ) {
+
+    if (( opCode < 0 ) || ( opCode >= T64_PROF_OPCODES )) return( 0 );
+    return( opCodeInstr[ opCode ] );
+}
+
+T64Word T64Profiler::getTrapCount( int trapCode ) {
+
+    if (( trapCode < 0 ) || ( trapCode >= T64_PROF_TRAP_CODES )) return( 0 );
+    return( trapCounts[ trapCode ] );
+}
+
+//----------------------------------------------------------------------------------------
+// Return the hot spots, i.e. the most sampled instruction addresses, sorted by
+// decreasing sample count. The number of entries returned is the function 
+// result. 
+//
+//----------------------------------------------------------------------------------------
+int T64Profiler::getHotSpots( T64HotSpot *tab, int maxEntries ) {
+
+    std::vector<T64HotSpot> spots;
+
+    spots.reserve( pcHistogram.size( ));
+    for ( auto &e : pcHistogram ) spots.push_back( e.second );
+
+    int n = std::min((int) spots.size( ), maxEntries );
+
+    std::partial_sort( spots.begin( ), 
+                       spots.begin( ) + n, 
+                       spots.end( ),
+                       [ ]( const T64HotSpot &a, const T64HotSpot &b ) {
+                           
+                           return( a.count > b.count );
+                       });
+
+    for ( int i = 0; i < n; i++ ) tab[ i ] = spots[ i ];
+    return( n );
+}
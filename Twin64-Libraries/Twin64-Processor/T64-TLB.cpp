@@ -10,6 +10,11 @@
 // in the unified TLB will trigger a TLB miss trap. The TLB supports a locked
 // entry, which is not replaced by the LRU mechanism. 
 //
+// The small TLBs can also be 4-way set associative, which allows for larger 
+// local TLBs without a longer search. Each page size has its own set index, 
+// only the sets for the page sizes in use are searched. The last translation
+// of each TLB is kept in a one entry micro TLB, which is checked first.
+//
 //----------------------------------------------------------------------------------------
 //
 // T64 - A 64-bit Processor - TLB
@@ -70,6 +75,72 @@ T64TlbEntry* lookup( T64TlbEntry *tlb, uint32_t tlbSize, T64Word  vAdr ) {
     return ( nullptr );
 }
 
+//----------------------------------------------------------------------------------------
+// Search a set associative TLB. For each page size in use, the set selected by
+// the virtual address is searched.
+//
+//----------------------------------------------------------------------------------------
+T64TlbEntry* lookupSa( T64TlbEntry  *tlb, 
+                       int          sets, 
+                       uint32_t     pageSizesUsed, 
+                       T64Word      vAdr ) {
+
+    for ( int pSize = 0; pSize < T64_TLB_PAGE_SIZES; pSize++ ) {
+
+        if ( ! ( pageSizesUsed & ( 1U << pSize ))) continue;
+
+        T64TlbEntry *set = &tlb[ tlbSetIndex( vAdr, pSize, sets ) * T64_TLB_SA_WAYS ];
+
+        for ( int i = 0; i < T64_TLB_SA_WAYS; i++ ) {
+
+            if (( tlbInfoIsValid( set[ i ].tlbInfo )) &&
+                ( tlbInfoPageSize( set[ i ].tlbInfo ) == pSize ) &&
+                (( vAdr & set[ i ].pageMask ) == set[ i ].vAdr )) {
+                
+                return ( &set[ i ] );
+            }
+        }
+    }
+
+    return ( nullptr );
+}
+
+//----------------------------------------------------------------------------------------
+// Enter a translation into a set associative TLB. We use a free way of the set
+// or replace one in round robin fashion.
+//
+//----------------------------------------------------------------------------------------
+void insertSa( T64TlbEntry  *tlb, 
+               int          sets, 
+               uint32_t     *pageSizesUsed, 
+               uint32_t     *roundRobin,
+               T64TlbEntry  *entry ) {
+
+    int         pSize = tlbInfoPageSize( entry -> tlbInfo );
+    T64TlbEntry *set  = &tlb[ tlbSetIndex( entry -> vAdr, pSize, sets ) * T64_TLB_SA_WAYS ];
+    int         way   = 0;
+
+    while (( way < T64_TLB_SA_WAYS ) && ( tlbInfoIsValid( set[ way ].tlbInfo ))) way ++;
+
+    if ( way == T64_TLB_SA_WAYS ) {
+        
+        way = ( *roundRobin ) & ( T64_TLB_SA_WAYS - 1 );
+        ( *roundRobin ) ++;
+    }
+
+    set[ way ]      = *entry;
+    *pageSizesUsed |= ( 1U << pSize );
+}
+
+//----------------------------------------------------------------------------------------
+// Check the micro TLB entry.
+//
+//----------------------------------------------------------------------------------------
+bool isMicroTlbHit( T64TlbEntry *e, T64Word vAdr ) {
+
+    return(( tlbInfoIsValid( e -> tlbInfo )) && (( vAdr & e -> pageMask ) == e -> vAdr ));
+}
+
 } // namespace
 
 
@@ -80,7 +151,8 @@ T64TlbEntry* lookup( T64TlbEntry *tlb, uint32_t tlbSize, T64Word  vAdr ) {
 //
 //----------------------------------------------------------------------------------------
 // Object creator. Based on kind and type of TLB, we allocate the local TLB data
-// structure. 
+// structure. The default is a fully associative TLB of four entries, the set 
+// associative types use four ways. 
 //
 //----------------------------------------------------------------------------------------
 T64LocalTlb::T64LocalTlb( T64Processor *proc, 
@@ -88,11 +160,19 @@ T64LocalTlb::T64LocalTlb( T64Processor *proc,
                           T64TlbType tlbType ) {
 
     this -> proc    = proc;
+    this -> perf    = proc -> getPerfBlock( );
     this -> tlbKind = tlbKind;
     this -> tlbType = tlbType;
 
-    iTlbEntries = 4;
-    dTlbEntries = 4;
+    switch ( tlbType ) {
+
+        case T64_TT_SA_64U:     iTlbEntries = 64;  break;
+        case T64_TT_SA_256U:    iTlbEntries = 256; break;
+        default:                iTlbEntries = 4;
+    }
+
+    dTlbEntries = iTlbEntries;
+    tlbSets     = ( iTlbEntries > 4 ) ? iTlbEntries / T64_TLB_SA_WAYS : 1;
     tlbConfig   = 0;
 
     iTlb = (T64TlbEntry *) calloc( iTlbEntries, sizeof( T64TlbEntry ));
@@ -114,131 +194,200 @@ T64LocalTlb::~T64LocalTlb( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Reset the local TLB.
+// Reset the local TLB. All entries are purged and the TLB statistics counters
+// are cleared.
 //
 //----------------------------------------------------------------------------------------
 void T64LocalTlb::reset( ) {
     
+    purgeAll( );
+    
+    for ( int i = T64_PC_ITLB_HITS; i <= T64_PC_DTLB_GTLB_MISSES; i++ ) perf -> set( i, 0 );
+}
+
+//----------------------------------------------------------------------------------------
+// Purge all entries of both TLBs and the micro TLBs. The statistics counters 
+// are left alone, this is a runtime operation and not a reset.
+//
+//----------------------------------------------------------------------------------------
+void T64LocalTlb::purgeAll( ) {
+    
     for ( int i = 0; i < iTlbEntries; i++ ) resetTlbEntry( &iTlb[ i ] );
     for ( int i = 0; i < dTlbEntries; i++ ) resetTlbEntry( &dTlb[ i ] );
+
+    resetTlbEntry( &iTlbLast );
+    resetTlbEntry( &dTlbLast );
      
     iTlbRoundRobin      = 0;            
-    
-    iTlbHits            = 0;
-    iTlbMisses          = 0;
-    iTlbMissGTlbHits    = 0;
-    iTlbMissGTlbMisses  = 0;
-
-    dTlbHits            = 0;
-    dTlbMisses          = 0;
-    dTlbMissGTlbHits    = 0;
-    dTlbMissGTlbMisses  = 0;
+    dTlbRoundRobin      = 0;            
+    iPageSizesUsed      = 0;
+    dPageSizesUsed      = 0;
 }
 
 //----------------------------------------------------------------------------------------
-// Lookup a Instruction TLB. If we do not find the entry in the L1, we consult 
-// the unified TLB buffer and if a translation is found, the L1 buffer is updated.
-// The entry to update is found via a simple round robin selection. Instruction
-// fetch tends to be rather serial in contrast to a data TLB.
+// Lookup a Instruction TLB. The micro TLB holds the last translation and is 
+// checked first. If we do not find the entry in the L1, we consult the unified
+// TLB buffer and if a translation is found, the L1 buffer is updated. For a 
+// fully associative TLB, the entry to update is found via a simple round robin
+// selection. Instruction fetch tends to be rather serial in contrast to a data
+// TLB.
 //  
 //----------------------------------------------------------------------------------------
 bool T64LocalTlb::lookupItlb( T64Word vAdr, T64Word *pAdr, uint16_t *tlbInfo ) {
+
+    if ( isMicroTlbHit( &iTlbLast, vAdr )) {
+
+        *pAdr    = iTlbLast.pAdr | ( vAdr & ~ iTlbLast.pageMask );  
+        *tlbInfo = iTlbLast.tlbInfo;
+        perf -> inc( T64_PC_ITLB_HITS );
+        return ( true );
+    }
     
-    T64TlbEntry *e = lookup( iTlb, iTlbEntries, vAdr );
+    T64TlbEntry *e = ( tlbSets == 1 ) ? 
+        lookup( iTlb, iTlbEntries, vAdr ) : 
+        lookupSa( iTlb, tlbSets, iPageSizesUsed, vAdr );
+
     if ( e != nullptr ) {
 
+        iTlbLast = *e;
         *pAdr    = e -> pAdr | ( vAdr & ~ e -> pageMask );  
         *tlbInfo = e -> tlbInfo;
-        iTlbHits ++;
+        perf -> inc( T64_PC_ITLB_HITS );
         return ( true );
     }
     
-    iTlbMisses ++;
+    perf -> inc( T64_PC_ITLB_MISSES );
 
     T64GlobalTlb *gTlb = proc -> getGlobalTlbPtr( );
     if ( gTlb == nullptr ) return ( false );
 
     T64TlbEntry tlbEntry;
-    if ( gTlb -> lookupTlb( vAdr, &tlbEntry )) {
+    if ( gTlb -> lookupTlb( vAdr, &tlbEntry, proc -> getModuleNum( ))) {
         
-        iTlbMissGTlbHits ++;
+        perf -> inc( T64_PC_ITLB_GTLB_HITS );
+
+        if ( tlbSets == 1 ) {
 
-        iTlb[ iTlbRoundRobin & ( iTlbEntries - 1 ) ] = tlbEntry;
-        iTlbRoundRobin ++;
+            iTlb[ iTlbRoundRobin & ( iTlbEntries - 1 ) ] = tlbEntry;
+            iTlbRoundRobin ++;
+        }
+        else insertSa( iTlb, tlbSets, &iPageSizesUsed, &iTlbRoundRobin, &tlbEntry );
 
+        iTlbLast = tlbEntry;
         *pAdr    = tlbEntry.pAdr | ( vAdr & ~ tlbEntry.pageMask );  
         *tlbInfo = tlbEntry.tlbInfo;
         return( true );
     }
     else {
 
-        iTlbMissGTlbMisses ++;
+        perf -> inc( T64_PC_ITLB_GTLB_MISSES );
         return ( false );
     }
 }
     
 //----------------------------------------------------------------------------------------
-// Lookup a Data TLB. If we find the entry in the L1 buffer, we return it and 
-// also place it in the slot 0, so that the next lookup has a higher chance of
-// finding it. All other entries are shifted by one. If we do not find the entry
-// in the L1 buffer, we consult the unified TLB buffer and if a translation is 
-// found, the L1 buffer is updated.
+// Lookup a Data TLB. The micro TLB holds the last translation and is checked
+// first. For a fully associative TLB, if we find the entry in the L1 buffer, we
+// return it and also place it in the slot 0, so that the next lookup has a 
+// higher chance of finding it. All other entries are shifted by one. If we do 
+// not find the entry in the L1 buffer, we consult the unified TLB buffer and if
+// a translation is found, the L1 buffer is updated.
 // 
 //----------------------------------------------------------------------------------------
 bool T64LocalTlb::lookupDtlb( T64Word vAdr, T64Word *pAdr, uint16_t *tlbInfo ) {
+
+    if ( isMicroTlbHit( &dTlbLast, vAdr )) {
+
+        *pAdr    = dTlbLast.pAdr | ( vAdr & ~ dTlbLast.pageMask );  
+        *tlbInfo = dTlbLast.tlbInfo;
+        perf -> inc( T64_PC_DTLB_HITS );
+        return ( true );
+    }
+
+    if ( tlbSets > 1 ) {
+
+        T64TlbEntry *e = lookupSa( dTlb, tlbSets, dPageSizesUsed, vAdr );
+        if ( e != nullptr ) {
+
+            perf -> inc( T64_PC_DTLB_HITS );
+
+            dTlbLast = *e;
+            *pAdr    = e -> pAdr | ( vAdr & ~ e -> pageMask ); 
+            *tlbInfo = e -> tlbInfo;
+            return ( true );
+        }
+    }
+    else {
                         
-    T64TlbEntry *e = lookup( dTlb, dTlbEntries, vAdr );
-    if ( e != nullptr ) {
+        T64TlbEntry *e = lookup( dTlb, dTlbEntries, vAdr );
+        if ( e != nullptr ) {
 
-        dTlbHits ++;
+            perf -> inc( T64_PC_DTLB_HITS );
 
-        int         idx = e - dTlb;
-        T64TlbEntry hit = *e;
+            int         idx = e - dTlb;
+            T64TlbEntry hit = *e;
 
-        for ( int i = idx; i > 0; i-- ) dTlb[ i ] = dTlb[ i - 1 ];
-        dTlb[ 0 ] = hit;
+            for ( int i = idx; i > 0; i-- ) dTlb[ i ] = dTlb[ i - 1 ];
+            dTlb[ 0 ] = hit;
 
-        *pAdr    = hit.pAdr | ( vAdr & ~ hit.pageMask ); 
-        *tlbInfo = hit.tlbInfo;
-        return ( true );
+            dTlbLast = hit;
+            *pAdr    = hit.pAdr | ( vAdr & ~ hit.pageMask ); 
+            *tlbInfo = hit.tlbInfo;
+            return ( true );
+        }
     }
    
-    dTlbMisses ++;
+    perf -> inc( T64_PC_DTLB_MISSES );
 
     T64GlobalTlb *gTlb = proc -> getGlobalTlbPtr( );
     if ( gTlb == nullptr ) return ( false );
 
     T64TlbEntry tlbEntry;
-    if ( gTlb -> lookupTlb( vAdr, &tlbEntry )) {
+    if ( gTlb -> lookupTlb( vAdr, &tlbEntry, proc -> getModuleNum( ))) {
         
-        dTlbMissGTlbHits ++;
+        perf -> inc( T64_PC_DTLB_GTLB_HITS );
 
-        for ( int i = dTlbEntries - 1; i > 0; i-- ) dTlb[ i ] = dTlb[ i - 1 ];
-        dTlb[ 0 ] = tlbEntry;
+        if ( tlbSets == 1 ) {
 
+            for ( int i = dTlbEntries - 1; i > 0; i-- ) dTlb[ i ] = dTlb[ i - 1 ];
+            dTlb[ 0 ] = tlbEntry;
+        }
+        else insertSa( dTlb, tlbSets, &dPageSizesUsed, &dTlbRoundRobin, &tlbEntry );
+
+        dTlbLast = tlbEntry;
         *pAdr    = tlbEntry.pAdr | ( vAdr & ~ tlbEntry.pageMask );  
         *tlbInfo = tlbEntry.tlbInfo;
         return ( true );
     }
     else {
 
-        dTlbMissGTlbMisses ++;
+        perf -> inc( T64_PC_DTLB_GTLB_MISSES );
         return ( false );
     }
 }
 
 //----------------------------------------------------------------------------------------
 // Remove the TLB entry that contains the virtual address from both TLBs. The 
-// entry is removed regardless if it is locked or not. 
+// entry is removed regardless if it is locked or not. The micro TLBs are 
+// simply cleared.
 // 
 //----------------------------------------------------------------------------------------
 bool T64LocalTlb::purgeTlb( T64Word vAdr ) {
 
-    T64TlbEntry *e = lookup( iTlb, iTlbEntries, vAdr );
+    T64TlbEntry *e = ( tlbSets == 1 ) ? 
+        lookup( iTlb, iTlbEntries, vAdr ) : 
+        lookupSa( iTlb, tlbSets, iPageSizesUsed, vAdr );
+
     if ( e != nullptr ) e -> tlbInfo &= 0x7FFF;
 
-    e = lookup( dTlb, dTlbEntries, vAdr );
+    e = ( tlbSets == 1 ) ? 
+        lookup( dTlb, dTlbEntries, vAdr ) : 
+        lookupSa( dTlb, tlbSets, dPageSizesUsed, vAdr );
+
     if ( e != nullptr ) e -> tlbInfo &= 0x7FFF;
+
+    resetTlbEntry( &iTlbLast );
+    resetTlbEntry( &dTlbLast );
         
     return( true );
 }
@@ -259,6 +408,48 @@ T64TlbEntry *T64LocalTlb::getDTlbEntry( int index ) {
     return ( &dTlb[ index ] );
 }
 
+//----------------------------------------------------------------------------------------
+// Snapshot support. The TLB entries, the page sizes in use and the replacement
+// positions are saved. The micro TLBs are just cleared on restore, they will 
+// refill on the next access. The counters are not part of the state.
+//
+//----------------------------------------------------------------------------------------
+void T64LocalTlb::saveState( T64Snapshot *snap ) {
+
+    snap -> put( &iTlbEntries, sizeof( iTlbEntries ));
+    snap -> put( &dTlbEntries, sizeof( dTlbEntries ));
+    snap -> put( iTlb, iTlbEntries * sizeof( T64TlbEntry ));
+    snap -> put( dTlb, dTlbEntries * sizeof( T64TlbEntry ));
+    snap -> put( &iPageSizesUsed, sizeof( iPageSizesUsed ));
+    snap -> put( &dPageSizesUsed, sizeof( dPageSizesUsed ));
+    snap -> put( &iTlbRoundRobin, sizeof( iTlbRoundRobin ));
+    snap -> put( &dTlbRoundRobin, sizeof( dTlbRoundRobin ));
+}
+
+bool T64LocalTlb::restoreState( T64Snapshot *snap ) {
+
+    int iEntries = 0;
+    int dEntries = 0;
+
+    if (( ! snap -> get( &iEntries, sizeof( iEntries ))) || 
+        ( ! snap -> get( &dEntries, sizeof( dEntries ))) ||
+        ( iEntries != iTlbEntries ) || 
+        ( dEntries != dTlbEntries )) {
+        
+        return( false );
+    }
+
+    resetTlbEntry( &iTlbLast );
+    resetTlbEntry( &dTlbLast );
+
+    return( snap -> get( iTlb, iTlbEntries * sizeof( T64TlbEntry ))         &&
+            snap -> get( dTlb, dTlbEntries * sizeof( T64TlbEntry ))         &&
+            snap -> get( &iPageSizesUsed, sizeof( iPageSizesUsed ))         &&
+            snap -> get( &dPageSizesUsed, sizeof( dPageSizesUsed ))         &&
+            snap -> get( &iTlbRoundRobin, sizeof( iTlbRoundRobin ))         &&
+            snap -> get( &dTlbRoundRobin, sizeof( dTlbRoundRobin )));
+}
+
 T64Word T64LocalTlb::getTlbStatus( ) {
     
     return ( tlbStatus );
@@ -271,38 +462,38 @@ T64Word T64LocalTlb::getTlbConfig( ) {
 
 T64Word T64LocalTlb::getItlbHits( ) {
 
-    return ( iTlbHits );
+    return ( perf -> get( T64_PC_ITLB_HITS ));
 }
 
 T64Word T64LocalTlb::getItlbMisses( ) {
 
-    return ( iTlbMisses );
+    return ( perf -> get( T64_PC_ITLB_MISSES ));
 }
 
 T64Word T64LocalTlb::getItlbMissGTlbHits( ) {
 
-    return ( iTlbMissGTlbHits );
+    return ( perf -> get( T64_PC_ITLB_GTLB_HITS ));
 }
 
 T64Word T64LocalTlb::getItlbMissGTlbMisses( ) {
 
-    return ( iTlbMissGTlbMisses );
+    return ( perf -> get( T64_PC_ITLB_GTLB_MISSES ));
 }
 
 T64Word T64LocalTlb::getDtlbHits( ) {
 
-    return ( dTlbHits );
+    return ( perf -> get( T64_PC_DTLB_HITS ));
 }
 
 T64Word T64LocalTlb::getDtlbMisses( ) {
 
-    return ( dTlbMisses );
+    return ( perf -> get( T64_PC_DTLB_MISSES ));
 }
 T64Word T64LocalTlb::getDtlbMissGTlbHits( ) {
 
-    return ( dTlbMissGTlbHits );
+    return ( perf -> get( T64_PC_DTLB_GTLB_HITS ));
 }
 T64Word T64LocalTlb::getDtlbMissGTlbMisses( ) {
 
-    return ( dTlbMissGTlbMisses );
+    return ( perf -> get( T64_PC_DTLB_GTLB_MISSES ));
 }
\ No newline at end of file
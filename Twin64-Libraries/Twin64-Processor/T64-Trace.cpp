@@ -0,0 +1,199 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Execution tracer
+//
+//----------------------------------------------------------------------------------------
+// The tracer records the execution of a processor into a ring buffer. A writer
+// thread streams the ring to a file. The CPU thread only stores a record and
+// advances the head index, the writer thread writes the records between its 
+// tail index and the head straight from the ring memory to the file and then 
+// advances the tail. The file is unbuffered, there is no copy of the records
+// on the way. The file is decoded offline by the Twin64-TraceDump program.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Execution tracer
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License along with
+// this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-Processor.h"
+
+#include <chrono>
+
+//----------------------------------------------------------------------------------------
+// Local name space.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// The ring size is a power of two, so that the index is just masked.
+//
+//----------------------------------------------------------------------------------------
+uint64_t ringSize( int records ) {
+
+    uint64_t size = 1024;
+
+    while ( size < (uint64_t) records ) size <<= 1;
+    return( size );
+}
+
+//----------------------------------------------------------------------------------------
+// Time the writer waits when the ring is empty. 
+//
+//----------------------------------------------------------------------------------------
+const auto WRITER_IDLE_WAIT = std::chrono::microseconds( 100 );
+
+};
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Tracer.
+//
+//----------------------------------------------------------------------------------------
+// The tracer object. The ring is allocated right away, the file is opened when
+// tracing starts.
+//
+//----------------------------------------------------------------------------------------
+T64Tracer::T64Tracer( int modNum, int ringRecords ) {
+
+    uint64_t size = ringSize( ringRecords );
+
+    this -> modNum   = modNum;
+    this -> ring     = new T64TraceRecord[ size ];
+    this -> ringMask = size - 1;
+}
+
+T64Tracer:: ~T64Tracer( ) {
+
+    close( );
+    delete [ ] ring;
+}
+
+//----------------------------------------------------------------------------------------
+// Open the trace file, write the file header and start the writer thread.
+//
+//----------------------------------------------------------------------------------------
+bool T64Tracer::open( const char *fileName ) {
+
+    if ( file != nullptr ) return( false );
+
+    file = fopen( fileName, "wb" );
+    if ( file == nullptr ) return( false );
+
+    setvbuf( file, nullptr, _IONBF, 0 );
+
+    T64TraceFileHeader hdr = { };
+
+    memcpy( hdr.magic, "T64TRACE", sizeof( hdr.magic ));
+    hdr.version     = T64_TRACE_VERSION;
+    hdr.recordSize  = sizeof( T64TraceRecord );
+    hdr.modNum      = modNum;
+
+    if ( fwrite( &hdr, sizeof( hdr ), 1, file ) != 1 ) {
+
+        fclose( file );
+        file = nullptr;
+        return( false );
+    }
+
+    head.store( 0 );
+    tail.store( 0 );
+    stopWriter.store( false );
+    waits = 0;
+
+    writer = std::thread( &T64Tracer::writerLoop, this );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Close the trace. The writer thread writes the remaining records and ends, then 
+// the file is closed. The processor must not be executing.
+//
+//----------------------------------------------------------------------------------------
+void T64Tracer::close( ) {
+
+    if ( file == nullptr ) return;
+
+    stopWriter.store( true, std::memory_order_release );
+    if ( writer.joinable( )) writer.join( );
+
+    fclose( file );
+    file = nullptr;
+}
+
+bool T64Tracer::isOpen( ) {
+
+    return( file != nullptr );
+}
+
+T64Word T64Tracer::getRecords( ) {
+
+    return((T64Word) head.load( ));
+}
+
+T64Word T64Tracer::getWaits( ) {
+
+    return( waits );
+}
+
+//----------------------------------------------------------------------------------------
+// The ring is full. The CPU thread waits until the writer has made room. 
+//
+//----------------------------------------------------------------------------------------
+void T64Tracer::waitForSpace( uint64_t head ) {
+
+    waits ++;
+
+    while ( head - tail.load( std::memory_order_acquire ) > ringMask ) {
+
+        std::this_thread::yield( );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// The writer thread. We write the records between tail and head in at most two
+// pieces, the part up to the ring end and the part from the ring start. When 
+// asked to stop, we continue until the ring is empty.
+//
+//----------------------------------------------------------------------------------------
+void T64Tracer::writerLoop( ) {
+
+    while ( true ) {
+
+        uint64_t t = tail.load( std::memory_order_relaxed );
+        uint64_t h = head.load( std::memory_order_acquire );
+
+        if ( h == t ) {
+
+            if ( stopWriter.load( std::memory_order_acquire )) {
+
+                if ( head.load( std::memory_order_acquire ) == t ) break;
+            }
+            else std::this_thread::sleep_for( WRITER_IDLE_WAIT );
+
+            continue;
+        }
+
+        uint64_t index = t & ringMask;
+        uint64_t len   = h - t;
+
+        if ( len > ( ringMask + 1 - index )) len = ringMask + 1 - index;
+
+        fwrite( &ring[ index ], sizeof( T64TraceRecord ), len, file );
+        tail.store( t + len, std::memory_order_release );
+    }
+}
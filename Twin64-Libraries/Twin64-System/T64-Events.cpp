@@ -0,0 +1,278 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System Timed Events and Interrupts
+//
+//----------------------------------------------------------------------------------------
+// The system keeps one event queue per processor. An event is due after a number
+// of instructions of the processor it is scheduled for. The processor advances
+// its queue between the batches it executes and fires the due events on its
+// own thread, nobody polls the queue per instruction. When the processor idles
+// with events in its queue, the time skips forward to the next event instead of
+// waiting, so a timer a guest waits for fires right away in host time. Events
+// are kept in a heap. Events with the same due time are fired in the order they
+// were scheduled, a run with one worker is thus reproducible.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License along with
+// this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-System.h"
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Event queue.
+//
+//----------------------------------------------------------------------------------------
+// The event queue object. The queue starts empty at time zero.
+//
+//----------------------------------------------------------------------------------------
+T64EventQueue::T64EventQueue( ) { }
+
+//----------------------------------------------------------------------------------------
+// Schedule an event. The event is due "delay" instructions from now, at least
+// one. The next due time is published after the heap is updated, so that the
+// processor finds the event when it looks next time. We fail when the queue is
+// full.
+//
+//----------------------------------------------------------------------------------------
+bool T64EventQueue::schedule( T64Module *mod, T64Word delay, int id, T64Word arg ) {
+
+    if ( mod == nullptr ) return( false );
+    if ( delay < 1 ) delay = 1;
+
+    std::lock_guard<std::mutex> lk( qLock );
+
+    if ( heapCount >= T64_EVENT_QUEUE_SIZE ) return( false );
+
+    T64TimedEvent &e = heap[ heapCount ];
+
+    e.due   = now.load( std::memory_order_relaxed ) + delay;
+    e.seq   = seqNum++;
+    e.mod   = mod;
+    e.id    = id;
+    e.arg   = arg;
+
+    siftUp( heapCount++ );
+
+    nextDue.store( heap[ 0 ].due, std::memory_order_release );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Cancel the events with the id scheduled by a module. We return the number of
+// events removed. The heap is small, we just rebuild it.
+//
+//----------------------------------------------------------------------------------------
+int T64EventQueue::cancel( T64Module *mod, int id ) {
+
+    std::lock_guard<std::mutex> lk( qLock );
+
+    int removed = 0;
+    int n       = 0;
+
+    for ( int i = 0; i < heapCount; i++ ) {
+
+        if (( heap[ i ].mod == mod ) && ( heap[ i ].id == id )) removed++;
+        else heap[ n++ ] = heap[ i ];
+    }
+
+    heapCount = n;
+
+    for ( int i = ( heapCount / 2 ) - 1; i >= 0; i-- ) siftDown( i );
+
+    nextDue.store(( heapCount > 0 ) ? heap[ 0 ].due : T64_EVENT_TIME_NONE,
+                  std::memory_order_release );
+    return( removed );
+}
+
+//----------------------------------------------------------------------------------------
+// Reset the queue. All events are dropped and the time starts again at zero.
+// This is done when the processor is reset.
+//
+//----------------------------------------------------------------------------------------
+void T64EventQueue::reset( ) {
+
+    std::lock_guard<std::mutex> lk( qLock );
+
+    heapCount = 0;
+    now.store( 0, std::memory_order_relaxed );
+    nextDue.store( T64_EVENT_TIME_NONE, std::memory_order_release );
+}
+
+//----------------------------------------------------------------------------------------
+// Skip the time forward to the next event and fire it. This is called by the
+// processor when it idles, instead of parking. We return the number of events
+// fired, zero when there is no event to skip to.
+//
+//----------------------------------------------------------------------------------------
+int T64EventQueue::skipToNext( ) {
+
+    if ( nextDue.load( std::memory_order_acquire ) == T64_EVENT_TIME_NONE ) return( 0 );
+
+    T64Word toNext = unitsToNext( );
+
+    return( advance(( toNext > 0 ) ? toNext : 0 ));
+}
+
+T64Word T64EventQueue::getTime( ) {
+
+    return( now.load( std::memory_order_relaxed ));
+}
+
+int T64EventQueue::getCount( ) {
+
+    std::lock_guard<std::mutex> lk( qLock );
+
+    return( heapCount );
+}
+
+//----------------------------------------------------------------------------------------
+// Fire the due events. They are taken from the heap with the lock held and the
+// handlers are called after releasing it, so that a handler can schedule its
+// next event. We return the number of events fired.
+//
+//----------------------------------------------------------------------------------------
+int T64EventQueue::fire( ) {
+
+    T64TimedEvent   due[ T64_EVENT_QUEUE_SIZE ];
+    int             n   = 0;
+
+    {
+        std::lock_guard<std::mutex> lk( qLock );
+
+        T64Word t = now.load( std::memory_order_relaxed );
+
+        while (( heapCount > 0 ) && ( heap[ 0 ].due <= t )) {
+
+            due[ n++ ] = heap[ 0 ];
+            heap[ 0 ]  = heap[ --heapCount ];
+            if ( heapCount > 0 ) siftDown( 0 );
+        }
+
+        nextDue.store(( heapCount > 0 ) ? heap[ 0 ].due : T64_EVENT_TIME_NONE,
+                      std::memory_order_release );
+    }
+
+    for ( int i = 0; i < n; i++ ) due[ i ].mod -> timerEvent( due[ i ].id, due[ i ].arg );
+
+    return( n );
+}
+
+//----------------------------------------------------------------------------------------
+// Heap routines. The earlier due time comes first, for the same time the event
+// scheduled first.
+//
+//----------------------------------------------------------------------------------------
+bool T64EventQueue::before( const T64TimedEvent &a, const T64TimedEvent &b ) {
+
+    return(( a.due < b.due ) || (( a.due == b.due ) && ( a.seq < b.seq )));
+}
+
+void T64EventQueue::siftUp( int pos ) {
+
+    while ( pos > 0 ) {
+
+        int parent = ( pos - 1 ) / 2;
+
+        if ( ! before( heap[ pos ], heap[ parent ] )) break;
+
+        std::swap( heap[ pos ], heap[ parent ] );
+        pos = parent;
+    }
+}
+
+void T64EventQueue::siftDown( int pos ) {
+
+    while ( true ) {
+
+        int left    = ( 2 * pos ) + 1;
+        int right   = left + 1;
+        int first   = pos;
+
+        if (( left < heapCount ) && ( before( heap[ left ], heap[ first ] )))   first = left;
+        if (( right < heapCount ) && ( before( heap[ right ], heap[ first ] ))) first = right;
+        if ( first == pos ) break;
+
+        std::swap( heap[ pos ], heap[ first ] );
+        pos = first;
+    }
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// System interface.
+//
+//----------------------------------------------------------------------------------------
+// Schedule an event for a processor. The processor is woken up when parked, so
+// that it can skip ahead to the event.
+//
+//----------------------------------------------------------------------------------------
+bool T64System::scheduleEvent( int         procNum,
+                               T64Module   *mod,
+                               T64Word     delay,
+                               int         id,
+                               T64Word     arg ) {
+
+    T64EventQueue *q = getEventQueue( procNum );
+    if ( q == nullptr ) return( false );
+
+    if ( ! q -> schedule( mod, delay, id, arg )) return( false );
+
+    if ( auto *p = dynamic_cast<T64ProcThreadModule *>( moduleMap[ procNum ] )) {
+
+        p -> wakeModule( );
+    }
+
+    return( true );
+}
+
+int T64System::cancelEvent( int procNum, T64Module *mod, int id ) {
+
+    T64EventQueue *q = getEventQueue( procNum );
+    if ( q == nullptr ) return( 0 );
+
+    return( q -> cancel( mod, id ));
+}
+
+//----------------------------------------------------------------------------------------
+// The event queue for a module number. There is one for each number, so that a
+// processor can get its queue when created, before it is added to the system.
+// Only the queue of a processor ever advances.
+//
+//----------------------------------------------------------------------------------------
+T64EventQueue *T64System::getEventQueue( int procNum ) {
+
+    if (( procNum < 0 ) || ( procNum >= MAX_MOD_MAP_ENTRIES )) return( nullptr );
+
+    return( &eventQueues[ procNum ] );
+}
+
+//----------------------------------------------------------------------------------------
+// Post an external interrupt to a processor.
+//
+//----------------------------------------------------------------------------------------
+bool T64System::postInterrupt( int procNum, int line ) {
+
+    if (( procNum < 0 ) || ( procNum >= MAX_MOD_MAP_ENTRIES )) return( false );
+
+    if ( auto *p = dynamic_cast<T64ProcThreadModule *>( moduleMap[ procNum ] )) {
+
+        return( p -> raiseInterrupt( line ));
+    }
+
+    return( false );
+}
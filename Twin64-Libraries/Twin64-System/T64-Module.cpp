@@ -35,7 +35,7 @@
 T64Module::T64Module( T64ModuleType    modType, 
                       int              modNum,
                       T64Word          spaAdr,
-                      int              spaLen ) {
+                      T64Word          spaLen ) {
 
     this -> moduleTyp   = modType;
     this -> moduleNum   = modNum;
@@ -45,6 +45,15 @@ T64Module::T64Module( T64ModuleType    modType,
     this -> spaLen      = spaLen;
 }
 
+//----------------------------------------------------------------------------------------
+// Object destructor. The performance counter block belongs to the module.
+//
+//----------------------------------------------------------------------------------------
+T64Module:: ~T64Module( ) {
+
+    delete perf;
+}
+
 //----------------------------------------------------------------------------------------
 // Module properties.
 //
@@ -90,8 +99,181 @@ T64Word T64Module::getSpaAdr( )  {
     return ( spaAdr );
 }
 
-int T64Module::getSpaLen( )  {
+T64Word T64Module::getSpaLen( )  {
 
     return ( spaLen );
 }
 
+//----------------------------------------------------------------------------------------
+// Control events. By default, a module subscribes to all control events and
+// handles a posted event right away. A module that has no interest in some of
+// the events should say so, it will then not be bothered with them.
+//
+//----------------------------------------------------------------------------------------
+uint32_t T64Module::getControlEventMask( ) {
+
+    return( T64_CNTRL_EVENT_ALL );
+}
+
+bool T64Module::postControlEvent( T64BBusOpControlEvents event, 
+                                  T64Word                arg1, 
+                                  T64Word                arg2 ) {
+
+    return( busOpControlEvent( event, arg1, arg2 ));
+}
+
+//----------------------------------------------------------------------------------------
+// Direct memory access. A module that holds its SPA range as plain host memory
+// can hand out the host address of a page, so that processors can access the 
+// data without a bus operation. The write mode states whether the caller will
+// store to the page. The writable flag tells whether stores may go directly to
+// this page. By default, a module has no such memory and all accesses go 
+// through the bus operations.
+//
+//----------------------------------------------------------------------------------------
+uint8_t *T64Module::getHostPagePtr( T64Word pAdr, bool wMode, bool *writable ) {
+
+    *writable = false;
+    return ( nullptr );
+}
+
+//----------------------------------------------------------------------------------------
+// Block events. A DMA style bus operation reads, writes or fills a block of any
+// length and alignment that lies within the module SPA range. A module that 
+// holds its data as host memory will do this in one go. By default, the block 
+// is transferred as a sequence of aligned words and bytes with read or write
+// events.
+//
+//----------------------------------------------------------------------------------------
+bool T64Module::busOpReadBlockEvent( T64Word pAdr, uint8_t *data, T64Word len ) {
+
+    for ( T64Word i = 0; i < len; ) {
+
+        int itemLen = ((( pAdr + i ) % sizeof( T64Word ) == 0 ) && 
+                       ( len - i >= (T64Word) sizeof( T64Word ))) ? sizeof( T64Word ) : 1;
+        
+        if ( ! busOpReadEvent( pAdr + i, data + i, itemLen )) return( false );
+        i += itemLen;
+    }
+
+    return( true );
+}
+
+bool T64Module::busOpWriteBlockEvent( T64Word pAdr, const uint8_t *data, T64Word len ) {
+
+    for ( T64Word i = 0; i < len; ) {
+
+        int itemLen = ((( pAdr + i ) % sizeof( T64Word ) == 0 ) && 
+                       ( len - i >= (T64Word) sizeof( T64Word ))) ? sizeof( T64Word ) : 1;
+        
+        if ( ! busOpWriteEvent( pAdr + i, (uint8_t *) data + i, itemLen )) return( false );
+        i += itemLen;
+    }
+
+    return( true );
+}
+
+bool T64Module::busOpFillBlockEvent( T64Word pAdr, uint8_t val, T64Word len ) {
+
+    uint8_t buf[ sizeof( T64Word ) ];
+    memset( buf, val, sizeof( buf ));
+
+    for ( T64Word i = 0; i < len; ) {
+
+        int itemLen = ((( pAdr + i ) % sizeof( T64Word ) == 0 ) && 
+                       ( len - i >= (T64Word) sizeof( T64Word ))) ? sizeof( T64Word ) : 1;
+        
+        if ( ! busOpWriteEvent( pAdr + i, buf, itemLen )) return( false );
+        i += itemLen;
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Conditional write. The data item is written only when it still holds the 
+// expected data. The comparison and the write must appear as one operation to 
+// any other access of the item. The system calls this routine with the line
+// locked. By default, the module just reads, compares and writes the item, 
+// which is enough for a module whose items are only written with the line 
+// locked or from one thread. A module accessed concurrently without locks, 
+// such as memory, implements this with a host atomic operation.
+//
+//----------------------------------------------------------------------------------------
+bool T64Module::busOpWriteCondEvent( T64Word pAdr, uint8_t *expected, uint8_t *data, int len ) {
+
+    T64Word curData = 0;
+
+    if ( ! busOpReadEvent( pAdr, (uint8_t *) &curData, len )) return( false );
+    if ( memcmp( &curData, expected, len ) != 0 ) return( false );
+
+    return( busOpWriteEvent( pAdr, data, len ));
+}
+
+//----------------------------------------------------------------------------------------
+// Line locks. The LDR / STC bus operations need the read or write of the data
+// item and the reservation handling to appear as one operation. A module that
+// is accessed concurrently without a lock of its own locks the line containing
+// the physical address for the duration of such an operation. By default a
+// module does not need this and the routines do nothing.
+//
+//----------------------------------------------------------------------------------------
+void T64Module::lockLine( T64Word pAdr ) { }
+
+void T64Module::unlockLine( T64Word pAdr ) { }
+
+//----------------------------------------------------------------------------------------
+// Snapshot support. A module with state worth keeping across a snapshot saves 
+// it into its snapshot record and restores it from there. The default is a
+// module without such state.
+//
+//----------------------------------------------------------------------------------------
+bool T64Module::saveState( T64Snapshot *snap ) {
+
+    return( true );
+}
+
+bool T64Module::restoreState( T64Snapshot *snap ) {
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Timed events. A module that schedules events with the system gets them back
+// here when they are due. The default module schedules none.
+//
+//----------------------------------------------------------------------------------------
+void T64Module::timerEvent( int id, T64Word arg ) { }
+
+
+//----------------------------------------------------------------------------------------
+// Performance counters. A module defines its counters once, typically in the
+// constructor, before any of its components counts. The names table must stay
+// valid for the lifetime of the module. A module without counters has no block
+// and its counter registers read as zero.
+//
+//----------------------------------------------------------------------------------------
+bool T64Module::definePerfCounters( const char *const *names, int count ) {
+
+    if (( perf != nullptr ) || ( count <= 0 ) || ( count > T64_PERF_MAX_COUNTERS )) {
+
+        return( false );
+    }
+
+    perf = new T64PerfBlock( names, count );
+    return( true );
+}
+
+T64PerfBlock *T64Module::getPerfBlock( ) {
+
+    return( perf );
+}
+
+bool T64Module::readPerfReg( int index, T64Word *val ) {
+
+    *val = 0;
+
+    if (( index < 0 ) || ( index >= T64_PERF_MAX_COUNTERS )) return( false );
+    if (( perf != nullptr ) && ( index < perf -> getCount( ))) *val = perf -> get( index );
+    return( true );
+}
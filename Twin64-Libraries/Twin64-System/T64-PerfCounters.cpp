@@ -0,0 +1,229 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System Performance Counters
+//
+//----------------------------------------------------------------------------------------
+// The modules keep their performance counters in a block of named counters.
+// This file contains the counter block, the output of the counters of all
+// modules in a system and the periodic export. The export thread only reads
+// the counters, the modules keep counting while it runs. A snapshot of the
+// counters is therefore not taken at one instant, but close enough for a look
+// at how a run progresses.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License along with
+// this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-System.h"
+#include <chrono>
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Counter block.
+//
+//----------------------------------------------------------------------------------------
+// The counter block. All counters start at zero. The names table is owned by
+// the module.
+//
+//----------------------------------------------------------------------------------------
+T64PerfBlock::T64PerfBlock( const char *const *names, int count ) {
+
+    this -> names = names;
+    this -> count = count;
+
+    clear( );
+}
+
+void T64PerfBlock::clear( ) {
+
+    for ( int i = 0; i < T64_PERF_MAX_COUNTERS; i++ ) {
+
+        value[ i ].store( 0, std::memory_order_relaxed );
+    }
+}
+
+int T64PerfBlock::getCount( ) {
+
+    return( count );
+}
+
+const char *T64PerfBlock::getName( int id ) {
+
+    if (( id < 0 ) || ( id >= count ) || ( names == nullptr )) return( "" );
+    return( names[ id ] );
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Counter output.
+//
+//----------------------------------------------------------------------------------------
+// Write the counters of all modules that have counters. The JSON format is one
+// object per call on a line of its own, holding the time and an entry for
+// each module. The CSV format is one row per counter. The time is passed by
+// the caller, typically the seconds since the export started.
+//
+//----------------------------------------------------------------------------------------
+void T64System::writePerfCounters( FILE *f, T64PerfFormat fmt, double secs ) {
+
+    if ( f == nullptr ) return;
+
+    bool first = true;
+
+    if ( fmt == T64_PERF_FMT_JSON ) fprintf( f, "{ \"secs\": %.6f, \"modules\": [ ", secs );
+
+    for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+        T64Module *mod = moduleMap[ i ];
+        if ( mod == nullptr ) continue;
+
+        T64PerfBlock *pb = mod -> getPerfBlock( );
+        if ( pb == nullptr ) continue;
+
+        if ( fmt == T64_PERF_FMT_JSON ) {
+
+            fprintf( f, "%s{ \"mod\": %d, \"type\": \"%s\"",
+                     ( first ) ? "" : ", ",
+                     mod -> getModuleNum( ),
+                     mod -> getModuleTypeName( ));
+
+            for ( int c = 0; c < pb -> getCount( ); c++ ) {
+
+                fprintf( f, ", \"%s\": %lld", pb -> getName( c ), (long long) pb -> get( c ));
+            }
+
+            fprintf( f, " }" );
+        }
+        else {
+
+            for ( int c = 0; c < pb -> getCount( ); c++ ) {
+
+                fprintf( f, "%.6f,%d,%s,%s,%lld\n",
+                         secs,
+                         mod -> getModuleNum( ),
+                         mod -> getModuleTypeName( ),
+                         pb -> getName( c ),
+                         (long long) pb -> get( c ));
+            }
+        }
+
+        first = false;
+    }
+
+    if ( fmt == T64_PERF_FMT_JSON ) fprintf( f, " ] }\n" );
+    fflush( f );
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Counter export.
+//
+//----------------------------------------------------------------------------------------
+// The export object. An export writes to one file at a time.
+//
+//----------------------------------------------------------------------------------------
+T64PerfExport::T64PerfExport( T64System *sys ) {
+
+    this -> sys = sys;
+}
+
+T64PerfExport:: ~T64PerfExport( ) {
+
+    stop( );
+}
+
+//----------------------------------------------------------------------------------------
+// Start an export. The file is created and for CSV gets a header row. With an
+// interval greater than zero, a thread writes the counters each interval and
+// once more when stopped. Without an interval, the counters are written once
+// right away and the file is closed.
+//
+//----------------------------------------------------------------------------------------
+bool T64PerfExport::start( const char *fileName, T64PerfFormat fmt, int intervalMs ) {
+
+    if (( isActive( )) || ( fileName == nullptr ) || ( intervalMs < 0 )) return( false );
+
+    out = fopen( fileName, "w" );
+    if ( out == nullptr ) return( false );
+
+    this -> fmt         = fmt;
+    this -> intervalMs  = intervalMs;
+    this -> stopReq     = false;
+
+    if ( fmt == T64_PERF_FMT_CSV ) fprintf( out, "secs,mod,type,counter,value\n" );
+
+    if ( intervalMs == 0 ) {
+
+        sys -> writePerfCounters( out, fmt, 0.0 );
+        fclose( out );
+        out = nullptr;
+    }
+    else worker = std::thread( &T64PerfExport::exportWorker, this );
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Stop a periodic export. The worker writes a last snapshot and we close the
+// file.
+//
+//----------------------------------------------------------------------------------------
+void T64PerfExport::stop( ) {
+
+    if ( ! worker.joinable( )) return;
+
+    {
+        std::lock_guard<std::mutex> lk( eLock );
+        stopReq = true;
+    }
+
+    eCondVar.notify_all( );
+    worker.join( );
+
+    fclose( out );
+    out = nullptr;
+}
+
+bool T64PerfExport::isActive( ) {
+
+    return( worker.joinable( ));
+}
+
+//----------------------------------------------------------------------------------------
+// The export worker. We sleep for the interval or until asked to stop and then
+// write the counters. The time is taken relative to the start of the export.
+//
+//----------------------------------------------------------------------------------------
+void T64PerfExport::exportWorker( ) {
+
+    auto                            startTime   = std::chrono::steady_clock::now( );
+    std::unique_lock<std::mutex>    lk( eLock );
+    bool                            done        = false;
+
+    while ( ! done ) {
+
+        done = eCondVar.wait_for( lk,
+                                  std::chrono::milliseconds( intervalMs ),
+                                  [ this ] { return( stopReq ); } );
+
+        double secs = std::chrono::duration<double>( std::chrono::steady_clock::now( ) -
+                                                     startTime ).count( );
+
+        sys -> writePerfCounters( out, fmt, secs );
+    }
+}
@@ -35,7 +35,7 @@
 T64ProcThreadModule::T64ProcThreadModule( T64ModuleType    modType, 
                                           int              modNum,
                                           T64Word          spaAdr,
-                                          int              spaLen ) 
+                                          T64Word          spaLen ) 
                                           : T64Module ( modType, 
                                                         modNum,
                                                         spaAdr, 
@@ -43,6 +43,11 @@ T64ProcThreadModule::T64ProcThreadModule( T64ModuleType    modType,
 
     mTrapCode = NO_TRAP;
     mState.store( T64_MOD_STATE_HALTED, std::memory_order_release );      
+
+    for ( int i = 0; i < T64_CNTRL_QUEUE_SIZE; i++ ) {
+        
+        evQueue[ i ].seq.store( i, std::memory_order_relaxed );
+    }
 }
 
 T64ProcThreadModule:: ~ T64ProcThreadModule( ) {
@@ -58,7 +63,9 @@ T64ProcThreadModule:: ~ T64ProcThreadModule( ) {
 // Module state routines. This is our way to control what the module thread is 
 // doing. We provide methods for RESET, HALT and EXECUTE. The module state is
 // the atomic variable "mState". The mutex ensures that we do a synchronized
-// update. Finally, we wake up the thread which is waiting in the "mCondVar".
+// update. The "mStateReq" flag tells a running thread to look at the new 
+// state when it is done with the current batch of units. Finally, we wake up
+// the thread which is waiting in the "mCondVar".
 //
 //----------------------------------------------------------------------------------------
 void T64ProcThreadModule::setModuleState( T64ModuleState state ) {
@@ -68,16 +75,19 @@ void T64ProcThreadModule::setModuleState( T64ModuleState state ) {
         mState = state;
     }
 
-    mCondVar.notify_one( );
+    mStateReq.store( true, std::memory_order_release );
+    mCondVar.notify_all( );
 }
 
 void T64ProcThreadModule::initModule( ) {
 
+    mState.store( T64_MOD_STATE_RESET, std::memory_order_release );
     mWorker = std::thread( &T64ProcThreadModule::moduleWorker, this );
 }
 
 void T64ProcThreadModule::resetModule( ) {
 
+    intPending.store( 0, std::memory_order_release );
     setModuleState( T64_MOD_STATE_RESET );
 }
 
@@ -121,23 +131,61 @@ T64TrapCode T64ProcThreadModule::waitUntilStopped( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Support for LDR/STC instructions.
+// Support for LDR/STC instructions. A processor holds at most one reservation,
+// which is the physical address and the data value read by the LDR instruction.
+// The reservation address is an atomic value, other processor threads clear a
+// reservation when they store to the reserved memory line. Whoever changes the
+// reservation address from a valid address to none, is responsible for the
+// bookkeeping in the system reservation directory. "setRsv" returns the 
+// previous reservation address for this purpose. The reservation directory is 
+// managed by the T64System object.
 //
 //----------------------------------------------------------------------------------------
-void T64ProcThreadModule::setRsvInfo( T64Word pAdr, bool valid ) {
+T64Word T64ProcThreadModule::setRsv( T64Word pAdr ) {
 
-    rsvInfo  = pAdr;
-    rsvValid = valid;
+    return( rsvAdr.exchange( pAdr ));
 }
+
+void T64ProcThreadModule::setRsvData( T64Word data ) {
+
+    rsvData = data;
+}
+
+bool T64ProcThreadModule::clearRsv( T64Word pAdr ) {
+
+    if ( pAdr == T64_RSV_NONE ) return( false );
+    if ( ! rsvAdr.compare_exchange_strong( pAdr, T64_RSV_NONE )) return( false ); 
     
-T64Word T64ProcThreadModule::getRsvInfo( ) {
+    notifyParked( );
+    return( true );
+}
+
+bool T64ProcThreadModule::clearRsvLine( T64Word pAdr ) {
+
+    T64Word adr = rsvAdr.load( std::memory_order_relaxed );
+
+    if (( adr == T64_RSV_NONE ) || 
+        (( adr / T64_RSV_LINE_SIZE ) != ( pAdr / T64_RSV_LINE_SIZE ))) return( false );
+
+    if ( ! rsvAdr.compare_exchange_strong( adr, T64_RSV_NONE )) return( false );
 
-    return( rsvInfo );
+    notifyParked( );
+    return( true );
+}
+    
+T64Word T64ProcThreadModule::getRsvAdr( ) {
+
+    return( rsvAdr.load( std::memory_order_relaxed ));
+}
+
+T64Word T64ProcThreadModule::getRsvData( ) {
+
+    return( rsvData );
 }
 
 bool T64ProcThreadModule::isRsvValid( ) {
 
-    return( rsvValid );
+    return( getRsvAdr( ) != T64_RSV_NONE );
 }
 
 //----------------------------------------------------------------------------------------
@@ -159,6 +207,262 @@ T64TrapCode T64ProcThreadModule::getTrapCode( ) {
     enterSimOnTrap = val;
  }
 
+bool T64ProcThreadModule::getEnterSimOnTrap( ) {
+
+    return( enterSimOnTrap );
+}
+
+//----------------------------------------------------------------------------------------
+// Execute a batch of units. We execute up to "units" units and stop early when
+// a unit reports a trap and we are asked to halt on a trap. The number of units
+// executed is returned in "done", the function returns the trap code of the last
+// unit. This default version just calls the unit routine, an inheriting module
+// should implement its own version with the loop inside.
+//
+//----------------------------------------------------------------------------------------
+T64TrapCode T64ProcThreadModule::executeUnits( int units, bool haltOnTrap, int *done ) {
+
+    T64TrapCode trapCode = NO_TRAP;
+    int         i        = 0;
+
+    while ( i < units ) {
+
+        trapCode = executeUnit( );
+        i++;
+
+        if (( trapCode != NO_TRAP ) && ( haltOnTrap )) break;
+    }
+
+    *done = i;
+    return( trapCode );
+}
+
+//----------------------------------------------------------------------------------------
+// Execute a quantum of units. This is one batch of the module thread, or one 
+// quantum the system scheduler runs on one of its workers. The control event
+// queue is owned while the units execute and drained before. The trap code of
+// the last unit is also kept as the module trap code.
+//
+//----------------------------------------------------------------------------------------
+T64TrapCode T64ProcThreadModule::executeQuantum( int units, int *done ) {
+
+    while ( evOwner.exchange( true, std::memory_order_acquire )) {
+
+        std::this_thread::yield( );
+    }
+
+    drainControlEvents( );
+    mTrapCode = executeUnits( units, enterSimOnTrap, done );
+    evOwner.store( false, std::memory_order_release );
+    deliverControlEvents( );
+
+    return( mTrapCode );
+}
+
+//----------------------------------------------------------------------------------------
+// Control event queue. Broadcast events for a processor are not handled on the
+// thread of the sender, they are put into our inbound queue. The queue is a 
+// bounded ring with a sequence number per slot. Any number of senders can put
+// an event without a lock, they just compete for the next slot. There is only
+// one party at a time who takes the events out, the owner of the queue. The 
+// module thread owns the queue while it executes a batch of units and drains 
+// it before each batch. A sender which finds the queue not owned, the module
+// is then not executing, drains the queue itself. The first event a sender 
+// cannot put into a full queue sets the overflow flag instead, the module is 
+// then asked to get back in sync when the queue is drained next.
+//
+//----------------------------------------------------------------------------------------
+bool T64ProcThreadModule::postControlEvent( T64BBusOpControlEvents event, 
+                                            T64Word                arg1, 
+                                            T64Word                arg2 ) {
+
+    uint64_t pos = evHead.load( std::memory_order_relaxed );
+
+    while ( true ) {
+
+        T64ControlQueueSlot *slot = &evQueue[ pos % T64_CNTRL_QUEUE_SIZE ];
+        int64_t             diff  = (int64_t) slot -> seq.load( std::memory_order_acquire ) - 
+                                    (int64_t) pos;
+
+        if ( diff == 0 ) {
+
+            if ( evHead.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed )) {
+
+                slot -> ev.event    = event;
+                slot -> ev.arg1     = arg1;
+                slot -> ev.arg2     = arg2;
+                slot -> seq.store( pos + 1, std::memory_order_release );
+                break;
+            }
+        }
+        else if ( diff < 0 ) {
+
+            evOverflow.store( true, std::memory_order_release );
+            break;
+        }
+        else pos = evHead.load( std::memory_order_relaxed );
+    }
+
+    deliverControlEvents( );
+    wakeModule( );
+    return( true );
+}
+
+bool T64ProcThreadModule::hasControlEvents( ) {
+
+    uint64_t pos = evTail.load( std::memory_order_relaxed );
+
+    return(( evOverflow.load( std::memory_order_acquire )) ||
+           ( evQueue[ pos % T64_CNTRL_QUEUE_SIZE ].seq.load( std::memory_order_acquire ) == 
+             pos + 1 ));
+}
+
+//----------------------------------------------------------------------------------------
+// Drain the queue. Only the owner of the queue calls this routine. An overflow
+// is reported first, the events still in the queue are handled after that.
+//
+//----------------------------------------------------------------------------------------
+void T64ProcThreadModule::drainControlEvents( ) {
+
+    if ( evOverflow.exchange( false, std::memory_order_acquire )) controlEventOverflow( );
+
+    uint64_t pos = evTail.load( std::memory_order_relaxed );
+
+    while ( true ) {
+
+        T64ControlQueueSlot *slot = &evQueue[ pos % T64_CNTRL_QUEUE_SIZE ];
+
+        if ( slot -> seq.load( std::memory_order_acquire ) != pos + 1 ) break;
+
+        T64ControlEvent ev = slot -> ev;
+        slot -> seq.store( pos + T64_CNTRL_QUEUE_SIZE, std::memory_order_release );
+        pos++;
+        evTail.store( pos, std::memory_order_relaxed );
+
+        busOpControlEvent( ev.event, ev.arg1, ev.arg2 );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Deliver the queued events when nobody owns the queue. After giving up the 
+// ownership, we look again, a sender could have put an event while we were 
+// still the owner and found the queue owned.
+//
+//----------------------------------------------------------------------------------------
+void T64ProcThreadModule::deliverControlEvents( ) {
+
+    while (( hasControlEvents( )) && ( ! evOwner.exchange( true, std::memory_order_acquire ))) {
+
+        drainControlEvents( );
+        evOwner.store( false, std::memory_order_release );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// The queue overflowed and events were lost. By default there is nothing to 
+// get in sync, an inheriting module will typically purge whatever it caches.
+//
+//----------------------------------------------------------------------------------------
+void T64ProcThreadModule::controlEventOverflow( ) { }
+
+//----------------------------------------------------------------------------------------
+// External interrupts. Posting an interrupt sets the line in the pending mask 
+// and wakes a parked module. The inheriting module takes the interrupts between
+// batches and clears a line when it took it.
+//
+//----------------------------------------------------------------------------------------
+bool T64ProcThreadModule::raiseInterrupt( int line ) {
+
+    if (( line < 0 ) || ( line >= T64_MAX_INT_LINES )) return( false );
+
+    intPending.fetch_or( 1ULL << line, std::memory_order_release );
+    wakeModule( );
+    return( true );
+}
+
+void T64ProcThreadModule::clearInterrupt( int line ) {
+
+    if (( line < 0 ) || ( line >= T64_MAX_INT_LINES )) return;
+
+    intPending.fetch_and( ~( 1ULL << line ), std::memory_order_acq_rel );
+}
+
+uint64_t T64ProcThreadModule::getPendingInterrupts( ) {
+
+    return( intPending.load( std::memory_order_acquire ));
+}
+
+//----------------------------------------------------------------------------------------
+// Idle parking. The inheriting module tells after a batch whether it wants to
+// be parked. By default a module never idles.
+//
+//----------------------------------------------------------------------------------------
+bool T64ProcThreadModule::takeIdleRequest( T64Word *timeoutUs ) {
+
+    return( false );
+}
+
+bool T64ProcThreadModule::isParked( ) {
+
+    return( parked.load( std::memory_order_acquire ));
+}
+
+//----------------------------------------------------------------------------------------
+// Park the module thread. We publish that we are parked and then check the 
+// wake up conditions with the module lock held. A party that changes one of
+// the conditions does so before it looks at the parked flag. All of these are
+// sequentially consistent operations, so either we see the change or the waker
+// sees us parked. A waker takes the module lock before the notify, so the wake
+// up cannot get lost between our check and the wait. A state change is set 
+// with the module lock held and is seen through the module state.
+//
+//----------------------------------------------------------------------------------------
+void T64ProcThreadModule::parkModule( T64Word timeoutUs ) {
+
+    std::unique_lock<std::mutex> lk( mLock );
+
+    parkRsvValid = ( rsvAdr.load( std::memory_order_relaxed ) != T64_RSV_NONE );
+    parked.store( true, std::memory_order_seq_cst );
+
+    auto wake = [ this ] {
+
+        return(( mState.load( std::memory_order_acquire ) != T64_MOD_STATE_EXECUTE ) ||
+               ( mStateReq.load( std::memory_order_acquire )) ||
+               ( wakeReq.load( std::memory_order_seq_cst )) ||
+               ( hasControlEvents( )) ||
+               (( parkRsvValid ) && 
+                ( rsvAdr.load( std::memory_order_seq_cst ) == T64_RSV_NONE )));
+    };
+
+    if ( timeoutUs > 0 ) mCondVar.wait_for( lk, std::chrono::microseconds( timeoutUs ), wake );
+    else                 mCondVar.wait( lk, wake );
+
+    parked.store( false, std::memory_order_release );
+}
+
+//----------------------------------------------------------------------------------------
+// Wake up a parked module. This is called after a control event was posted and
+// by anybody else who wants the module to run again. A cleared reservation only
+// needs the notify, the parked module checks the reservation itself. When the
+// module is not parked, there is nothing to do. The wake request is cleared 
+// before each batch, a request made during a batch ends the next park at once.
+//
+//----------------------------------------------------------------------------------------
+void T64ProcThreadModule::wakeModule( ) {
+
+    wakeReq.store( true, std::memory_order_seq_cst );
+    notifyParked( );
+}
+
+void T64ProcThreadModule::notifyParked( ) {
+
+    if ( parked.load( std::memory_order_seq_cst )) {
+
+        { std::lock_guard<std::mutex> lk( mLock ); }
+        mCondVar.notify_all( );
+    }
+}
+
 //----------------------------------------------------------------------------------------
 // The module thread worker routine. The module is the class for processors.
 //
@@ -166,6 +470,10 @@ T64TrapCode T64ProcThreadModule::getTrapCode( ) {
 // ensures synchronized access. If the thread was awoken we continue the main 
 // loop, where we get as first thing the new state, so we know what we should do.
 //
+// The module starts out in the RESET state. It is set before the thread is 
+// created, so that a state change requested right after the module init is
+// not overwritten by the starting thread.
+//
 // Think of it like a CPU:
 //
 //      procState = control register
@@ -173,10 +481,13 @@ T64TrapCode T64ProcThreadModule::getTrapCode( ) {
 //      wait() = halt instruction
 //      loop = fetch-decode-execute
 //
+// In the EXECUTE state the units are executed in batches. The module state is 
+// only looked at again when a batch is done and the state request flag was set.
+// A debug break event always halts the module. When running without a unit 
+// limit, a module that asked to idle is parked after the batch.
+//
 //----------------------------------------------------------------------------------------
 void T64ProcThreadModule::moduleWorker( ) {
-    
-    mState.store( T64_MOD_STATE_RESET, std::memory_order_release );
 
     while ( true ) {
 
@@ -213,8 +524,9 @@ void T64ProcThreadModule::moduleWorker( ) {
 
                 while ( true ) {
 
-                    if ( mState.load( std::memory_order_acquire )
-                            != T64_MOD_STATE_EXECUTE ) {
+                    if (( mStateReq.exchange( false, std::memory_order_acquire )) &&
+                        ( mState.load( std::memory_order_acquire ) 
+                            != T64_MOD_STATE_EXECUTE )) {
 
                         break;
                     }
@@ -228,19 +540,33 @@ void T64ProcThreadModule::moduleWorker( ) {
                         break;
                     }
 
-                    mTrapCode = executeUnit();
+                    int batch = T64_PROC_UNIT_BATCH;
+                    int done  = 0;
+
+                    if (( mUnitCount > 0 ) && ( mUnitCount < batch )) batch = mUnitCount;
 
-                    if (( mTrapCode != NO_TRAP ) && ( enterSimOnTrap )) {
+                    wakeReq.store( false, std::memory_order_seq_cst );
+                    mTrapCode = executeQuantum( batch, &done );
+
+                    if ( mUnitCount > 0 ) mUnitCount -= done;
+
+                    if ((( mTrapCode != NO_TRAP ) && ( enterSimOnTrap )) ||
+                        ( mTrapCode == DEBUG_BREAK_EVENT )) {
 
                         mState.store( T64_MOD_STATE_HALTED, 
                                       std::memory_order_release );
                         break;
                     }
 
-                    if ( mUnitCount > 0 ) mUnitCount--;
+                    T64Word timeoutUs = 0;
+
+                    if (( takeIdleRequest( &timeoutUs )) && ( mUnitCount < 0 )) {
+                        
+                        parkModule( timeoutUs );
+                    }
                 }
 
-                mCondVar.notify_one();
+                mCondVar.notify_all( );
 
             } break;
 
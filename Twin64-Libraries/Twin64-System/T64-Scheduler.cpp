@@ -0,0 +1,274 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System Scheduler
+//
+//----------------------------------------------------------------------------------------
+// The scheduler runs the processors of a system on a pool of worker threads
+// instead of their own module threads. A processor runs for one quantum of units
+// at a time on whatever worker picks it up. The caller of the run routine is
+// worker zero, the others are started for the run and joined at its end. In
+// lockstep mode, the run is a sequence of rounds. Each round, the processors
+// still active are split into one share per worker. A worker runs its share and
+// then helps the others by taking the remaining quanta from their shares. The
+// last worker arriving at the barrier sets up the next round. The quanta of a
+// round run concurrently, only with a single worker is the order of the memory
+// accesses among the processors fixed. The reproducible mode is therefore a
+// lockstep run with one worker. In relaxed mode, each worker just keeps running
+// quanta for the processors not currently busy.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License along with
+// this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-System.h"
+
+//----------------------------------------------------------------------------------------
+// The scheduler object. The default mode leaves the processors in their own
+// threads.
+//
+//----------------------------------------------------------------------------------------
+T64Scheduler::T64Scheduler( ) { }
+
+//----------------------------------------------------------------------------------------
+// Set the scheduling mode. The quantum is the number of units a processor runs
+// before the next scheduling decision. A worker count of zero means one worker
+// per host core. The reproducible mode always uses one worker, whatever count
+// is passed. The mode cannot be changed during a run.
+//
+//----------------------------------------------------------------------------------------
+bool T64Scheduler::setMode( T64SchedMode mode, int quantum, int workers ) {
+
+    if (( mode < T64_SCHED_THREADS ) || ( mode > T64_SCHED_REPRODUCIBLE )) return( false );
+    if (( quantum < 1 ) || ( workers < 0 ) || ( workers > T64_SCHED_MAX_WORKERS )) {
+
+        return( false );
+    }
+
+    if ( mode == T64_SCHED_REPRODUCIBLE ) workers = 1;
+
+    this -> mode    = mode;
+    this -> quantum = quantum;
+    this -> workers = workers;
+    return( true );
+}
+
+T64SchedMode T64Scheduler::getMode( ) {
+
+    return( mode );
+}
+
+int T64Scheduler::getQuantum( ) {
+
+    return( quantum );
+}
+
+int T64Scheduler::getWorkers( ) {
+
+    return( workers );
+}
+
+T64Word T64Scheduler::getQuanta( ) {
+
+    return( quanta.load( std::memory_order_relaxed ));
+}
+
+//----------------------------------------------------------------------------------------
+// Ask a run to stop. The workers finish the quantum they are in. In lockstep
+// mode, the current round is completed.
+//
+//----------------------------------------------------------------------------------------
+void T64Scheduler::stop( ) {
+
+    stopReq.store( true, std::memory_order_release );
+}
+
+//----------------------------------------------------------------------------------------
+// Run the processors. Each processor executes the number of units, or runs
+// until it stops on a trap or the run is stopped when the units are negative.
+// We return when all processors are done. The number of workers is never more
+// than the number of processors.
+//
+//----------------------------------------------------------------------------------------
+void T64Scheduler::run( T64ProcThreadModule **procs, int count, T64Word units ) {
+
+    if (( count <= 0 ) || ( units == 0 ) || ( mode == T64_SCHED_THREADS )) return;
+
+    slotCount = 0;
+
+    for ( int i = 0; ( i < count ) && ( i < MAX_MOD_MAP_ENTRIES ); i++ ) {
+
+        Slot &s = slots[ slotCount++ ];
+
+        s.proc  = procs[ i ];
+        s.units = units;
+        s.active.store( true, std::memory_order_relaxed );
+        s.busy.store( false, std::memory_order_relaxed );
+    }
+
+    if ( slotCount == 0 ) return;
+
+    runWorkers = ( workers > 0 ) ? workers : (int) std::thread::hardware_concurrency( );
+    if ( runWorkers > slotCount ) runWorkers = slotCount;
+    if ( runWorkers > T64_SCHED_MAX_WORKERS ) runWorkers = T64_SCHED_MAX_WORKERS;
+    if ( runWorkers < 1 ) runWorkers = 1;
+
+    activeCount.store( slotCount, std::memory_order_release );
+    stopReq.store( false, std::memory_order_release );
+    quanta.store( 0, std::memory_order_relaxed );
+
+    std::vector<std::thread> pool;
+
+    if (( mode == T64_SCHED_LOCKSTEP ) || ( mode == T64_SCHED_REPRODUCIBLE )) {
+
+        std::barrier<RoundDone> sync( runWorkers, RoundDone { this } );
+
+        startRound( );
+
+        for ( int i = 1; i < runWorkers; i++ ) {
+
+            pool.emplace_back( &T64Scheduler::lockstepWorker, this, i, &sync );
+        }
+
+        lockstepWorker( 0, &sync );
+        for ( auto &t : pool ) t.join( );
+    }
+    else {
+
+        for ( int i = 1; i < runWorkers; i++ ) {
+
+            pool.emplace_back( &T64Scheduler::relaxedWorker, this, i );
+        }
+
+        relaxedWorker( 0 );
+        for ( auto &t : pool ) t.join( );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Run one quantum for a processor. Only one worker at a time runs a processor.
+// The processor is no longer active when its units are executed, when it hit a
+// breakpoint, or when it took a trap and should enter the simulator.
+//
+//----------------------------------------------------------------------------------------
+void T64Scheduler::runSlot( int index ) {
+
+    Slot    &s      = slots[ index ];
+    int     units   = quantum;
+    int     done    = 0;
+
+    if (( s.units > 0 ) && ( s.units < units )) units = (int) s.units;
+
+    T64TrapCode trapCode = s.proc -> executeQuantum( units, &done );
+
+    if ( s.units > 0 ) s.units -= done;
+    quanta.fetch_add( 1, std::memory_order_relaxed );
+
+    if (( s.units == 0 ) ||
+        ( trapCode == DEBUG_BREAK_EVENT ) ||
+        (( trapCode != NO_TRAP ) && ( s.proc -> getEnterSimOnTrap( )))) {
+
+        s.active.store( false, std::memory_order_release );
+        activeCount.fetch_sub( 1, std::memory_order_acq_rel );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Set up a lockstep round. The active processors are listed in slot order and
+// split into equal shares. This routine runs when all workers arrived at the
+// barrier, or before the workers are started.
+//
+//----------------------------------------------------------------------------------------
+void T64Scheduler::startRound( ) {
+
+    int n = 0;
+
+    if ( ! stopReq.load( std::memory_order_acquire )) {
+
+        for ( int i = 0; i < slotCount; i++ ) {
+
+            if ( slots[ i ].active.load( std::memory_order_acquire )) roundList[ n++ ] = i;
+        }
+    }
+
+    finished = ( n == 0 );
+
+    for ( int w = 0; w < runWorkers; w++ ) {
+
+        shares[ w ].next.store( w * n / runWorkers, std::memory_order_relaxed );
+        shares[ w ].limit = ( w + 1 ) * n / runWorkers;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// The lockstep worker. We take the quanta from our own share first and then from
+// the shares of the other workers. A quantum is taken by incrementing the next
+// index of a share, so each one is run exactly once. The barrier ends a round.
+//
+//----------------------------------------------------------------------------------------
+void T64Scheduler::lockstepWorker( int index, std::barrier<RoundDone> *sync ) {
+
+    while ( ! finished ) {
+
+        for ( int k = 0; k < runWorkers; k++ ) {
+
+            Share   &sh = shares[ ( index + k ) % runWorkers ];
+            int     j   = 0;
+
+            while (( j = sh.next.fetch_add( 1, std::memory_order_relaxed )) < sh.limit ) {
+
+                runSlot( roundList[ j ] );
+            }
+        }
+
+        sync -> arrive_and_wait( );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// The relaxed worker. We look for an active processor that nobody else runs,
+// starting with the first processor of our share. When all active processors
+// are busy with other workers, we give up the host core for a moment.
+//
+//----------------------------------------------------------------------------------------
+void T64Scheduler::relaxedWorker( int index ) {
+
+    int home = index * slotCount / runWorkers;
+
+    while (( activeCount.load( std::memory_order_acquire ) > 0 ) &&
+           ( ! stopReq.load( std::memory_order_acquire ))) {
+
+        bool found = false;
+
+        for ( int k = 0; k < slotCount; k++ ) {
+
+            Slot &s = slots[ ( home + k ) % slotCount ];
+
+            if (( s.active.load( std::memory_order_acquire )) &&
+                ( ! s.busy.exchange( true, std::memory_order_acquire ))) {
+
+                if ( s.active.load( std::memory_order_acquire )) {
+
+                    runSlot(( home + k ) % slotCount );
+                    found = true;
+                }
+
+                s.busy.store( false, std::memory_order_release );
+                if ( found ) break;
+            }
+        }
+
+        if ( ! found ) std::this_thread::yield( );
+    }
+}
@@ -0,0 +1,236 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System Snapshots
+//
+//----------------------------------------------------------------------------------------
+// A snapshot captures the state of all modules in a system, so that a run can
+// later continue from that point. A snapshot is a directory with a state file,
+// which contains one record per module. The records are built in memory while
+// the modules save their state, and written as a whole. On restore, the state
+// file is read and each module finds its record and reads it back in the same
+// order it was written. Modules with a large state, such as the memory, store
+// it in their own file in the snapshot directory and refer to it by name.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License along with
+// this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-System.h"
+
+//----------------------------------------------------------------------------------------
+// Name space for local routines.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+const char  SNAP_MAGIC[ 8 ]     = { 'T', '6', '4', 'S', 'N', 'A', 'P', 0 };
+const char  *SNAP_STATE_FILE    = "state.bin";
+
+}; // namespace
+
+//----------------------------------------------------------------------------------------
+// The snapshot object. It just remembers the directory name. The directory
+// itself is created by the caller.
+//
+//----------------------------------------------------------------------------------------
+T64Snapshot::T64Snapshot( const char *dirName ) {
+
+    this -> dirName = ( dirName != nullptr ) ? dirName : "";
+}
+
+const char *T64Snapshot::getDirName( ) {
+
+    return( dirName.c_str( ));
+}
+
+const char *T64Snapshot::getBaseDirName( ) {
+
+    return( baseDirName.c_str( ));
+}
+
+void T64Snapshot::setBaseDirName( const char *name ) {
+
+    baseDirName = ( name != nullptr ) ? name : "";
+}
+
+bool T64Snapshot::isIncremental( ) {
+
+    return( ! baseDirName.empty( ));
+}
+
+//----------------------------------------------------------------------------------------
+// Build a file name in the snapshot directory. The module number is inserted
+// before the file name extension when not negative, so that two modules of the
+// same kind do not share a file. For example, "mem.img" becomes "mem-2.img".
+//
+//----------------------------------------------------------------------------------------
+bool T64Snapshot::filePath( char *buf, int bufLen, const char *name, int modNum ) {
+
+    const char  *ext    = strrchr( name, '.' );
+    int         baseLen = ( ext != nullptr ) ? (int) ( ext - name ) : (int) strlen( name );
+    int         len     = 0;
+
+    if ( ext == nullptr ) ext = "";
+
+    if ( modNum >= 0 )
+        len = snprintf( buf, bufLen, "%s/%.*s-%d%s", 
+                        dirName.c_str( ), baseLen, name, modNum, ext );
+    else
+        len = snprintf( buf, bufLen, "%s/%s", dirName.c_str( ), name );
+
+    return(( len > 0 ) && ( len < bufLen ));
+}
+
+//----------------------------------------------------------------------------------------
+// Record access. A module starts its record on save, which replaces any record
+// that was there before, and then puts its data items. On restore, the module
+// looks up its record and gets the data items in the same order. Each record
+// carries the module type, a record of another module kind is not accepted.
+//
+//----------------------------------------------------------------------------------------
+void T64Snapshot::beginModule( T64Module *mod ) {
+
+    curRecord               = &records[ mod -> getModuleNum( ) ];
+    curRecord -> modType    = mod -> getModuleType( );
+    curRecord -> data.clear( );
+    curOfs                  = 0;
+}
+
+bool T64Snapshot::findModule( T64Module *mod ) {
+
+    auto it = records.find( mod -> getModuleNum( ));
+
+    if (( it == records.end( )) || ( it -> second.modType != mod -> getModuleType( ))) {
+
+        curRecord = nullptr;
+        return( false );
+    }
+
+    curRecord   = &it -> second;
+    curOfs      = 0;
+    return( true );
+}
+
+void T64Snapshot::put( const void *data, size_t len ) {
+
+    if ( curRecord == nullptr ) return;
+
+    const uint8_t *p = (const uint8_t *) data;
+    curRecord -> data.insert( curRecord -> data.end( ), p, p + len );
+}
+
+bool T64Snapshot::get( void *data, size_t len ) {
+
+    if (( curRecord == nullptr ) || ( curOfs + len > curRecord -> data.size( ))) {
+
+        return( false );
+    }
+
+    memcpy( data, curRecord -> data.data( ) + curOfs, len );
+    curOfs += len;
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Write the state file. The header is followed by the module records. Each
+// record has a small header with module number, type and data length.
+//
+//----------------------------------------------------------------------------------------
+bool T64Snapshot::store( ) {
+
+    char path[ T64_SNAP_MAX_PATH * 2 ];
+    if ( ! filePath( path, sizeof( path ), SNAP_STATE_FILE, -1 )) return( false );
+
+    if ( baseDirName.size( ) >= T64_SNAP_MAX_PATH ) return( false );
+
+    FILE *f = fopen( path, "wb" );
+    if ( f == nullptr ) return( false );
+
+    T64SnapFileHeader hdr;
+    memset( &hdr, 0, sizeof( hdr ));
+    memcpy( hdr.magic, SNAP_MAGIC, sizeof( hdr.magic ));
+    hdr.version = T64_SNAP_VERSION;
+    hdr.records = (uint32_t) records.size( );
+    strncpy( hdr.baseDirName, baseDirName.c_str( ), T64_SNAP_MAX_PATH - 1 );
+
+    bool rStat = ( fwrite( &hdr, sizeof( hdr ), 1, f ) == 1 );
+
+    for ( auto &r : records ) {
+
+        if ( ! rStat ) break;
+
+        T64SnapRecordHeader rHdr;
+        rHdr.modNum     = r.first;
+        rHdr.modType    = r.second.modType;
+        rHdr.len        = r.second.data.size( );
+
+        rStat = ( fwrite( &rHdr, sizeof( rHdr ), 1, f ) == 1 );
+
+        if (( rStat ) && ( rHdr.len > 0 )) {
+
+            rStat = ( fwrite( r.second.data.data( ), rHdr.len, 1, f ) == 1 );
+        }
+    }
+
+    if ( fclose( f ) != 0 ) rStat = false;
+    return( rStat );
+}
+
+//----------------------------------------------------------------------------------------
+// Read the state file. We check the magic word and version and then read all
+// records. Any inconsistency rejects the entire snapshot.
+//
+//----------------------------------------------------------------------------------------
+bool T64Snapshot::load( ) {
+
+    char path[ T64_SNAP_MAX_PATH * 2 ];
+    if ( ! filePath( path, sizeof( path ), SNAP_STATE_FILE, -1 )) return( false );
+
+    FILE *f = fopen( path, "rb" );
+    if ( f == nullptr ) return( false );
+
+    records.clear( );
+    curRecord = nullptr;
+
+    T64SnapFileHeader hdr;
+
+    bool rStat = ( fread( &hdr, sizeof( hdr ), 1, f ) == 1 )                &&
+                 ( memcmp( hdr.magic, SNAP_MAGIC, sizeof( hdr.magic )) == 0 ) &&
+                 ( hdr.version == T64_SNAP_VERSION );
+
+    if ( rStat ) {
+
+        hdr.baseDirName[ T64_SNAP_MAX_PATH - 1 ] = 0;
+        baseDirName = hdr.baseDirName;
+    }
+
+    for ( uint32_t i = 0; ( rStat ) && ( i < hdr.records ); i++ ) {
+
+        T64SnapRecordHeader rHdr;
+
+        rStat = ( fread( &rHdr, sizeof( rHdr ), 1, f ) == 1 );
+        if ( ! rStat ) break;
+
+        Record &r = records[ rHdr.modNum ];
+        r.modType = rHdr.modType;
+        r.data.resize( rHdr.len );
+
+        if ( rHdr.len > 0 ) rStat = ( fread( r.data.data( ), rHdr.len, 1, f ) == 1 );
+    }
+
+    fclose( f );
+    if ( ! rStat ) records.clear( );
+    return( rStat );
+}
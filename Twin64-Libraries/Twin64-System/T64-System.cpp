@@ -25,6 +25,12 @@
 //----------------------------------------------------------------------------------------
 #include "T64-System.h"
 
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 //----------------------------------------------------------------------------------------
 // Name space for local routines.
 //
@@ -135,6 +141,67 @@ void removeFromMap( T64Module **map, T64Module *module, int *hwm ) {
     }
 }
 
+//----------------------------------------------------------------------------------------
+// Add the SPA ranges of a module map to the address decode map. The entries are
+// inserted sorted by start address.
+//
+//----------------------------------------------------------------------------------------
+void addToDecodeMap( T64AdrDecodeEntry *decodeMap, 
+                     int               *decodeHwm, 
+                     T64Module         **map, 
+                     int               hwm ) {
+
+    for ( int i = 0; i < hwm; i++ ) {
+
+        T64AdrDecodeEntry e;
+        
+        e.start  = map[ i ] -> getSpaAdr( );
+        e.limit  = e.start + map[ i ] -> getSpaLen( );
+        e.module = map[ i ];
+
+        int pos = *decodeHwm;
+
+        while (( pos > 0 ) && ( decodeMap[ pos - 1 ].start > e.start )) {
+
+            decodeMap[ pos ] = decodeMap[ pos - 1 ];
+            pos --;
+        }
+
+        decodeMap[ pos ] = e;
+        (*decodeHwm) ++;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Hash functions for the reservation and code page directory. 
+//
+//----------------------------------------------------------------------------------------
+int rsvDirIndex( T64Word pAdr ) {
+
+    return((int) (( pAdr / T64_RSV_LINE_SIZE ) & ( T64_RSV_DIR_ENTRIES - 1 )));
+}
+
+int codeDirIndex( T64Word pAdr ) {
+
+    return((int) (( pAdr / T64_PAGE_SIZE_BYTES ) & ( T64_CODE_DIR_ENTRIES - 1 )));
+}
+
+//----------------------------------------------------------------------------------------
+// Create the snapshot directory. An existing directory is fine, its files are
+// just replaced.
+//
+//----------------------------------------------------------------------------------------
+bool makeSnapDir( const char *dirName ) {
+
+#ifdef _WIN32
+    int rc = _mkdir( dirName );
+#else
+    int rc = mkdir( dirName, 0755 );
+#endif
+
+    return(( rc == 0 ) || ( errno == EEXIST ));
+}
+
 }; // namespace
 
 //----------------------------------------------------------------------------------------
@@ -143,7 +210,10 @@ void removeFromMap( T64Module **map, T64Module *module, int *hwm ) {
 //----------------------------------------------------------------------------------------
 T64System::T64System( ) {
 
-   initModuleMap( );
+    for ( int i = 0; i < T64_RSV_DIR_ENTRIES; i++ ) rsvDir[ i ] = 0;
+    for ( int i = 0; i < T64_CODE_DIR_ENTRIES; i++ ) codeDir[ i ] = 0;
+
+    initModuleMap( );
 }
 
 //----------------------------------------------------------------------------------------
@@ -169,6 +239,54 @@ void T64System::initModuleMap( ) {
     systemPhysMemMapHwm     = 0;
     systemIoMemMapHwm      = 0;
     systemProcMapHwm     = 0;
+
+    buildAdrDecodeMap( );
+    buildControlEventMap( );
+}
+
+//----------------------------------------------------------------------------------------
+// Build the address decode map. The physical memory and IO maps are combined
+// into one map sorted by address. The map is rebuilt whenever a module is 
+// added or removed. 
+//
+//----------------------------------------------------------------------------------------
+void T64System::buildAdrDecodeMap( ) {
+
+    adrDecodeMapHwm = 0;
+
+    addToDecodeMap( adrDecodeMap, &adrDecodeMapHwm, 
+                    systemPhysMemMap, systemPhysMemMapHwm );
+
+    addToDecodeMap( adrDecodeMap, &adrDecodeMapHwm, 
+                    systemIoMemMap, systemIoMemMapHwm );
+}
+
+//----------------------------------------------------------------------------------------
+// Build the control event map. For each control event there is a dense list of
+// the modules that subscribed to it, so that a broadcast only visits them. The
+// map is rebuilt whenever a module is added or removed.
+//
+//----------------------------------------------------------------------------------------
+void T64System::buildControlEventMap( ) {
+
+    for ( int e = 0; e < T64_CNTRL_EVENT_MAX; e++ ) {
+
+        int hwm = 0;
+
+        for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+            T64Module *mPtr = moduleMap[ i ];
+
+            if (( mPtr != nullptr ) && 
+                ( mPtr -> getControlEventMask( ) & 
+                  controlEventBit((T64BBusOpControlEvents) e ))) {
+
+                ctrlEventMap[ e ][ hwm++ ] = mPtr;
+            }
+        }
+
+        ctrlEventMapHwm[ e ] = hwm;
+    }
 }
 
 //----------------------------------------------------------------------------------------
@@ -209,12 +327,12 @@ int T64System::addModule( T64Module *module ) {
 
         for ( int i = 0; i < systemPhysMemMapHwm; ++i ) {
 
-            if ( overlap( moduleMap[ i ], module )) return ( -3 );
+            if ( overlap( systemPhysMemMap[ i ], module )) return ( -3 );
         }
 
         for ( int i = 0; i < systemIoMemMapHwm; ++i ) {
 
-            if ( overlap( moduleMap[ i ], module )) return ( -3 );
+            if ( overlap( systemIoMemMap[ i ], module )) return ( -3 );
         }
 
         if ( isIo ) {
@@ -233,6 +351,8 @@ int T64System::addModule( T64Module *module ) {
         }
     
         if ( rStat != 0 ) return( -2 );
+
+        buildAdrDecodeMap( );
     }
 
     moduleMap[ module -> getModuleNum( ) ] = module;    
@@ -247,6 +367,7 @@ int T64System::addModule( T64Module *module ) {
         if ( rStat != 0 ) return( -2 );
     }
 
+    buildControlEventMap( );
     module -> initModule( );
     return ( 0 );
 }
@@ -272,7 +393,9 @@ int T64System::removeModule( T64Module *module ) {
     removeFromMap( systemPhysMemMap, module, &systemPhysMemMapHwm );
     removeFromMap( systemIoMemMap, module, &systemIoMemMapHwm );
     removeFromMap( systemProcMap, module, &systemProcMapHwm );
+    buildAdrDecodeMap( );
     moduleMap[ modNum ] = nullptr;
+    buildControlEventMap( );
     delete module;
 
     return ( 0 );
@@ -304,19 +427,19 @@ T64Module *T64System::lookupByModuleType( T64ModuleType typ ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Find the module entry that covers the address. Since we have only a small
-// number of module, we do a simple linear search of the system map. We check 
-// whether the address is in the MEM or IO SPA or HPA address range. We return
-// the first match, which is ok since the address ranges cannot overlap. 
-//
-// For performance reasons there is a certain order how we search. We will 
-// first check with a simple HPA range comparison whether we look at an HPA 
-// address range. Next, we will look at the MEM SPA range followed by the IO
-// SPA range. Access to the MEM SPA range, which holds the physical memory, is
-// by far the most performed access.
+// Find the module entry that covers the address. We first check with a simple 
+// HPA range comparison whether we look at an HPA address range. The module 
+// number is then directly encoded in the address. All other addresses are 
+// looked up in the address decode map. Consecutive accesses of a module tend to
+// go to the same target, so when the requesting module is passed, we first check
+// the map entry of its last lookup. The hint is kept in the requesting module, 
+// on a cache line of its own. It is only written by the thread running that 
+// module and thus does not move between the host cores. Otherwise, a binary 
+// search on the sorted map finds the entry with the highest start address not
+// above the address, which covers the address if it is below its limit.
 //
 //----------------------------------------------------------------------------------------
-T64Module *T64System::lookupByAdr ( T64Word adr ) const {
+T64Module *T64System::lookupByAdr ( T64Word adr, T64Module *src ) const {
 
     if (( adr >= T64_IO_HPA_MEM_START ) && ( adr < T64_IO_HPA_MEM_LIMIT )) {
 
@@ -328,28 +451,62 @@ T64Module *T64System::lookupByAdr ( T64Word adr ) const {
     }
     else {
 
-        for ( int i = 0; i < systemPhysMemMapHwm; i++ ) {
-
-            T64Module *mPtr = systemPhysMemMap[ i ];
+        int last = ( src != nullptr ) ? 
+                   src -> adrDecodeHint.index.load( std::memory_order_relaxed ) : 0;
 
-            if (( adr >= mPtr -> getSpaAdr( )) && 
-                ( adr <  mPtr -> getSpaAdr( ) + mPtr -> getSpaLen( ))) 
-                return ( mPtr ); 
+        if (( last < adrDecodeMapHwm ) &&
+            ( adr >= adrDecodeMap[ last ].start ) && 
+            ( adr <  adrDecodeMap[ last ].limit )) {
+            
+            return( adrDecodeMap[ last ].module );
         }
 
-        for ( int i = 0; i < systemIoMemMapHwm; i++ ) {
+        int lo = 0;
+        int hi = adrDecodeMapHwm - 1;
+
+        while ( lo <= hi ) {
 
-            T64Module *mPtr = systemIoMemMap[ i ];
+            int mid = ( lo + hi ) / 2;
 
-            if (( adr >= mPtr -> getSpaAdr( )) && 
-                ( adr <  mPtr -> getSpaAdr( ) + mPtr -> getSpaLen( ))) 
-                return ( mPtr ); 
+            if      ( adr < adrDecodeMap[ mid ].start ) hi = mid - 1;
+            else if ( adr >= adrDecodeMap[ mid ].limit ) lo = mid + 1;
+            else {
+
+                if ( src != nullptr ) {
+
+                    src -> adrDecodeHint.index.store( mid, std::memory_order_relaxed );
+                }
+
+                return( adrDecodeMap[ mid ].module );
+            }
         }
 
         return nullptr;
     }
 } 
 
+//----------------------------------------------------------------------------------------
+// Direct memory access. We look up the module that covers the physical address
+// and ask it for the host memory address of the page. Only memory modules that
+// fully cover the page will return a pointer. For all other cases, such as the
+// IO address range, the caller uses the regular bus operations. When there are
+// processor caches, memory could be older than a cached line, and all access
+// needs to go through the bus operations.
+//
+//----------------------------------------------------------------------------------------
+uint8_t *T64System::getHostPagePtr( T64Word pAdr, bool wMode, bool *writable ) {
+
+    *writable = false;
+
+    if ( isInIoAdrRange( pAdr )) return( nullptr );
+    if ( cacheCount.load( std::memory_order_relaxed ) > 0 ) return( nullptr );
+
+    T64Module *mPtr = lookupByAdr( pAdr );
+    if ( mPtr == nullptr ) return( nullptr );
+
+    return( mPtr -> getHostPagePtr( pAdr, wMode, writable ));
+}
+
 //----------------------------------------------------------------------------------------
 // Get the module type.
 //
@@ -424,27 +581,142 @@ void T64System::execModule( int modNum, int units, bool haltOnTrap ) {
 }
 
 //----------------------------------------------------------------------------------------
-// RUN. The simulator can just run the system. We just enter an endless loop 
-// which single steps all modules. 
+// The scheduling mode. By default, the processors run in their module threads.
+// The scheduler can instead run them on a pool of workers, in lockstep or in 
+// relaxed mode, or on a single worker in reproducible mode.
+//
+//----------------------------------------------------------------------------------------
+bool T64System::setSchedMode( T64SchedMode mode, int quantum, int workers ) {
+
+    return( scheduler.setMode( mode, quantum, workers ));
+}
+
+T64Scheduler *T64System::getScheduler( ) {
+
+    return( &scheduler );
+}
+
+//----------------------------------------------------------------------------------------
+// RUN. The simulator can just run the system. All processors execute the number
+// of units, a negative number runs them until they stop. With the module threads,
+// we return right away when running without a limit, otherwise we wait until 
+// all processors have executed their units. With the scheduler, we return when 
+// all processors are done. Only processors that are halted take part in a run
+// by the scheduler, a processor running in its module thread is left alone.
+//
+//----------------------------------------------------------------------------------------
+void T64System::run( T64Word units ) {
+
+    T64ProcThreadModule *procs[ MAX_MOD_MAP_ENTRIES ];
+    int                 count = 0;
+
+    for ( int i = 0; i < systemProcMapHwm; i++ ) {
+
+        if ( auto *m = dynamic_cast<T64ProcThreadModule *>( systemProcMap[ i ] )) {
+
+            procs[ count++ ] = m;
+        }
+    }
+
+    if ( scheduler.getMode( ) == T64_SCHED_THREADS ) {
+
+        for ( int i = 0; i < count; i++ ) {
+
+            if ( units < 0 ) procs[ i ] -> runModule( );
+            else procs[ i ] -> execModule((int) units, procs[ i ] -> getEnterSimOnTrap( ));
+        }
+
+        if ( units >= 0 ) {
+
+            for ( int i = 0; i < count; i++ ) procs[ i ] -> waitUntilStopped( );
+        }
+    }
+    else {
+
+        int halted = 0;
+
+        for ( int i = 0; i < count; i++ ) {
+
+            if ( procs[ i ] -> getModuleState( ) == T64_MOD_STATE_HALTED ) {
+
+                procs[ halted++ ] = procs[ i ];
+            }
+        }
+
+        scheduler.run( procs, halted, units );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Stop a run. The module threads are halted, a scheduler run is asked to stop
+// after the current quantum.
 //
 //----------------------------------------------------------------------------------------
-void T64System::run( ) {
+void T64System::stopRun( ) {
+
+    scheduler.stop( );
+
+    for ( int i = 0; i < systemProcMapHwm; i++ ) {
+
+        if ( auto *m = dynamic_cast<T64ProcThreadModule *>( systemProcMap[ i ] )) {
+            
+            m -> haltModule( );
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// A system is running while one of its processors executes.
+//
+//----------------------------------------------------------------------------------------
+bool T64System::isRunning( ) {
+
+    for ( int i = 0; i < systemProcMapHwm; i++ ) {
 
-    // ??? signal all processors 
+        auto p = dynamic_cast<T64ProcThreadModule*>( systemProcMap[ i ] );
+        if (( p != nullptr ) && ( p -> getModuleState( ) == T64_MOD_STATE_EXECUTE )) return( true );
+    }
+
+    return( false );
 }
 
 //----------------------------------------------------------------------------------------
 // Bus read operation. The system is the dispatcher for bus operations. We look
 // up the module that covers the address and call the module's bus event handler. 
 // The module can react to the bus event and return true if it has handled the 
-// event, or false if it has not handled the event. 
+// event, or false if it has not handled the event. When processors with caches
+// are present, a modified copy of the memory line is written back first.
 //
 //----------------------------------------------------------------------------------------
 bool T64System::busOpRead( T64Module *mod, T64Word pAdr, uint8_t *data, int len ) {
 
-    T64Module *mPtr = lookupByAdr( pAdr );
+    T64Module *mPtr = lookupByAdr( pAdr, mod );
     if ( mPtr == nullptr ) return( false );
 
+    std::unique_lock<std::recursive_mutex> lk( cohLock, std::defer_lock );
+
+    if ( snoopRequired( pAdr )) {
+
+        lk.lock( );
+        snoopCaches( nullptr, T64_CNTRL_EVENT_CACHE_FLUSH, pAdr, len );
+    }
+
+    return ( mPtr -> busOpReadEvent( pAdr, data, len ));
+}
+
+//----------------------------------------------------------------------------------------
+// Bus peek operation. The peek reads memory for a look at it while processors
+// run. There is no cache snoop, so the peek does not change the cache state of
+// a running processor, but a line modified in a cache is seen with its older 
+// memory content. Only memory modules are read, an IO module may react to a
+// read.
+//
+//----------------------------------------------------------------------------------------
+bool T64System::busOpPeek( T64Word pAdr, uint8_t *data, int len ) {
+
+    T64Module *mPtr = lookupByAdr( pAdr );
+    if (( mPtr == nullptr ) || ( mPtr -> getModuleType( ) != MT_MEM )) return( false );
+
     return ( mPtr -> busOpReadEvent( pAdr, data, len ));
 }
 
@@ -452,8 +724,9 @@ bool T64System::busOpRead( T64Module *mod, T64Word pAdr, uint8_t *data, int len
 // Bus read and reserve operation. The LDR instruction implements our foundation
 // for mutexes, semaphores, etc. A bus read reserved operation will just as the 
 // normal read operation read the data value, and also remember the address 
-// used. The operation needs to be protected by a mutex, as we potentially run 
-// several processors.
+// and the data value read. The reservation is entered in the reservation
+// directory before the data is read. A store to the line that is not seen by
+// the read will therefore see the reservation and clear it.
 //
 //----------------------------------------------------------------------------------------
 bool T64System::busOpReadRsv( T64Module *mod, 
@@ -461,55 +734,140 @@ bool T64System::busOpReadRsv( T64Module *mod,
                               uint8_t *data, 
                               int len ) {
 
-    {
-        std::lock_guard<std::mutex> lk(sLock);
+    T64Module *mPtr = lookupByAdr( pAdr, mod );
+    if ( mPtr == nullptr ) return( false );
 
-        if (dynamic_cast<T64ProcThreadModule*>( mod )) {
+    std::unique_lock<std::recursive_mutex> lk( cohLock, std::defer_lock );
 
-           (( T64ProcThreadModule *) mod ) -> setRsvInfo( pAdr, true );
-        }
+    if ( snoopRequired( pAdr )) {
+
+        lk.lock( );
+        snoopCaches( nullptr, T64_CNTRL_EVENT_CACHE_FLUSH, pAdr, len );
     }
 
+    auto p = dynamic_cast<T64ProcThreadModule*>( mod );
+    if ( p == nullptr ) return( mPtr -> busOpReadEvent( pAdr, data, len ));
+
+    rsvDir[ rsvDirIndex( pAdr ) ].fetch_add( 1 );
+    rsvCount.fetch_add( 1 );
+
+    releaseRsv( p -> setRsv( pAdr ));
+
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    if ( ! mPtr -> busOpReadEvent( pAdr, data, len )) {
+
+        clearReservation( p );
+        return( false );
+    }
+
+    T64Word rsvData = 0;
+    memcpy( &rsvData, data, len );
+    p -> setRsvData( rsvData );
+
     return ( true );
 }
 
 //----------------------------------------------------------------------------------------
 // Bus write operation. The system is the dispatcher for bus operations. We look
 // up the module that covers the address and call the module's bus event handler.
-// Since the write operation could potentially address a location used by a 
-// LDR/STC instruction, we need to synchronize access and if there is an address
-// match clear the reservation.
+// The write operation could potentially address a location used by a LDR/STC 
+// instruction or a page processors have decoded instructions from. Both cases
+// are handled by the store notification after the write. Any cached copy of
+// the memory line is removed from the processor caches before the write.
 //
 //----------------------------------------------------------------------------------------
 bool T64System::busOpWrite( T64Module *mod, T64Word pAdr, uint8_t *data, int len ) {
 
-    T64Module *mPtr = lookupByAdr( pAdr );
+    T64Module *mPtr = lookupByAdr( pAdr, mod );
     if ( mPtr == nullptr ) return ( false );
 
-    bool rStat;
+    std::unique_lock<std::recursive_mutex> lk( cohLock, std::defer_lock );
 
-    {
-        std::lock_guard<std::mutex> lk(sLock);
-        rStat = mPtr -> busOpWriteEvent( pAdr, data, len );
+    if ( snoopRequired( pAdr )) {
 
-        for ( int i = 0; i < systemProcMapHwm; i ++ ) {
+        lk.lock( );
+        snoopCaches( nullptr, T64_CNTRL_EVENT_CACHE_PURGE, pAdr, len );
+    }
 
-            if ( auto p = dynamic_cast<T64ProcThreadModule*>( systemProcMap[ i ] )) {
+    bool rStat = mPtr -> busOpWriteEvent( pAdr, data, len );
+    storeNotify( mod, pAdr, len );
 
-                if (( p -> isRsvValid( )) && ( p -> getRsvInfo( ) == pAdr )) {
+    return ( rStat );
+}
 
-                    p -> setRsvInfo( pAdr, false );
+//----------------------------------------------------------------------------------------
+// Store notification. A processor that stores directly into host memory did 
+// not go through the bus write operation. It still needs to inform the other
+// processors about the store, which is what this bus operation does. 
+//
+//----------------------------------------------------------------------------------------
+void T64System::busOpStoreNotify( T64Module *mod, T64Word pAdr, int len ) {
+
+    storeNotify( mod, pAdr, len );
+}
+
+//----------------------------------------------------------------------------------------
+// The actual store notification, called after the data was written. Most 
+// stores neither hit a reserved memory line nor a decoded code page. We check
+// the two directories and only if there is a hit, the processors are visited. 
+// A reservation on the memory line is cleared. For a code page, the processors
+// are informed with a store event, a processor could have decoded instructions
+// from the target page. The fence orders the store before the directory checks,
+// matching the directory updates done before the memory is read. There is no 
+// lock, the processor map only changes while the system is configured.
+//
+//----------------------------------------------------------------------------------------
+void T64System::storeNotify( T64Module *mod, T64Word pAdr, int len ) {
+
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    if ( rsvCount.load( std::memory_order_relaxed ) > 0 ) {
+
+        if ( len > T64_RSV_LINE_SIZE * ( systemProcMapHwm + 1 )) {
+
+            invalidateRsvRange( pAdr, len );
+        }
+        else {
+
+            for ( T64Word lAdr = rounddown( pAdr, T64_RSV_LINE_SIZE ); 
+                  lAdr < pAdr + len; 
+                  lAdr += T64_RSV_LINE_SIZE ) {
+
+                if ( rsvDir[ rsvDirIndex( lAdr ) ].load( std::memory_order_relaxed ) > 0 ) {
+                    
+                    invalidateRsv( lAdr );
                 }
             }
         }
     }
 
-    return ( rStat );
+    for ( T64Word pgAdr = rounddown( pAdr, T64_PAGE_SIZE_BYTES ); 
+          pgAdr < pAdr + len; 
+          pgAdr += T64_PAGE_SIZE_BYTES ) {
+
+        if ( codeDir[ codeDirIndex( pgAdr ) ].load( std::memory_order_relaxed ) > 0 ) {
+
+            for ( int i = 0; i < systemProcMapHwm; i ++ ) {
+
+                systemProcMap[ i ] -> busOpControlEvent( T64_CNTRL_EVENT_STORE_OP, pgAdr, len );
+            }
+        }
+    }
 }
 
 //----------------------------------------------------------------------------------------
-// Bus write conditional operation.This bus operation is only used by the STC 
-// instruction. 
+// Bus write conditional operation. This bus operation is only used by the STC 
+// instruction. The reservation of the requesting processor is consumed in any
+// case. If it was held for the address and memory still contains the data value
+// read by the LDR instruction, the data is written and the other processors are
+// informed about the store. The comparison and the write are one conditional 
+// write of the module, for memory a host compare and exchange. A plain store 
+// does not take any lock. It happens either before the conditional write, and
+// the comparison fails, or after it, so it is never overwritten with stale 
+// data. The memory line is locked for the reservation handling, so that two 
+// processors holding a reservation for the same address cannot both succeed. 
+// The result tells whether the data was written.
 //
 //----------------------------------------------------------------------------------------
 bool T64System::busOpWriteCond( T64Module *mod,
@@ -517,39 +875,490 @@ bool T64System::busOpWriteCond( T64Module *mod,
                                 uint8_t *data, 
                                 int     len ) {
 
-    T64Module *mPtr = lookupByAdr( pAdr );
+    T64Module *mPtr = lookupByAdr( pAdr, mod );
     if ( mPtr == nullptr ) return ( false );
 
+    auto p = dynamic_cast<T64ProcThreadModule*>( mod );
+    if ( p == nullptr ) return ( false );
+
+    std::unique_lock<std::recursive_mutex> lk( cohLock, std::defer_lock );
+
+    if ( snoopRequired( pAdr )) {
+
+        lk.lock( );
+        snoopCaches( nullptr, T64_CNTRL_EVENT_CACHE_PURGE, pAdr, len );
+    }
+
+    if ( p -> getRsvAdr( ) != pAdr ) {
+
+        clearReservation( p );
+        return ( false );
+    }
+
     bool rStat = false;
 
-    {
-        std::lock_guard<std::mutex> lk(sLock);
+    mPtr -> lockLine( pAdr );
 
-        if ( auto p = dynamic_cast<T64ProcThreadModule*>( mPtr )) {
+    T64Word rsvData = p -> getRsvData( );
 
-            if (( p -> isRsvValid( )) && ( p -> getRsvInfo( ) == pAdr )) {
+    if ( p -> clearRsv( pAdr )) {
 
-                rStat = mPtr -> busOpWriteEvent( pAdr, data, len );
-                rStat = true;
-            }
+        releaseRsv( pAdr );
+
+        rStat = mPtr -> busOpWriteCondEvent( pAdr, (uint8_t *) &rsvData, data, len );
+    }
+
+    if ( rStat ) storeNotify( mod, pAdr, len );
+
+    mPtr -> unlockLine( pAdr );
+    return ( rStat );
+}
+
+//----------------------------------------------------------------------------------------
+// Cache coherence. Processors can have caches, which hold copies of memory 
+// lines. A modified line is only written back to memory when it is replaced or
+// another party asks for it. Every access to a memory line that could be in a
+// cache therefore first informs the processors. A read sends a flush event, a
+// cache holding the line modified writes it back and keeps a shared copy. A 
+// write sends a purge event, a cache writes back the line if modified and 
+// removes it. Stores to a line held modified in a cache are seen by the store
+// notification just as direct memory stores are, so that LDR and STC work with
+// caches as well.
+//
+// All coherence work is serialized by the coherence lock, which is the system
+// wide order of all cache line transfers. A cache holds the lock while it 
+// handles a miss, so that the line cannot be requested by another cache before
+// it is entered. The lock is recursive, the bus operations below take it as 
+// well. Without caches in the system, none of this is done.
+//
+//----------------------------------------------------------------------------------------
+void T64System::registerCache( ) {
+
+    cacheCount.fetch_add( 1 );
+}
+
+void T64System::unregisterCache( ) {
+
+    cacheCount.fetch_sub( 1 );
+}
+
+void T64System::lockCoherence( ) {
+
+    cohLock.lock( );
+}
+
+void T64System::unlockCoherence( )  {
+
+    cohLock.unlock( );
+}
+
+bool T64System::snoopRequired( T64Word pAdr ) {
+
+    return(( cacheCount.load( std::memory_order_relaxed ) > 0 ) && 
+           ( ! isInIoAdrRange( pAdr )));
+}
+
+//----------------------------------------------------------------------------------------
+// Send a cache event to all processors except the requesting module. We are 
+// called with the coherence lock held.
+//
+//----------------------------------------------------------------------------------------
+void T64System::snoopCaches( T64Module              *mod,
+                             T64BBusOpControlEvents event,
+                             T64Word                pAdr, 
+                             int                    len ) {
+
+    for ( int i = 0; i < systemProcMapHwm; i ++ ) {
+
+        if ( systemProcMap[ i ] != mod ) {
+            
+            systemProcMap[ i ] -> busOpControlEvent( event, pAdr, len );
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Block bus operations. A cache transfers an entire memory line. The block is 
+// aligned to its length, which is a multiple of the word size. A block read is
+// transferred one word at a time, a block write is passed to the module as one
+// block write event. A shared read lets the other caches write back a modified
+// line and keep their copy, a private read also removes their copy, since the
+// requesting cache is about to modify the line. A block write stores a line in
+// memory, any other cached copy is removed. The requesting module handles its 
+// own caches.
+//
+//----------------------------------------------------------------------------------------
+bool T64System::busOpReadSharedBlock( T64Module *mod,
+                                      T64Word   pAdr, 
+                                      uint8_t   *data, 
+                                      int       len ) {
+
+    T64Module *mPtr = lookupByAdr( pAdr, mod );
+    if ( mPtr == nullptr ) return( false );
+
+    std::lock_guard<std::recursive_mutex> lk( cohLock );
+
+    snoopCaches( mod, T64_CNTRL_EVENT_CACHE_FLUSH, pAdr, len );
+
+    for ( int i = 0; i < len; i += sizeof( T64Word )) {
+
+        if ( ! mPtr -> busOpReadEvent( pAdr + i, data + i, sizeof( T64Word ))) {
+            
+            return( false );
         }
+    }
 
-        for ( int i = 0; i < systemProcMapHwm; i ++ ) {
+    return( true );
+}
 
-            if ( systemProcMap[ i ] != mod ) {
-                
-                busOpControl( mod, T64_CNTRL_EVENT_STORE_OP, pAdr, 0 );
-            }
+bool T64System::busOpReadPrivateBlock( T64Module *mod,
+                                       T64Word   pAdr, 
+                                       uint8_t   *data, 
+                                       int       len ) {
+
+    T64Module *mPtr = lookupByAdr( pAdr, mod );
+    if ( mPtr == nullptr ) return( false );
+
+    std::lock_guard<std::recursive_mutex> lk( cohLock );
+
+    snoopCaches( mod, T64_CNTRL_EVENT_CACHE_PURGE, pAdr, len );
+
+    for ( int i = 0; i < len; i += sizeof( T64Word )) {
+
+        if ( ! mPtr -> busOpReadEvent( pAdr + i, data + i, sizeof( T64Word ))) {
+            
+            return( false );
         }
     }
 
-    return ( rStat );
+    return( true );
+}
+
+bool T64System::busOpWriteBlock( T64Module *mod,
+                                 T64Word   pAdr, 
+                                 uint8_t   *data, 
+                                 int       len ) {
+
+    T64Module *mPtr = lookupByAdr( pAdr, mod );
+    if ( mPtr == nullptr ) return( false );
+
+    std::lock_guard<std::recursive_mutex> lk( cohLock );
+
+    snoopCaches( mod, T64_CNTRL_EVENT_CACHE_PURGE, pAdr, len );
+
+    if ( ! mPtr -> busOpWriteBlockEvent( pAdr, data, len )) return( false );
+
+    storeNotify( mod, pAdr, len );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// DMA bus operations. A DMA read copies a block of physical memory of any 
+// length and alignment to a host buffer, a DMA write copies a host buffer to 
+// physical memory and a DMA fill sets a block to a byte value. This is how a 
+// loader or an I/O module moves large amounts of data. The scatter/gather 
+// operations transfer a list of blocks. A block may span several modules. For
+// each module range, the module is looked up once and the range is transferred
+// with one block event. The caches are asked once for the range to write back
+// their modified lines, or to remove their copies for a write. After a write,
+// the reservations and code pages in the range are handled as for a store.
+//
+//----------------------------------------------------------------------------------------
+bool T64System::busOpDmaRead( T64Module *mod,
+                              T64Word   pAdr,
+                              uint8_t   *data,
+                              T64Word   len ) {
+
+    if ( data == nullptr ) return( false );
+    return( dmaTransfer( mod, T64_DMA_READ, pAdr, data, 0, len ));
+}
+
+bool T64System::busOpDmaWrite( T64Module        *mod,
+                               T64Word          pAdr,
+                               const uint8_t    *data,
+                               T64Word          len ) {
+
+    if ( data == nullptr ) return( false );
+    return( dmaTransfer( mod, T64_DMA_WRITE, pAdr, (uint8_t *) data, 0, len ));
+}
+
+bool T64System::busOpDmaFill( T64Module *mod,
+                              T64Word   pAdr,
+                              uint8_t   val,
+                              T64Word   len ) {
+
+    return( dmaTransfer( mod, T64_DMA_FILL, pAdr, nullptr, val, len ));
+}
+
+bool T64System::busOpDmaReadV( T64Module *mod, const T64DmaDesc *desc, int count ) {
+
+    for ( int i = 0; i < count; i++ ) {
+
+        if ( ! busOpDmaRead( mod, desc[ i ].pAdr, desc[ i ].data, desc[ i ].len )) {
+            
+            return( false );
+        }
+    }
+
+    return( true );
+}
+
+bool T64System::busOpDmaWriteV( T64Module *mod, const T64DmaDesc *desc, int count ) {
+
+    for ( int i = 0; i < count; i++ ) {
+
+        if ( ! busOpDmaWrite( mod, desc[ i ].pAdr, desc[ i ].data, desc[ i ].len )) {
+            
+            return( false );
+        }
+    }
+
+    return( true );
+}
+
+bool T64System::dmaTransfer( T64Module      *mod, 
+                             T64DmaOp       op,
+                             T64Word        pAdr, 
+                             uint8_t        *data, 
+                             uint8_t        val, 
+                             T64Word        len ) {
+
+    if ( len < 0 ) return( false );
+
+    while ( len > 0 ) {
+
+        T64Module *mPtr = lookupByAdr( pAdr, mod );
+        if ( mPtr == nullptr ) return( false );
+
+        T64Word chunk = mPtr -> getSpaAdr( ) + mPtr -> getSpaLen( ) - pAdr;
+        if ( chunk > len ) chunk = len;
+        if ( chunk > T64_DMA_MAX_CHUNK ) chunk = T64_DMA_MAX_CHUNK;
+
+        std::unique_lock<std::recursive_mutex> lk( cohLock, std::defer_lock );
+
+        if ( snoopRequired( pAdr )) {
+
+            lk.lock( );
+            snoopCaches( mod, 
+                         ( op == T64_DMA_READ ) ? T64_CNTRL_EVENT_CACHE_FLUSH : 
+                                                  T64_CNTRL_EVENT_CACHE_PURGE,
+                         pAdr, 
+                         (int) chunk );
+        }
+
+        bool rStat = false;
+
+        switch ( op ) {
+
+            case T64_DMA_READ:  rStat = mPtr -> busOpReadBlockEvent( pAdr, data, chunk ); break;
+            case T64_DMA_WRITE: rStat = mPtr -> busOpWriteBlockEvent( pAdr, data, chunk ); break;
+            case T64_DMA_FILL:  rStat = mPtr -> busOpFillBlockEvent( pAdr, val, chunk ); break;
+        }
+
+        if ( ! rStat ) return( false );
+
+        if ( op != T64_DMA_READ ) storeNotify( mod, pAdr, (int) chunk );
+
+        pAdr    += chunk;
+        len     -= chunk;
+        if ( data != nullptr ) data += chunk;
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Reservation directory. A reservation that was removed from a processor is 
+// released in the directory. Clearing the reservation of a processor, for 
+// example on a trap, goes through the system, so that the directory stays in
+// sync. A store to a memory line with reservations in the directory clears the
+// reservations of all processors on that line. A store to a large range, such
+// as a DMA write, just checks the reservation of each processor.
+//
+//----------------------------------------------------------------------------------------
+void T64System::releaseRsv( T64Word pAdr ) {
+
+    if ( pAdr == T64_RSV_NONE ) return;
+
+    rsvDir[ rsvDirIndex( pAdr ) ].fetch_sub( 1 );
+    rsvCount.fetch_sub( 1 );
+}
+
+void T64System::clearReservation( T64Module *mod ) {
+
+    if ( auto p = dynamic_cast<T64ProcThreadModule*>( mod )) {
+
+        T64Word pAdr = p -> getRsvAdr( );
+        if ( p -> clearRsv( pAdr )) releaseRsv( pAdr );
+    }
+}
+
+void T64System::invalidateRsv( T64Word pAdr ) {
+
+    for ( int i = 0; i < systemProcMapHwm; i ++ ) {
+
+        auto p = dynamic_cast<T64ProcThreadModule*>( systemProcMap[ i ] );
+        
+        if (( p != nullptr ) && ( p -> clearRsvLine( pAdr ))) releaseRsv( pAdr );
+    }
+}
+
+void T64System::invalidateRsvRange( T64Word pAdr, T64Word len ) {
+
+    T64Word lineStart = rounddown( pAdr, T64_RSV_LINE_SIZE );
+
+    for ( int i = 0; i < systemProcMapHwm; i ++ ) {
+
+        auto p = dynamic_cast<T64ProcThreadModule*>( systemProcMap[ i ] );
+        if ( p == nullptr ) continue;
+
+        T64Word adr = p -> getRsvAdr( );
+
+        if (( adr != T64_RSV_NONE ) && 
+            ( adr >= lineStart ) && 
+            ( adr < pAdr + len ) &&
+            ( p -> clearRsv( adr ))) {
+            
+            releaseRsv( adr );
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Enter a reservation for a processor, as it is done by a LDR instruction. This
+// is used when a processor state is restored. Any current reservation of the 
+// processor is released first.
+//
+//----------------------------------------------------------------------------------------
+void T64System::setReservation( T64Module *mod, T64Word pAdr, T64Word data ) {
+
+    auto p = dynamic_cast<T64ProcThreadModule*>( mod );
+    if ( p == nullptr ) return;
+
+    clearReservation( p );
+
+    rsvDir[ rsvDirIndex( pAdr ) ].fetch_add( 1 );
+    rsvCount.fetch_add( 1 );
+
+    releaseRsv( p -> setRsv( pAdr ));
+    p -> setRsvData( data );
+}
+
+//----------------------------------------------------------------------------------------
+// System snapshots. A snapshot saves the state of all modules into a snapshot
+// directory. The processors are saved first, they write back their data caches
+// to memory. An incremental snapshot is based on the last snapshot taken or
+// restored, only the memory pages modified since then are saved. After saving
+// or restoring, the processors are asked to drop their direct memory pointers,
+// so that the memory modules see the pages modified from now on. All modules 
+// that run in a thread must be halted.
+//
+//----------------------------------------------------------------------------------------
+bool T64System::saveSnapshot( const char *dirName, bool incremental ) {
+
+    for ( int i = 0; i < systemProcMapHwm; i ++ ) {
+
+        auto p = dynamic_cast<T64ProcThreadModule*>( systemProcMap[ i ] );
+        if (( p != nullptr ) && ( p -> getModuleState( ) == T64_MOD_STATE_EXECUTE )) return( false );
+    }
+
+    if (( incremental ) && ( lastSnapDirName.empty( ))) return( false );
+    if ( ! makeSnapDir( dirName )) return( false );
+
+    T64Snapshot snap( dirName );
+    if ( incremental ) snap.setBaseDirName( lastSnapDirName.c_str( ));
+
+    bool rStat = true;
+
+    for ( int i = 0; ( rStat ) && ( i < systemProcMapHwm ); i ++ ) {
+
+        rStat = systemProcMap[ i ] -> saveState( &snap );
+    }
+
+    for ( int i = 0; ( rStat ) && ( i < MAX_MOD_MAP_ENTRIES ); i++ ) {
+
+        if (( moduleMap[ i ] != nullptr ) && ( moduleMap[ i ] -> getModuleType( ) != MT_PROC )) {
+
+            rStat = moduleMap[ i ] -> saveState( &snap );
+        }
+    }
+
+    if ( rStat ) rStat = snap.store( );
+    
+    busOpControl( nullptr, T64_CNTRL_EVENT_MODULE_PURGE, -1, 0 );
+
+    if ( rStat ) lastSnapDirName = dirName;
+    else         lastSnapDirName.clear( );
+
+    return( rStat );
+}
+
+//----------------------------------------------------------------------------------------
+// Restore a snapshot. The system needs to be configured with the same modules
+// as the one where the snapshot was taken. The memory modules are restored 
+// first, then the processors and all other modules. A failed restore leaves 
+// the system in an undefined state and should be followed by a reset.
+//
+//----------------------------------------------------------------------------------------
+bool T64System::restoreSnapshot( const char *dirName ) {
+
+    for ( int i = 0; i < systemProcMapHwm; i ++ ) {
+
+        auto p = dynamic_cast<T64ProcThreadModule*>( systemProcMap[ i ] );
+        if (( p != nullptr ) && ( p -> getModuleState( ) == T64_MOD_STATE_EXECUTE )) return( false );
+    }
+
+    T64Snapshot snap( dirName );
+    if ( ! snap.load( )) return( false );
+
+    bool rStat = true;
+
+    for ( int i = 0; ( rStat ) && ( i < MAX_MOD_MAP_ENTRIES ); i++ ) {
+
+        if (( moduleMap[ i ] != nullptr ) && ( moduleMap[ i ] -> getModuleType( ) == MT_MEM )) {
+
+            rStat = moduleMap[ i ] -> restoreState( &snap );
+        }
+    }
+
+    for ( int i = 0; ( rStat ) && ( i < MAX_MOD_MAP_ENTRIES ); i++ ) {
+
+        if (( moduleMap[ i ] != nullptr ) && ( moduleMap[ i ] -> getModuleType( ) != MT_MEM )) {
+
+            rStat = moduleMap[ i ] -> restoreState( &snap );
+        }
+    }
+
+    busOpControl( nullptr, T64_CNTRL_EVENT_MODULE_PURGE, -1, 0 );
+
+    if ( rStat ) lastSnapDirName = dirName;
+    else         lastSnapDirName.clear( );
+
+    return( rStat );
+}
+
+//----------------------------------------------------------------------------------------
+// Code page directory. A processor marks a physical page before it decodes
+// instructions from it and unmarks the page when its cache entry for the page 
+// is reused. Stores to a page without marks do not need to be reported.
+//
+//----------------------------------------------------------------------------------------
+void T64System::markCodePage( T64Word pAdr ) {
+
+    codeDir[ codeDirIndex( pAdr ) ].fetch_add( 1 );
+}
+
+void T64System::unmarkCodePage( T64Word pAdr ) {
+
+    codeDir[ codeDirIndex( pAdr ) ].fetch_sub( 1 );
 }
 
 //----------------------------------------------------------------------------------------
 // Bus broadcast operation. We need to provide a way to signal global events
-// such as a TLB entry purge to all modules. We will lock the system mutex and 
-// inform all modules.
+// such as a TLB entry purge to all modules. The event is posted to each module
+// that subscribed to it. There is no lock, a module that runs in a thread of 
+// its own queues the event and handles it between two batches of units. The 
+// sender itself is informed directly, it expects the event done on return.
 //
 //----------------------------------------------------------------------------------------
 bool T64System::busOpControl( T64Module *mod,
@@ -557,14 +1366,14 @@ bool T64System::busOpControl( T64Module *mod,
                               T64Word            arg1, 
                               T64Word            arg2 ) {
 
-    {
-        std::lock_guard<std::mutex> lk(sLock);                              
+    if (( event < 0 ) || ( event >= T64_CNTRL_EVENT_MAX )) return( false );
 
-        for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+    for ( int i = 0; i < ctrlEventMapHwm[ event ]; i++ ) {
 
-            if ( moduleMap[ i ] != nullptr )
-                moduleMap[ i ] -> busOpControlEvent( event, arg1, arg2 );
-        }
+        T64Module *mPtr = ctrlEventMap[ event ][ i ];
+
+        if ( mPtr == mod ) mPtr -> busOpControlEvent( event, arg1, arg2 );
+        else               mPtr -> postControlEvent( event, arg1, arg2 );
     }
 
     return( true );
@@ -33,6 +33,11 @@
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <barrier>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
 
 //----------------------------------------------------------------------------------------
 // The architecture defines 64 module on the system bus so far. Typically the 
@@ -42,6 +47,38 @@
 //----------------------------------------------------------------------------------------
 const int MAX_MOD_MAP_ENTRIES   = T64_IO_MAX_MODULES;
 
+//----------------------------------------------------------------------------------------
+// The system keeps two small directories to decide whether a store needs to be
+// seen by the processors. The reservation directory counts the outstanding LDR
+// reservations by memory line, the code page directory counts the physical 
+// pages processors have decoded instructions from. Both are hashed tables of
+// counters, the number of entries must be a power of two. 
+//
+//----------------------------------------------------------------------------------------
+const int       T64_RSV_LINE_SIZE       = 64;
+const int       T64_RSV_DIR_ENTRIES     = 256;
+const int       T64_CODE_DIR_ENTRIES    = 256;
+const T64Word   T64_RSV_NONE            = -1;
+
+//----------------------------------------------------------------------------------------
+// A processor thread executes its units in batches. The module state is only 
+// checked between batches. A state change request, such as a halt, is therefore
+// seen after at most one batch of units was executed.
+//
+//----------------------------------------------------------------------------------------
+const int       T64_PROC_UNIT_BATCH     = 1024;
+
+//----------------------------------------------------------------------------------------
+// Idle parking. A module that only waits, for example a processor polling a 
+// memory location, asks to be parked when its batch is done. The module thread
+// then sleeps on its condition variable until a state change request, a control
+// event, an interrupt or another wake up request, the loss of the reservation 
+// held when parking, or the timeout. Parking
+// is only done while the module runs without a unit limit, a limited run just 
+// continues executing. A timeout of zero waits without a time limit.
+//
+//----------------------------------------------------------------------------------------
+
 //----------------------------------------------------------------------------------------
 // Modules have a type, submodules a subtype.
 //
@@ -58,7 +95,12 @@ enum T64ModuleType {
 };
 
 //----------------------------------------------------------------------------------------
-// Modules send a control event to the system. They all will run serialized.
+// Modules send a control event to the system, which passes it on to the modules
+// that subscribed to the event. The cache events are sent to the processors 
+// when a memory line is accessed that could be held in a processor cache. A 
+// flush event asks for a write back of the line if it was modified, a purge 
+// event also removes the line from the cache. The first argument is the 
+// physical address, the second the length in bytes.
 //
 //----------------------------------------------------------------------------------------
 enum T64BBusOpControlEvents {
@@ -66,7 +108,64 @@ enum T64BBusOpControlEvents {
     T64_CNTRL_EVENT_MODULE_PURGE  = 1,
     T64_CNTRL_EVENT_TLB_PURGE     = 2,
     T64_CNTRL_EVENT_TLB_INSERT    = 3,
-    T64_CNTRL_EVENT_STORE_OP      = 4
+    T64_CNTRL_EVENT_STORE_OP      = 4,
+    T64_CNTRL_EVENT_CACHE_FLUSH   = 5,
+    T64_CNTRL_EVENT_CACHE_PURGE   = 6,
+    T64_CNTRL_EVENT_MAX           = 7
+};
+
+//----------------------------------------------------------------------------------------
+// Control event subscriptions. A module tells with a bit mask which control 
+// events it wants to see, the system keeps a list of the subscribers for each
+// event. A module in a thread of its own receives the broadcast events in an 
+// inbound queue, which is drained between the batches of units it executes.
+// When the queue overflows, the module is informed that it lost events and 
+// needs to get back in sync.
+//
+//----------------------------------------------------------------------------------------
+const uint32_t  T64_CNTRL_EVENT_ALL     = 0xFFFFFFFF;
+const int       T64_CNTRL_QUEUE_SIZE    = 256;
+
+inline uint32_t controlEventBit( T64BBusOpControlEvents event ) {
+
+    return( 1U << event );
+}
+
+struct T64ControlEvent {
+
+    T64BBusOpControlEvents  event   = T64_CNTRL_EVENT_MODULE_PURGE;
+    T64Word                 arg1    = 0;
+    T64Word                 arg2    = 0;
+};
+
+struct T64ControlQueueSlot {
+
+    std::atomic<uint64_t>   seq     { 0 };
+    T64ControlEvent         ev;
+};
+
+//----------------------------------------------------------------------------------------
+// DMA transfers. A DMA bus operation moves a block of any length and alignment
+// between physical memory and a host buffer, for example the buffer of an I/O
+// module. A descriptor describes one block, a scatter/gather operation takes a
+// list of them. The module owning a range is looked up once per range, larger
+// ranges are transferred in chunks of at most the maximum chunk size.
+//
+//----------------------------------------------------------------------------------------
+const T64Word   T64_DMA_MAX_CHUNK       = 1 << 30;
+
+enum T64DmaOp : int {
+
+    T64_DMA_READ    = 0,
+    T64_DMA_WRITE   = 1,
+    T64_DMA_FILL    = 2
+};
+
+struct T64DmaDesc {
+
+    T64Word     pAdr    = 0;
+    uint8_t     *data   = nullptr;
+    T64Word     len     = 0;
 };
 
 //----------------------------------------------------------------------------------------
@@ -82,6 +181,247 @@ enum T64ModuleState : int {
     T64_MOD_STATE_TERMINATE    = 4    
 };
 
+//----------------------------------------------------------------------------------------
+// System snapshots. A snapshot is a directory. The state file holds one record
+// for each module, which the module fills in and reads back with its save and
+// restore state methods. The record content is defined by the module. A module
+// with a large state, such as a memory module, can place additional files in 
+// the snapshot directory. An incremental snapshot refers to the snapshot taken
+// before, its base. Only the memory is stored incrementally, the records of the
+// other modules are always complete.
+//
+//----------------------------------------------------------------------------------------
+const uint32_t  T64_SNAP_VERSION        = 1;
+const int       T64_SNAP_MAX_PATH       = 256;
+
+struct T64Module;
+
+struct T64SnapFileHeader {
+
+    char        magic[ 8 ];
+    uint32_t    version;
+    uint32_t    records;
+    char        baseDirName[ T64_SNAP_MAX_PATH ];
+};
+
+struct T64SnapRecordHeader {
+
+    int32_t     modNum;
+    int32_t     modType;
+    uint64_t    len;
+};
+
+struct T64Snapshot {
+
+    public:
+
+    T64Snapshot( const char *dirName );
+
+    bool            load( );
+    bool            store( );
+
+    void            beginModule( T64Module *mod );
+    bool            findModule( T64Module *mod );
+
+    void            put( const void *data, size_t len );
+    bool            get( void *data, size_t len );
+
+    bool            filePath( char *buf, int bufLen, const char *name, int modNum );
+
+    const char      *getDirName( );
+    const char      *getBaseDirName( );
+    void            setBaseDirName( const char *name );
+    bool            isIncremental( );
+
+    private:
+
+    struct Record {
+
+        int                     modType = 0;
+        std::vector<uint8_t>    data;
+    };
+
+    std::string             dirName;
+    std::string             baseDirName;
+    std::map<int, Record>   records;
+    Record                  *curRecord  = nullptr;
+    size_t                  curOfs      = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// Performance counters. A module defines a block of named counters. The block 
+// is cache line aligned and written only by the thread currently executing the
+// module, so counting is a plain add without any sharing between threads. Other
+// threads, such as the counter export, just read the values. The few counters 
+// that other threads update as well use an atomic add. The counter names
+// are a static table of the module. Guests read the counters through register 
+// set 2 of the module HPA page, word N is counter N. 
+//
+// The performance counter export writes the counters of all modules to a file,
+// once when asked or periodically from a thread of its own while the system is
+// running. The output is either a JSON line or CSV rows per snapshot.
+//
+//----------------------------------------------------------------------------------------
+const int T64_PERF_MAX_COUNTERS     = T64_IO_REG_SET_SIZE;
+const int T64_PERF_REG_SET          = 2;
+
+enum T64PerfFormat : int {
+
+    T64_PERF_FMT_JSON   = 0,
+    T64_PERF_FMT_CSV    = 1
+};
+
+struct alignas( 64 ) T64PerfBlock {
+
+    public:
+
+    T64PerfBlock( const char *const *names, int count );
+
+    inline void inc( int id ) {
+
+        value[ id ].store( value[ id ].load( std::memory_order_relaxed ) + 1, 
+                           std::memory_order_relaxed );
+    }
+
+    inline void incShared( int id ) {
+
+        value[ id ].fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    inline void add( int id, T64Word n ) {
+
+        value[ id ].store( value[ id ].load( std::memory_order_relaxed ) + n, 
+                           std::memory_order_relaxed );
+    }
+
+    inline void set( int id, T64Word val ) {
+
+        value[ id ].store( val, std::memory_order_relaxed );
+    }
+
+    inline T64Word get( int id ) {
+
+        return( value[ id ].load( std::memory_order_relaxed ));
+    }
+
+    void                    clear( );
+    int                     getCount( );
+    const char              *getName( int id );
+
+    private:
+
+    std::atomic<T64Word>    value[ T64_PERF_MAX_COUNTERS ];
+    const char *const       *names  = nullptr;
+    int                     count   = 0;
+};
+
+struct T64System;
+
+struct T64PerfExport {
+
+    public:
+
+    T64PerfExport( T64System *sys );
+    ~ T64PerfExport( );
+
+    bool                    start( const char *fileName, T64PerfFormat fmt, int intervalMs );
+    void                    stop( );
+    bool                    isActive( );
+
+    private:
+
+    void                    exportWorker( );
+
+    T64System               *sys        = nullptr;
+    FILE                    *out        = nullptr;
+    T64PerfFormat           fmt         = T64_PERF_FMT_JSON;
+    int                     intervalMs  = 0;
+    std::thread             worker;
+    std::mutex              eLock;
+    std::condition_variable eCondVar;
+    bool                    stopReq     = false;
+};
+
+//----------------------------------------------------------------------------------------
+// Timed events. A module schedules an event for a processor, the event is due 
+// after a number of instructions executed by that processor. The time base is
+// the virtual time of the processor, it advances as the processor executes and
+// is skipped forward to the next event when the processor idles. Each processor
+// has an event queue in the system, a heap ordered by due time. The processor 
+// looks at the queue only between its batches of instructions and shortens a 
+// batch so that it ends when the next event is due. The due events are then 
+// passed to the "timerEvent" method of the scheduling module, on the thread of
+// the processor. An I/O module typically posts an interrupt from there, so it
+// models a device completion without a thread of its own. A module scheduling
+// for a processor running in another thread sees the time as of the last batch.
+//
+//----------------------------------------------------------------------------------------
+const int       T64_EVENT_QUEUE_SIZE    = 64;
+const T64Word   T64_EVENT_TIME_NONE     = INT64_MAX;
+
+struct T64TimedEvent {
+
+    T64Word     due     = 0;
+    uint64_t    seq     = 0;
+    T64Module   *mod    = nullptr;
+    int         id      = 0;
+    T64Word     arg     = 0;
+};
+
+struct T64EventQueue {
+
+    public:
+
+    T64EventQueue( );
+
+    bool                    schedule( T64Module *mod, T64Word delay, int id, T64Word arg );
+    int                     cancel( T64Module *mod, int id );
+    void                    reset( );
+    int                     skipToNext( );
+    T64Word                 getTime( );
+    int                     getCount( );
+
+    inline T64Word unitsToNext( ) {
+
+        return( nextDue.load( std::memory_order_acquire ) - 
+                now.load( std::memory_order_relaxed ));
+    }
+
+    inline int advance( T64Word units ) {
+
+        T64Word t = now.load( std::memory_order_relaxed ) + units;
+
+        now.store( t, std::memory_order_relaxed );
+        if ( t >= nextDue.load( std::memory_order_acquire )) return( fire( ));
+        return( 0 );
+    }
+
+    private:
+
+    int                     fire( );
+    void                    siftUp( int pos );
+    void                    siftDown( int pos );
+    bool                    before( const T64TimedEvent &a, const T64TimedEvent &b );
+
+    std::mutex              qLock;
+    T64TimedEvent           heap[ T64_EVENT_QUEUE_SIZE ];
+    int                     heapCount   = 0;
+    uint64_t                seqNum      = 0;
+    std::atomic<T64Word>    now         { 0 };
+    std::atomic<T64Word>    nextDue     { T64_EVENT_TIME_NONE };
+};
+
+//----------------------------------------------------------------------------------------
+// External interrupts. A processor has 64 interrupt lines, a posted interrupt 
+// sets the line bit in an atomic pending mask of the processor. The mask is 
+// only looked at between batches. A pending line is taken when the PSR I bit 
+// is set and the line is enabled in the EIEM control register, the lowest 
+// line first. The EXTERNAL_INTERRUPT trap passes the line number in IARG 0 and
+// the lines still pending in IARG 1. The line is cleared when taken.
+//
+//----------------------------------------------------------------------------------------
+const int       T64_MAX_INT_LINES       = 64;
+
 //----------------------------------------------------------------------------------------
 // Modules have registers in their HPA. The can be accessed via load / store 
 // instructions. 
@@ -114,9 +454,9 @@ struct T64Module {
     T64Module( T64ModuleType    modType, 
                int              modNum,
                T64Word          spaAdr,
-               int              spaLen  );
+               T64Word          spaLen  );
 
-    virtual             ~T64Module()            = default;
+    virtual             ~T64Module( );
 
     virtual void        initModule( )           = 0;
     virtual void        resetModule( )          = 0;
@@ -127,10 +467,34 @@ struct T64Module {
     virtual bool        
     busOpWriteEvent( T64Word pAdr, uint8_t *data, int len ) = 0;
 
+    virtual bool        
+    busOpWriteCondEvent( T64Word pAdr, uint8_t *expected, uint8_t *data, int len );
+
     virtual bool        
     busOpControlEvent( T64BBusOpControlEvents event, 
                        T64Word  arg1, T64Word arg2 ) = 0;
 
+    virtual uint32_t    getControlEventMask( );
+    virtual bool        
+    postControlEvent( T64BBusOpControlEvents event, 
+                      T64Word  arg1, T64Word arg2 );
+
+    virtual bool        
+    busOpReadBlockEvent( T64Word pAdr, uint8_t *data, T64Word len );
+
+    virtual bool        
+    busOpWriteBlockEvent( T64Word pAdr, const uint8_t *data, T64Word len );
+
+    virtual bool        
+    busOpFillBlockEvent( T64Word pAdr, uint8_t val, T64Word len );
+
+    virtual uint8_t     *getHostPagePtr( T64Word pAdr, bool wMode, bool *writable );
+    virtual void        lockLine( T64Word pAdr );
+    virtual void        unlockLine( T64Word pAdr );
+
+    virtual bool        saveState( T64Snapshot *snap );
+    virtual bool        restoreState( T64Snapshot *snap );
+
     T64ModuleType       getModuleType( );
     int                 getModuleNum( );
     const char          *getModuleTypeName( );
@@ -138,12 +502,25 @@ struct T64Module {
     T64Word             getHpaAdr( );
     int                 getHpaLen( );
     T64Word             getSpaAdr( );
-    int                 getSpaLen( );
+    T64Word             getSpaLen( );
+
+    virtual void        timerEvent( int id, T64Word arg );
+
+    bool                definePerfCounters( const char *const *names, int count );
+    T64PerfBlock        *getPerfBlock( );
+    bool                readPerfReg( int index, T64Word *val );
 
     public: 
 
     T64ModuleType       moduleTyp   = MT_NIL;
     int                 moduleNum   = 0;
+
+    struct alignas( 64 ) AdrHint {
+
+        std::atomic<int>    index   { 0 };
+    };
+
+    AdrHint             adrDecodeHint;
     
     protected: 
 
@@ -151,11 +528,13 @@ struct T64Module {
     int                 hpaLen      = 0;
 
     T64Word             spaAdr      = 0;
-    int                 spaLen      = 0;
+    T64Word             spaLen      = 0;
 
     bool                rsvValid    = false;
     T64Word             rsvInfo     = 0;
 
+    T64PerfBlock        *perf       = nullptr;
+
     // ??? work in progress ... how do we best represent the regs in a module ?
     // ??? we should have the fields that are common to every module...
 
@@ -182,7 +561,7 @@ struct T64ProcThreadModule : T64Module {
     T64ProcThreadModule( T64ModuleType    modType, 
                          int              modNum,
                          T64Word          spaAdr,
-                         int              spaLen );
+                         T64Word          spaLen );
 
     ~ T64ProcThreadModule( );
 
@@ -194,29 +573,153 @@ struct T64ProcThreadModule : T64Module {
     virtual T64TrapCode     waitUntilStopped( );
     
     virtual T64TrapCode     executeUnit( ) = 0;
+    virtual T64TrapCode     executeUnits( int units, bool haltOnTrap, int *done );
+
+    T64TrapCode             executeQuantum( int units, int *done );
+
+    virtual bool            postControlEvent( T64BBusOpControlEvents event, 
+                                              T64Word  arg1, T64Word arg2 );
+    virtual void            controlEventOverflow( );
+    void                    deliverControlEvents( );
+
+    bool                    raiseInterrupt( int line );
+    void                    clearInterrupt( int line );
+    uint64_t                getPendingInterrupts( );
+
+    virtual bool            takeIdleRequest( T64Word *timeoutUs );
+    void                    wakeModule( );
+    bool                    isParked( );
 
     T64ModuleState          getModuleState( );
     T64TrapCode             getTrapCode( );
     void                    setEnterSimOnTrap( bool val );
+    bool                    getEnterSimOnTrap( );
   
-    void                    setRsvInfo( T64Word pAdr, bool valid );
-    T64Word                 getRsvInfo( );
+    T64Word                 setRsv( T64Word pAdr );
+    void                    setRsvData( T64Word data );
+    bool                    clearRsv( T64Word pAdr );
+    bool                    clearRsvLine( T64Word pAdr );
+    T64Word                 getRsvAdr( );
+    T64Word                 getRsvData( );
     bool                    isRsvValid( );
 
     private: 
 
     void                    setModuleState( T64ModuleState state );
     void                    moduleWorker( );
+    bool                    hasControlEvents( );
+    void                    drainControlEvents( );
+    void                    parkModule( T64Word timeoutUs );
+    void                    notifyParked( );
 
     std::atomic<T64ModuleState> mState { T64_MOD_STATE_NIL };
+    std::atomic<bool>           mStateReq      { false };
     std::mutex                  mLock;
     std::condition_variable     mCondVar;
     std::thread                 mWorker;
     T64TrapCode                 mTrapCode      = NO_TRAP;
     int                         mUnitCount     = 0;
     bool                        enterSimOnTrap = false;
-    bool                        rsvValid       = false;
-    T64Word                     rsvInfo        = 0;
+    std::atomic<T64Word>        rsvAdr         { T64_RSV_NONE };
+    T64Word                     rsvData        = 0;
+
+    T64ControlQueueSlot         evQueue[ T64_CNTRL_QUEUE_SIZE ];
+    std::atomic<uint64_t>       evHead         { 0 };
+    std::atomic<uint64_t>       evTail         { 0 };
+    std::atomic<bool>           evOwner        { false };
+    std::atomic<bool>           evOverflow     { false };
+
+    std::atomic<uint64_t>       intPending     { 0 };
+
+    std::atomic<bool>           parked         { false };
+    std::atomic<bool>           wakeReq        { false };
+    bool                        parkRsvValid   = false;
+};
+
+//----------------------------------------------------------------------------------------
+// The system scheduler. By default, each processor runs in its own module 
+// thread. As an alternative, the scheduler runs the processors on a pool of 
+// worker threads, sized to the host cores. The processors execute in quanta of
+// a fixed number of units. In lockstep mode, the workers meet at a barrier after
+// each quantum, so all processors stay within one quantum of each other. The 
+// quanta of one round still run at the same time on the workers, so the order
+// in which the processors see each other's stores depends on the host timing.
+// A lockstep run is not reproducible with more than one worker. In reproducible
+// mode, the run is a lockstep run with just one worker. The processors run one
+// after the other in module order and a run with the same inputs always gives
+// the same result. In relaxed mode there is no barrier. A worker runs a quantum
+// for any processor that is not busy, starting with the processors of its own
+// share. In the multi worker modes, a worker that is done with its share steals
+// the quanta of the other shares. A processor leaves the run when its units are
+// executed or when it took a trap and was told to enter the simulator on a trap.
+//
+//----------------------------------------------------------------------------------------
+enum T64SchedMode : int {
+
+    T64_SCHED_THREADS       = 0,
+    T64_SCHED_LOCKSTEP      = 1,
+    T64_SCHED_RELAXED       = 2,
+    T64_SCHED_REPRODUCIBLE  = 3
+};
+
+const int T64_SCHED_MAX_WORKERS = 64;
+
+struct T64Scheduler {
+
+    public:
+
+    T64Scheduler( );
+
+    bool                setMode( T64SchedMode mode, int quantum, int workers );
+    T64SchedMode        getMode( );
+    int                 getQuantum( );
+    int                 getWorkers( );
+    T64Word             getQuanta( );
+
+    void                run( T64ProcThreadModule **procs, int count, T64Word units );
+    void                stop( );
+
+    private:
+
+    struct Slot {
+
+        T64ProcThreadModule     *proc   = nullptr;
+        T64Word                 units   = 0;
+        std::atomic<bool>       active  { false };
+        std::atomic<bool>       busy    { false };
+    };
+
+    struct alignas( 64 ) Share {
+
+        std::atomic<int>        next    { 0 };
+        int                     limit   = 0;
+    };
+
+    struct RoundDone {
+
+        T64Scheduler            *sched;
+        void operator( ) ( ) noexcept { sched -> startRound( ); }
+    };
+
+    void                runSlot( int index );
+    void                startRound( );
+    void                lockstepWorker( int index, std::barrier<RoundDone> *sync );
+    void                relaxedWorker( int index );
+
+    T64SchedMode        mode            = T64_SCHED_THREADS;
+    int                 quantum         = T64_PROC_UNIT_BATCH;
+    int                 workers         = 0;
+    int                 runWorkers      = 0;
+
+    Slot                slots[ MAX_MOD_MAP_ENTRIES ];
+    int                 slotCount       = 0;
+    int                 roundList[ MAX_MOD_MAP_ENTRIES ];
+    Share               shares[ T64_SCHED_MAX_WORKERS ];
+    bool                finished        = false;
+
+    std::atomic<int>    activeCount     { 0 };
+    std::atomic<bool>   stopReq         { false };
+    std::atomic<T64Word> quanta         { 0 };
 };
 
 //----------------------------------------------------------------------------------------
@@ -230,6 +733,19 @@ struct T64ModuleMapEntry {
     T64Module *module = nullptr;
 };
 
+//----------------------------------------------------------------------------------------
+// The address decode map is used to find the module for a physical address. It
+// contains the SPA ranges of all memory and IO modules, sorted by address. An
+// entry covers the range from start up to, but not including, limit.
+//
+//----------------------------------------------------------------------------------------
+struct T64AdrDecodeEntry {
+
+    T64Word     start   = 0;
+    T64Word     limit   = 0;
+    T64Module   *module = nullptr;
+};
+
 //----------------------------------------------------------------------------------------
 // A T64 system is a bus where you plug in modules. A module represents an 
 // entity such as a processor, a memory module, an I/O module and so on. At 
@@ -254,21 +770,32 @@ struct T64System {
     void                execModule( int modNum, int steps, bool haltOnTrap );
     bool                isModuleHalted( int modNum );   
     
-    void                run( );
+    bool                setSchedMode( T64SchedMode  mode, 
+                                      int           quantum = T64_PROC_UNIT_BATCH, 
+                                      int           workers = 0 );
+    T64Scheduler        *getScheduler( );
+
+    void                run( T64Word units = -1 );
+    void                stopRun( );
+    bool                isRunning( );
     
     T64ModuleType       getModuleType( int modNum ) const;
     char                *getModuleStateStr( int modNum ) const;
     T64Module           *lookupByModNum( int modNum ) const;
     T64Module           *lookupByModuleType( T64ModuleType typ );
-    T64Module           *lookupByAdr( T64Word adr ) const;  
+    T64Module           *lookupByAdr( T64Word adr, T64Module *src = nullptr ) const;
     
     bool                translateAdr( T64Word vAdr, T64Word *pAdr );
 
+    uint8_t             *getHostPagePtr( T64Word pAdr, bool wMode, bool *writable );
+
     bool                busOpRead(  T64Module *mod, 
                                     T64Word pAdr, 
                                     uint8_t *data, 
                                     int len );
 
+    bool                busOpPeek( T64Word pAdr, uint8_t *data, int len );
+
     bool                busOpReadRsv( T64Module *mod, 
                                       T64Word pAdr, 
                                       uint8_t *data, 
@@ -289,9 +816,86 @@ struct T64System {
                                       T64Word             arg1, 
                                       T64Word             arg2 );
 
+    bool                busOpReadSharedBlock( T64Module *mod,
+                                              T64Word   pAdr, 
+                                              uint8_t   *data, 
+                                              int       len );
+
+    bool                busOpReadPrivateBlock( T64Module *mod,
+                                               T64Word   pAdr, 
+                                               uint8_t   *data, 
+                                               int       len );
+
+    bool                busOpWriteBlock( T64Module *mod,
+                                         T64Word   pAdr, 
+                                         uint8_t   *data, 
+                                         int       len );
+
+    bool                busOpDmaRead( T64Module *mod,
+                                      T64Word   pAdr, 
+                                      uint8_t   *data, 
+                                      T64Word   len );
+
+    bool                busOpDmaReadV( T64Module *mod, const T64DmaDesc *desc, int count );
+    bool                busOpDmaWriteV( T64Module *mod, const T64DmaDesc *desc, int count );
+
+    bool                busOpDmaWrite( T64Module        *mod,
+                                       T64Word          pAdr, 
+                                       const uint8_t    *data, 
+                                       T64Word          len );
+
+    bool                busOpDmaFill( T64Module *mod,
+                                      T64Word   pAdr, 
+                                      uint8_t   val, 
+                                      T64Word   len );
+
+    void                busOpStoreNotify( T64Module *mod, T64Word pAdr, int len );
+
+    void                registerCache( );
+    void                unregisterCache( );
+    void                lockCoherence( );
+    void                unlockCoherence( );
+
+    void                clearReservation( T64Module *mod );
+    void                setReservation( T64Module *mod, T64Word pAdr, T64Word data );
+
+    bool                saveSnapshot( const char *dirName, bool incremental = false );
+    bool                restoreSnapshot( const char *dirName );
+
+    bool                scheduleEvent( int         procNum, 
+                                       T64Module   *mod, 
+                                       T64Word     delay, 
+                                       int         id, 
+                                       T64Word     arg = 0 );
+    int                 cancelEvent( int procNum, T64Module *mod, int id );
+    T64EventQueue       *getEventQueue( int procNum );
+    bool                postInterrupt( int procNum, int line );
+
+    void                markCodePage( T64Word pAdr );
+    void                unmarkCodePage( T64Word pAdr );
+
+    void                writePerfCounters( FILE *f, T64PerfFormat fmt, double secs );
+
     private:
 
     void                initModuleMap( );
+    void                buildAdrDecodeMap( );
+    void                buildControlEventMap( );
+    void                storeNotify( T64Module *mod, T64Word pAdr, int len );
+    bool                dmaTransfer( T64Module      *mod, 
+                                     T64DmaOp       op,
+                                     T64Word        pAdr, 
+                                     uint8_t        *data, 
+                                     uint8_t        val, 
+                                     T64Word        len );
+    void                releaseRsv( T64Word pAdr );
+    void                invalidateRsv( T64Word pAdr );
+    void                invalidateRsvRange( T64Word pAdr, T64Word len );
+    bool                snoopRequired( T64Word pAdr );
+    void                snoopCaches( T64Module              *mod, 
+                                     T64BBusOpControlEvents event,
+                                     T64Word                pAdr, 
+                                     int                    len );
                             
     T64Module           *moduleMap[ MAX_MOD_MAP_ENTRIES ];
 
@@ -304,5 +908,21 @@ struct T64System {
     T64Module           *systemProcMap[ MAX_MOD_MAP_ENTRIES ];
     int                 systemProcMapHwm;
 
-    std::mutex          sLock;
+    T64Module           *ctrlEventMap[ T64_CNTRL_EVENT_MAX ][ MAX_MOD_MAP_ENTRIES ];
+    int                 ctrlEventMapHwm[ T64_CNTRL_EVENT_MAX ] = { 0 };
+
+    T64AdrDecodeEntry   adrDecodeMap[ MAX_MOD_MAP_ENTRIES * 2 ];
+    int                 adrDecodeMapHwm = 0;
+
+    std::atomic<int>    rsvCount { 0 };
+    std::atomic<int>    rsvDir[ T64_RSV_DIR_ENTRIES ];
+    std::atomic<int>    codeDir[ T64_CODE_DIR_ENTRIES ];
+    std::atomic<int>    cacheCount { 0 };
+
+    std::recursive_mutex    cohLock;
+
+    T64Scheduler            scheduler;
+    T64EventQueue           eventQueues[ MAX_MOD_MAP_ENTRIES ];
+
+    std::string             lastSnapDirName;
 };
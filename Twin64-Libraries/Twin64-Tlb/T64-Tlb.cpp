@@ -88,6 +88,58 @@ T64TlbEntry* lookupTlbEntry( T64TlbEntry *tlb,
     return ( best );
 }
 
+//----------------------------------------------------------------------------------------
+// Search a set associative TLB. For each page size in use, starting with the 
+// smallest page size, the set the virtual address maps to is searched. The 
+// first match is the best match. The cost of a lookup is thus independent of
+// the TLB size.
+//
+//----------------------------------------------------------------------------------------
+T64TlbEntry* lookupTlbEntrySa( T64TlbEntry *tlb, 
+                               int         sets,
+                               uint32_t    pageSizesUsed,
+                               T64Word     vAdr ) {
+    
+    for ( int pSize = 0; pSize < T64_TLB_PAGE_SIZES; pSize++ ) {
+
+        if ( ! ( pageSizesUsed & ( 1U << pSize ))) continue;
+
+        T64TlbEntry *set = &tlb[ tlbSetIndex( vAdr, pSize, sets ) * T64_TLB_SA_WAYS ];
+
+        for ( int i = 0; i < T64_TLB_SA_WAYS; i++ ) {
+            
+            T64TlbEntry *e = &set[ i ];
+
+            if (( tlbInfoIsValid( e -> tlbInfo )) && 
+                ( tlbInfoPageSize( e -> tlbInfo ) == pSize ) &&
+                (( vAdr & e -> pageMask ) == e -> vAdr )) {
+                
+                return ( e );
+            }
+        }
+    }
+
+    return ( nullptr );
+}
+
+//----------------------------------------------------------------------------------------
+// The global TLB performance counters. Inserts and purges are counted with the
+// update lock held, the lookup retries by any processor.
+//
+//----------------------------------------------------------------------------------------
+enum GlobalTlbPerfCounter : int {
+
+    GTLB_PC_INSERTS = 0,
+    GTLB_PC_PURGES  = 1,
+    GTLB_PC_RETRIES = 2,
+    GTLB_PC_MAX     = 3
+};
+
+const char *const gTlbPerfCounterNames[ GTLB_PC_MAX ] = {
+
+    "inserts", "purges", "retries"
+};
+
 } // namespace
 
 //****************************************************************************************
@@ -97,8 +149,8 @@ T64TlbEntry* lookupTlbEntry( T64TlbEntry *tlb,
 //
 //----------------------------------------------------------------------------------------
 // Object creator. Based on kind and type of TLB, we allocate the global TLB 
-// data structure. Right now, we only support a fully associative unified TLB 
-// of different sizes.
+// data structure. We support a fully associative and a 4-way set associative 
+// unified TLB of different sizes.
 //
 //----------------------------------------------------------------------------------------
 T64GlobalTlb::T64GlobalTlb( T64ModuleType    modType, 
@@ -116,11 +168,34 @@ T64GlobalTlb::T64GlobalTlb( T64ModuleType    modType,
         case T64_TT_FA_32S:     tlbSize = 32; break;
         case T64_TT_FA_64S:     tlbSize = 64; break;
         case T64_TT_FA_128S:    tlbSize = 128; break;
+        case T64_TT_SA_256S:    tlbSize = 256; break;
+        case T64_TT_SA_1024S:   tlbSize = 1024; break;
+        case T64_TT_SA_4096S:   tlbSize = 4096; break;
         default:                tlbSize = 64;
     }
 
-    tlbMissCount = 0;
-    tlbHitCount  = 0;
+    switch ( tlbType ) {
+
+        case T64_TT_SA_256S:
+        case T64_TT_SA_1024S:
+        case T64_TT_SA_4096S: {
+            
+            tlbWays = T64_TLB_SA_WAYS; 
+            tlbSets = tlbSize / tlbWays;
+        
+        } break;
+
+        default: {
+            
+            tlbWays = tlbSize; 
+            tlbSets = 1;
+        }
+    }
+
+    tlbRoundRobin    = 0;
+    tlbPageSizesUsed = 0;
+
+    definePerfCounters( gTlbPerfCounterNames, GTLB_PC_MAX );
 
     tlbTable = ( T64TlbEntry *) calloc( tlbSize, sizeof( T64TlbEntry ));
 }
@@ -140,29 +215,118 @@ T64GlobalTlb:: ~ T64GlobalTlb( ) {
 // allow for overlapping entries, which can be used to deploy a large page and 
 // overlap another smaller range. The best match is the entry with the largest
 // page mask, which is the smallest page size. If we found a match, we copy the 
-// entry to the passed parameter.
+// entry to the passed parameter. A set associative TLB only searches the sets
+// for the page sizes in use.
 // 
 //----------------------------------------------------------------------------------------
-bool T64GlobalTlb::lookupTlb( T64Word vAdr, T64TlbEntry *e ) {
+T64TlbEntry *T64GlobalTlb::findTlbEntry( T64Word vAdr ) {
 
-    std::shared_lock lock( tLock );
+    if ( tlbSets == 1 ) return( lookupTlbEntry( tlbTable, tlbSize, vAdr ));
+    else return( lookupTlbEntrySa( tlbTable, tlbSets, tlbPageSizesUsed, vAdr ));
+}
 
-    T64TlbEntry *entry = lookupTlbEntry( tlbTable, tlbSize, vAdr );
-    if ( entry == nullptr ) return( false );
+//----------------------------------------------------------------------------------------
+// The lookup is the reader side of the sequence lock. We take the sequence 
+// number, search the table and copy the entry found. If an update was in 
+// progress or completed in the meantime, the copy may be torn and we just try
+// again. The table is never reallocated, so a search during an update stays
+// within the table. The caller passes its module number for the counters.
+//
+//----------------------------------------------------------------------------------------
+bool T64GlobalTlb::lookupTlb( T64Word vAdr, T64TlbEntry *e, int reqModNum ) {
 
-    *e = *entry;
-    
-    tlbHitCount ++;
-    return( true );
+    bool found = false;
+
+    while ( true ) {
+
+        uint32_t seq = tSeq.load( std::memory_order_acquire );
+
+        if ( seq & 0x1 ) {
+
+            std::this_thread::yield( );
+            continue;
+        }
+
+        T64TlbEntry *entry = findTlbEntry( vAdr );
+
+        found = ( entry != nullptr );
+        if ( found ) *e = *entry;
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if ( tSeq.load( std::memory_order_relaxed ) == seq ) break;
+
+        perf -> incShared( GTLB_PC_RETRIES );
+    }
+
+    countLookup( reqModNum, found );
+    return( found );
 }
 
 //----------------------------------------------------------------------------------------
-// Insert a new translation.
+// The writer side of the sequence lock. The caller holds the update lock. An
+// odd sequence number tells the readers that the table is being changed.
 //
 //----------------------------------------------------------------------------------------
-bool T64GlobalTlb::insertTlbEntry( T64Word arg1, T64Word arg2 ) {
+void T64GlobalTlb::beginUpdate( ) {
 
-    std::unique_lock lock( tLock );
+    tSeq.store( tSeq.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+}
+
+void T64GlobalTlb::endUpdate( ) {
+
+    tSeq.store( tSeq.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+}
+
+//----------------------------------------------------------------------------------------
+// Lookup counters. Each module only updates its own counter line, so a plain 
+// load and store is sufficient. Lookups without a module number, such as the 
+// simulator commands, are not counted.
+//
+//----------------------------------------------------------------------------------------
+void T64GlobalTlb::countLookup( int reqModNum, bool hit ) {
+
+    if (( reqModNum < 0 ) || ( reqModNum >= MAX_MOD_MAP_ENTRIES )) return;
+
+    std::atomic<T64Word> &c = ( hit ) ? counters[ reqModNum ].hits : 
+                                        counters[ reqModNum ].misses;
+
+    c.store( c.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+}
+
+T64Word T64GlobalTlb::getTlbHits( ) {
+
+    T64Word sum = 0;
+
+    for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+        sum += counters[ i ].hits.load( std::memory_order_relaxed );
+    }
+
+    return( sum );
+}
+
+T64Word T64GlobalTlb::getTlbMisses( ) {
+
+    T64Word sum = 0;
+
+    for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+        sum += counters[ i ].misses.load( std::memory_order_relaxed );
+    }
+
+    return( sum );
+}
+
+//----------------------------------------------------------------------------------------
+// Insert a new translation. An existing entry for the same virtual page and page 
+// size is replaced, unless it is locked and the new one is not. Otherwise we 
+// use a free entry or replace an unlocked entry in round robin fashion. For a
+// set associative TLB, the candidates are the ways of the set the virtual page
+// maps to.
+//
+//----------------------------------------------------------------------------------------
+bool T64GlobalTlb::insertTlbEntry( T64Word arg1, T64Word arg2 ) {
 
     uint16_t tlbInfo = arg2 >> 48;
     int      pSize   = tlbPageSize( tlbInfoPageSize( tlbInfo ));
@@ -171,16 +335,43 @@ bool T64GlobalTlb::insertTlbEntry( T64Word arg1, T64Word arg2 ) {
     if ( ! isAlignedPageAdr( arg1, pSize )) return ( false );
     if ( ! isAlignedPageAdr( arg2, pSize )) return ( false );
 
+    std::unique_lock lock( tLock );
+
+    beginUpdate( );
+    bool rStat = insertEntry( arg1, arg2, tlbInfo );
+    endUpdate( );
+
+    perf -> inc( GTLB_PC_INSERTS );
+
+    return( rStat );
+}
+
+//----------------------------------------------------------------------------------------
+// The table part of the insert. The caller holds the update lock and marks the
+// update in progress.
+//
+//----------------------------------------------------------------------------------------
+bool T64GlobalTlb::insertEntry( T64Word arg1, T64Word arg2, uint16_t tlbInfo ) {
+
     T64TlbEntry entry;
 
     entry.pageMask  = tlbPageMask( tlbInfoPageSize( tlbInfo ));
     entry.vAdr      = vAdr( arg1 & entry.pageMask );
     entry.pAdr      = arg2 & entry.pageMask & 0xFFFFFFFFFFULL;
     entry.tlbInfo   = tlbInfo | 0x8000;
+
+    T64TlbEntry *set = tlbTable;
+
+    if ( tlbSets > 1 ) {
+        
+        set = &tlbTable[ tlbSetIndex( entry.vAdr, 
+                                      tlbInfoPageSize( tlbInfo ), 
+                                      tlbSets ) * tlbWays ];
+    }
     
-    for ( int i = 0; i < tlbSize; i++ ) {
+    for ( int i = 0; i < tlbWays; i++ ) {
 
-        T64TlbEntry *e = &tlbTable[ i ];
+        T64TlbEntry *e = &set[ i ];
 
          if ( ! ( tlbInfoIsValid( e -> tlbInfo ))) continue;
 
@@ -193,27 +384,29 @@ bool T64GlobalTlb::insertTlbEntry( T64Word arg1, T64Word arg2 ) {
                 return ( true );
             }
             
-            tlbTable[ i ] = entry;
+            set[ i ] = entry;
             return ( true );
         }
     }
 
-    for ( int i = 0; i < tlbSize; i++ ) {
+    tlbPageSizesUsed |= ( 1U << tlbInfoPageSize( tlbInfo ));
 
-        if ( ! ( tlbInfoIsValid( tlbTable[ i ].tlbInfo ))) {
+    for ( int i = 0; i < tlbWays; i++ ) {
 
-            tlbTable[ i ] = entry;
+        if ( ! ( tlbInfoIsValid( set[ i ].tlbInfo ))) {
+
+            set[ i ] = entry;
             return ( true );
         }
     }
 
-    for ( int i = 0; i < tlbSize; i++ ) {
+    for ( int i = 0; i < tlbWays; i++ ) {
 
-        int idx = tlbRoundRobin++ % tlbSize;
+        int idx = tlbRoundRobin++ % tlbWays;
 
-        if ( ! ( tlbInfoIsLocked( tlbTable[ idx ].tlbInfo ))) {
+        if ( ! ( tlbInfoIsLocked( set[ idx ].tlbInfo ))) {
 
-            tlbTable[ idx ] = entry;
+            set[ idx ] = entry;
             return ( true );
         }
     }
@@ -231,10 +424,14 @@ bool T64GlobalTlb::removeTlbEntry( T64Word vAdr ) {
 
     std::unique_lock lock( tLock );
 
-    T64TlbEntry *e = lookupTlbEntry( tlbTable, tlbSize, vAdr );
+    T64TlbEntry *e = findTlbEntry( vAdr );
     if ( e == nullptr ) return( true );
     
+    beginUpdate( );
     e -> tlbInfo &= 0x7FFF; 
+    endUpdate( );
+
+    perf -> inc( GTLB_PC_PURGES );
     return ( true );
 }
 
@@ -255,6 +452,9 @@ char *T64GlobalTlb::getTlbTypeStr( ) {
         case T64_TT_FA_32S:     return ( (char *) "FA_32S" ); break;
         case T64_TT_FA_64S:     return ( (char *) "FA_64S" ); break;
         case T64_TT_FA_128S:    return ( (char *) "FA_128S" ); break;
+        case T64_TT_SA_256S:    return ( (char *) "SA_256S" ); break;
+        case T64_TT_SA_1024S:   return ( (char *) "SA_1024S" ); break;
+        case T64_TT_SA_4096S:   return ( (char *) "SA_4096S" ); break;
         default:                return ( (char *) "TLB_**" ); break;
     }
 }
@@ -267,6 +467,34 @@ T64TlbEntry *T64GlobalTlb::getTlbEntry( int index ) {
     return( &tlbTable[ index ] );
  }
 
+//----------------------------------------------------------------------------------------
+// Copy a TLB entry by index. Other than the entry pointer, the copy is a reader
+// of the sequence lock and thus consistent while the processors run and change
+// the table.
+//
+//----------------------------------------------------------------------------------------
+bool T64GlobalTlb::readTlbEntry( int index, T64TlbEntry *e ) {
+
+    T64TlbEntry *entry = getTlbEntry( index );
+    if ( entry == nullptr ) return( false );
+
+    while ( true ) {
+
+        uint32_t seq = tSeq.load( std::memory_order_acquire );
+
+        if ( seq & 0x1 ) {
+
+            std::this_thread::yield( );
+            continue;
+        }
+
+        *e = *entry;
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if ( tSeq.load( std::memory_order_relaxed ) == seq ) return( true );
+    }
+}
+
 
 bool T64GlobalTlb::translateAdr( T64Word vAdr, T64Word *pAdr ) {
 
@@ -291,14 +519,27 @@ void T64GlobalTlb::initModule( ) {
     resetModule( );
 }
 
+//----------------------------------------------------------------------------------------
+// A reset clears the table in place. It is not reallocated, readers may still
+// search it concurrently.
+//
+//----------------------------------------------------------------------------------------
 void T64GlobalTlb::resetModule( ) { 
 
-    tlbMissCount = 0;
-    tlbHitCount  = 0;
+    std::unique_lock lock( tLock );
 
-    if ( tlbTable != nullptr ) free ( tlbTable );
+    beginUpdate( );
+    tlbPageSizesUsed = 0;
+    if ( tlbTable != nullptr ) memset( tlbTable, 0, tlbSize * sizeof( T64TlbEntry ));
+    endUpdate( );
 
-    tlbTable = ( T64TlbEntry *) calloc( tlbSize, sizeof( T64TlbEntry ));
+    for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+        counters[ i ].hits.store( 0, std::memory_order_relaxed );
+        counters[ i ].misses.store( 0, std::memory_order_relaxed );
+    }
+
+    perf -> clear( );
 }
 
 //----------------------------------------------------------------------------------------
@@ -320,6 +561,13 @@ T64GlobalTlb::busOpReadEvent( T64Word pAdr, uint8_t *data, int len )  {
 
     // ??? what registers do we have ?
 
+    if ( regSetIndex == T64_PERF_REG_SET ) {
+
+        if ( ! readPerfReg( wordInRegSetIndex, &tmp )) return( false );
+        copyFromReg( data, tmp, wordOfs, len );
+        return( true );
+    }
+
     copyFromReg( data, tmp, 0, len );
     return ( true );
 }
@@ -349,9 +597,16 @@ T64GlobalTlb::busOpWriteEvent( T64Word pAdr, uint8_t *data, int len )  {
 
 //----------------------------------------------------------------------------------------
 // A bus control event. The processor uses such events to signal a TLB flush
-// for example.
+// for example. We only subscribe to the TLB insert and purge events. They are
+// handled right away on the thread of the sender.
 //
 //----------------------------------------------------------------------------------------
+uint32_t T64GlobalTlb::getControlEventMask( ) {
+
+    return( controlEventBit( T64_CNTRL_EVENT_TLB_INSERT ) | 
+            controlEventBit( T64_CNTRL_EVENT_TLB_PURGE ));
+}
+
 bool T64GlobalTlb::busOpControlEvent( T64BBusOpControlEvents id, 
                                       T64Word            arg1, 
                                       T64Word            arg2 )  {
@@ -372,4 +627,44 @@ bool T64GlobalTlb::busOpControlEvent( T64BBusOpControlEvents id,
 
         default: return( false );
     }
-}
\ No newline at end of file
+}
+//----------------------------------------------------------------------------------------
+// Snapshot support. We save the TLB entries together with the page size usage
+// and the replacement position, so that a restored TLB will behave exactly as
+// the saved one. The TLB geometry is part of the configuration and needs to 
+// match.
+//
+//----------------------------------------------------------------------------------------
+bool T64GlobalTlb::saveState( T64Snapshot *snap ) {
+
+    std::unique_lock<std::mutex> lk( tLock );
+
+    snap -> beginModule( this );
+    snap -> put( &tlbSize, sizeof( tlbSize ));
+    snap -> put( &tlbPageSizesUsed, sizeof( tlbPageSizesUsed ));
+    snap -> put( &tlbRoundRobin, sizeof( tlbRoundRobin ));
+    snap -> put( tlbTable, tlbSize * sizeof( T64TlbEntry ));
+    return( true );
+}
+
+bool T64GlobalTlb::restoreState( T64Snapshot *snap ) {
+
+    std::unique_lock<std::mutex> lk( tLock );
+
+    int size = 0;
+
+    if (( ! snap -> findModule( this ))               || 
+        ( ! snap -> get( &size, sizeof( size )))      ||
+        ( size != tlbSize )) {
+        
+        return( false );
+    }
+
+    beginUpdate( );
+    bool rStat = snap -> get( &tlbPageSizesUsed, sizeof( tlbPageSizesUsed )) &&
+                 snap -> get( &tlbRoundRobin, sizeof( tlbRoundRobin ))       &&
+                 snap -> get( tlbTable, tlbSize * sizeof( T64TlbEntry ));
+    endUpdate( );
+
+    return( rStat );
+}
@@ -40,7 +40,15 @@
 // The Twin64 Simulator features a global TLB used by all processor resources.
 // It is a module by itself and follows the module protocols. The TLB data
 // is mapped into the HPA address range and can be examined with a simple memory
-// display command.
+// display command. The TLB is either fully associative or 4-way set associative.
+// A fully associative TLB is one set with all entries as ways. A set associative
+// TLB remembers which page sizes are in use and only probes the sets for those.
+//
+// All processors consult the global TLB on a local TLB miss. The lookup is a
+// sequence lock reader and never blocks. Insert, purge and reset are serialized
+// by the update lock and bump the sequence number before and after they change
+// the table. A reader that overlapped an update simply retries. The hit and miss
+// counters are kept per requesting module, each on its own cache line.
 //
 //----------------------------------------------------------------------------------------
 struct T64GlobalTlb : T64Module {
@@ -54,14 +62,17 @@ struct T64GlobalTlb : T64Module {
 
     virtual ~T64GlobalTlb( );
 
-    bool        lookupTlb( T64Word vAdr, T64TlbEntry *e );
+    bool        lookupTlb( T64Word vAdr, T64TlbEntry *e, int reqModNum = -1 );
     bool        insertTlbEntry( T64Word arg1, T64Word arg2 );
     bool        removeTlbEntry( T64Word vAdr );
 
     int         getTlbSize( );
     char        *getTlbTypeStr( );
     T64TlbEntry *getTlbEntry( int index );
+    bool        readTlbEntry( int index, T64TlbEntry *e );
     bool        translateAdr( T64Word vAdr, T64Word *pAdr );
+    T64Word     getTlbHits( );
+    T64Word     getTlbMisses( );
 
     void        initModule( );
     void        resetModule( );
@@ -73,15 +84,35 @@ struct T64GlobalTlb : T64Module {
                                    T64Word            arg1, 
                                    T64Word            arg2 );
 
+    uint32_t    getControlEventMask( );
+
+    bool        saveState( T64Snapshot *snap );
+    bool        restoreState( T64Snapshot *snap );
+
     private:
 
+    struct alignas( 64 ) Counters {
+
+        std::atomic<T64Word>    hits    { 0 };
+        std::atomic<T64Word>    misses  { 0 };
+    };
+
+    T64TlbEntry         *findTlbEntry( T64Word vAdr );
+    bool                insertEntry( T64Word arg1, T64Word arg2, uint16_t tlbInfo );
+    void                beginUpdate( );
+    void                endUpdate( );
+    void                countLookup( int reqModNum, bool hit );
+
     T64TlbKind          tlbKind;
     T64TlbType          tlbType;
     int                 tlbSize;
+    int                 tlbSets;
+    int                 tlbWays;
+    uint32_t            tlbPageSizesUsed;
     T64TlbEntry         *tlbTable;
     int                 tlbRoundRobin;
-    std::shared_mutex   tLock;
+    std::mutex          tLock;
+    std::atomic<uint32_t> tSeq      { 0 };
 
-    T64Word             tlbMissCount;
-    T64Word             tlbHitCount;
+    Counters            counters[ MAX_MOD_MAP_ENTRIES ];
 };
@@ -129,6 +129,9 @@ void processCmdLineOptions( SimGlobals *glb, int argc, char *argv[ ] ) {
                 printf( "  --configfile=<file>  : specify configuration file\n" );
                 printf( "  --logfile=<file>     : specify log file\n" );
                 printf( "  --initfile=<file>    : specify init file\n" );
+                printf( "  --batch              : run without the window display and exit\n" );
+                printf( "  --elffile=<file>     : ELF file to load in batch mode\n" );
+                printf( "  --steps=<num>        : instruction limit in batch mode\n" );
                 exit( 0 );
             
             } break;
@@ -177,6 +180,41 @@ void processCmdLineOptions( SimGlobals *glb, int argc, char *argv[ ] ) {
 
             } break; 
 
+            case CL_ARG_VAL_BATCH: {
+
+                glb -> batchFlag = true;
+
+            } break;
+
+            case CL_ARG_VAL_ELF_FILE: {
+
+                if ( optArg ) {
+        
+                    strncpy( glb -> elfFileName, optArg, MAX_FILE_PATH_SIZE - 1 );
+                    glb -> elfFileName[ MAX_FILE_PATH_SIZE - 1 ] = '\0';
+                }
+                else {
+        
+                    printf( "Error: --elffile requires a filename\n" );
+                    exit( 1 );
+                }
+
+            } break;
+
+            case CL_ARG_VAL_STEPS: {
+
+                if (( optArg ) && ( atoi( optArg ) >= 0 )) {
+
+                    glb -> batchSteps = atoi( optArg );
+                }
+                else {
+        
+                    printf( "Error: --steps requires a positive number\n" );
+                    exit( 1 );
+                }
+
+            } break;
+
             default: {
 
                 printf( "Invalid command parameter option, use help\n" );
@@ -208,10 +208,18 @@ enum SimTokId : uint16_t {
     TOK_BYTE,                   TOK_UBYTE,                  TOK_SHORT,  
     TOK_USHORT,                 TOK_HALF,                   TOK_UHALF, 
     TOK_WORD,                   TOK_UWORD,                  TOK_DWORD,      
-    TOK_DOUBLE,                    
+    TOK_DOUBLE,                 TOK_ON,                     TOK_OFF,
+    TOK_INCR,                   TOK_READ,                   TOK_WRITE,
+    TOK_ACCESS,
     
     TOK_TLB_FA_16S,             TOK_TLB_FA_32S,             TOK_TLB_FA_64S,             
-    TOK_TLB_FA_128S,            TOK_MOD_SPA_ADR,            TOK_MOD_SPA_LEN,
+    TOK_TLB_FA_128S,            TOK_TLB_SA_256S,            TOK_TLB_SA_1024S,
+    TOK_TLB_SA_4096S,           TOK_TLB_SA_64U,             TOK_TLB_SA_256U,
+    TOK_CACHE_2W_128S_4L,       TOK_CACHE_4W_128S_4L,       TOK_CACHE_8W_128S_4L,
+    TOK_CACHE_2W_64S_8L,        TOK_CACHE_4W_64S_8L,        TOK_CACHE_8W_64S_8L,
+    TOK_MOD_SPA_ADR,            TOK_MOD_SPA_LEN,
+    TOK_PROC_PREDECODE,         TOK_PROC_DIRECT_MEM,        TOK_PROC_BLOCKS,
+    TOK_PROC_VERIFY,            TOK_PROC_TIMING,
 
     TOK_TRUE, TOK_FALSE,
 
@@ -231,6 +239,9 @@ enum SimTokId : uint16_t {
     CMD_DWIN,                   CMD_ECHO,                   CMD_LOG,
     CMD_IF,                     CMD_ELSEIF,                 CMD_ELSE,
     CMD_ENDIF,                  CMD_WHILE,                  CMD_ENDWHILE,
+    CMD_TRACE,                  CMD_PROF,                   CMD_SNAP,
+    CMD_RESTORE,                CMD_BREAK,                  CMD_WATCH,
+    CMD_BLIST,                  CMD_BDEL,
     
     //------------------------------------------------------------------------------------
     // Window Commands Tokens.
@@ -360,6 +371,14 @@ enum SimErrMsgId : int {
     ERR_OPEN_LOG_FILE               = 321,
     ERR_NO_LOG_FILE_CONFIGURED      = 322,
     ERR_OUT_OF_HIST_BOUNDS          = 323,
+    ERR_OPEN_TRACE_FILE             = 324,
+    ERR_MODULE_IS_RUNNING           = 325,
+    ERR_SAVE_SNAPSHOT               = 326,
+    ERR_RESTORE_SNAPSHOT            = 327,
+    ERR_BREAK_TABLE_FULL            = 328,
+    ERR_BREAK_NOT_FOUND             = 329,
+    ERR_BREAK_COND_OPERAND          = 330,
+    ERR_BREAK_COND_TOO_LONG         = 331,
 
     ERR_EXPR_TYPE_MATCH             = 400,
     ERR_EXPR_FACTOR                 = 401,
@@ -431,6 +450,7 @@ const char ENV_WORDS_PER_LINE [ ]       = "WORDS_PER_LINE";
 const char ENV_WIN_MIN_ROWS[ ]          = "WIN_MIN_ROWS";
 const char ENV_WIN_TEXT_LINE_WIDTH[ ]   = "WIN_TEXT_WIDTH";
 const char ENV_WIN_TEXT_TAB_SIZE[ ]     = "WIN_TEXT_TAB_SIZE";
+const char ENV_WIN_REFRESH_MS[ ]        = "WIN_REFRESH_MS";
 
 const char ENV_ASSERT_DEF_MSG[ ]        = "ASSERT_DEF_MSG";
 const char ENV_CHECK_DEF_MSG[ ]         = "CHECK_DEF_MSG";
@@ -457,6 +477,28 @@ const char ENV_SPA_MEM_LIMIT[ ]         = "SPA_MEM_LIMIT";
 const char ENV_HPA_MEM_START[ ]         = "HPA_MEM_START";
 const char ENV_HPA_MEM_LIMIT[ ]         = "HPA_MEM_LIMIT";
 
+//----------------------------------------------------------------------------------------
+// Handles for the predefined environment variables used on the command paths. The
+// variables are resolved once when the predefined variables are entered, further
+// access by handle does not need a name lookup.
+//
+//----------------------------------------------------------------------------------------
+enum SimEnvHandleId : int {
+
+    ENV_H_SHOW_CMD_CNT          = 0,
+    ENV_H_CMD_CNT               = 1,
+    ENV_H_ECHO_CMD_INPUT        = 2,
+    ENV_H_EXIT_CODE             = 3,
+    ENV_H_RDX_DEFAULT           = 4,
+    ENV_H_WORDS_PER_LINE        = 5,
+    ENV_H_WIN_MIN_ROWS          = 6,
+    ENV_H_WIN_TEXT_LINE_WIDTH   = 7,
+    ENV_H_WIN_TEXT_TAB_SIZE     = 8,
+    ENV_H_HALT_ON_TRAPS         = 9,
+    ENV_H_WIN_REFRESH_MS        = 10,
+    ENV_H_MAX                   = 11
+};
+
 //----------------------------------------------------------------------------------------
 // Forward declaration of the globals structure. Every object will have access to 
 // the globals structure, so we do not have to pass around references to all the
@@ -491,7 +533,10 @@ enum SimCmdLineArgVal : int {
     CL_ARG_VAL_VERSION,
     CL_ARG_VAL_VERBOSE,        
     CL_ARG_VAL_CONFIG_FILE,      
-    CL_ARG_VAL_LOG_FILE
+    CL_ARG_VAL_LOG_FILE,
+    CL_ARG_VAL_BATCH,
+    CL_ARG_VAL_ELF_FILE,
+    CL_ARG_VAL_STEPS
 };
 
 struct SimCmdLineOptions {
@@ -691,6 +736,7 @@ struct SimExprEvaluator {
     bool            acceptBoolExpr( SimErrMsgId errCode );
     char            *acceptStringExpr( SimErrMsgId errCode );
     void            parseExpr( SimExpr *rExpr, bool evalEnabled = true );
+    void            compileCond( T64BreakCond *cond );
     
     private:
     
@@ -714,11 +760,24 @@ struct SimExprEvaluator {
     void            pFuncRegion( SimExpr *rExpr, bool evalEnabled );
     void            pFuncOffset( SimExpr *rExpr, bool evalEnabled );
     void            pFuncPage( SimExpr *rExpr, bool evalEnabled );  
+
+    SimTokTypeId    compileOrExpr( T64BreakCond *cond );
+    SimTokTypeId    compileAndExpr( T64BreakCond *cond );
+    SimTokTypeId    compileNotExpr( T64BreakCond *cond );
+    SimTokTypeId    compileRelationExpr( T64BreakCond *cond );
+    SimTokTypeId    compileSimpleExpr( T64BreakCond *cond );
+    SimTokTypeId    compileTerm( T64BreakCond *cond );
+    SimTokTypeId    compileFactor( T64BreakCond *cond );
+    void            emitCond( T64BreakCond    *cond, 
+                              T64BreakCondOp  op, 
+                              int             reg = 0, 
+                              T64Word         val = 0 );
     
     SimGlobals      *glb        = nullptr;
     SimTokenizer    *tok        = nullptr;
     T64Assemble     *inlineAsm  = nullptr;
     T64DisAssemble  *disAsm     = nullptr;
+    int             condDepth   = 0;
 };
 
 //----------------------------------------------------------------------------------------
@@ -746,7 +805,9 @@ struct SimEnvTabEntry {
 //----------------------------------------------------------------------------------------
 // Environment variables. The simulator has a global table where all variables are 
 // kept. It is a simple array with a high water mark concept. The table will be 
-// allocated at simulator start.
+// allocated at simulator start. A variable never moves in the table, so its index
+// is a stable handle. The names are found through an open addressing hash table
+// that maps the upshifted name to the table index.
 //
 //----------------------------------------------------------------------------------------
 struct SimEnv {
@@ -769,6 +830,10 @@ struct SimEnv {
     SimEnvTabEntry  *getEnvEntry( char *name );
     SimEnvTabEntry  *getEnvEntry( int index );
 
+    bool            getEnvVarBool( SimEnvHandleId id, bool def = false );
+    T64Word         getEnvVarInt( SimEnvHandleId id, T64Word def = 0 );
+    void            setEnvVar( SimEnvHandleId id, T64Word val );
+
     int             getEnvHwm( );
     int             formatEnvEntry( char *name, char *buf, int bufLen );
     int             formatEnvEntry( int index, char *buf, int bufLen );
@@ -781,6 +846,8 @@ struct SimEnv {
     
     int             lookupEntry( char *name );
     int             findFreeEntry( );
+    void            hashInsert( int index );
+    void            hashRemove( int index );
     
     void            enterVar( char *name, 
                               T64Word val, 
@@ -801,6 +868,10 @@ struct SimEnv {
     SimEnvTabEntry  *hwm    = nullptr;
     SimEnvTabEntry  *limit  = nullptr;
     SimGlobals      *glb    = nullptr;
+
+    int             *hashTab    = nullptr;
+    int             hashMask    = 0;
+    int             handles[ ENV_H_MAX ];
 };
 
 //----------------------------------------------------------------------------------------
@@ -858,6 +929,7 @@ struct SimWinOutBuffer : SimFormatter {
     int         writeChars( const char *format, ... );
     int         writeChar( const char ch );
     void        setScrollWindowSize( int size );
+    void        setDirectOutput( bool val );
     
     void        resetLineCursor( );
     char        *getLineRelative( int lineBelowTop );
@@ -874,6 +946,7 @@ struct SimWinOutBuffer : SimFormatter {
     int         cursorIndex = 0; // Index of the last line currently shown.
     int         screenLines = 0; // Number of lines displayed in the window.
     int         charPos     = 0; // Current character position in the line.
+    bool        directOut   = false; // Print to stdout instead of buffering.
 };
 
 //----------------------------------------------------------------------------------------
@@ -1113,15 +1186,16 @@ struct SimWinProcState : SimWin {
     void drawGRegDataLine( int from, int to );
     void drawCRegDataLine( int from, int to );
     
-    T64Processor    *proc;
-    T64DisAssemble  *disAsm;
-    T64Word         codeWinBaseAdr;
+    T64Processor        *proc;
+    T64ProcStateView    view;
+    T64DisAssemble      *disAsm;
+    T64Word             codeWinBaseAdr;
 
-    T64Word         lastGRegState[ T64_MAX_GREGS ];
-    T64Word         lastCRegState[ T64_MAX_CREGS ];
+    T64Word             lastGRegState[ T64_MAX_GREGS ];
+    T64Word             lastCRegState[ T64_MAX_CREGS ];
     
-    T64Word         lastCodeWinBaseAdr;
-    uint8_t         lastDataBuf[ MAX_WIN_ROW_SIZE * 4 ];
+    T64Word             lastCodeWinBaseAdr;
+    uint8_t             lastDataBuf[ MAX_WIN_ROW_SIZE * 4 ];
 };
 
 //----------------------------------------------------------------------------------------
@@ -1256,12 +1330,17 @@ public:
     SimTokId        getCurrentCmd( );
     void            cmdInterpreterSetup( ); 
     void            cmdInterpreterLoop( );
+    int             cmdBatchRun( );
 
 private:
     
     void            printWelcome( );
     int             buildCmdPrompt( char *promptStr, int promptStrLen );
     int             readCmdLine( char *cmdBuf, int cmdBufLen, char *promptStr );
+    void            refreshWhileRunning( char *cmdBuf, 
+                                         char *promptStr, 
+                                         int  promptStrLen, 
+                                         int  cmdBufCursor );
     void            evalInputLine( char *cmdBuf );
     void            cmdLineError( SimErrMsgId errNum, char *argStr = nullptr );
     int             promptYesNoCancel( char *promptStr );
@@ -1289,7 +1368,7 @@ private:
     void            envCmd( );
     void            execFileCmd( );
     void            loadElfFileCmd( );
-    void            loadElfFile( char *fileName );
+    T64Word         loadElfFile( char *fileName );
     void            writeLineCmd( );
     void            execCmdsFromFile( char* fileName );
     
@@ -1316,6 +1395,14 @@ private:
     void            runCmd( );
     void            stepCmd( );
     void            haltCmd( );
+    void            traceCmd( );
+    void            profileCmd( );
+    void            snapCmd( );
+    void            restoreCmd( );
+    void            breakCmd( );
+    void            watchCmd( );
+    void            breakListCmd( );
+    void            breakDeleteCmd( );
    
     void            modifyRegCmd( );
     
@@ -1384,6 +1471,7 @@ public:
     
     void            setupWinDisplay( );
     void            startWinDisplay( );
+    int             startBatchRun( );
     SimTokId        getCurrentCmd( );
 
     void            setWinMode( bool winOn );
@@ -1470,9 +1558,13 @@ struct SimGlobals {
     SimEnv              *env            = nullptr;
     SimWinDisplay       *winDisplay     = nullptr;
     T64System           *system         = nullptr;
+    T64SymTab           *symTab         = nullptr;
 
     bool                verboseFlag                             = false;
+    bool                batchFlag                               = false;
+    int                 batchSteps                              = 0;
     char                configFileName[ MAX_FILE_PATH_SIZE ]    = { 0 };
     char                logFileName[ MAX_FILE_PATH_SIZE ]       = { 0 };
+    char                elfFileName[ MAX_FILE_PATH_SIZE ]       = { 0 };
     FILE                *logFile;
 };
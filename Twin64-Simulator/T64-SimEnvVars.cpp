@@ -26,7 +26,6 @@
 
 //----------------------------------------------------------------------------------------
 // Local name space. We try to keep utility functions local to the file.  
-// None so far.
 //
 //----------------------------------------------------------------------------------------
 namespace {
@@ -49,6 +48,43 @@ void copyStr( char *dst, const char *src, int maxSize, bool upshift ) {
     dst[ i ] = '\0';
 }
 
+//----------------------------------------------------------------------------------------
+// The hash of an already upshifted variable name. A simple FNV-1a hash is good 
+// enough for the short names we have.
+//
+//----------------------------------------------------------------------------------------
+uint32_t hashName( const char *name ) {
+
+    uint32_t h = 2166136261u;
+
+    while ( *name != '\0' ) {
+
+        h ^= (uint8_t) *name++;
+        h *= 16777619u;
+    }
+
+    return( h );
+}
+
+//----------------------------------------------------------------------------------------
+// The predefined variables with a handle. The order matches the handle ids.
+//
+//----------------------------------------------------------------------------------------
+const char *const EnvHandleNames[ ENV_H_MAX ] = {
+
+    ENV_SHOW_CMD_CNT,
+    ENV_CMD_CNT,
+    ENV_ECHO_CMD_INPUT,
+    ENV_EXIT_CODE,
+    ENV_RDX_DEFAULT,
+    ENV_WORDS_PER_LINE,
+    ENV_WIN_MIN_ROWS,
+    ENV_WIN_TEXT_LINE_WIDTH,
+    ENV_WIN_TEXT_TAB_SIZE,
+    ENV_HALT_ON_TRAPS,
+    ENV_WIN_REFRESH_MS
+};
+
 }; // namespace
 
 
@@ -72,7 +108,9 @@ void copyStr( char *dst, const char *src, int maxSize, bool upshift ) {
 
 //----------------------------------------------------------------------------------------
 // The ENV variable object. The table is dynamically allocated, the HWM and limit 
-// pointer are used to manage the search, add and remove functions.
+// pointer are used to manage the search, add and remove functions. The hash table
+// has at least twice the slots of the variable table, rounded up to a power of 
+// two, so that a probe sequence always ends at a free slot.
 //
 //----------------------------------------------------------------------------------------
 SimEnv::SimEnv( SimGlobals *glb, int size ) {
@@ -81,6 +119,15 @@ SimEnv::SimEnv( SimGlobals *glb, int size ) {
     hwm         = table;
     limit       = &table[ size ];
     this -> glb = glb;
+
+    int hashSize = 16;
+    while ( hashSize < 2 * size ) hashSize <<= 1;
+
+    hashTab     = (int *) malloc( hashSize * sizeof( int ));
+    hashMask    = hashSize - 1;
+
+    for ( int i = 0; i < hashSize; i++ ) hashTab[ i ] = -1;
+    for ( int i = 0; i < ENV_H_MAX; i++ ) handles[ i ] = -1;
 }
 
 //----------------------------------------------------------------------------------------
@@ -130,28 +177,81 @@ int SimEnv::getEnvHwm( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Look a variable. We just do a linear search up to the HWM. If not found, a 
-// -1 is returned. We create local upshifted copy, truncated to the maximum
-// name size, if the name is too large.
+// Look a variable. We create local upshifted copy, truncated to the maximum name
+// size, if the name is too large, and probe the hash table starting at the slot
+// of the name hash. Only valid entries are in the hash table. If not found, a -1
+// is returned.
 //
 //----------------------------------------------------------------------------------------
 int SimEnv::lookupEntry( char *name ) {
     
-    SimEnvTabEntry *entry = table;
-
     char tmp[ MAX_ENV_NAME_SIZE ];
     copyStr( tmp, name, sizeof( tmp ), true );
 
-    while ( entry < hwm ) {
+    int slot = hashName( tmp ) & hashMask;
+
+    while ( hashTab[ slot ] >= 0 ) {
+
+        int index = hashTab[ slot ];
         
-        if (( entry -> valid ) && ( strcmp( entry -> name, tmp ) == 0 )) 
-            return((int) ( entry - table ));
-        else entry ++;
+        if ( strcmp( table[ index ].name, tmp ) == 0 ) return( index );
+        slot = ( slot + 1 ) & hashMask;
     }
     
     return( -1 );
 }
 
+//----------------------------------------------------------------------------------------
+// Enter a table entry into the hash table. The entry name is already upshifted.
+// We use the first free slot of the probe sequence.
+//
+//----------------------------------------------------------------------------------------
+void SimEnv::hashInsert( int index ) {
+
+    int slot = hashName( table[ index ].name ) & hashMask;
+
+    while ( hashTab[ slot ] >= 0 ) slot = ( slot + 1 ) & hashMask;
+
+    hashTab[ slot ] = index;
+}
+
+//----------------------------------------------------------------------------------------
+// Remove a table entry from the hash table. To keep the probe sequences intact
+// without marking deleted slots, the entries following the freed slot are moved
+// back when their home slot does not lie between the freed slot and their slot.
+//
+//----------------------------------------------------------------------------------------
+void SimEnv::hashRemove( int index ) {
+
+    int slot = hashName( table[ index ].name ) & hashMask;
+
+    while (( hashTab[ slot ] >= 0 ) && ( hashTab[ slot ] != index )) {
+
+        slot = ( slot + 1 ) & hashMask;
+    }
+
+    if ( hashTab[ slot ] < 0 ) return;
+
+    int hole = slot;
+    
+    hashTab[ hole ] = -1;
+    slot            = ( slot + 1 ) & hashMask;
+
+    while ( hashTab[ slot ] >= 0 ) {
+
+        int home = hashName( table[ hashTab[ slot ]].name ) & hashMask;
+
+        if ((( slot - home ) & hashMask ) >= (( slot - hole ) & hashMask )) {
+
+            hashTab[ hole ] = hashTab[ slot ];
+            hashTab[ slot ] = -1;
+            hole            = slot;
+        }
+
+        slot = ( slot + 1 ) & hashMask;
+    }
+}
+
 //----------------------------------------------------------------------------------------
 // Find a free slot for a variable. First we look for a free entry in the range
 // up to the HWM. If there is none, we try to increase the HWM. If all fails, 
@@ -280,6 +380,36 @@ void SimEnv::setEnvAttr( char *name, bool predefined, bool readOnly ) {
     }
 }
 
+//----------------------------------------------------------------------------------------
+// Access the predefined variables by handle. The handles are resolved when the
+// predefined variables are entered. A predefined variable cannot be removed and
+// keeps its type, so the table index stays valid. Before the setup, the getters 
+// return the default value and the setter does nothing.
+//
+//----------------------------------------------------------------------------------------
+bool SimEnv::getEnvVarBool( SimEnvHandleId id, bool def ) {
+
+    int index = handles[ id ];
+
+    if ( index >= 0 )   return( table[ index ].u.bVal );
+    else                return ( def );
+}
+
+T64Word SimEnv::getEnvVarInt( SimEnvHandleId id, T64Word def ) {
+
+    int index = handles[ id ];
+
+    if ( index >= 0 )   return( table[ index ].u.iVal );
+    else                return ( def );
+}
+
+void SimEnv::setEnvVar( SimEnvHandleId id, T64Word val ) {
+
+    int index = handles[ id ];
+
+    if ( index >= 0 ) table[ index ].u.iVal = val;
+}
+
 //----------------------------------------------------------------------------------------
 // Environment variables getter functions. Just look up the entry and return the 
 // value. If the entry does not exist, we return an optional default.
@@ -329,6 +459,7 @@ void SimEnv::enterVar( char *name, T64Word  val, bool predefined, bool rOnly ) {
         tmp.readOnly    = rOnly;
         tmp.u.iVal      = val;
         table[ index ]  = tmp;
+        hashInsert( index );
     }
     else throw( ERR_ENV_TABLE_FULL );
 }
@@ -347,6 +478,7 @@ void SimEnv::enterVar( char *name, bool val, bool predefined, bool rOnly ) {
         tmp.readOnly    = rOnly;
         tmp.u.bVal      = val;
         table[ index ]  = tmp;
+        hashInsert( index );
     }
     else throw( ERR_ENV_TABLE_FULL );
 }
@@ -367,6 +499,7 @@ void SimEnv::enterVar( char *name, char *str, bool predefined, bool rOnly ) {
         strcpy( tmp.u.strVal, str );  
             
         table[ index ]  = tmp;
+        hashInsert( index );
     }
     else throw( ERR_ENV_TABLE_FULL );
 }
@@ -374,8 +507,8 @@ void SimEnv::enterVar( char *name, char *str, bool predefined, bool rOnly ) {
 //----------------------------------------------------------------------------------------
 // Remove a user defined ENV variable. If the ENV variable is predefined it is 
 // an error. If the ENV variable type is a string, free the string space. The 
-// entry is marked invalid, i.e. free. Finally, if the entry was at the high 
-// water mark, adjust the HWM.
+// entry is removed from the hash table and marked invalid, i.e. free. Finally, 
+// if the entry was at the high water mark, adjust the HWM.
 //
 //----------------------------------------------------------------------------------------
 void SimEnv::removeEnvVar( char *name ) {
@@ -391,6 +524,8 @@ void SimEnv::removeEnvVar( char *name ) {
     if (( ptr -> typ == TYP_STR ) && 
         ( ptr -> u.strVal != nullptr )) free( ptr -> u.strVal );
     
+    hashRemove( index );
+
     ptr -> valid    = false;
     ptr -> typ      = TYP_NIL;
     
@@ -465,7 +600,8 @@ int SimEnv::formatEnvEntry( int index, char *buf, int bufLen ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Enter the predefined entries.
+// Enter the predefined entries. When all are entered, the handles of the variables
+// used on the command paths are resolved.
 //
 //----------------------------------------------------------------------------------------
 void SimEnv::setupPredefined( ) {
@@ -498,6 +634,7 @@ void SimEnv::setupPredefined( ) {
     enterVar((char *) ENV_WIN_MIN_ROWS, (T64Word) 24, true, false );
     enterVar((char *) ENV_WIN_TEXT_LINE_WIDTH, (T64Word) 90, true, false );
     enterVar((char *) ENV_WIN_TEXT_TAB_SIZE, (T64Word) 4, true, false );
+    enterVar((char *) ENV_WIN_REFRESH_MS, (T64Word) 200, true, false );
 
     enterVar((char *) ENV_HALT_ON_TRAPS, (bool) false, true, false );
 
@@ -513,4 +650,9 @@ void SimEnv::setupPredefined( ) {
     enterVar((char *) ENV_SPA_MEM_START, T64_IO_SPA_MEM_START, true, true );
     enterVar((char *) ENV_SPA_MEM_LIMIT, T64_IO_SPA_MEM_LIMIT, true, true );
 
+    for ( int i = 0; i < ENV_H_MAX; i++ ) {
+        
+        handles[ i ] = lookupEntry((char *) EnvHandleNames[ i ] );
+    }
+
 }
@@ -0,0 +1,363 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin64Sim - A 64-bit CPU Simulator - Break Condition Compiler
+//
+//----------------------------------------------------------------------------------------
+// Breakpoints and watchpoints can have a condition. The condition is written in
+// the expression syntax of the command line, but it is not evaluated when the
+// command is entered. Instead, it is compiled to the stack machine code of the
+// processor break table, which the CPU thread evaluates each time the entry
+// matches. The compiler follows the grammar of the expression evaluator:
+//
+//      <factor>        ->  <number> | <boolean> | <envId> |
+//                          <pswId> | <gregId> | <cregId> |
+//                          "~" <factor> | "(" <expr> ")"
+//
+//      <term>          ->  <factor> { <termOp> <factor> }
+//      <simpleExpr>    ->  [ ( "+" | "-" ) ] <term> { <exprOp> <term> }
+//      <relationExpr>  ->  <simpleExpr> [ <relOp> <simpleExpr> ]
+//      <notExpr>       ->  { <notOp> } <relationExpr>
+//      <andExpr>       ->  <notExpr> { <andOp> <notExpr> }
+//      <orExpr>        ->  <andExpr> { <orOp> <andExpr> }
+//
+// The registers are always the registers of the processor that breaks, a
+// processor qualifier is not allowed. An environment variable is replaced by its
+// value when the condition is compiled. Strings, memory data and predefined
+// functions are not supported in a condition. The condition must be of type
+// BOOL.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin64Sim - A 64-bit CPU Simulator - Break Condition Compiler
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You
+// should have received a copy of the GNU General Public License along with this
+// program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-SimDeclarations.h"
+
+//----------------------------------------------------------------------------------------
+// Local name space. We try to keep utility functions local to the file.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// Map the operator tokens to the condition code operations.
+//
+//----------------------------------------------------------------------------------------
+T64BreakCondOp condOpForToken( SimTokId tokId ) {
+
+    switch ( tokId ) {
+
+        case TOK_MULT:  return( T64_BC_MUL );
+        case TOK_DIV:   return( T64_BC_DIV );
+        case TOK_MOD:   return( T64_BC_MOD );
+        case TOK_AND:   return( T64_BC_AND );
+        case TOK_PLUS:  return( T64_BC_ADD );
+        case TOK_MINUS: return( T64_BC_SUB );
+        case TOK_OR:    return( T64_BC_OR );
+        case TOK_XOR:   return( T64_BC_XOR );
+        case TOK_EQ:    return( T64_BC_EQ );
+        case TOK_NE:    return( T64_BC_NE );
+        case TOK_LT:    return( T64_BC_LT );
+        case TOK_LE:    return( T64_BC_LE );
+        case TOK_GT:    return( T64_BC_GT );
+        case TOK_GE:    return( T64_BC_GE );
+        default:        return( T64_BC_NIL );
+    }
+}
+
+}; // namespace
+
+//----------------------------------------------------------------------------------------
+// Emit one operation. We keep track of the stack depth, so that a condition
+// which does not fit the code or the stack of the break table is rejected here.
+//
+//----------------------------------------------------------------------------------------
+void SimExprEvaluator::emitCond( T64BreakCond *cond, T64BreakCondOp op, int reg, T64Word val ) {
+
+    if ( cond -> len >= T64_BREAK_COND_CODE_LEN ) throw( ERR_BREAK_COND_TOO_LONG );
+
+    T64BreakCondInstr *ci = &cond -> code[ cond -> len++ ];
+
+    ci -> op    = op;
+    ci -> reg   = (uint8_t) reg;
+    ci -> val   = val;
+
+    switch ( op ) {
+
+        case T64_BC_NUM:
+        case T64_BC_GREG:
+        case T64_BC_CREG:
+        case T64_BC_IA:
+        case T64_BC_ST:     condDepth ++; break;
+
+        case T64_BC_NEG:
+        case T64_BC_LNOT:   break;
+
+        default:            condDepth --;
+    }
+
+    if ( condDepth > T64_BREAK_COND_STACK_SIZE ) throw( ERR_BREAK_COND_TOO_LONG );
+}
+
+//----------------------------------------------------------------------------------------
+// "compileFactor" compiles the operands. The register ids are the register
+// numbers, for the PSR they select the instruction address or the status field.
+//
+//----------------------------------------------------------------------------------------
+SimTokTypeId SimExprEvaluator::compileFactor( T64BreakCond *cond ) {
+
+    if ( tok -> isTokenTyp( TYP_NUM )) {
+
+        emitCond( cond, T64_BC_NUM, 0, tok -> tokVal( ));
+        tok -> nextToken( );
+        return( TYP_NUM );
+    }
+    else if ( tok -> isTokenTyp( TYP_BOOL )) {
+
+        emitCond( cond, T64_BC_NUM, 0, ( tok -> tokVal( ) != 0 ));
+        tok -> nextToken( );
+        return( TYP_BOOL );
+    }
+    else if (( tok -> isTokenTyp( TYP_GREG )) ||
+             ( tok -> isTokenTyp( TYP_CREG )) ||
+             ( tok -> isTokenTyp( TYP_PREG ))) {
+
+        SimTokTypeId    regType = tok -> tokTyp( );
+        int             regId   = (int) tok -> tokVal( );
+
+        if      ( regType == TYP_GREG ) emitCond( cond, T64_BC_GREG, regId );
+        else if ( regType == TYP_CREG ) emitCond( cond, T64_BC_CREG, regId );
+        else if ( regId == 1 )          emitCond( cond, T64_BC_IA );
+        else                            emitCond( cond, T64_BC_ST );
+
+        tok -> nextToken( );
+        if ( tok -> isToken( TOK_COLON )) throw( ERR_BREAK_COND_OPERAND );
+        return( TYP_NUM );
+    }
+    else if ( tok -> isToken( TOK_NEG )) {
+
+        tok -> nextToken( );
+        if ( compileFactor( cond ) != TYP_BOOL ) throw( ERR_EXPECTED_BOOL_VALUE );
+
+        emitCond( cond, T64_BC_LNOT );
+        return( TYP_BOOL );
+    }
+    else if ( tok -> isToken( TOK_LPAREN )) {
+
+        tok -> nextToken( );
+        SimTokTypeId typ = compileOrExpr( cond );
+
+        if ( tok -> isToken( TOK_RPAREN )) tok -> nextToken( );
+        else throw ( ERR_EXPECTED_RPAREN );
+
+        return( typ );
+    }
+    else if ( tok -> isToken( TOK_IDENT )) {
+
+        SimEnvTabEntry  *entry  = glb -> env -> getEnvEntry( tok -> tokName( ));
+        T64Word         symAdr  = 0;
+
+        if ( entry == nullptr ) {
+
+            if ( ! glb -> symTab -> find( tok -> tokName( ), &symAdr )) {
+
+                throw( ERR_ENV_VAR_NOT_FOUND );
+            }
+
+            tok -> nextToken( );
+            emitCond( cond, T64_BC_NUM, 0, symAdr );
+            return( TYP_NUM );
+        }
+
+        tok -> nextToken( );
+
+        if ( entry -> typ == TYP_NUM ) {
+
+            emitCond( cond, T64_BC_NUM, 0, entry -> u.iVal );
+            return( TYP_NUM );
+        }
+        else if ( entry -> typ == TYP_BOOL ) {
+
+            emitCond( cond, T64_BC_NUM, 0, entry -> u.bVal );
+            return( TYP_BOOL );
+        }
+        else throw( ERR_BREAK_COND_OPERAND );
+    }
+    else if (( tok -> isTokenTyp( TYP_STR ))    ||
+             ( tok -> isTokenTyp( TYP_P_FUNC )) ||
+             ( tok -> isToken( TOK_LBRACK ))) {
+
+        throw( ERR_BREAK_COND_OPERAND );
+    }
+    else if ( tok -> isToken( TOK_EOS )) throw( ERR_UNEXPECTED_EOS );
+    else throw ( ERR_EXPR_FACTOR );
+}
+
+//----------------------------------------------------------------------------------------
+// "compileTerm" and "compileSimpleExpr" compile the numeric operations. Both
+// operands must be numeric.
+//
+//----------------------------------------------------------------------------------------
+SimTokTypeId SimExprEvaluator::compileTerm( T64BreakCond *cond ) {
+
+    SimTokTypeId typ = compileFactor( cond );
+
+    while (( tok -> isToken( TOK_MULT )) ||
+           ( tok -> isToken( TOK_DIV  )) ||
+           ( tok -> isToken( TOK_MOD  )) ||
+           ( tok -> isToken( TOK_AND  ))) {
+
+        T64BreakCondOp op = condOpForToken( tok -> tokId( ));
+
+        tok -> nextToken( );
+
+        if (( typ != TYP_NUM ) || ( compileFactor( cond ) != TYP_NUM )) {
+
+            throw ( ERR_EXPECTED_NUM_VALUE );
+        }
+
+        emitCond( cond, op );
+    }
+
+    return( typ );
+}
+
+SimTokTypeId SimExprEvaluator::compileSimpleExpr( T64BreakCond *cond ) {
+
+    SimTokTypeId typ = TYP_NIL;
+
+    if ( tok -> isToken( TOK_PLUS )) {
+
+        tok -> nextToken( );
+        typ = compileTerm( cond );
+        if ( typ != TYP_NUM ) throw ( ERR_EXPECTED_NUM_VALUE );
+    }
+    else if ( tok -> isToken( TOK_MINUS )) {
+
+        tok -> nextToken( );
+        typ = compileTerm( cond );
+        if ( typ != TYP_NUM ) throw ( ERR_EXPECTED_NUM_VALUE );
+
+        emitCond( cond, T64_BC_NEG );
+    }
+    else typ = compileTerm( cond );
+
+    while (( tok -> isToken( TOK_PLUS ))  ||
+           ( tok -> isToken( TOK_MINUS )) ||
+           ( tok -> isToken( TOK_OR ))    ||
+           ( tok -> isToken( TOK_XOR ))) {
+
+        T64BreakCondOp op = condOpForToken( tok -> tokId( ));
+
+        tok -> nextToken( );
+
+        if (( typ != TYP_NUM ) || ( compileTerm( cond ) != TYP_NUM )) {
+
+            throw ( ERR_EXPECTED_NUM_VALUE );
+        }
+
+        emitCond( cond, op );
+    }
+
+    return( typ );
+}
+
+//----------------------------------------------------------------------------------------
+// "compileRelationExpr" compiles a comparison. Both sides must be of the same
+// type, the result is a BOOL.
+//
+//----------------------------------------------------------------------------------------
+SimTokTypeId SimExprEvaluator::compileRelationExpr( T64BreakCond *cond ) {
+
+    SimTokTypeId    typ = compileSimpleExpr( cond );
+    T64BreakCondOp  op  = condOpForToken( tok -> tokId( ));
+
+    if (( op < T64_BC_EQ ) || ( op > T64_BC_GE )) return( typ );
+
+    tok -> nextToken( );
+    if ( compileSimpleExpr( cond ) != typ ) throw ( ERR_EXPR_TYPE_MATCH );
+
+    emitCond( cond, op );
+    return( TYP_BOOL );
+}
+
+//----------------------------------------------------------------------------------------
+// "compileNotExpr", "compileAndExpr" and "compileOrExpr" compile the logical
+// operations. The operands must be BOOL. The code has no side effects, so both
+// sides are always evaluated.
+//
+//----------------------------------------------------------------------------------------
+SimTokTypeId SimExprEvaluator::compileNotExpr( T64BreakCond *cond ) {
+
+    if ( tok -> isToken( TOK_LNOT )) {
+
+        tok -> nextToken( );
+        if ( compileNotExpr( cond ) != TYP_BOOL ) throw( ERR_EXPECTED_BOOL_VALUE );
+
+        emitCond( cond, T64_BC_LNOT );
+        return( TYP_BOOL );
+    }
+    else return( compileRelationExpr( cond ));
+}
+
+SimTokTypeId SimExprEvaluator::compileAndExpr( T64BreakCond *cond ) {
+
+    SimTokTypeId typ = compileNotExpr( cond );
+
+    while ( tok -> isToken( TOK_LAND )) {
+
+        tok -> nextToken( );
+
+        if (( typ != TYP_BOOL ) || ( compileNotExpr( cond ) != TYP_BOOL )) {
+
+            throw( ERR_EXPECTED_BOOL_VALUE );
+        }
+
+        emitCond( cond, T64_BC_LAND );
+    }
+
+    return( typ );
+}
+
+SimTokTypeId SimExprEvaluator::compileOrExpr( T64BreakCond *cond ) {
+
+    SimTokTypeId typ = compileAndExpr( cond );
+
+    while ( tok -> isToken( TOK_LOR )) {
+
+        tok -> nextToken( );
+
+        if (( typ != TYP_BOOL ) || ( compileAndExpr( cond ) != TYP_BOOL )) {
+
+            throw( ERR_EXPECTED_BOOL_VALUE );
+        }
+
+        emitCond( cond, T64_BC_LOR );
+    }
+
+    return( typ );
+}
+
+//----------------------------------------------------------------------------------------
+// "compileCond" is the entry point. The condition must evaluate to a BOOL. The
+// code is verified by the break table when the entry is set.
+//
+//----------------------------------------------------------------------------------------
+void SimExprEvaluator::compileCond( T64BreakCond *cond ) {
+
+    cond -> len = 0;
+    condDepth   = 0;
+
+    if ( compileOrExpr( cond ) != TYP_BOOL ) throw( ERR_EXPECTED_BOOL_VALUE );
+}
@@ -346,6 +346,8 @@ SimExprEvaluator::SimExprEvaluator( SimGlobals *glb, SimTokenizer *tok ) {
     this -> tok         = tok;
     this -> inlineAsm   = new T64Assemble( );
     this -> disAsm      = new T64DisAssemble( );
+
+    disAsm -> setSymTab( glb -> symTab );
 }
 
 //----------------------------------------------------------------------------------------
@@ -469,7 +471,8 @@ void SimExprEvaluator::parseMemData( SimExpr *rExpr, bool evalEnabled ) {
 //----------------------------------------------------------------------------------------
 // "parseFactor" parses the factor syntax part of an expression. The expression directly
 // ties into the value providers, i.e. a register of a processor or an environment 
-// variable.
+// variable. An identifier that is not an environment variable is looked up in the
+// symbol table of the loaded program and yields the symbol address.
 //
 //      <factor> -> <number>                        |
 //                  <pswRegId>  [ ":" <proc> ]      |
@@ -540,20 +543,29 @@ void SimExprEvaluator::parseFactor( SimExpr *rExpr, bool evalEnabled ) {
     }
     else if ( tok -> isToken( TOK_IDENT )) {
     
-        SimEnvTabEntry *entry = glb -> env -> getEnvEntry( tok -> tokName( ));
-        if ( entry == nullptr ) throw( ERR_ENV_VAR_NOT_FOUND );
-            
-        rExpr -> typ = entry -> typ;
-        rExpr -> u.str = entry -> u.strVal;
+        SimEnvTabEntry  *entry  = glb -> env -> getEnvEntry( tok -> tokName( ));
+        T64Word         symAdr  = 0;
+
+        if ( entry != nullptr ) {
+
+            rExpr -> typ = entry -> typ;
+            rExpr -> u.str = entry -> u.strVal;
             
-        switch( rExpr -> typ ) {
+            switch( rExpr -> typ ) {
                     
-            case TYP_NIL:                                                break;
-            case TYP_BOOL:  rExpr -> u.bVal =  entry -> u.bVal;          break;
-            case TYP_NUM:   rExpr -> u.val  =  entry -> u.iVal;          break;
-            case TYP_STR:   strcpy( rExpr -> u.str, entry -> u.strVal ); break;
-            default: throw( ERR_INVALID_EXPR );
+                case TYP_NIL:                                                break;
+                case TYP_BOOL:  rExpr -> u.bVal =  entry -> u.bVal;          break;
+                case TYP_NUM:   rExpr -> u.val  =  entry -> u.iVal;          break;
+                case TYP_STR:   strcpy( rExpr -> u.str, entry -> u.strVal ); break;
+                default: throw( ERR_INVALID_EXPR );
+            }
+        }
+        else if ( glb -> symTab -> find( tok -> tokName( ), &symAdr )) {
+
+            rExpr -> typ    = TYP_NUM;
+            rExpr -> u.val  = symAdr;
         }
+        else throw( ERR_ENV_VAR_NOT_FOUND );
        
         tok -> nextToken( );
     }
@@ -38,6 +38,9 @@ const SimCmdLineOptions optionTable[ ] = {
     { "verbose",    CL_OPT_NO_ARGUMENT,        CL_ARG_VAL_VERBOSE },
     { "configfile", CL_OPT_REQUIRED_ARGUMENT,  CL_ARG_VAL_CONFIG_FILE },
     { "logfile",    CL_OPT_REQUIRED_ARGUMENT,  CL_ARG_VAL_LOG_FILE },
+    { "batch",      CL_OPT_NO_ARGUMENT,        CL_ARG_VAL_BATCH },
+    { "elffile",    CL_OPT_REQUIRED_ARGUMENT,  CL_ARG_VAL_ELF_FILE },
+    { "steps",      CL_OPT_REQUIRED_ARGUMENT,  CL_ARG_VAL_STEPS },
     { 0,            CL_OPT_NO_ARGUMENT,        0 }
 };
 
@@ -64,6 +67,12 @@ const SimToken cmdTokTab[ ] = {
     { .name = "MEM",        .typ = TYP_SYM,     .tid = TOK_MEM                      },
     { .name = "IO",         .typ = TYP_SYM,     .tid = TOK_IO                       },
     { .name = "TEXT",       .typ = TYP_SYM,     .tid = TOK_TEXT                     },
+    { .name = "ON",         .typ = TYP_SYM,     .tid = TOK_ON                       },
+    { .name = "OFF",        .typ = TYP_SYM,     .tid = TOK_OFF                      },
+    { .name = "INCR",       .typ = TYP_SYM,     .tid = TOK_INCR                     },
+    { .name = "READ",       .typ = TYP_SYM,     .tid = TOK_READ                     },
+    { .name = "WRITE",      .typ = TYP_SYM,     .tid = TOK_WRITE                    },
+    { .name = "ACCESS",     .typ = TYP_SYM,     .tid = TOK_ACCESS                   },
 
     { .name = "&&",         .typ = TYP_SYM,     .tid = TOK_LAND                     },
     { .name = "||",         .typ = TYP_SYM,     .tid = TOK_LOR                      },
@@ -120,6 +129,14 @@ const SimToken cmdTokTab[ ] = {
     { .name = "RUN",        .typ = TYP_CMD,     .tid = CMD_RUN                      },
     { .name = "STEP",       .typ = TYP_CMD,     .tid = CMD_STEP                     },
     { .name = "S",          .typ = TYP_CMD,     .tid = CMD_STEP                     },
+    { .name = "TRACE",      .typ = TYP_CMD,     .tid = CMD_TRACE                    },
+    { .name = "PROF",       .typ = TYP_CMD,     .tid = CMD_PROF                     },
+    { .name = "SNAP",       .typ = TYP_CMD,     .tid = CMD_SNAP                     },
+    { .name = "RESTORE",    .typ = TYP_CMD,     .tid = CMD_RESTORE                  },
+    { .name = "BREAK",      .typ = TYP_CMD,     .tid = CMD_BREAK                    },
+    { .name = "WATCH",      .typ = TYP_CMD,     .tid = CMD_WATCH                    },
+    { .name = "BLIST",      .typ = TYP_CMD,     .tid = CMD_BLIST                    },
+    { .name = "BDEL",       .typ = TYP_CMD,     .tid = CMD_BDEL                     },
     
     { .name = "MR",         .typ = TYP_CMD,     .tid = CMD_MR                       },
     { .name = "DM",         .typ = TYP_CMD,     .tid = CMD_DM                       },
@@ -297,6 +314,39 @@ const SimToken cmdTokTab[ ] = {
     { .name = "TLB_FA_128S",                .typ = TYP_SYM, 
       .tid = TOK_TLB_FA_128S,               .u = { .val = 0 }},
 
+    { .name = "TLB_SA_256S",                .typ = TYP_SYM, 
+      .tid = TOK_TLB_SA_256S,               .u = { .val = 0 }},
+
+    { .name = "TLB_SA_1024S",               .typ = TYP_SYM, 
+      .tid = TOK_TLB_SA_1024S,              .u = { .val = 0 }},
+
+    { .name = "TLB_SA_4096S",               .typ = TYP_SYM, 
+      .tid = TOK_TLB_SA_4096S,              .u = { .val = 0 }},
+
+    { .name = "TLB_SA_64U",                 .typ = TYP_SYM, 
+      .tid = TOK_TLB_SA_64U,                .u = { .val = 0 }},
+
+    { .name = "TLB_SA_256U",                .typ = TYP_SYM, 
+      .tid = TOK_TLB_SA_256U,               .u = { .val = 0 }},
+
+    { .name = "CACHE_2W_128S_4L",           .typ = TYP_SYM, 
+      .tid = TOK_CACHE_2W_128S_4L,          .u = { .val = 0 }},
+
+    { .name = "CACHE_4W_128S_4L",           .typ = TYP_SYM, 
+      .tid = TOK_CACHE_4W_128S_4L,          .u = { .val = 0 }},
+
+    { .name = "CACHE_8W_128S_4L",           .typ = TYP_SYM, 
+      .tid = TOK_CACHE_8W_128S_4L,          .u = { .val = 0 }},
+
+    { .name = "CACHE_2W_64S_8L",            .typ = TYP_SYM, 
+      .tid = TOK_CACHE_2W_64S_8L,           .u = { .val = 0 }},
+
+    { .name = "CACHE_4W_64S_8L",            .typ = TYP_SYM, 
+      .tid = TOK_CACHE_4W_64S_8L,           .u = { .val = 0 }},
+
+    { .name = "CACHE_8W_64S_8L",            .typ = TYP_SYM, 
+      .tid = TOK_CACHE_8W_64S_8L,           .u = { .val = 0 }},
+
     { .name = "ROM",                        .typ = TYP_SYM, 
       .tid = TOK_MEM_ROM,                   .u = { .val = 0 }},
 
@@ -309,6 +359,21 @@ const SimToken cmdTokTab[ ] = {
     { .name = "SPA_LEN",                    .typ = TYP_SYM, 
       .tid = TOK_MOD_SPA_LEN,               .u = { .val = 0 }},
 
+    { .name = "PREDECODE",                  .typ = TYP_SYM, 
+      .tid = TOK_PROC_PREDECODE,            .u = { .val = 0 }},
+
+    { .name = "DIRECT_MEM",                 .typ = TYP_SYM, 
+      .tid = TOK_PROC_DIRECT_MEM,           .u = { .val = 0 }},
+
+    { .name = "BLOCKS",                     .typ = TYP_SYM, 
+      .tid = TOK_PROC_BLOCKS,               .u = { .val = 0 }},
+
+    { .name = "VERIFY",                     .typ = TYP_SYM, 
+      .tid = TOK_PROC_VERIFY,               .u = { .val = 0 }},
+
+    { .name = "TIMING",                     .typ = TYP_SYM, 
+      .tid = TOK_PROC_TIMING,               .u = { .val = 0 }},
+
     //------------------------------------------------------------------------------------
     // Constants.
     //
@@ -502,6 +567,30 @@ const SimErrMsgTabEntry errMsgTab [ ] = {
     { .errNum = ERR_NO_LOG_FILE_CONFIGURED,             
       .errStr = (char *) "No log file configured" },
 
+    { .errNum = ERR_OPEN_TRACE_FILE,             
+      .errStr = (char *) "Error while opening trace file" },
+
+    { .errNum = ERR_MODULE_IS_RUNNING,             
+      .errStr = (char *) "Module is running" },
+
+    { .errNum = ERR_SAVE_SNAPSHOT,             
+      .errStr = (char *) "Error while saving snapshot" },
+
+    { .errNum = ERR_RESTORE_SNAPSHOT,             
+      .errStr = (char *) "Error while restoring snapshot" },
+
+    { .errNum = ERR_BREAK_TABLE_FULL,             
+      .errStr = (char *) "Break table full or invalid break entry" },
+
+    { .errNum = ERR_BREAK_NOT_FOUND,             
+      .errStr = (char *) "Break entry not found" },
+
+    { .errNum = ERR_BREAK_COND_OPERAND,             
+      .errStr = (char *) "Operand not supported in break condition" },
+
+    { .errNum = ERR_BREAK_COND_TOO_LONG,             
+      .errStr = (char *) "Break condition too complex" },
+
     { .errNum = ERR_EXTRA_TOKEN_IN_STR,         
       .errStr = (char *) "Extra tokens in command line" },
 
@@ -755,6 +844,62 @@ const SimHelpMsgEntry cmdHelpTab[ ] = {
         .helpStr        = (char *) "single step a module"
     },
 
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_TRACE,
+        .cmdNameStr     = (char *) "trace",
+        .cmdSyntaxStr   = (char *) "trace <modNum> [ , \"<filePath>\" ]",
+        .helpStr        = (char *) "start or stop tracing a processor"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_PROF,
+        .cmdNameStr     = (char *) "prof",
+        .cmdSyntaxStr   = (char *) "prof <modNum> [ , ON [ , <rate> ] | , OFF | , <topN> ]",
+        .helpStr        = (char *) "profile a processor and list the hot spots"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_SNAP,
+        .cmdNameStr     = (char *) "snap",
+        .cmdSyntaxStr   = (char *) "snap \"<dirPath>\" [ , INCR ]",
+        .helpStr        = (char *) "save a system snapshot"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_RESTORE,
+        .cmdNameStr     = (char *) "restore",
+        .cmdSyntaxStr   = (char *) "restore \"<dirPath>\"",
+        .helpStr        = (char *) "restore a system snapshot"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_BREAK,
+        .cmdNameStr     = (char *) "break",
+        .cmdSyntaxStr   = (char *) "break <modNum> , <adr> [ , <cond> ]",
+        .helpStr        = (char *) "set an instruction breakpoint"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_WATCH,
+        .cmdNameStr     = (char *) "watch",
+        .cmdSyntaxStr   = (char *) "watch <modNum> , <adr> , <len> [ , READ | WRITE | ACCESS ] [ , <cond> ]",
+        .helpStr        = (char *) "set a data watchpoint"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_BLIST,
+        .cmdNameStr     = (char *) "blist",
+        .cmdSyntaxStr   = (char *) "blist <modNum>",
+        .helpStr        = (char *) "list the breakpoints and watchpoints"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_BDEL,
+        .cmdNameStr     = (char *) "bdel",
+        .cmdSyntaxStr   = (char *) "bdel <modNum> , ( <index> | ALL )",
+        .helpStr        = (char *) "remove breakpoints and watchpoints"
+    },
+
     {
         .helpTypeId = TYP_CMD,  .helpTokId  = CMD_HALT,
         .cmdNameStr     = (char *) "halt",
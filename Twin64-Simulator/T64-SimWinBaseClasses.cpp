@@ -759,10 +759,13 @@ void SimWinOutBuffer::addToBuffer( const char *buf ) {
 // "printChar and "printChars" will add data to the window output buffer. The 
 // resulting print string is just added to the window output buffer. The actual 
 // printing to screen is performed in the "drawBody" routine of the command window.
+// With direct output, used in batch mode, the data goes straight to stdout.
 //
 //----------------------------------------------------------------------------------------
 int SimWinOutBuffer::writeChar( const char ch ) {
     
+    if ( directOut ) return(( fputc( ch, stdout ) == EOF ) ? 0 : 1 );
+
     char buf[ 2 ];
     buf[0] = ch;
     buf[1] = '\0';
@@ -788,7 +791,8 @@ int SimWinOutBuffer::writeChars( const char *format, ... ) {
             lineBuf[ len ] = '\0';
         }
         
-        addToBuffer( lineBuf );
+        if ( directOut ) fputs( lineBuf, stdout );
+        else             addToBuffer( lineBuf );
     }
     
     return ( len );
@@ -866,3 +870,8 @@ void SimWinOutBuffer::setScrollWindowSize( int size ) {
     screenLines = size;
 }
 
+void SimWinOutBuffer::setDirectOutput( bool val ) {
+
+    directOut = val;
+}
+
@@ -147,16 +147,22 @@ bool translateAdr( T64System *sys, T64Word virtAdr, T64Word *physAdr ) {
 // address translation and the endian conversion. It first translates the virtual
 // address to a physical address. If the translation succeeds, it performs a bus 
 // read operation to read the memory content. If the bus read operation succeeds, 
-// it converts endian aware the data and returns true.
+// it converts endian aware the data and returns true. While the processors run,
+// a window refresh must not disturb their caches. The memory is then read with
+// a bus peek, which shows the memory content without the modified cache lines.
 //
 //----------------------------------------------------------------------------------------
 bool readMem( T64System *sys, T64Word adr, uint8_t *val, size_t size ) {
 
     T64Word physAdr = 0;
+    bool    rStat   = false;
 
     if ( ! translateAdr( sys, adr, &physAdr )) return ( false );
 
-    if ( sys -> busOpRead( nullptr, physAdr, (uint8_t *)val, size)) {
+    if ( sys -> isRunning( )) rStat = sys -> busOpPeek( physAdr, (uint8_t *) val, size );
+    else                      rStat = sys -> busOpRead( nullptr, physAdr, (uint8_t *) val, size );
+
+    if ( rStat ) {
 
         copyEndianAware((uint8_t *) val, (uint8_t *) val, size);
         return ( true );    
@@ -183,6 +189,8 @@ SimWinProcState::SimWinProcState( SimGlobals *glb, int modNum ) : SimWin( glb )
     this -> disAsm          = new T64DisAssemble( );
     this -> codeWinBaseAdr  = 0;
 
+    disAsm -> setSymTab( glb -> symTab );
+
     for ( int i = 0; i < T64_MAX_GREGS; i++ ) lastGRegState[ i ] = 0;
     for ( int i = 0; i < T64_MAX_CREGS; i++ ) lastCRegState[ i ] = 0;
 
@@ -213,10 +221,8 @@ void SimWinProcState::setDefaults( ) {
     const int MAX_COLS                  = 98;
 
 
-    T64Cpu    *cpu                      = proc -> getCpuPtr( );
-    
     setWinType( WT_CPU_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_H_RDX_DEFAULT ));
 
     setWinToggleLimit( 2 );
     setWinToggleVal( 0 );
@@ -240,18 +246,20 @@ void SimWinProcState::setDefaults( ) {
     setRows( getWinSize( 0 ).actualRow );
     setColumns( getWinSize( 0 ).minCol );
 
+    proc -> getStateView( &view );
+
      if ( getWinToggleVal( ) == 0 ) {
 
         for ( int i = 0; i < T64_MAX_GREGS; i++ ) {
 
-            lastGRegState[ i ] = cpu -> getGeneralReg( i ); 
+            lastGRegState[ i ] = view.gRegs[ i ]; 
         }
     }
     else if ( getWinToggleVal( ) == 1 ) {
 
         for ( int i = 0; i < T64_MAX_GREGS; i++ ) {
 
-            lastGRegState[ i ] = cpu -> getControlReg( i ); 
+            lastGRegState[ i ] = view.cRegs[ i ]; 
         }
     }
 
@@ -279,7 +287,10 @@ void SimWinProcState::setDefaults( ) {
 //----------------------------------------------------------------------------------------
 // Each window consist of a headline and a body. The banner line is always shown 
 // in inverse and contains summary or head data for the window. The program state
-// banner lists the instruction address and the status word.
+// banner lists the instruction address and the status word. The banner is drawn
+// first, we take the state view of the processor here for the entire window. A 
+// running processor publishes its state after each batch, the window thus shows
+// a consistent state while the processor keeps running.
 //
 // Format:
 //
@@ -299,7 +310,9 @@ void SimWinProcState::drawBanner( ) {
     printTextField((char *) "Mod:", fmtDescBlack );
     printNumericField( getWinModNum( ), fmtDescBlack | FMT_DEC );
 
-    T64Word psw = proc -> getCpuPtr( ) -> getPsrReg( );
+    proc -> getStateView( &view );
+
+    T64Word psw = view.psr;
 
     printTextField((char *) " IA: ", fmtDescBlack );
     printNumericField( psw, fmtDescBlack | FMT_HEX_2_4_4_4 );
@@ -338,7 +351,6 @@ void SimWinProcState::drawBanner( ) {
 void SimWinProcState::drawGRegDataLine( int from, int to ) {
 
     uint32_t fmtDesc        = FMT_DEFAULT | FMT_ALIGN_LFT;
-    T64Cpu   *cpu           = proc -> getCpuPtr( );
     uint32_t rdxFmt         = FMT_DEFAULT;
 
     if      ( getRadix( ) == 10 )  rdxFmt = FMT_DEC_64;
@@ -349,7 +361,7 @@ void SimWinProcState::drawGRegDataLine( int from, int to ) {
 
     for ( int i = from; i <= to; i++ ) {
 
-        T64Word dataVal = cpu -> getGeneralReg( i );
+        T64Word dataVal = view.gRegs[ i ];
 
         if ( dataVal != lastGRegState[ i ] ) {
 
@@ -373,7 +385,6 @@ void SimWinProcState::drawGRegDataLine( int from, int to ) {
 void SimWinProcState::drawCRegDataLine( int from, int to ) {
 
     uint32_t fmtDesc        = FMT_DEFAULT | FMT_ALIGN_LFT;
-    T64Cpu   *cpu           = proc -> getCpuPtr( );
     uint32_t rdxFmt         = FMT_DEFAULT;
 
     if      ( getRadix( ) == 10 )  rdxFmt = FMT_DEC_64;
@@ -384,7 +395,7 @@ void SimWinProcState::drawCRegDataLine( int from, int to ) {
 
     for ( int i = from; i <= to; i++ ) {
 
-        T64Word dataVal = cpu -> getControlReg( i );
+        T64Word dataVal = view.cRegs[ i ];
 
         if ( dataVal != lastCRegState[ i ] ) {
 
@@ -474,7 +485,7 @@ int SimWinProcState::drawCRegSubWindow( int linePos ) {
 int SimWinProcState::drawCodeSubWindow( int linePos, int linesLeft ) {
 
     uint32_t    fmtDesc     = FMT_DEFAULT;
-    T64Word     currentIa   = proc -> getCpuPtr( ) -> getPsrReg( );
+    T64Word     currentIa   = view.psr;
     T64Word     windowSize  = linesLeft * 4;
     T64Word     windowEnd   = codeWinBaseAdr + windowSize;
     uint32_t    instr       = 0x0;
@@ -540,6 +551,12 @@ int SimWinProcState::drawCodeSubWindow( int linePos, int linesLeft ) {
             printTextField( instrBuf, fmtDesc, (int) strlen( instrBuf ));
             setWinCursor( 0, pos + opCodeField + operandField );
 
+            if ( disAsm -> formatTarget( instrBuf, sizeof( instrBuf ), instr, ia ) > 0 ) {
+
+                printTextField((char *) "; ", fmtDesc );
+                printTextField( instrBuf, fmtDesc, (int) strlen( instrBuf ));
+            }
+
             padLine( fmtDesc );
         }
         else {
@@ -622,7 +639,7 @@ SimWinTlb::SimWinTlb( SimGlobals    *glb,
 void SimWinTlb::setDefaults( ) {
     
     setWinType( WT_TLB_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_H_RDX_DEFAULT ));
 
     setWinToggleLimit( 1 );
     setWinLimitsForToggle( 0, 8, tlb -> getTlbSize( ) + 1, 96, 96 );
@@ -694,13 +711,13 @@ void SimWinTlb::drawTlbEntry( T64TlbEntry *ePtr ) {
 void SimWinTlb::drawLine( T64Word index ) {
 
     uint32_t    fmtDesc     = FMT_DEFAULT;
-    T64TlbEntry *ePtr       = tlb -> getTlbEntry( index );
+    T64TlbEntry entry;
 
     printTextField((char *) "(", fmtDesc );
     printNumericField( index, fmtDesc | FMT_HEX_4 );
     printTextField((char *) "): ", fmtDesc );
 
-    if ( ePtr != nullptr ) drawTlbEntry( ePtr );
+    if ( tlb -> readTlbEntry( index, &entry )) drawTlbEntry( &entry );
     padLine( fmtDesc );
 }
 
@@ -719,6 +736,8 @@ SimWinMem::SimWinMem( SimGlobals *glb, T64Word adr ) : SimWinScrollable( glb ) {
 
     this -> disAsm              = new T64DisAssemble( );
     this -> adr                 = rounddown( adr, 8 );
+
+    disAsm -> setSymTab( glb -> symTab );
     this -> lastWinItemAdr      = 0;
     this -> lastWinRows         = 0;
     this -> lastWinToggleVal    = 0;
@@ -738,7 +757,7 @@ SimWinMem::SimWinMem( SimGlobals *glb, T64Word adr ) : SimWinScrollable( glb ) {
 void SimWinMem::setDefaults( ) {
     
     setWinType( WT_MEM_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_H_RDX_DEFAULT ));
 
     setWinToggleLimit( 5 );
     setWinLimitsForToggle( 0, 5, MAX_WIN_ROW_SIZE, 124, 124 );
@@ -1030,6 +1049,12 @@ void SimWinMem::drawMemDataLineCode( T64Word itemAdr ) {
     printTextField( buf, fmtDesc, (int) strlen( buf ));
     setWinCursor( 0, pos + opCodeField + operandField );
 
+    if ( disAsm -> formatTarget( buf, sizeof( buf ), instr, itemAdr ) > 0 ) {
+
+        printTextField((char *) "; ", fmtDesc );
+        printTextField( buf, fmtDesc, (int) strlen( buf ));
+    }
+
     padLine( fmtDesc );
 }
 
@@ -1095,7 +1120,7 @@ SimWinText:: ~SimWinText( ) {
 //----------------------------------------------------------------------------------------
 void SimWinText::setDefaults( ) {
 
-    int txWidth = glb -> env -> getEnvVarInt((char *) ENV_WIN_TEXT_LINE_WIDTH );
+    int txWidth = glb -> env -> getEnvVarInt( ENV_H_WIN_TEXT_LINE_WIDTH );
     
     setWinType( WT_TEXT_WIN );
     
@@ -1154,7 +1179,7 @@ void SimWinText::drawBanner( ) {
 void SimWinText::drawLine( T64Word index ) {
     
     uint32_t    fmtDesc = FMT_DEFAULT;
-    int         tabSize = glb -> env -> getEnvVarInt((char *) ENV_WIN_TEXT_TAB_SIZE );
+    int         tabSize = glb -> env -> getEnvVarInt( ENV_H_WIN_TEXT_TAB_SIZE );
     char        lineBuf[ MAX_TEXT_LINE_SIZE ];
     int         lineSize = 0;
 
@@ -1276,7 +1301,7 @@ SimWinConsole::SimWinConsole( SimGlobals *glb ) : SimWin( glb ) {
 void SimWinConsole::setDefaults( ) {
     
     setWinType( WT_CONSOLE_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_H_RDX_DEFAULT ));
 
     setWinToggleLimit( 1 );
     setWinLimitsForToggle( 0, 24, MAX_WIN_ROW_SIZE, 112, 112 );
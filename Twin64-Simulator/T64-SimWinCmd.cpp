@@ -32,6 +32,8 @@
 #include "T64-SimDeclarations.h"
 #include "T64-SimTables.h"
 
+#include <algorithm>
+
 //----------------------------------------------------------------------------------------
 // Local name space. We try to keep utility functions local to the file.
 //
@@ -296,6 +298,50 @@ bool readMem( T64System *sys, T64Word adr, uint8_t *val, size_t size ) {
     return ( false );
 }
 
+//----------------------------------------------------------------------------------------
+// "lookupProc" returns the processor module for a module number or a nullptr if 
+// there is no processor module with this number.
+//
+//----------------------------------------------------------------------------------------
+T64Processor *lookupProc( T64System *sys, int modNum ) {
+
+    T64Module *m = sys -> lookupByModNum( modNum );
+
+    if (( m == nullptr ) || ( m -> getModuleType( ) != MT_PROC )) return ( nullptr );
+    return ((T64Processor *) m );
+}
+
+//----------------------------------------------------------------------------------------
+// "lookupBreakTable" returns the break table of a processor module. The break
+// commands change the table, the processor must not be running.
+//
+//----------------------------------------------------------------------------------------
+T64BreakTable *lookupBreakTable( T64System *sys, int modNum ) {
+
+    T64Processor *proc = lookupProc( sys, modNum );
+
+    if ( proc == nullptr ) throw( ERR_EXPCTED_PROC_MODULE );
+    if ( proc -> getModuleState( ) == T64_MOD_STATE_EXECUTE ) throw( ERR_MODULE_IS_RUNNING );
+
+    return( proc -> getBreakTablePtr( ));
+}
+
+//----------------------------------------------------------------------------------------
+// The break entry kind names for the list command.
+//
+//----------------------------------------------------------------------------------------
+const char *breakKindStr( T64BreakKind kind ) {
+
+    switch ( kind ) {
+
+        case T64_BK_INSTR:  return( "INSTR" );
+        case T64_BK_READ:   return( "READ" );
+        case T64_BK_WRITE:  return( "WRITE" );
+        case T64_BK_ACCESS: return( "ACCESS" );
+        default:            return( "NIL" );
+    }
+}
+
 }; // namespace
 
 
@@ -417,6 +463,8 @@ SimCommandsWin::SimCommandsWin( SimGlobals *glb ) : SimWin( glb ) {
     disAsm      = new T64DisAssemble( );
     inlineAsm   = new T64Assemble( );
 
+    disAsm -> setSymTab( glb -> symTab );
+
     setDefaults( );
 }
 
@@ -428,7 +476,7 @@ SimCommandsWin::SimCommandsWin( SimGlobals *glb ) : SimWin( glb ) {
 void SimCommandsWin::setDefaults( ) {
     
     setWinType( WT_CMD_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_H_RDX_DEFAULT ));
 
     setWinToggleLimit( 1 );
     setWinLimitsForToggle( 0, 10, MAX_WIN_ROW_SIZE, 104, MAX_WIN_COL_SIZE );
@@ -508,6 +556,47 @@ void SimCommandsWin::clearCmdWin( ) {
     winOut -> initBuffer( );
 }
 
+//----------------------------------------------------------------------------------------
+// "refreshWhileRunning" keeps the windows current while the processors run and 
+// we wait for the next input character. Each time nothing was typed within the
+// refresh interval, the windows are drawn again and the command line input so
+// far is shown again with the cursor where it was. The windows show the state
+// the processors published and read memory without disturbing the caches, so
+// a refresh does not slow down or change the run. When the processors stop, 
+// the windows are drawn one more time for the final state. A refresh interval
+// of zero turns off the refresh.
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::refreshWhileRunning( char    *cmdBuf, 
+                                          char    *promptBuf, 
+                                          int     promptBufLen, 
+                                          int     cmdBufCursor ) {
+
+    if (( ! glb -> winDisplay -> isWindowsOn( )) || ( ! glb -> console -> isConsole( ))) return;
+
+    int     refreshMs   = (int) glb -> env -> getEnvVarInt( ENV_H_WIN_REFRESH_MS );
+    bool    redrawn     = false;
+
+    if ( refreshMs <= 0 ) return;
+
+    while ( true ) {
+
+        bool running = glb -> system -> isRunning( );
+
+        if (( ! running ) && ( ! redrawn )) return;
+        if (( running ) && ( glb -> console -> waitForInput( refreshMs ))) return;
+
+        glb -> winDisplay -> reDraw( );
+
+        glb -> console -> writeChars( "\r %s%s", promptBuf, cmdBuf );
+        glb -> console -> clearToEndOfLine( ); 
+        setWinCursor( 0, 1 + promptBufLen + cmdBufCursor );
+
+        if ( ! running ) return;
+        redrawn = true;
+    }
+}
+
 //----------------------------------------------------------------------------------------
 // "readCmdLine" is used by the command line interpreter to get the command. 
 // Since we run in raw mode, the basic handling of backspace, carriage return, 
@@ -583,6 +672,11 @@ int SimCommandsWin::readCmdLine( char *cmdBuf, int initialCmdBufLen, char *promp
     
     while ( true ) {
         
+        if ( state == CT_NORMAL ) {
+            
+            refreshWhileRunning( cmdBuf, promptBuf, promptBufLen, cmdBufCursor );
+        }
+
         ch = glb -> console -> readChar( );
         
         switch ( state ) {
@@ -929,7 +1023,7 @@ void SimCommandsWin::printStackInfoField( uint32_t fmtDesc, int row, int col ) {
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::printWelcome( ) {
     
-    glb -> env -> setEnvVar((char *) ENV_EXIT_CODE, (T64Word) 0 );
+    glb -> env -> setEnvVar( ENV_H_EXIT_CODE, (T64Word) 0 );
     
     if ( glb -> console -> isConsole( )) {
         
@@ -961,11 +1055,11 @@ void SimCommandsWin::printWelcome( ) {
 //----------------------------------------------------------------------------------------
 int SimCommandsWin::buildCmdPrompt( char *promptStr, int promptStrLen ) {
     
-    if ( glb -> env -> getEnvVarBool((char *) ENV_SHOW_CMD_CNT )) {
+    if ( glb -> env -> getEnvVarBool( ENV_H_SHOW_CMD_CNT )) {
             
         return ( snprintf( promptStr, promptStrLen,
                            "(%i) ->",
-                           (int) glb -> env -> getEnvVarInt((char *) ENV_CMD_CNT )));
+                           (int) glb -> env -> getEnvVarInt( ENV_H_CMD_CNT )));
         }
     else return ( snprintf( promptStr, promptStrLen, "->" ));
 }
@@ -976,24 +1070,138 @@ int SimCommandsWin::buildCmdPrompt( char *promptStr, int promptStrLen ) {
 // pairs to get all module type info. Omitted key/value pairs are set to reasonable
 // defaults.
 //
-//  NMOD PROC, <modNum>
+//  NMOD PROC, <modNum> [ , PREDECODE ] [ , DIRECT_MEM ] [ , BLOCKS ] 
+//             [ , VERIFY ] [ , TIMING ] [ , <tlbType> ] [ , <cacheType> ]
 //
-// Processors are threads, so we need to start them after creating them. The 
-// "startModule" method will create a thread for the processor and start it. 
+// The PREDECODE option lets the processor execute from the predecoded 
+// instruction cache. The BLOCKS option executes the predecoded instructions a
+// basic block at a time and implies PREDECODE. On an x86-64 host, frequently
+// executed blocks also run as translated host code. VERIFY checks each block
+// instruction against the regular fetch and decode and each translated block
+// run against the instruction handlers. TIMING turns on the cycle estimate, 
+// readable in control register 3. The DIRECT_MEM option lets the processor 
+// access RAM directly instead of using bus operations. The TLB type selects a
+// set associative local TLB instead of the small fully associative one. The 
+// cache type, such as CACHE_4W_128S_4L, gives the processor an instruction and
+// a data cache. With caches in the system, DIRECT_MEM has no effect. Processors
+// are threads, so we need to start them after creating them. The "startModule"
+// method will create a thread for the processor and start it. 
 //
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::addProcModule( int modNum ) {
 
+    T64Options   options    = T64_PO_NIL;
     T64TlbType   tlbType    = T64_TT_FA_4U;  
     T64CacheType cacheType  = T64_CT_NIL;
 
+    while ( tok -> isToken( TOK_COMMA )) {
+
+        tok -> nextToken( );
+
+        switch ( tok -> tokId( )) {
+
+            case TOK_PROC_PREDECODE: {
+
+                options = (T64Options) ( options | T64_PO_PREDECODE );
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_PROC_DIRECT_MEM: {
+
+                options = (T64Options) ( options | T64_PO_DIRECT_MEM );
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_PROC_BLOCKS: {
+
+                options = (T64Options) ( options | T64_PO_PREDECODE | T64_PO_BLOCKS );
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_PROC_VERIFY: {
+
+                options = (T64Options) ( options | T64_PO_VERIFY );
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_PROC_TIMING: {
+
+                options = (T64Options) ( options | T64_PO_TIMING );
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_TLB_SA_64U: {
+
+                tlbType = T64_TT_SA_64U;
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_TLB_SA_256U: {
+
+                tlbType = T64_TT_SA_256U;
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_CACHE_2W_128S_4L: {
+
+                cacheType = T64_CT_2W_128S_4L;
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_CACHE_4W_128S_4L: {
+
+                cacheType = T64_CT_4W_128S_4L;
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_CACHE_8W_128S_4L: {
+
+                cacheType = T64_CT_8W_128S_4L;
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_CACHE_2W_64S_8L: {
+
+                cacheType = T64_CT_2W_64S_8L;
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_CACHE_4W_64S_8L: {
+
+                cacheType = T64_CT_4W_64S_8L;
+                tok -> nextToken( );
+
+            } break;
+
+            case TOK_CACHE_8W_64S_8L: {
+
+                cacheType = T64_CT_8W_64S_8L;
+                tok -> nextToken( );
+
+            } break;
+
+            default: throw( ERR_INVALID_ARG );
+        }
+    }
+
     tok -> checkEOS( );
 
     if ( modNum == -1 ) throw( SimErrMsgId( ERR_EXPECTED_MOD_NUM ));
 
     T64Processor *p = new T64Processor( glb -> system,
                                         modNum,
-                                        T64_PO_NIL,
+                                        options,
                                         T64_CPU_T_NIL,
                                         tlbType,
                                         cacheType );
@@ -1066,7 +1274,7 @@ void SimCommandsWin::addMemModule( int modNum ) {
                 if ( tok -> tokTyp( ) == TYP_NUM ) {
 
                     spaLen = eval -> acceptNumExpr( ERR_INVALID_ARG, 
-                                                    0, UINT32_MAX );
+                                                    0, T64_MAX_PHYS_MEM_LIMIT );
                 }
                 else throw( ERR_INVALID_ARG );
 
@@ -1117,6 +1325,12 @@ void SimCommandsWin::addTlbModule( int modNum ) {
             tlbType = T64_TT_FA_64S;
         else if ( tok -> isToken( TOK_TLB_FA_128S )) 
             tlbType = T64_TT_FA_128S;
+        else if ( tok -> isToken( TOK_TLB_SA_256S )) 
+            tlbType = T64_TT_SA_256S;
+        else if ( tok -> isToken( TOK_TLB_SA_1024S )) 
+            tlbType = T64_TT_SA_1024S;
+        else if ( tok -> isToken( TOK_TLB_SA_4096S )) 
+            tlbType = T64_TT_SA_4096S;
         else throw( ERR_INVALID_ARG );
 
         tok -> nextToken( );
@@ -1205,7 +1419,8 @@ void  SimCommandsWin::displayMemContent( T64Word ofs, T64Word len, SimTokId fmtO
 
 //----------------------------------------------------------------------------------------
 // Display absolute memory content as code shown in assembler syntax. There is 
-// one word per line.
+// one word per line. An address with a symbol starts with a label line, branch
+// targets with a symbol are shown after the instruction.
 //
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::displayMemContentAsCode( T64Word adr, T64Word len ) {
@@ -1213,17 +1428,27 @@ void SimCommandsWin::displayMemContentAsCode( T64Word adr, T64Word len ) {
     T64Word  index  = rounddown( adr, 4 );
     T64Word  limit  = roundup(( index + len ), 4 );
     uint32_t instr  = 0;
+    T64Word  ofs    = 0;
     char     buf[ MAX_TEXT_FIELD_LEN ];
+    char     sym[ MAX_TEXT_FIELD_LEN ];
 
     while ( index < limit ) {
 
+        const char *label = glb -> symTab -> lookup( index, &ofs );
+        if (( label != nullptr ) && ( ofs == 0 )) winOut -> writeChars( "%s:\n", label );
+
         winOut -> printNumber( index, FMT_HEX_2_4_4 );
         winOut -> writeChars( ": " );
 
         if ( readMem( glb -> system, index, (uint8_t *) &instr, sizeof( instr )) ) {
 
             disAsm -> formatInstr( buf, sizeof( buf ), instr, 16 );
-            winOut -> writeChars( "%s\n", buf ); 
+
+            if ( disAsm -> formatTarget( sym, sizeof( sym ), instr, index ) > 0 ) {
+
+                winOut -> writeChars( "%s ; %s\n", buf, sym );
+            } 
+            else winOut -> writeChars( "%s\n", buf ); 
         }
         else winOut -> writeChars( "******\n" );
 
@@ -1338,7 +1563,7 @@ void SimCommandsWin::execCmdsFromFile( char* fileName ) {
 
             if ( continuation ) continue;
 
-            if ( glb -> env -> getEnvVarBool((char*) ENV_ECHO_CMD_INPUT )) {
+            if ( glb -> env -> getEnvVarBool( ENV_H_ECHO_CMD_INPUT )) {
 
                 winOut -> writeChars( "%s\n", cmdLineBuf );
             }
@@ -1435,12 +1660,15 @@ void SimCommandsWin::echoCmd( char *cmdBuf ) {
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::exitCmd( ) {
 
-    glb -> console -> clearScrollArea( );
-    glb -> console -> clearScreen( );
+    if ( ! glb -> batchFlag ) {
+
+        glb -> console -> clearScrollArea( );
+        glb -> console -> clearScreen( );
+    }
     
     if ( tok -> isToken( TOK_EOS )) {
         
-        int exitVal = glb -> env -> getEnvVarInt((char *) ENV_EXIT_CODE );
+        int exitVal = glb -> env -> getEnvVarInt( ENV_H_EXIT_CODE );
         exit(( exitVal > 255 ) ? 255 : exitVal );
     }
     else {
@@ -1805,12 +2033,415 @@ void SimCommandsWin::stepCmd( ) {
 
     if ( m -> getModuleType( ) != MT_PROC ) throw( ERR_EXPCTED_PROC_MODULE );
 
-    bool haltOnTrap = glb -> env -> getEnvVarBool((char *) ENV_HALT_ON_TRAPS );
+    bool haltOnTrap = glb -> env -> getEnvVarBool( ENV_H_HALT_ON_TRAPS );
 
     tok -> checkEOS( );
     glb -> system -> execModule( modNum, numOfSteps, haltOnTrap );
 }
 
+//----------------------------------------------------------------------------------------
+// Trace command. With a file name, the processor execution is traced to that 
+// file, replacing any trace in progress. Without a file name, the trace in 
+// progress is closed. The processor must not be running. The trace file is 
+// decoded with the Twin64-TraceDump program.
+//
+//  TRACE <modNum> [ "," <filePath> ]
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::traceCmd( ) {
+
+    char fileName[ MAX_FILE_PATH_SIZE ] = { 0 };
+
+    int modNum = eval -> acceptNumExpr( ERR_EXPECTED_MOD_NUM, 
+                                        0, T64_IO_MAX_MODULES - 1 );
+
+    if ( tok -> isToken( TOK_COMMA )) {
+
+        tok -> nextToken( );
+
+        if ( tok -> tokTyp( ) != TYP_STR ) throw( ERR_EXPECTED_FILE_NAME );
+        strncpy( fileName, tok -> tokStr( ), sizeof( fileName ) - 1 );
+        tok -> nextToken( );
+    }
+
+    tok -> checkEOS( );
+
+    T64Module *m = glb -> system -> lookupByModNum( modNum );
+    if (( m == nullptr ) || ( m -> getModuleType( ) != MT_PROC )) {
+
+        throw( ERR_EXPCTED_PROC_MODULE );
+    }
+
+    T64Processor *proc   = (T64Processor *) m;
+    T64Tracer    *tracer = proc -> getTracer( );
+
+    if ( proc -> getModuleState( ) == T64_MOD_STATE_EXECUTE ) throw( ERR_MODULE_IS_RUNNING );
+
+    if ( tracer != nullptr ) {
+
+        proc -> setTracer( nullptr );
+        delete tracer;
+    }
+
+    if ( fileName[ 0 ] != 0 ) {
+
+        tracer = new T64Tracer( modNum );
+
+        if ( ! tracer -> open( fileName )) {
+
+            delete tracer; 
+            throw( ERR_OPEN_TRACE_FILE );
+        }
+
+        proc -> setTracer( tracer );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Profile command. "ON" attaches a new profiler to the processor, the optional
+// sample rate sets how often an instruction address is entered into the hot
+// spot histogram. "OFF" removes the profiler. Otherwise, the profile report is 
+// printed: the instruction count, the opcode mix, the trap counts and the top
+// hot spots with their disassembled instruction. The processor must not be 
+// running.
+//
+//  PROF <modNum> [ "," ON [ "," <rate> ] | "," OFF | "," <topN> ]
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::profileCmd( ) {
+
+    const int MAX_HOT_SPOTS = 64;
+
+    int  modNum     = eval -> acceptNumExpr( ERR_EXPECTED_MOD_NUM, 
+                                             0, T64_IO_MAX_MODULES - 1 );
+    int  topN       = 10;
+    int  rate       = 1;
+    bool profOn     = false;
+    bool profOff    = false;
+
+    if ( tok -> isToken( TOK_COMMA )) {
+
+        tok -> nextToken( );
+
+        if ( tok -> isToken( TOK_ON )) {
+
+            tok -> nextToken( );
+            profOn = true;
+
+            if ( tok -> isToken( TOK_COMMA )) {
+
+                tok -> nextToken( );
+                rate = eval -> acceptNumExpr( ERR_INVALID_NUM, 1, INT32_MAX );
+            }
+        }
+        else if ( tok -> isToken( TOK_OFF )) {
+
+            tok -> nextToken( );
+            profOff = true;
+        }
+        else topN = eval -> acceptNumExpr( ERR_INVALID_NUM, 1, MAX_HOT_SPOTS );
+    }
+
+    tok -> checkEOS( );
+
+    T64Module *m = glb -> system -> lookupByModNum( modNum );
+    if (( m == nullptr ) || ( m -> getModuleType( ) != MT_PROC )) {
+
+        throw( ERR_EXPCTED_PROC_MODULE );
+    }
+
+    T64Processor *proc = (T64Processor *) m;
+    T64Profiler  *prof = proc -> getProfiler( );
+
+    if ( proc -> getModuleState( ) == T64_MOD_STATE_EXECUTE ) throw( ERR_MODULE_IS_RUNNING );
+
+    if (( profOn ) || ( profOff )) {
+
+        proc -> setProfiler( nullptr );
+        delete prof;
+
+        if ( profOn ) proc -> setProfiler( new T64Profiler( rate ));
+        return;  
+    }
+
+    if ( prof == nullptr ) {
+
+        winOut -> writeChars( "No profile\n" );
+        return;
+    }
+
+    T64DisAssemble  disAsm;
+    char            buf[ MAX_TEXT_LINE_SIZE ];
+    char            sym[ MAX_TEXT_LINE_SIZE ];
+    T64Word         instrs  = prof -> getInstrs( );
+    T64Word         samples = prof -> getSamples( );
+    double          iDiv    = ( instrs > 0 ) ? (double) instrs : 1.0;
+    double          sDiv    = ( samples > 0 ) ? (double) samples : 1.0;
+    int             order[ T64_PROF_OPCODES ];
+
+    winOut -> writeChars( "Instructions: %" PRId64 ", samples: %" PRId64 ", rate: %d\n", 
+                          (int64_t) instrs, (int64_t) samples, prof -> getSampleRate( ));
+
+    for ( int i = 0; i < T64_PROF_OPCODES; i++ ) order[ i ] = i;
+
+    std::sort( order, order + T64_PROF_OPCODES, [ prof ]( int a, int b ) {
+
+        return( prof -> getOpCodeCount( a ) > prof -> getOpCodeCount( b ));
+    });
+
+    winOut -> writeChars( "\nOpcode mix:\n" );
+
+    for ( int i = 0; i < T64_PROF_OPCODES; i++ ) {
+
+        T64Word cnt = prof -> getOpCodeCount( order[ i ] );
+        if ( cnt == 0 ) break;
+
+        disAsm.formatOpCode( buf, sizeof( buf ), prof -> getOpCodeInstr( order[ i ] ));
+        winOut -> writeChars( "  %-12s %14" PRId64 "  %6.2f%%\n", 
+                              buf, (int64_t) cnt, cnt * 100.0 / iDiv );
+    }
+
+    winOut -> writeChars( "\nTraps:\n" );
+
+    for ( int i = 0; i < T64_PROF_TRAP_CODES; i++ ) {
+
+        T64Word cnt = prof -> getTrapCount( i );
+        if ( cnt > 0 ) winOut -> writeChars( "  %-12d %14" PRId64 "\n", i, (int64_t) cnt );
+    }
+
+    T64HotSpot  spots[ MAX_HOT_SPOTS ];
+    int         n = prof -> getHotSpots( spots, topN );
+
+    winOut -> writeChars( "\nHot spots:\n" );
+
+    for ( int i = 0; i < n; i++ ) {
+
+        winOut -> writeChars( "  " );
+        winOut -> printNumber( spots[ i ].vAdr, FMT_PREFIX_0X | FMT_HEX_2_4_4 );
+        
+        disAsm.formatInstr( buf, sizeof( buf ), spots[ i ].instr, 16 );
+        glb -> symTab -> formatAdr( sym, sizeof( sym ), spots[ i ].vAdr );
+        winOut -> writeChars( "  %12" PRId64 "  %6.2f%%  %-32s %s\n", 
+                              (int64_t) spots[ i ].count, 
+                              spots[ i ].count * 100.0 / sDiv, 
+                              buf, sym );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Snapshot command. The state of all modules is saved to the snapshot directory,
+// which is created when needed. With the "INCR" option, only the memory pages 
+// modified since the last snapshot taken or restored are saved. Such a snapshot
+// refers to the previous one, which needs to be kept. The system must not be 
+// running.
+//
+//  SNAP <dirPath> [ "," INCR ]
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::snapCmd( ) {
+
+    char dirName[ MAX_FILE_PATH_SIZE ] = { 0 };
+    bool incremental                   = false;
+
+    if ( tok -> tokTyp( ) != TYP_STR ) throw( ERR_EXPECTED_FILE_NAME );
+    strncpy( dirName, tok -> tokStr( ), sizeof( dirName ) - 1 );
+    tok -> nextToken( );
+
+    if ( tok -> isToken( TOK_COMMA )) {
+
+        tok -> nextToken( );
+
+        if ( ! tok -> isToken( TOK_INCR )) throw( ERR_INVALID_ARG );
+        tok -> nextToken( );
+        incremental = true;
+    }
+
+    tok -> checkEOS( );
+
+    if ( ! glb -> system -> saveSnapshot( dirName, incremental )) throw( ERR_SAVE_SNAPSHOT );
+}
+
+//----------------------------------------------------------------------------------------
+// Restore command. The system state is restored from the snapshot directory. 
+// The system needs to be configured with the same modules as when the snapshot
+// was taken. A failed restore should be followed by a reset.
+//
+//  RESTORE <dirPath>
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::restoreCmd( ) {
+
+    char dirName[ MAX_FILE_PATH_SIZE ] = { 0 };
+
+    if ( tok -> tokTyp( ) != TYP_STR ) throw( ERR_EXPECTED_FILE_NAME );
+    strncpy( dirName, tok -> tokStr( ), sizeof( dirName ) - 1 );
+    tok -> nextToken( );
+    tok -> checkEOS( );
+
+    if ( ! glb -> system -> restoreSnapshot( dirName )) throw( ERR_RESTORE_SNAPSHOT );
+}
+
+//----------------------------------------------------------------------------------------
+// Break command. An instruction breakpoint stops the processor before the 
+// instruction at the address executes. The optional condition is compiled and
+// evaluated by the processor each time the address is reached.
+//
+//  BREAK <modNum> "," <adr> [ "," <cond> ]
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::breakCmd( ) {
+
+    T64BreakCond cond;
+
+    int modNum = eval -> acceptNumExpr( ERR_EXPECTED_MOD_NUM, 
+                                        0, T64_IO_MAX_MODULES - 1 );
+
+    tok -> acceptComma( );
+    T64Word adr = eval -> acceptNumExpr( ERR_EXPECTED_EXT_ADR );
+
+    if ( tok -> isToken( TOK_COMMA )) {
+
+        tok -> nextToken( );
+        eval -> compileCond( &cond );
+    }
+
+    tok -> checkEOS( );
+
+    T64BreakTable *bTab  = lookupBreakTable( glb -> system, modNum );
+    int           index  = bTab -> setBreak( T64_BK_INSTR, adr, 0, &cond );
+
+    if ( index < 0 ) throw( ERR_BREAK_TABLE_FULL );
+    winOut -> writeChars( "Break %d set\n", index );
+}
+
+//----------------------------------------------------------------------------------------
+// Watch command. A data watchpoint stops the processor after the instruction 
+// that accessed data in the address range. By default, writes are watched. The
+// optional condition is evaluated when an access matches.
+//
+//  WATCH <modNum> "," <adr> "," <len> [ "," READ | WRITE | ACCESS ] [ "," <cond> ]
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::watchCmd( ) {
+
+    T64BreakCond cond;
+    T64BreakKind kind = T64_BK_WRITE;
+
+    int modNum = eval -> acceptNumExpr( ERR_EXPECTED_MOD_NUM, 
+                                        0, T64_IO_MAX_MODULES - 1 );
+
+    tok -> acceptComma( );
+    T64Word adr = eval -> acceptNumExpr( ERR_EXPECTED_EXT_ADR );
+
+    tok -> acceptComma( );
+    T64Word len = eval -> acceptNumExpr( ERR_INVALID_NUM, 1, INT32_MAX );
+
+    if ( tok -> isToken( TOK_COMMA )) {
+
+        tok -> nextToken( );
+
+        if (( tok -> isToken( TOK_READ )) || 
+            ( tok -> isToken( TOK_WRITE )) || 
+            ( tok -> isToken( TOK_ACCESS ))) {
+
+            if      ( tok -> isToken( TOK_READ ))  kind = T64_BK_READ;
+            else if ( tok -> isToken( TOK_WRITE )) kind = T64_BK_WRITE;
+            else                                   kind = T64_BK_ACCESS;
+
+            tok -> nextToken( );
+
+            if ( tok -> isToken( TOK_COMMA )) {
+
+                tok -> nextToken( );
+                eval -> compileCond( &cond );
+            }
+        }
+        else eval -> compileCond( &cond );
+    }
+
+    tok -> checkEOS( );
+
+    T64BreakTable *bTab  = lookupBreakTable( glb -> system, modNum );
+    int           index  = bTab -> setBreak( kind, adr, len, &cond );
+
+    if ( index < 0 ) throw( ERR_BREAK_TABLE_FULL );
+    winOut -> writeChars( "Watch %d set\n", index );
+}
+
+//----------------------------------------------------------------------------------------
+// Break list command. We list the entries of the break table with their hit 
+// counts and the last hit.
+//
+//  BLIST <modNum>
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::breakListCmd( ) {
+
+    int modNum = eval -> acceptNumExpr( ERR_EXPECTED_MOD_NUM, 
+                                        0, T64_IO_MAX_MODULES - 1 );
+    tok -> checkEOS( );
+
+    T64BreakTable   *bTab   = lookupBreakTable( glb -> system, modNum );
+    T64BreakHit     hit;
+    int             count   = 0;
+
+    for ( int i = 0; i < T64_MAX_BREAKS; i++ ) {
+
+        T64BreakEntry *e = bTab -> getBreak( i );
+        if ( e == nullptr ) continue;
+
+        winOut -> writeChars( "%2d  %-6s  0x%016llx  len: %-6lld  hits: %lld%s\n", 
+                              i, 
+                              breakKindStr( e -> kind ),
+                              (long long) e -> adr,
+                              (long long) e -> len,
+                              (long long) e -> hits,
+                              ( e -> cond.len > 0 ) ? "  (cond)" : "" );
+        count ++;
+    }
+
+    if ( count == 0 ) winOut -> writeChars( "No breaks\n" );
+
+    if ( bTab -> getLastHit( &hit )) {
+
+        winOut -> writeChars( "Last hit: %d at 0x%016llx, data: 0x%016llx\n", 
+                              hit.index,
+                              (long long) hit.instrAdr,
+                              (long long) hit.dataAdr );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Break delete command. We remove one entry or all entries of the break table.
+//
+//  BDEL <modNum> "," ( <index> | ALL )
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::breakDeleteCmd( ) {
+
+    int modNum = eval -> acceptNumExpr( ERR_EXPECTED_MOD_NUM, 
+                                        0, T64_IO_MAX_MODULES - 1 );
+    tok -> acceptComma( );
+
+    if ( tok -> isToken( TOK_ALL )) {
+
+        tok -> nextToken( );
+        tok -> checkEOS( );
+
+        lookupBreakTable( glb -> system, modNum ) -> removeAll( );
+    }
+    else {
+
+        int index = eval -> acceptNumExpr( ERR_INVALID_NUM, 0, T64_MAX_BREAKS - 1 );
+        tok -> checkEOS( );
+
+        if ( ! lookupBreakTable( glb -> system, modNum ) -> removeBreak( index )) {
+
+            throw( ERR_BREAK_NOT_FOUND );
+        }
+    }
+}
+
 //----------------------------------------------------------------------------------------
 // Run command. The command will just run the system until a halt is detected.
 //
@@ -1860,7 +2491,7 @@ void SimCommandsWin::runCmd( ) {
 void SimCommandsWin::writeLineCmd( ) {
     
     SimExpr  rExpr = INIT_EXPR;
-    int      rdx   = glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT );
+    int      rdx   = glb -> env -> getEnvVarInt( ENV_H_RDX_DEFAULT );
     
     eval -> parseExpr( &rExpr );
     
@@ -2189,7 +2820,7 @@ void SimCommandsWin::writeLogCmd( ) {
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::displayMemCmd( ) {
     
-    int         rdx     = glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT );
+    int         rdx     = glb -> env -> getEnvVarInt( ENV_H_RDX_DEFAULT );
     SimTokId    fmtOpt  = ( rdx == 10 ) ? TOK_DEC : TOK_HEX;
     T64Word     ofs     = 0;
     T64Word     len     = sizeof( T64Word );
@@ -2574,7 +3205,7 @@ void SimCommandsWin::winEnableCmd( bool enable ) {
 void SimCommandsWin::winSetRadixCmd( ) {
 
    
-    int rdx     = glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT );
+    int rdx     = glb -> env -> getEnvVarInt( ENV_H_RDX_DEFAULT );
     int winNum  = -1;
    
     if ( tok -> isToken( TOK_EOS )) {
@@ -2584,7 +3215,7 @@ void SimCommandsWin::winSetRadixCmd( ) {
     }
     else if ( tok -> isToken( TOK_COMMA )) {
         
-        rdx = glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT );
+        rdx = glb -> env -> getEnvVarInt( ENV_H_RDX_DEFAULT );
         tok -> nextToken( );
 
         winNum = eval -> acceptNumExpr( ERR_EXPECTED_WIN_ID, 1, MAX_WINDOWS );
@@ -3063,7 +3694,7 @@ void SimCommandsWin::evalInputLine( char *cmdBuf ) {
                     
                     hist -> addCmdLine( cmdBuf );
                     glb -> env -> 
-                        setEnvVar((char *) ENV_CMD_CNT, (T64Word) hist -> getCmdNum( ));
+                        setEnvVar( ENV_H_CMD_CNT, (T64Word) hist -> getCmdNum( ));
                 }
                 
                 switch( currentCmd ) {
@@ -3090,6 +3721,14 @@ void SimCommandsWin::evalInputLine( char *cmdBuf ) {
                     case CMD_HALT:          haltCmd( );                     break;
                     case CMD_RUN:           runCmd( );                      break;
                     case CMD_STEP:          stepCmd( );                     break;
+                    case CMD_TRACE:         traceCmd( );                    break;
+                    case CMD_PROF:          profileCmd( );                  break;
+                    case CMD_SNAP:          snapCmd( );                     break;
+                    case CMD_RESTORE:       restoreCmd( );                  break;
+                    case CMD_BREAK:         breakCmd( );                    break;
+                    case CMD_WATCH:         watchCmd( );                    break;
+                    case CMD_BLIST:         breakListCmd( );                break;
+                    case CMD_BDEL:          breakDeleteCmd( );              break;
 
                     case CMD_NMOD:          addModuleCmd( );                break;
                     case CMD_RMOD:          removeModuleCmd( );             break;
@@ -3140,7 +3779,7 @@ void SimCommandsWin::evalInputLine( char *cmdBuf ) {
             else {
             
                 hist -> addCmdLine( cmdBuf );
-                glb -> env -> setEnvVar((char *) ENV_CMD_CNT, 
+                glb -> env -> setEnvVar( ENV_H_CMD_CNT, 
                                         (T64Word) hist -> getCmdNum( ));
                 throw ( ERR_INVALID_CMD );
             }
@@ -3149,7 +3788,7 @@ void SimCommandsWin::evalInputLine( char *cmdBuf ) {
     
     catch ( SimErrMsgId errNum ) {
         
-        glb -> env -> setEnvVar((char *) ENV_EXIT_CODE, (T64Word) -1 );
+        glb -> env -> setEnvVar( ENV_H_EXIT_CODE, (T64Word) -1 );
         cmdLineError( errNum );
     }
 }
@@ -3193,4 +3832,109 @@ void SimCommandsWin::cmdInterpreterLoop( ) {
         if ( cmdLen > 0 ) evalInputLine( cmdLineBuf );
         glb -> winDisplay -> reDraw( );
     }
+}
+
+//----------------------------------------------------------------------------------------
+// "cmdBatchRun" is the batch mode counterpart to the command loop. There is no
+// screen handling, all output goes directly to stdout. We process the config
+// file, load the ELF file if one is specified and set the processors to its 
+// entry address. All processors are then started and run until they halt, trap
+// or reach the instruction limit, and the processor registers are listed. The
+// result is the program exit code. It is zero when all processors stopped 
+// without a trap, one for a command error and two for a processor trap.
+//
+//----------------------------------------------------------------------------------------
+int SimCommandsWin::cmdBatchRun( ) {
+
+    T64System   *sys        = glb -> system;
+    int         exitCode    = 0;
+
+    winOut -> setDirectOutput( true );
+    glb -> env -> setEnvVar( ENV_H_EXIT_CODE, (T64Word) 0 );
+
+    try {
+
+        configureT64Sim( );
+        configureT64Log( );
+    }
+    catch ( SimErrMsgId errNum ) {
+
+        cmdLineError( errNum );
+        return( 1 );
+    }
+
+    if ( strlen( glb -> elfFileName ) > 0 ) {
+
+        try {
+
+            T64Word entry = loadElfFile( glb -> elfFileName );
+
+            for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+                T64Processor *proc = lookupProc( sys, i );
+                if ( proc == nullptr ) continue;
+
+                T64Cpu *cpu = proc -> getCpuPtr( );
+                cpu -> setPsrReg( depositField64( cpu -> getPsrReg( ), 0, 52, entry ));
+            }
+        }
+        catch ( SimErrMsgId errNum ) {
+
+            cmdLineError( errNum );
+            return( 1 );
+        }
+        catch ( ... ) {
+
+            return( 1 );
+        }
+    }
+
+    if ( glb -> env -> getEnvVarInt( ENV_H_EXIT_CODE ) != 0 ) return( 1 );
+
+    for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+        T64Processor *proc = lookupProc( sys, i );
+        if ( proc == nullptr ) continue;
+
+        if ( glb -> batchSteps > 0 ) {
+            
+            proc -> execModule( glb -> batchSteps, true );
+        }
+        else {
+
+            proc -> setEnterSimOnTrap( true );
+            proc -> runModule( );
+        }
+    }
+
+    for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+        T64Processor *proc = lookupProc( sys, i );
+        if ( proc == nullptr ) continue;
+
+        T64TrapCode trapCode = proc -> waitUntilStopped( );
+        T64Cpu      *cpu     = proc -> getCpuPtr( );
+
+        winOut -> writeChars( "PROC %d: %s\n", i, proc -> getProcStateStr( ));
+        winOut -> writeChars( "PSR: 0x%016llx\n", (long long) cpu -> getPsrReg( ));
+
+        for ( int r = 0; r < T64_MAX_GREGS; r++ ) {
+
+            winOut -> writeChars( "R%-2d: 0x%016llx", 
+                                  r, (long long) cpu -> getGeneralReg( r ));
+            winOut -> writeChars((( r % 4 ) == 3 ) ? "\n" : "  " );
+        }
+
+        if ( trapCode != NO_TRAP ) {
+
+            winOut -> writeChars( "IPSR: 0x%016llx  IARG0: 0x%016llx  IARG1: 0x%016llx\n",
+                                  (long long) cpu -> getControlReg( CTL_REG_IPSR ),
+                                  (long long) cpu -> getControlReg( CTL_REG_IARG_0 ),
+                                  (long long) cpu -> getControlReg( CTL_REG_IARG_1 ));
+            exitCode = 2;
+        }
+    }
+
+    fflush( stdout );
+    return( exitCode );
 }
\ No newline at end of file
@@ -66,6 +66,16 @@ void SimWinDisplay::startWinDisplay( ) {
     cmdWin -> cmdInterpreterLoop( );
 }
 
+//----------------------------------------------------------------------------------------
+// Start the batch run. There is no screen and no command loop, the command 
+// window just runs the batch job and returns the program exit code.
+//
+//----------------------------------------------------------------------------------------
+int SimWinDisplay::startBatchRun( ) {
+
+    return( cmdWin -> cmdBatchRun( ));
+}
+
 SimTokId SimWinDisplay::getCurrentCmd( ) {
     
     return( cmdWin -> getCurrentCmd( ));
@@ -343,6 +353,9 @@ void SimWinDisplay::setWindowOrigins( int winStack, int rowOffset, int colOffset
 // chance to resize itself. However, the resetting of the terminal size is only
 // done after the next command input.
 //
+// The drawing is done into a screen frame of the console. Only the cells that 
+// changed since the last redraw are sent to the terminal, all in one write.
+//
 //----------------------------------------------------------------------------------------
 void SimWinDisplay::reDraw( ) {
     
@@ -352,7 +365,7 @@ void SimWinDisplay::reDraw( ) {
     int maxRowsNeeded                       = 0;
     int maxColumnsNeeded                    = 0;
     int stackColumnGap                      = 2;
-    int minRowSize = glb -> env -> getEnvVarInt((char *) ENV_WIN_MIN_ROWS );
+    int minRowSize = glb -> env -> getEnvVarInt( ENV_H_WIN_MIN_ROWS );
     
     if ( winModeOn ) {
        
@@ -428,6 +441,8 @@ void SimWinDisplay::reDraw( ) {
 
         winReFormatPending = true;
     }
+
+    glb -> console -> beginFrame( actualRows, actualCols );
    
     if ( winReFormatPending ) {
        
@@ -454,6 +469,7 @@ void SimWinDisplay::reDraw( ) {
     cmdWin -> setColumns( maxColumnsNeeded );
     cmdWin -> reDraw( );
     glb -> console -> setAbsCursor( maxRowsNeeded, 1 );
+    glb -> console -> endFrame( );
     winReFormatPending = false;
 }
 
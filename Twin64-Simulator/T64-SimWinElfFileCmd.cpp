@@ -75,31 +75,15 @@ bool elfioValidate( elfio *reader, char* msg, int msg_len ) {
     return error.empty( );
 }
 
-//----------------------------------------------------------------------------------------
-// Write a word to the simulator memory.
-//
-//----------------------------------------------------------------------------------------
-bool writeMem( T64System *sys, int32_t ofs, uint32_t val ) {
-
-    if ( ! sys -> busOpWrite( nullptr, ofs, (uint8_t *) &val, sizeof( uint32_t ))) {
-
-        throw( ERR_MEM_OP_FAILED );
-    }
-   
-    return( true );
-}
-
 //----------------------------------------------------------------------------------------
 // Load a segment into main memory. We are passed the segment and the CPU handle. 
 // Currently we only load physical memory. First we get the segment attributes 
-// and validate them for size, etc. Next we clear the physical memory in the size
-// of what it should be according to the segment data. Next, we copy the segment
-// data word by word up to the segment file size attribute. Note that a segment 
-// needs to have loadable data. Since our memory access is on a word basis, there
-// is one more thing. The data is correctly encoded in big endian format. However,
-// the coercion from that byte array to a word array will place the data in the 
-// host system order, in our case little endian. We need to swap each word
-// accordingly.
+// and validate them for size, etc. Next, we copy the segment data up to the 
+// segment file size attribute with one DMA write directly from the segment data
+// buffer. The remainder up to the segment memory size, i.e. the BSS part, is
+// cleared with one DMA fill. Note that a segment needs to have loadable data. 
+// The data is correctly encoded in big endian format and copied as is, memory 
+// holds the data in big endian format too.
 //
 //----------------------------------------------------------------------------------------
 void loadSegmentIntoMemory( elfio           *reader, 
@@ -113,7 +97,6 @@ void loadSegmentIntoMemory( elfio           *reader,
         Elf_Xword       fileSize    = segment -> get_file_size( );
         Elf_Xword       memorySize  = segment -> get_memory_size( );
         const char      *dataPtr    = segment -> get_data( );
-        const uint32_t  *wordPtr    = reinterpret_cast<const uint32_t*> ( dataPtr );
         Elf64_Addr      vAdr        = segment -> get_physical_address( );
         Elf_Xword       align       = segment -> get_align( );
         Elf_Word        flags       = segment -> get_flags( );
@@ -144,20 +127,21 @@ void loadSegmentIntoMemory( elfio           *reader,
             throw( ERR_ELF_MEMORY_SIZE_EXCEEDED );
         }
 
-        for ( Elf64_Addr i = 0; i < memorySize; i += 4  ) {
-            
-           if ( ! writeMem( sys, uint32_t( vAdr + i ), 0 )) {
+        if ( fileSize > memorySize ) fileSize = memorySize;
 
-                throw( ERR_MEM_OP_FAILED ); 
-           }
+        if (( fileSize > 0 ) && 
+            ( ! sys -> busOpDmaWrite( nullptr, 
+                                      vAdr, 
+                                      reinterpret_cast<const uint8_t *>( dataPtr ), 
+                                      fileSize ))) {
+
+            throw( ERR_MEM_OP_FAILED ); 
         }
-        
-        for ( Elf64_Addr i = 0; i < fileSize; i += 4  ) {
-            
-           if ( ! writeMem( sys, uint32_t( vAdr + i ), wordPtr[ i / 4 ] )) {
 
-                throw( ERR_MEM_OP_FAILED ); 
-           }
+        if (( memorySize > fileSize ) &&
+            ( ! sys -> busOpDmaFill( nullptr, vAdr + fileSize, 0, memorySize - fileSize ))) {
+
+            throw( ERR_MEM_OP_FAILED ); 
         }
     }
 }
@@ -167,14 +151,16 @@ void loadSegmentIntoMemory( elfio           *reader,
 
 //----------------------------------------------------------------------------------------
 // Loading a basic ELF file. This routine is rather simple. All we do is to locate 
-// the segments and load them into physical memory. Could be refined and do more 
-// checking one day.
+// the segments and load them into physical memory. The symbols of the file replace
+// the symbol table contents, they are taken from the reader we already have. 
+// Could be refined and do more checking one day.
 //
 //----------------------------------------------------------------------------------------
-void SimCommandsWin::loadElfFile( char *fileName ) {
+T64Word SimCommandsWin::loadElfFile( char *fileName ) {
     
-    elfio *reader = nullptr;
-    char  errMsgBuf[ 256 ];
+    elfio       *reader = nullptr;
+    char        errMsgBuf[ 256 ];
+    Elf64_Addr  entry   = 0;
     
     try {
         
@@ -198,9 +184,14 @@ void SimCommandsWin::loadElfFile( char *fileName ) {
                                     winOut );
         }
         
-        Elf64_Addr entry = reader -> get_entry( );
+        entry = reader -> get_entry( );
         
         winOut -> writeChars( "Set entry: 0x%08x\n", entry );
+
+        if ( glb -> symTab -> loadElf( *reader )) {
+
+            winOut -> writeChars( "Symbols: %d\n", glb -> symTab -> getCount( ));
+        }
     
         // ??? to do ....
         // glb -> cpu -> setReg( RC_FD_PSTAGE, PSTAGE_REG_ID_PSW_0, (uint32_t) 0 );
@@ -217,5 +208,5 @@ void SimCommandsWin::loadElfFile( char *fileName ) {
         throw( errNum );
     }
     
-    
+    return( entry );
 }
@@ -9,6 +9,10 @@
 // is the backbone of all configured modules. As the last step we start the 
 // window subsystem, which will present the command line interface. 
 //
+// In batch mode, there is no console setup and no window display. The batch run
+// processes the configuration file, loads and runs the program and exits with
+// the batch run result as the program exit code.
+//
 // Optionally, the command interpreter will try to load a configuration file.
 // This is a file of plain command lines, such as creating the modules, setting
 // values in memory and so on.
@@ -41,10 +45,17 @@ int main( int argc, char * argv[] ) {
 
     processCmdLineOptions( glb, argc, argv );
    
+    glb -> symTab       = new T64SymTab( );
     glb -> console      = new SimConsoleIO( );
     glb -> env          = new SimEnv( glb, 100 );
     glb -> winDisplay   = new SimWinDisplay( glb );
     glb -> system       = new T64System( );  
+
+    if ( glb -> batchFlag ) {
+
+        glb -> env -> setupPredefined( );
+        return ( glb -> winDisplay -> startBatchRun( ));
+    }
     
     glb -> console      -> initConsoleIO( );
     glb -> env          -> setupPredefined( );
@@ -0,0 +1,32 @@
+; Arithmetic, logical and shift instructions on register and immediate
+; operands.
+;
+;! R2 12345
+;! R3 0x00000000FFFF0000
+;! R4 0x000000000000FF00
+;! R5 0x00000000FFFFFF00
+;! R6 0x000000000000FF00
+;! R7 1
+;! R8 0
+;! R9 49380
+;! R10 0xFF
+;! R11 0x0000000000012345
+
+        ADD     R2,R0,12300
+        ADD     R2,R2,45
+        LDIL    R3,0xFFFF0
+        ADD     R12,R0,0xFF
+        SHL3A   R4,R12,R0
+        SHL3A   R4,R4,R0
+        SHL2A   R4,R4,R0
+        OR      R5,R3,R4
+        XOR     R6,R5,R3
+        CMP.LT  R7,R4,R3
+        CMP.GT  R8,R4,R3
+        SHL2A   R9,R2,R0
+        EXTR    R10,R4,8,8
+        ADD     R11,R0,0x1234
+        SHL3A   R11,R11,R0
+        SHL1A   R11,R11,R0
+        ADD     R11,R11,5
+        TRAP    1,R0,R0
@@ -0,0 +1,33 @@
+; Conditional branches. The loop runs 11 times and counts the odd values with
+; BB.F and the values with bit 1 cleared with BB.T. ABR adds minus one to the
+; loop counter and branches until it is zero. MBR and CBR are then taken.
+;
+;! R2 11
+;! R3 6
+;! R4 5
+;! R5 0
+;! R6 0
+;! R7 3
+;! LIMIT 1000
+
+        ADD     R5,R0,11
+        SUB     R8,R0,1
+loop:   ADD     R2,R2,1
+        BB.F    R2,0,even
+        ADD     R3,R3,1
+even:   BB.T    R2,1,next
+        ADD     R4,R4,1
+next:   ABR.NE  R5,R8,loop
+        MBR.EQ  R6,R5,zero
+        TRAP    2,R0,R0
+
+zero:   ADD     R7,R7,1
+        CBR.LT  R5,R7,less
+        TRAP    2,R0,R0
+
+less:   ADD     R7,R7,1
+        CBR.GE  R5,R0,done
+        TRAP    2,R0,R0
+
+done:   ADD     R7,R7,1
+        TRAP    1,R0,R0
@@ -0,0 +1,20 @@
+; Subroutine calls. The routine squares R3 into R4 with repeated additions and
+; returns through the link register R14.
+;
+;! R2 91
+;! R3 0
+;! LIMIT 10000
+
+        ADD     R3,R0,6
+next:   B       square,R14
+        ADD     R2,R2,R4
+        SUB     R3,R3,1
+        CBR.NE  R3,R0,next
+        TRAP    1,R0,R0
+
+square: ADD     R4,R0,0
+        ADD     R5,R3,0
+sum:    ADD     R4,R4,R3
+        SUB     R5,R5,1
+        CBR.NE  R5,R0,sum
+        BE      0(R14)
@@ -0,0 +1,49 @@
+; Reservations racing with plain stores. Processors 0 and 1 increment the low
+; word of a doubleword 10000 times each with LDR/STC. Processor 2 increments 
+; the high word of the same doubleword 10000 times with plain loads and word
+; stores. A store conditional must never write back a stale high word, so no
+; increment of either kind is lost. Each processor then increments the done 
+; counter, processor 0 waits for all three and loads both words.
+;
+;! PROCS 3
+;! R3 20000
+;! R4 10000
+;! LIMIT 100000000
+
+        ADD     R9,R0,data
+        ADD     R5,R0,10000
+        ADD     R8,R0,2
+        CBR.EQ  R1,R8,plain
+
+rsv:    LDR     R2,0(R9)
+        ADD     R2,R2,1
+        STC     R2,0(R9)
+        CBR.EQ  R2,R0,rsv
+        SUB     R5,R5,1
+        CBR.NE  R5,R0,rsv
+        B       join
+
+plain:  LD.W    R2,0(R9)
+        ADD     R2,R2,1
+        ST.W    R2,0(R9)
+        SUB     R5,R5,1
+        CBR.NE  R5,R0,plain
+
+join:   LDR     R2,64(R9)
+        ADD     R2,R2,1
+        STC     R2,64(R9)
+        CBR.EQ  R2,R0,join
+        CBR.NE  R1,R0,exit
+
+        ADD     R8,R0,3
+wait:   LD      R2,64(R9)
+        CBR.NE  R2,R8,wait
+        LD.W    R3,4(R9)
+        LD.W    R4,0(R9)
+
+exit:   TRAP    1,R0,R0
+
+        .ALIGN  64
+data:   .DWORD  0
+        .SPACE  56
+done:   .DWORD  0
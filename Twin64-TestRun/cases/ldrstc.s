@@ -0,0 +1,23 @@
+; Reservations on one processor. A load reserved and store conditional pair
+; succeeds, a plain store to the same doubleword in between makes the next
+; store conditional fail.
+;
+;! R2 1
+;! R3 0
+;! R4 43
+;! R5 7
+
+        ADD     R9,R0,data
+        LDR     R4,0(R9)
+        ADD     R4,R4,1
+        ADD     R2,R4,0
+        STC     R2,0(R9)
+        LDR     R3,0(R9)
+        ADD     R5,R0,7
+        ST      R5,0(R9)
+        STC     R3,0(R9)
+        LD      R5,0(R9)
+        TRAP    1,R0,R0
+
+        .ALIGN  8
+data:   .DWORD  42
@@ -0,0 +1,33 @@
+; Loads and stores of all sizes. Memory is big endian, the byte at the lowest
+; address is the most significant byte of a doubleword.
+;
+;! R2 0x1122334455667788
+;! R3 0x11
+;! R4 0x3344
+;! R5 0x55667788
+;! R6 0x1122334455667799
+;! R7 0x7788
+;! R8 0x1122334455667788
+
+        ADD     R9,R0,data
+        LD      R2,0(R9)
+        LD.B    R3,0(R9)
+        LD.H    R4,2(R9)
+        LD.W    R5,4(R9)
+        ST      R2,8(R9)
+        ADD     R10,R0,0x77
+        ST.B    R10,15(R9)
+        ADD     R10,R0,0x99
+        ST.B    R10,15(R9)
+        LD      R6,8(R9)
+        ST.H    R5,16(R9)
+        LD.H    R7,16(R9)
+        LDO     R11,8(R9)
+        ST.W    R5,4(R11)
+        LD      R8,0(R11)
+        TRAP    1,R0,R0
+
+        .ALIGN  8
+data:   .DWORD  0x1122334455667788
+        .DWORD  0
+        .DWORD  0
@@ -0,0 +1,12 @@
+; Sum of 1 .. 100 in a counted loop.
+;
+;! R2 5050
+;! R3 0
+;! LIMIT 1000
+
+        ADD     R3,R0,100
+loop:   ADD     R2,R2,R3
+        SUB     R3,R3,1
+        CMP.NE  R4,R3,R0
+        BB.T    R4,0,loop
+        TRAP    1,R0,R0
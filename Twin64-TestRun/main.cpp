@@ -0,0 +1,528 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - Parallel Test Runner.
+//
+//----------------------------------------------------------------------------------------
+// TestRun runs test cases for the T64 system in parallel. A test case is an
+// assembler program file. Each instance of a case runs in a system of its own,
+// with a global TLB, a memory module and by default one processor. Many systems
+// run at the same time, each on one thread of a pool of worker threads. The 
+// processor is run with the system scheduler in reproducible mode on the thread
+// of the worker, a system has no running module thread of its own. A case with
+// more than one processor runs them in relaxed mode with one scheduler worker
+// per processor, so that they really run at the same time and race for memory.
+//
+// The cases are first assembled in parallel. The program image of a case is
+// written once as a memory image file, which each instance maps copy on write
+// in place of its memory data. All instances of a case share the pages of the
+// image they only read, a page gets copied when an instance modifies it.
+//
+// A case ends with a "TRAP" instruction. The case passes when all processors 
+// take the user defined trap within the instruction limit and the general 
+// registers of the first processor hold the expected values. All processors 
+// start at the entry address, general register R1 holds the processor index.
+// Comment lines starting with ";!" are the directives of the runner:
+//
+//  ;! R<n> <val>       -> expected value of the general register n at the end
+//  ;! LIMIT <num>      -> instruction limit of the case, overrides "-n"
+//  ;! PROCS <num>      -> number of processors, the default is 1
+//
+// The result is one line per case in JSON format, with the number of instances
+// run and passed, followed by a summary line with the aggregate throughput in
+// instructions and case instances per second. The program options are:
+//
+//  -j <num>    -> number of worker threads, the default is the host core count
+//  -r <num>    -> number of instances per case, the default is 1
+//  -n <num>    -> instruction limit per instance, the default is 10000000
+//  -o <num>    -> processor options, e.g. 1 = PREDECODE, 2 = DIRECT_MEM,
+//                 5 = PREDECODE and BLOCKS, 16 = TIMING
+//  -m <num>    -> memory module size in MBytes, the default is 4
+//  -d <dir>    -> directory for the image files, the default is "."
+//
+// The exit code is one when any case instance failed. The cases in the "cases"
+// directory are registered as tests with CTest.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Test Runner
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details. You should have received a copy of the GNU General Public
+// License along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-System.h"
+#include "T64-Processor.h"
+#include "T64-Memory.h"
+#include "T64-Tlb.h"
+#include "T64-InlineAsm.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+// Local declarations. A test system has a global TLB, one memory module and one
+// or more processors. The case program is assembled for address zero.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+const int       RUN_GTLB_MOD_NUM    = 0;
+const int       RUN_MEM_MOD_NUM     = 2;
+const int       RUN_PROC_MOD_NUM    = 4;
+const T64Word   RUN_MEM_SIZE_MB     = 4;
+const T64Word   RUN_CODE_ADR        = 0x0;
+const int       RUN_MAX_PATH        = 512;
+const int       RUN_MAX_INFO        = 128;
+const int       RUN_MAX_PROCS       = 8;
+
+struct TestCase {
+
+    const char  *fileName               = nullptr;
+    char        imageName[ RUN_MAX_PATH ] = { 0 };
+    T64Word     entryAdr                = 0;
+    T64Word     limit                   = 0;
+    int         procs                   = 1;
+    bool        expSet[ T64_MAX_GREGS ] = { false };
+    T64Word     expVal[ T64_MAX_GREGS ] = { 0 };
+    bool        ready                   = false;
+    char        info[ RUN_MAX_INFO ]    = { 0 };
+};
+
+struct TestRun {
+
+    int         caseIndex               = 0;
+    bool        passed                  = false;
+    T64Word     instrs                  = 0;
+    double      secs                    = 0.0;
+    char        info[ RUN_MAX_INFO ]    = { 0 };
+};
+
+std::vector<TestCase>   cases;
+std::vector<TestRun>    runs;
+
+//----------------------------------------------------------------------------------------
+// Program input parameters.
+//
+//----------------------------------------------------------------------------------------
+int         workerCount = 0;
+int         repeatCount = 1;
+T64Word     instrLimit  = 10000000;
+T64Options  procOptions = T64_PO_NIL;
+T64Word     memSizeMb   = RUN_MEM_SIZE_MB;
+const char  *imageDir   = ".";
+
+bool parseParameters( int argc, const char * argv[] ) {
+
+    for ( int i = 1; i < argc; i++ ) {
+
+        if (( strcmp( argv[ i ], "-j" ) == 0 ) && ( i + 1 < argc )) {
+
+            workerCount = atoi( argv[ ++ i ] );
+        }
+        else if (( strcmp( argv[ i ], "-r" ) == 0 ) && ( i + 1 < argc )) {
+
+            repeatCount = atoi( argv[ ++ i ] );
+        }
+        else if (( strcmp( argv[ i ], "-n" ) == 0 ) && ( i + 1 < argc )) {
+
+            instrLimit = atoll( argv[ ++ i ] );
+        }
+        else if (( strcmp( argv[ i ], "-o" ) == 0 ) && ( i + 1 < argc )) {
+
+            procOptions = (T64Options) atoi( argv[ ++ i ] );
+        }
+        else if (( strcmp( argv[ i ], "-m" ) == 0 ) && ( i + 1 < argc )) {
+
+            memSizeMb = atoll( argv[ ++ i ] );
+        }
+        else if (( strcmp( argv[ i ], "-d" ) == 0 ) && ( i + 1 < argc )) {
+
+            imageDir = argv[ ++ i ];
+        }
+        else if ( argv[ i ][ 0 ] != '-' ) {
+
+            TestCase c;
+
+            c.fileName = argv[ i ];
+            cases.push_back( c );
+        }
+        else {
+
+            printf( "Usage: Twin64-TestRun [ -j <num> ] [ -r <num> ] [ -n <num> ] " );
+            printf( "[ -o <num> ] [ -m <num> ] [ -d <dir> ] <file> ...\n" );
+            return( false );
+        }
+    }
+
+    if (( workerCount < 0 ) || ( repeatCount < 1 ) || ( instrLimit < 1 ) ||
+        ( memSizeMb < 1 ) || ( memSizeMb * 1024 * 1024 > T64_MAX_PHYS_MEM_LIMIT ) ||
+        ( cases.empty( ))) {
+
+        printf( "Invalid parameter value\n" );
+        return( false );
+    }
+
+    if ( workerCount == 0 ) workerCount = (int) std::thread::hardware_concurrency( );
+    if ( workerCount < 1 )  workerCount = 1;
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Run a routine for a number of work items on the worker threads. A worker just
+// takes the next item until there are none left.
+//
+//----------------------------------------------------------------------------------------
+void poolWorker( std::atomic<int> *next, int items, void ( *fn )( int )) {
+
+    int i = 0;
+
+    while (( i = next -> fetch_add( 1, std::memory_order_relaxed )) < items ) fn( i );
+}
+
+void runPool( int items, void ( *fn )( int )) {
+
+    std::atomic<int>            next { 0 };
+    std::vector<std::thread>    pool;
+
+    for ( int i = 0; i < workerCount; i++ ) pool.emplace_back( poolWorker, &next, items, fn );
+    for ( auto &t : pool ) t.join( );
+}
+
+//----------------------------------------------------------------------------------------
+// Read the runner directives of a case. A directive we do not know makes the
+// case fail, a typo should not silently pass a case.
+//
+//----------------------------------------------------------------------------------------
+bool readDirectives( TestCase *c ) {
+
+    FILE *f = fopen( c -> fileName, "r" );
+
+    if ( f == nullptr ) {
+
+        snprintf( c -> info, sizeof( c -> info ), "cannot open file" );
+        return( false );
+    }
+
+    char    buf[ 256 ];
+    int     lineNum     = 0;
+    bool    rStat       = true;
+
+    c -> limit = instrLimit;
+
+    while (( rStat ) && ( fgets( buf, sizeof( buf ), f ) != nullptr )) {
+
+        char        *p      = buf;
+        char        name[ 16 ];
+        long long   val     = 0;
+        int         regNum  = 0;
+
+        lineNum ++;
+
+        while ( isspace((unsigned char) *p )) p++;
+        if (( p[ 0 ] != ';' ) || ( p[ 1 ] != '!' )) continue;
+
+        if ( sscanf( p + 2, "%15s %lli", name, &val ) != 2 ) rStat = false;
+        else if ( strcmp( name, "LIMIT" ) == 0 ) {
+
+            c -> limit = val;
+            rStat      = ( val > 0 );
+        }
+        else if ( strcmp( name, "PROCS" ) == 0 ) {
+
+            c -> procs = (int) val;
+            rStat      = (( val > 0 ) && ( val <= RUN_MAX_PROCS ));
+        }
+        else if (( sscanf( name, "R%d", &regNum ) == 1 ) &&
+                 ( regNum >= 0 ) && ( regNum < T64_MAX_GREGS )) {
+
+            c -> expSet[ regNum ] = true;
+            c -> expVal[ regNum ] = val;
+        }
+        else rStat = false;
+
+        if ( ! rStat ) snprintf( c -> info, sizeof( c -> info ), "line %d: invalid directive", lineNum );
+    }
+
+    fclose( f );
+    return( rStat );
+}
+
+//----------------------------------------------------------------------------------------
+// Write the memory image of a case. The file has the size of the memory module,
+// the program image is placed at its address. The rest of the file is never
+// written, the host keeps it sparse.
+//
+//----------------------------------------------------------------------------------------
+bool writeMemImage( const char *fileName, const uint8_t *data, T64Word adr, T64Word len ) {
+
+    T64Word memSize = memSizeMb * 1024 * 1024;
+
+    if (( adr < 0 ) || ( adr + len > memSize )) return( false );
+
+    FILE *f = fopen( fileName, "wb" );
+    if ( f == nullptr ) return( false );
+
+    bool rStat = true;
+
+    if ( len > 0 ) {
+
+        rStat = ( fseek( f, (long) adr, SEEK_SET ) == 0 ) &&
+                ( fwrite( data, 1, len, f ) == (size_t) len );
+    }
+
+    if (( rStat ) && ( adr + len < memSize )) {
+
+        rStat = ( fseek( f, (long) ( memSize - 1 ), SEEK_SET ) == 0 ) &&
+                ( fputc( 0, f ) != EOF );
+    }
+
+    return(( fclose( f ) == 0 ) && ( rStat ));
+}
+
+//----------------------------------------------------------------------------------------
+// Prepare a case. We read the directives, assemble the program and write the
+// memory image. This runs on the worker threads, each worker has an assembler
+// for the case it prepares.
+//
+//----------------------------------------------------------------------------------------
+void prepareCase( int index ) {
+
+    TestCase    *c = &cases[ index ];
+    T64Assemble doAsm;
+
+    if ( ! readDirectives( c )) return;
+
+    if ( doAsm.assembleFile( c -> fileName, RUN_CODE_ADR ) != 0 ) {
+
+        snprintf( c -> info, sizeof( c -> info ), "line %d: %s",
+                  doAsm.getErrLine( ), doAsm.getErrStr( doAsm.getErrId( )));
+        return;
+    }
+
+    snprintf( c -> imageName, sizeof( c -> imageName ), "%s/T64-TestRun.%d.img", imageDir, index );
+
+    if ( ! writeMemImage( c -> imageName,
+                          doAsm.getImageData( ),
+                          doAsm.getImageAdr( ),
+                          doAsm.getImageSize( ))) {
+
+        snprintf( c -> info, sizeof( c -> info ), "cannot write image file" );
+        return;
+    }
+
+    c -> entryAdr   = doAsm.getEntryAdr( );
+    c -> ready      = true;
+}
+
+//----------------------------------------------------------------------------------------
+// Run one instance of a case. We build a fresh system, map the case image and
+// run the processors with the scheduler on this thread until they trap or the
+// limit is reached. The system is taken apart again when done.
+//
+//----------------------------------------------------------------------------------------
+void runInstance( int index ) {
+
+    TestRun     *r  = &runs[ index ];
+    TestCase    *c  = &cases[ r -> caseIndex ];
+
+    if ( ! c -> ready ) {
+
+        snprintf( r -> info, sizeof( r -> info ), "%s", c -> info );
+        return;
+    }
+
+    T64System   *sys  = new T64System( );
+    T64Module   *gTlb = new T64GlobalTlb( MT_GTLB,
+                                          RUN_GTLB_MOD_NUM,
+                                          T64_TK_GLOBAL_TLB,
+                                          T64_TT_FA_16S );
+
+    T64Memory   *mem  = new T64Memory( sys,
+                                       RUN_MEM_MOD_NUM,
+                                       T64_MK_NIL,
+                                       T64_MT_RAM,
+                                       0,
+                                       memSizeMb * 1024 * 1024 );
+
+    sys -> addModule( gTlb );
+    sys -> addModule( mem );
+
+    if ( ! mem -> mapImageFile( c -> imageName )) {
+
+        snprintf( r -> info, sizeof( r -> info ), "cannot map image file" );
+    }
+    else {
+
+        T64Processor *procs[ RUN_MAX_PROCS ] = { nullptr };
+
+        for ( int i = 0; i < c -> procs; i++ ) {
+
+            T64Processor *proc = new T64Processor( sys,
+                                                   RUN_PROC_MOD_NUM + i,
+                                                   procOptions,
+                                                   T64_CPU_T_NIL,
+                                                   T64_TT_FA_4U,
+                                                   T64_CT_NIL );
+
+            sys -> addModule( proc );
+
+            proc -> resetModule( );
+            proc -> waitUntilStopped( );
+            proc -> setEnterSimOnTrap( true );
+            proc -> getCpuPtr( ) -> setPsrReg( c -> entryAdr );
+            proc -> getCpuPtr( ) -> setGeneralReg( 1, i );
+            procs[ i ] = proc;
+        }
+
+        if ( c -> procs == 1 ) {
+
+            sys -> setSchedMode( T64_SCHED_REPRODUCIBLE, T64_PROC_UNIT_BATCH, 1 );
+        }
+        else sys -> setSchedMode( T64_SCHED_RELAXED, T64_PROC_UNIT_BATCH, c -> procs );
+
+        auto startTime = std::chrono::steady_clock::now( );
+
+        sys -> run( c -> limit );
+
+        auto endTime = std::chrono::steady_clock::now( );
+
+        r -> secs   = std::chrono::duration<double>( endTime - startTime ).count( );
+        r -> passed = true;
+
+        for ( int i = 0; i < c -> procs; i++ ) {
+
+            T64TrapCode trapCode = procs[ i ] -> getTrapCode( );
+
+            r -> instrs += procs[ i ] -> getPerfBlock( ) -> get( T64_PC_INSTRS );
+
+            if (( r -> passed ) && ( trapCode != USER_DEFINED_TRAP )) {
+
+                if ( trapCode == NO_TRAP ) {
+
+                    snprintf( r -> info, sizeof( r -> info ), 
+                              "processor %d: instruction limit reached", i );
+                }
+                else {
+
+                    snprintf( r -> info, sizeof( r -> info ), 
+                              "processor %d: trap %d", i, (int) trapCode );
+                }
+
+                r -> passed = false;
+            }
+        }
+
+        T64Cpu *cpu = procs[ 0 ] -> getCpuPtr( );
+
+        for ( int i = 0; ( r -> passed ) && ( i < T64_MAX_GREGS ); i++ ) {
+
+            if (( c -> expSet[ i ] ) && ( cpu -> getGeneralReg( i ) != c -> expVal[ i ] )) {
+
+                snprintf( r -> info, sizeof( r -> info ), "R%d = 0x%llx, expected 0x%llx",
+                          i,
+                          (unsigned long long) cpu -> getGeneralReg( i ),
+                          (unsigned long long) c -> expVal[ i ] );
+
+                r -> passed = false;
+            }
+        }
+
+        for ( int i = 0; i < c -> procs; i++ ) sys -> removeModule( procs[ i ] );
+    }
+
+    sys -> removeModule( mem );
+    sys -> removeModule( gTlb );
+    delete sys;
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------------------
+// Here we go. The cases are prepared first, then all instances run. We report
+// the result of each case and the summary, and remove the image files.
+//
+//----------------------------------------------------------------------------------------
+int main( int argc, const char * argv[] ) {
+
+    if ( ! parseParameters( argc, argv )) return( 1 );
+
+    auto prepTime = std::chrono::steady_clock::now( );
+
+    runPool((int) cases.size( ), prepareCase );
+
+    for ( int i = 0; i < (int) cases.size( ); i++ ) {
+
+        for ( int k = 0; k < repeatCount; k++ ) {
+
+            TestRun r;
+
+            r.caseIndex = i;
+            runs.push_back( r );
+        }
+    }
+
+    auto startTime = std::chrono::steady_clock::now( );
+
+    runPool((int) runs.size( ), runInstance );
+
+    auto endTime = std::chrono::steady_clock::now( );
+
+    double  prepSecs    = std::chrono::duration<double>( startTime - prepTime ).count( );
+    double  runSecs     = std::chrono::duration<double>( endTime - startTime ).count( );
+    int     passedTotal = 0;
+    T64Word instrTotal  = 0;
+
+    for ( int i = 0; i < (int) cases.size( ); i++ ) {
+
+        int         passed  = 0;
+        T64Word     instrs  = 0;
+        double      secs    = 0.0;
+        const char  *info   = "";
+
+        for ( int k = 0; k < repeatCount; k++ ) {
+
+            TestRun *r = &runs[ i * repeatCount + k ];
+
+            if ( r -> passed ) passed ++;
+            else if ( info[ 0 ] == '\0' ) info = r -> info;
+
+            instrs  += r -> instrs;
+            secs    += r -> secs;
+        }
+
+        printf( "{ \"case\": \"%s\", \"result\": \"%s\", \"runs\": %d, \"passed\": %d, ",
+                cases[ i ].fileName, ( passed == repeatCount ) ? "pass" : "fail",
+                repeatCount, passed );
+        printf( "\"instrs\": %lld, \"seconds\": %.6f", (long long) instrs, secs );
+
+        if ( info[ 0 ] != '\0' ) printf( ", \"info\": \"%s\"", info );
+        printf( " }\n" );
+
+        passedTotal += passed;
+        instrTotal  += instrs;
+
+        if ( cases[ i ].ready ) remove( cases[ i ].imageName );
+    }
+
+    printf( "{ \"cases\": %d, \"runs\": %d, \"passed\": %d, \"failed\": %d, \"workers\": %d, ",
+            (int) cases.size( ), (int) runs.size( ), passedTotal,
+            (int) runs.size( ) - passedTotal, workerCount );
+    printf( "\"prepSeconds\": %.6f, \"seconds\": %.6f, \"instrs\": %lld, ",
+            prepSecs, runSecs, (long long) instrTotal );
+    printf( "\"mips\": %.3f, \"runsPerSec\": %.3f }\n",
+            (double) instrTotal / runSecs / 1.0e6, (double) runs.size( ) / runSecs );
+
+    return(( passedTotal == (int) runs.size( )) ? 0 : 1 );
+}
@@ -0,0 +1,224 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - Trace File Decoder.
+//
+//----------------------------------------------------------------------------------------
+// TraceDump decodes a trace file written by a processor tracer. Each executed 
+// instruction is listed with its address, the instruction word and the 
+// disassembled instruction, followed by the register writes, data memory 
+// accesses and traps it caused. The summary option only counts the records.
+// With the symbols of the traced program loaded from its ELF file, the address
+// of each instruction is also shown as symbol and offset.
+//
+// The program options are:
+//
+//  <file>      -> the trace file
+//  -n <num>    -> decode at most <num> records
+//  -s          -> print the record counts only
+//  -e <elf>    -> load the symbols from the ELF file <elf>
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Trace file decoder
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details. You should have received a copy of the GNU General Public
+// License along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-Processor.h"
+#include "T64-InlineAsm.h"
+
+//----------------------------------------------------------------------------------------
+// Local declarations.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+const int READ_CHUNK_RECORDS = 4096;
+
+const char  *fileName   = nullptr;
+const char  *elfName    = nullptr;
+long long   maxRecords  = -1;
+bool        summaryOnly = false;
+
+//----------------------------------------------------------------------------------------
+// Program input parameters.
+//
+//----------------------------------------------------------------------------------------
+bool parseParameters( int argc, const char * argv[] ) {
+
+    for ( int i = 1; i < argc; i++ ) {
+
+        if (( strcmp( argv[ i ], "-n" ) == 0 ) && ( i + 1 < argc )) {
+
+            maxRecords = atoll( argv[ ++ i ] );
+        }
+        else if ( strcmp( argv[ i ], "-s" ) == 0 ) {
+
+            summaryOnly = true;
+        }
+        else if (( strcmp( argv[ i ], "-e" ) == 0 ) && ( i + 1 < argc )) {
+
+            elfName = argv[ ++ i ];
+        }
+        else if (( argv[ i ][ 0 ] != '-' ) && ( fileName == nullptr )) {
+
+            fileName = argv[ i ];
+        }
+        else {
+
+            printf( "Usage: Twin64-TraceDump <file> [ -n <num> ] [ -s ] [ -e <elf> ]\n" );
+            return( false );
+        }
+    }
+
+    if ( fileName == nullptr ) {
+
+        printf( "Usage: Twin64-TraceDump <file> [ -n <num> ] [ -s ] [ -e <elf> ]\n" );
+        return( false );
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Print one record. The instruction records start a line, all other records 
+// are indented below the instruction that caused them.
+//
+//----------------------------------------------------------------------------------------
+void printRecord( T64DisAssemble *disAsm, T64SymTab *symTab, const T64TraceRecord *r ) {
+
+    switch ( r -> kind ) {
+
+        case T64_TR_INSTR: {
+
+            char buf[ 128 ];
+            char sym[ 128 ];
+
+            disAsm -> formatInstr( buf, sizeof( buf ), r -> data, 16 );
+
+            if ( symTab -> formatAdr( sym, sizeof( sym ), r -> val ) > 0 ) {
+
+                printf( "P%-3d %016llx  %08x  %-40s <%s>\n", 
+                        r -> modNum, (unsigned long long) r -> val, r -> data, buf, sym );
+            }
+            else {
+
+                printf( "P%-3d %016llx  %08x  %s\n", 
+                        r -> modNum, (unsigned long long) r -> val, r -> data, buf );
+            }
+
+        } break;
+
+        case T64_TR_REG_WRITE: {
+
+            printf( "%34sR%-2d  <- 0x%016llx\n", 
+                    "", r -> aux, (unsigned long long) r -> val );
+
+        } break;
+
+        case T64_TR_MEM_READ: {
+
+            printf( "%34sRD%d  @  0x%016llx\n", 
+                    "", r -> aux, (unsigned long long) r -> val );
+
+        } break;
+
+        case T64_TR_MEM_WRITE: {
+
+            printf( "%34sWR%d  @  0x%016llx\n", 
+                    "", r -> aux, (unsigned long long) r -> val );
+
+        } break;
+
+        case T64_TR_TRAP: {
+
+            printf( "%34sTRAP %d @  0x%016llx\n", 
+                    "", r -> data, (unsigned long long) r -> val );
+
+        } break;
+
+        default: printf( "%34s??? kind %d\n", "", r -> kind );
+    }
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------------------
+// Here we go. We check the file header and then decode the records in chunks.
+//
+//----------------------------------------------------------------------------------------
+int main( int argc, const char * argv[] ) {
+
+    if ( ! parseParameters( argc, argv )) return( 1 );
+
+    FILE *f = fopen( fileName, "rb" );
+
+    if ( f == nullptr ) {
+
+        printf( "Cannot open file: %s\n", fileName );
+        return( 1 );
+    }
+
+    T64TraceFileHeader hdr;
+
+    if (( fread( &hdr, sizeof( hdr ), 1, f ) != 1 ) || 
+        ( memcmp( hdr.magic, "T64TRACE", sizeof( hdr.magic )) != 0 ) ||
+        ( hdr.version != T64_TRACE_VERSION ) ||
+        ( hdr.recordSize != sizeof( T64TraceRecord ))) {
+
+        printf( "Not a trace file: %s\n", fileName );
+        fclose( f );
+        return( 1 );
+    }
+
+    T64SymTab *symTab = new T64SymTab( );
+
+    if (( elfName != nullptr ) && ( ! symTab -> loadElf( elfName ))) {
+
+        printf( "Cannot load symbols: %s\n", elfName );
+        fclose( f );
+        return( 1 );
+    }
+
+    T64DisAssemble  *disAsm = new T64DisAssemble( );
+    T64TraceRecord  *buf    = new T64TraceRecord[ READ_CHUNK_RECORDS ];
+    long long       counts[ T64_TR_TRAP + 1 ] = { };
+    long long       total   = 0;
+    size_t          n       = 0;
+
+    while (( n = fread( buf, sizeof( T64TraceRecord ), READ_CHUNK_RECORDS, f )) > 0 ) {
+
+        for ( size_t i = 0; i < n; i++ ) {
+
+            if (( maxRecords >= 0 ) && ( total >= maxRecords )) break;
+
+            if ( buf[ i ].kind <= T64_TR_TRAP ) counts[ buf[ i ].kind ] ++;
+            if ( ! summaryOnly ) printRecord( disAsm, symTab, &buf[ i ] );
+            total ++;
+        }
+
+        if (( maxRecords >= 0 ) && ( total >= maxRecords )) break;
+    }
+
+    printf( "{ \"module\": %u, \"records\": %lld, \"instrs\": %lld, \"regWrites\": %lld, ",
+            hdr.modNum, total, counts[ T64_TR_INSTR ], counts[ T64_TR_REG_WRITE ] );
+    printf( "\"memReads\": %lld, \"memWrites\": %lld, \"traps\": %lld }\n",
+            counts[ T64_TR_MEM_READ ], counts[ T64_TR_MEM_WRITE ], counts[ T64_TR_TRAP ] );
+
+    fclose( f );
+    delete [ ] buf;
+    delete disAsm;
+    delete symTab;
+    return( 0 );
+}